@@ -22,16 +22,45 @@
  *  Handling various archive files.
  */
 
+#include "src/common/atomic.h"
+
+#include <boost/unordered_map.hpp>
+#include <boost/functional/hash.hpp>
+
 #include "src/common/system.h"
 
 #include "src/aurora/archive.h"
 
 namespace Aurora {
 
+/** A resource's name and type. Unlike ResourceKey, the name is compared exactly. */
+typedef std::pair<Common::UString, FileType> NameKey;
+
+struct hashNameKey {
+	size_t operator()(const NameKey &key) const {
+		size_t seed = Common::hashUStringCaseSensitive()(key.first);
+		boost::hash_combine(seed, (int) key.second);
+
+		return seed;
+	}
+};
+
+typedef boost::unordered_map<NameKey, uint32, hashNameKey> NameIndex;
+
+struct Archive::Index {
+	/** Name hash to resource index. */
+	boost::unordered_map<uint64, uint32> hashes;
+	/** Name and type to resource index. */
+	NameIndex names;
+};
+
 Archive::Resource::Resource() : hash(0), type(kFileTypeNone), index(0xFFFFFFFF) {
 }
 
-Archive::Archive() {
+Archive::Location::Location() : stream(0), offset(0), size(0), raw(false) {
+}
+
+Archive::Archive() : _hasIndex(false) {
 }
 
 Archive::~Archive() {
@@ -41,27 +70,66 @@ uint32 Archive::getResourceSize(uint32 UNUSED(index)) const {
 	return 0xFFFFFFFF;
 }
 
+bool Archive::getResourceLocation(uint32 UNUSED(index), Location &UNUSED(location)) const {
+	return false;
+}
+
 Common::HashAlgo Archive::getNameHashAlgo() const {
 	return Common::kHashNone;
 }
 
+const Archive::Index &Archive::getIndex() const {
+	if (_hasIndex.load(boost::memory_order_acquire))
+		return *_index;
+
+	Common::StackLock lock(_indexMutex);
+
+	if (!_index) {
+		Common::ScopedPtr<Index> index(new Index);
+
+		const ResourceList &resources = getResources();
+		const bool hasHashes = getNameHashAlgo() != Common::kHashNone;
+
+		index->names.reserve(resources.size());
+		if (hasHashes)
+			index->hashes.reserve(resources.size());
+
+		// If there are duplicates, the first resource in the list wins
+		for (ResourceList::const_iterator r = resources.begin(); r != resources.end(); ++r) {
+			index->names.insert(std::make_pair(NameKey(r->name, r->type), r->index));
+
+			if (hasHashes)
+				index->hashes.insert(std::make_pair(r->hash, r->index));
+		}
+
+		_index.reset(index.release());
+		_hasIndex.store(true, boost::memory_order_release);
+	}
+
+	return *_index;
+}
+
 uint32 Archive::findResource(uint64 hash) const {
 	if (getNameHashAlgo() == Common::kHashNone)
 		return 0xFFFFFFFF;
 
-	for (ResourceList::const_iterator r = getResources().begin(); r != getResources().end(); ++r)
-		if (r->hash == hash)
-			return r->index;
+	const Index &index = getIndex();
 
-	return 0xFFFFFFFF;
+	boost::unordered_map<uint64, uint32>::const_iterator r = index.hashes.find(hash);
+	if (r == index.hashes.end())
+		return 0xFFFFFFFF;
+
+	return r->second;
 }
 
 uint32 Archive::findResource(const Common::UString &name, FileType type) const {
-	for (ResourceList::const_iterator r = getResources().begin(); r != getResources().end(); ++r)
-		if ((r->type == type) && (r->name == name))
-			return r->index;
+	const Index &index = getIndex();
 
-	return 0xFFFFFFFF;
+	NameIndex::const_iterator r = index.names.find(NameKey(name, type));
+	if (r == index.names.end())
+		return 0xFFFFFFFF;
+
+	return r->second;
 }
 
 } // End of namespace Aurora
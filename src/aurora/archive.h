@@ -25,13 +25,17 @@
 #ifndef AURORA_ARCHIVE_H
 #define AURORA_ARCHIVE_H
 
+#include "src/common/atomic.h"
+
 #include <list>
 
 #include <boost/noncopyable.hpp>
 
 #include "src/common/types.h"
+#include "src/common/scopedptr.h"
 #include "src/common/ustring.h"
 #include "src/common/hash.h"
+#include "src/common/mutex.h"
 
 #include "src/aurora/types.h"
 
@@ -56,6 +60,18 @@ public:
 
 	typedef std::list<Resource> ResourceList;
 
+	/** Where a resource's data is stored within the stream the archive reads from. */
+	struct Location {
+		Common::SeekableReadStream *stream; ///< The stream holding the data.
+
+		size_t offset; ///< The offset of the data within the stream.
+		size_t size;   ///< The size of the data, as stored.
+
+		bool raw; ///< Is the data stored as-is, without compression or encryption?
+
+		Location();
+	};
+
 	Archive();
 	virtual ~Archive();
 
@@ -66,20 +82,56 @@ public:
 	virtual uint32 getResourceSize(uint32 index) const;
 
 	/** Return a stream of the resource's contents.
+	 *
+	 *  The archive's data is only read positionally (see
+	 *  Common::SeekableReadStream::readAt()), so getResource() can be
+	 *  called concurrently from several threads, as long as the
+	 *  archive itself was opened on a file, mapped file or memory
+	 *  stream. The returned streams are independent of each other.
 	 *
 	 *  @param  index The index of the resource we want.
+	 *  Unless tryNoCopy is set, the returned stream owns all the data
+	 *  it reads, and stays valid after the archive is destroyed. With
+	 *  tryNoCopy, it might read directly from the archive (compressed
+	 *  resources are then decompressed from the archive on demand), so
+	 *  the archive has to outlive it.
+	 *
 	 *  @param  tryNoCopy Try to return a SeekableSubReadStream of the archive instead of copying.
 	 *  @return A (sub)stream of the resource's contents.
 	 */
 	virtual Common::SeekableReadStream *getResource(uint32 index, bool tryNoCopy = false) const = 0;
 
+	/** Find where the data of a resource is stored.
+	 *
+	 *  This lets callers order their reads of many resources by their
+	 *  position within the archive. Archives that can't tell return false.
+	 */
+	virtual bool getResourceLocation(uint32 index, Location &location) const;
+
 	/** Return with which algorithm the name is hashed. */
 	virtual Common::HashAlgo getNameHashAlgo() const;
 
 	/** Return the index of the resource matching the hash, or 0xFFFFFFFF if not found. */
 	uint32 findResource(uint64 hash) const;
-	/** Return the index of the resource matching the name and type, or 0xFFFFFFFF if not found. */
+	/** Return the index of the resource matching the name and type, or 0xFFFFFFFF if not found.
+	 *
+	 *  The name has to match exactly, including its case.
+	 */
 	uint32 findResource(const Common::UString &name, FileType type) const;
+
+private:
+	struct Index;
+
+	/** Hash tables for findResource(), built on the first lookup.
+	 *
+	 *  Since they index the resource list, an archive's list of resources
+	 *  must not change anymore after it has been constructed.
+	 */
+	mutable Common::ScopedPtr<Index> _index;
+	mutable Common::Mutex _indexMutex;
+	mutable boost::atomic<bool> _hasIndex;
+
+	const Index &getIndex() const;
 };
 
 } // End of namespace Aurora
@@ -32,6 +32,7 @@
 #include "src/common/strutil.h"
 #include "src/common/error.h"
 #include "src/common/memreadstream.h"
+#include "src/common/mappedfile.h"
 
 #include "src/aurora/biffile.h"
 
@@ -96,14 +97,18 @@ void BIFFile::readVarResTable(Common::SeekableReadStream &bif, uint32 offset) {
 	}
 }
 
-Common::SeekableReadStream *BIFFile::getResource(uint32 index) const {
+Common::SeekableReadStream *BIFFile::getResource(uint32 index, bool tryNoCopy) const {
 	const Resource &res = getRes(index);
 	if (res.size == 0)
 		return new Common::MemoryReadStream(static_cast<const byte *>(0), 0);
 
-	_bif->seek(res.offset);
+	if (tryNoCopy) {
+		Common::SeekableReadStream *view = Common::createMemoryView(*_bif, res.offset, res.offset + res.size);
+		if (view)
+			return view;
+	}
 
-	Common::ScopedPtr<Common::SeekableReadStream> resStream(_bif->readStream(res.size));
+	Common::ScopedPtr<Common::SeekableReadStream> resStream(_bif->readStreamAt(res.offset, res.size));
 
 	if (!resStream || (((uint32) resStream->size()) != res.size))
 		throw Common::Exception(Common::kReadError);
@@ -111,4 +116,15 @@ Common::SeekableReadStream *BIFFile::getResource(uint32 index) const {
 	return resStream.release();
 }
 
+bool BIFFile::getResourceLocation(uint32 index, Archive::Location &location) const {
+	const Resource &res = getRes(index);
+
+	location.stream = _bif.get();
+	location.offset = res.offset;
+	location.size   = res.size;
+	location.raw    = true;
+
+	return true;
+}
+
 } // End of namespace Aurora
@@ -67,7 +67,10 @@ public:
 	~BIFFile();
 
 	/** Return a stream of the resource's contents. */
-	Common::SeekableReadStream *getResource(uint32 index) const;
+	Common::SeekableReadStream *getResource(uint32 index, bool tryNoCopy = false) const;
+
+	/** Return where the resource's data is stored. */
+	bool getResourceLocation(uint32 index, Archive::Location &location) const;
 
 private:
 	Common::ScopedPtr<Common::SeekableReadStream> _bif;
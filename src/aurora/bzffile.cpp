@@ -27,6 +27,7 @@
 
 #include <cassert>
 
+#include "src/common/system.h"
 #include "src/common/util.h"
 #include "src/common/strutil.h"
 #include "src/common/error.h"
@@ -96,14 +97,32 @@ void BZFFile::readVarResTable(Common::SeekableReadStream &bzf, uint32 offset) {
 		_resources.back().packedSize = bzf.size() - _resources.back().offset;
 }
 
-Common::SeekableReadStream *BZFFile::getResource(uint32 index) const {
+Common::SeekableReadStream *BZFFile::getResource(uint32 index, bool tryNoCopy) const {
 	const Resource &res = getRes(index);
 	if ((res.packedSize == 0) || (res.size == 0))
 		return new Common::MemoryReadStream(static_cast<const byte *>(0), 0);
 
-	_bzf->seek(res.offset);
+	/* Decompress on demand, instead of holding both the packed and unpacked data in memory.
+	 * Only read the packed data directly out of the BZF if the caller allowed us to depend
+	 * on the BZF staying open; otherwise, copy it first. */
+	Common::SeekableReadStream *packed = 0;
+	if (tryNoCopy)
+		packed = new Common::SeekableSubReadStream(_bzf.get(), res.offset, res.offset + res.packedSize);
+	else
+		packed = _bzf->readStreamAt(res.offset, res.packedSize);
 
-	return Common::decompressLZMA1(*_bzf, res.packedSize, res.size);
+	return new Common::LZMAReadStream(packed, res.size);
+}
+
+bool BZFFile::getResourceLocation(uint32 index, Archive::Location &location) const {
+	const Resource &res = getRes(index);
+
+	location.stream = _bzf.get();
+	location.offset = res.offset;
+	location.size   = res.packedSize;
+	location.raw    = false;
+
+	return true;
 }
 
 } // End of namespace Aurora
@@ -0,0 +1,109 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  An archive whose resource table was restored from an index cache.
+ */
+
+#include "src/common/error.h"
+
+#include "src/aurora/cachedarchive.h"
+
+namespace Aurora {
+
+CachedArchive::CachedArchive(const IndexCache::ArchiveTable &table, const Opener &opener) :
+	_table(&table), _opener(opener), _archive(0) {
+
+	_dataFileResources.resize(_table->dataFiles.size());
+
+	for (ResourceList::const_iterator r = _table->resources.begin(); r != _table->resources.end(); ++r) {
+		if (r->index >= _table->dataFileIndices.size())
+			continue;
+
+		const uint32 dataFileIndex = _table->dataFileIndices[r->index];
+		if (dataFileIndex < _dataFileResources.size())
+			_dataFileResources[dataFileIndex].push_back(&*r);
+	}
+}
+
+CachedArchive::~CachedArchive() {
+}
+
+const Archive::ResourceList &CachedArchive::getResources() const {
+	return _table->resources;
+}
+
+uint32 CachedArchive::getResourceSize(uint32 index) const {
+	if (index >= _table->resourceSizes.size())
+		throw Common::Exception("Resource index out of range (%u/%u)", index, (uint)_table->resourceSizes.size());
+
+	return _table->resourceSizes[index];
+}
+
+Common::HashAlgo CachedArchive::getNameHashAlgo() const {
+	return _table->nameHashAlgo;
+}
+
+Common::SeekableReadStream *CachedArchive::getResource(uint32 index, bool tryNoCopy) const {
+	return getArchive().getResource(index, tryNoCopy);
+}
+
+bool CachedArchive::getResourceLocation(uint32 index, Location &location) const {
+	return getArchive().getResourceLocation(index, location);
+}
+
+std::vector<Common::UString> CachedArchive::getDataFileList() const {
+	std::vector<Common::UString> dataFiles;
+
+	dataFiles.reserve(_table->dataFiles.size());
+	for (std::vector<IndexCache::DataFile>::const_iterator d = _table->dataFiles.begin(); d != _table->dataFiles.end(); ++d)
+		dataFiles.push_back(d->name);
+
+	return dataFiles;
+}
+
+std::vector<const Archive::Resource *> CachedArchive::getResourceListForDataFile(const Common::UString &dataFile) const {
+	for (size_t i = 0; i < _table->dataFiles.size(); i++)
+		if (_table->dataFiles[i].name == dataFile)
+			return _dataFileResources[i];
+
+	return std::vector<const Resource *>();
+}
+
+const std::vector<const Archive::Resource *> &CachedArchive::getResourceListForDataFile(uint32 dataFileIndex) const {
+	if (dataFileIndex >= _dataFileResources.size())
+		throw Common::Exception("Data file index out of range (%u/%u)", dataFileIndex, (uint)_dataFileResources.size());
+
+	return _dataFileResources[dataFileIndex];
+}
+
+Archive &CachedArchive::getArchive() const {
+	Common::StackLock lock(_mutex);
+
+	if (!_archive) {
+		_archive = _opener();
+		if (!_archive)
+			throw Common::Exception("Failed to open the archive of a cached resource table");
+	}
+
+	return *_archive;
+}
+
+} // End of namespace Aurora
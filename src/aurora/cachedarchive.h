@@ -0,0 +1,99 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  An archive whose resource table was restored from an index cache.
+ */
+
+#ifndef AURORA_CACHEDARCHIVE_H
+#define AURORA_CACHEDARCHIVE_H
+
+#include <vector>
+#include <functional>
+
+#include "src/common/types.h"
+#include "src/common/ustring.h"
+#include "src/common/mutex.h"
+
+#include "src/aurora/archive.h"
+#include "src/aurora/indexcache.h"
+
+namespace Aurora {
+
+/** An archive whose resource table was restored from an IndexCache.
+ *
+ *  The list of resources, their sizes and, for KEY files, the data files
+ *  they're found in are all taken from the cached table. The real archive
+ *  is only opened, with the opener function, once the contents of a
+ *  resource are requested.
+ *
+ *  Both the cached table and the real archive returned by the opener
+ *  need to be kept around as long as the CachedArchive object lives;
+ *  ownership is not transferred.
+ */
+class CachedArchive : public Archive {
+public:
+	/** A function opening the real archive. */
+	typedef std::function<Archive *()> Opener;
+
+	CachedArchive(const IndexCache::ArchiveTable &table, const Opener &opener);
+	~CachedArchive();
+
+	/** Return the list of resources. */
+	const ResourceList &getResources() const;
+
+	/** Return the size of a resource. */
+	uint32 getResourceSize(uint32 index) const;
+
+	/** Return with which algorithm the name is hashed. */
+	Common::HashAlgo getNameHashAlgo() const;
+
+	/** Return a stream of the resource's contents, opening the real archive if necessary. */
+	Common::SeekableReadStream *getResource(uint32 index, bool tryNoCopy = false) const;
+
+	/** Return where the resource's data is stored. */
+	bool getResourceLocation(uint32 index, Location &location) const;
+
+	/** KEY only: Return the list of data files (BIF/BZF) the KEY file indexes. */
+	std::vector<Common::UString> getDataFileList() const;
+
+	/** KEY only: Return all resources found in this data file. */
+	std::vector<const Resource *> getResourceListForDataFile(const Common::UString &dataFile) const;
+	/** KEY only: Return all resources found in this data file, by index into the data file list. */
+	const std::vector<const Resource *> &getResourceListForDataFile(uint32 dataFileIndex) const;
+
+	/** Return the real archive, opening it if necessary. */
+	Archive &getArchive() const;
+
+private:
+	const IndexCache::ArchiveTable *_table;
+
+	Opener _opener;
+
+	/** KEY only: The resources within each data file. */
+	std::vector< std::vector<const Resource *> > _dataFileResources;
+
+	mutable Archive *_archive;
+	mutable Common::Mutex _mutex;
+};
+
+} // End of namespace Aurora
+
+#endif // AURORA_CACHEDARCHIVE_H
@@ -30,6 +30,7 @@
 
 #include "src/common/memreadstream.h"
 #include "src/common/readfile.h"
+#include "src/common/mappedfile.h"
 #include "src/common/util.h"
 #include "src/common/strutil.h"
 #include "src/common/error.h"
@@ -301,9 +302,9 @@ void ERFFile::load() {
 void ERFFile::decryptNWNPremium() {
 	assert(_header.encryption == kEncryptionBlowfishNWN);
 
-	_erf->seek(0);
-
-	_erf.reset(decrypt(*_erf, kEncryptionBlowfishNWN, _password));
+	/* The whole module is encrypted, so we read it through a stream that
+	 * decrypts only the parts that are actually read. */
+	_erf.reset(new Common::BlowfishReadStream(_erf.release(), _password));
 
 	_header.encryption = kEncryptionNone;
 }
@@ -662,13 +663,27 @@ uint32 ERFFile::getResourceSize(uint32 index) const {
 Common::SeekableReadStream *ERFFile::getResource(uint32 index, bool tryNoCopy) const {
 	const IResource &res = getIResource(index);
 
-	if (tryNoCopy && (_header.encryption == kEncryptionNone) && (_header.compression == kCompressionNone))
+	const bool isPacked = (_header.encryption != kEncryptionNone) || (_header.compression != kCompressionNone);
+
+	if (tryNoCopy && !isPacked) {
+		Common::SeekableReadStream *view = Common::createMemoryView(*_erf, res.offset, res.offset + res.packedSize);
+		if (view)
+			return view;
+
 		return new Common::SeekableSubReadStream(_erf.get(), res.offset, res.offset + res.packedSize);
+	}
 
-	_erf->seek(res.offset);
+	/* Read. Decryption copies the data, so it can always work on a view into memory.
+	 * Decompression reads the packed data for as long as the returned stream lives,
+	 * so it may only use a view if the caller allowed us to depend on the ERF. */
+	const bool canView = (_header.encryption != kEncryptionNone) || tryNoCopy;
 
-	// Read
-	Common::MemoryReadStream *stream = _erf->readStream(res.packedSize);
+	Common::MemoryReadStream *stream = 0;
+	if (isPacked && canView)
+		stream = Common::createMemoryView(*_erf, res.offset, res.offset + res.packedSize);
+
+	if (!stream)
+		stream = _erf->readStreamAt(res.offset, res.packedSize);
 
 	// Decrypt
 	if (_header.encryption != kEncryptionNone)
@@ -678,6 +693,17 @@ Common::SeekableReadStream *ERFFile::getResource(uint32 index, bool tryNoCopy) c
 	return decompress(stream, res.unpackedSize);
 }
 
+bool ERFFile::getResourceLocation(uint32 index, Location &location) const {
+	const IResource &res = getIResource(index);
+
+	location.stream = _erf.get();
+	location.offset = res.offset;
+	location.size   = res.packedSize;
+	location.raw    = (_header.encryption == kEncryptionNone) && (_header.compression == kCompressionNone);
+
+	return true;
+}
+
 Common::MemoryReadStream *ERFFile::decrypt(Common::SeekableReadStream &cryptStream,
                                            Encryption encryption, const std::vector<byte> &password) {
 	switch (encryption) {
@@ -747,10 +773,11 @@ Common::SeekableReadStream *ERFFile::decompressBiowareZlib(Common::MemoryReadStr
 
 	Common::ScopedPtr<Common::MemoryReadStream> stream(packedStream);
 
-	const byte * const compressedData = stream->getData();
 	const uint32 packedSize = stream->size();
+	const int windowBits = stream->readByte() >> 4;
 
-	return decompressZlib(compressedData + 1, packedSize - 1, unpackedSize, *compressedData >> 4);
+	return decompressZlib(new Common::SeekableSubReadStream(stream.release(), 1, packedSize, true),
+	                      unpackedSize, windowBits);
 }
 
 Common::SeekableReadStream *ERFFile::decompressHeaderlessZlib(Common::MemoryReadStream *packedStream,
@@ -760,21 +787,14 @@ Common::SeekableReadStream *ERFFile::decompressHeaderlessZlib(Common::MemoryRead
 
 	assert(packedStream);
 
-	Common::ScopedPtr<Common::MemoryReadStream> stream(packedStream);
-
-	const byte * const compressedData = stream->getData();
-	const uint32 packedSize = stream->size();
-
-	return decompressZlib(compressedData, packedSize, unpackedSize, Common::kWindowBitsMax);
+	return decompressZlib(packedStream, unpackedSize, Common::kWindowBitsMax);
 }
 
-Common::SeekableReadStream *ERFFile::decompressZlib(const byte *compressedData, uint32 packedSize,
+Common::SeekableReadStream *ERFFile::decompressZlib(Common::SeekableReadStream *packedStream,
                                                     uint32 unpackedSize, int windowBits) const {
 
-	// Decompress. Negative window size to signal not to look for a gzip header.
-	const byte *data = Common::decompressDeflate(compressedData, packedSize, unpackedSize, -windowBits);
-
-	return new Common::MemoryReadStream(data, unpackedSize, true);
+	// Inflate on demand. Negative window size to signal not to look for a gzip header.
+	return new Common::DeflateReadStream(packedStream, unpackedSize, -windowBits);
 }
 
 Common::HashAlgo ERFFile::getNameHashAlgo() const {
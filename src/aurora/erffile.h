@@ -124,6 +124,9 @@ public:
 	/** Return a stream of the resource's contents. */
 	Common::SeekableReadStream *getResource(uint32 index, bool tryNoCopy = false) const;
 
+	/** Return where the resource's data is stored. */
+	bool getResourceLocation(uint32 index, Location &location) const;
+
 	/** Return the year the ERF was built. */
 	uint32 getBuildYear() const;
 	/** Return the day of year the ERF was built. */
@@ -290,7 +293,7 @@ private:
 	Common::SeekableReadStream *decompressHeaderlessZlib(Common::MemoryReadStream *packedStream,
 	                                                     uint32 unpackedSize) const;
 
-	Common::SeekableReadStream *decompressZlib(const byte *compressedData, uint32 packedSize,
+	Common::SeekableReadStream *decompressZlib(Common::SeekableReadStream *packedStream,
 	                                           uint32 unpackedSize, int windowBits) const;
 	// '---
 
@@ -248,10 +248,11 @@ GFF4Struct *GFF4File::findStruct(uint64 id) {
 	return s->second;
 }
 
-Common::SeekableReadStream &GFF4File::getStream(uint32 offset) const {
-	_stream->seek(offset);
-
-	return *_stream;
+Common::SeekableReadStream *GFF4File::createStream() const {
+	/* Hand out a separate cursor over the whole file. Since these only read
+	 * positionally from _stream, several can be used at once, and the GFF4's
+	 * absolute offsets stay valid within them. */
+	return new Common::SeekableSubReadStream(_stream.get(), 0, _stream->size());
 }
 
 uint32 GFF4File::getDataOffset() const {
@@ -329,7 +330,7 @@ GFF4Struct::Field::~Field() {
 
 
 GFF4Struct::GFF4Struct(GFF4File &parent, uint32 offset, const GFF4File::StructTemplate &tmplt) :
-	_parent(&parent), _label(tmplt.label), _refCount(0), _fieldCount(0) {
+	_parent(&parent), _label(tmplt.label), _refCount(0), _fieldCount(0), _stream(parent.createStream()) {
 
 	// Constructor for a real struct, from a template
 
@@ -345,7 +346,7 @@ GFF4Struct::GFF4Struct(GFF4File &parent, uint32 offset, const GFF4File::StructTe
 }
 
 GFF4Struct::GFF4Struct(GFF4File &parent, const Field &genericParent) :
-	_parent(&parent), _label(0), _refCount(0), _fieldCount(0) {
+	_parent(&parent), _label(0), _refCount(0), _fieldCount(0), _stream(parent.createStream()) {
 
 	// Constructor for a generic, converted into a struct
 
@@ -430,7 +431,7 @@ void GFF4Struct::loadStructs(GFF4File &parent, Field &field) {
 
 	const GFF4File::StructTemplate &tmplt = parent.getStructTemplate(field.structIndex);
 
-	Common::SeekableReadStream &data = parent.getStream(field.offset);
+	Common::SeekableReadStream &data = getStream(field.offset);
 
 	const uint32 structCount = getListCount(data, field);
 	const uint32 structSize  = field.isReference ? 4 : tmplt.size;
@@ -477,7 +478,7 @@ void GFF4Struct::load(GFF4File &parent, const Field &genericParent) {
 
 	static const uint32 kGenericSize = 8;
 
-	Common::SeekableReadStream &data = parent.getStream(genericParent.offset);
+	Common::SeekableReadStream &data = getStream(genericParent.offset);
 
 	const uint32 genericCount = genericParent.isList ? data.readUint32LE() : 1;
 	const uint32 genericStart = data.pos();
@@ -563,6 +564,12 @@ bool GFF4Struct::getFieldProperties(uint32 field, FieldType &type, uint32 &label
 
 // --- Field value reader helpers ---
 
+Common::SeekableReadStream &GFF4Struct::getStream(uint32 offset) const {
+	_stream->seek(offset);
+
+	return *_stream;
+}
+
 const GFF4Struct::Field *GFF4Struct::getField(uint32 field) const {
 	FieldMap::const_iterator f = _fields.find(field);
 	if (f == _fields.end())
@@ -575,7 +582,7 @@ uint32 GFF4Struct::getDataOffset(bool isReference, uint32 offset) const {
 	if (!isReference || (offset == 0xFFFFFFFF))
 		return offset;
 
-	Common::SeekableReadStream &data = _parent->getStream(offset);
+	Common::SeekableReadStream &data = getStream(offset);
 
 	offset = data.readUint32LE();
 	if (offset == 0xFFFFFFFF)
@@ -596,7 +603,7 @@ Common::SeekableReadStream *GFF4Struct::getData(const Field &field) const {
 	if (offset == 0xFFFFFFFF)
 		return 0;
 
-	return &_parent->getStream(offset);
+	return &getStream(offset);
 }
 
 Common::SeekableReadStream *GFF4Struct::getField(uint32 fieldID, const Field *&field) const {
@@ -1349,7 +1356,7 @@ Common::SeekableReadStream *GFF4Struct::getData(uint32 field) const {
 		throw Common::Exception("Invalid data offset (%u, %u, %u)",
 		                        (uint) dataBegin, (uint) dataSize, (uint) data->size());
 
-	return new Common::SeekableSubReadStream(data, dataBegin, dataEnd);
+	return new Common::SeekableSubReadStream(_parent->_stream.get(), dataBegin, dataEnd);
 }
 
 } // End of namespace Aurora
@@ -170,7 +170,12 @@ private:
 	void unregisterStruct(uint64 id);
 	GFF4Struct *findStruct(uint64 id);
 
-	Common::SeekableReadStream &getStream(uint32 offset) const;
+	/** Return a new stream over the whole GFF4, owned by the caller.
+	 *
+	 *  The returned streams are independent of each other and of the
+	 *  GFF4's own stream.
+	 */
+	Common::SeekableReadStream *createStream() const;
 	const StructTemplate &getStructTemplate(uint32 i) const;
 	uint32 getDataOffset() const;
 
@@ -360,6 +365,9 @@ private:
 	/** The labels of all fields in this struct. */
 	std::vector<uint32> _fieldLabels;
 
+	/** Our own cursor over the GFF4, to read the field data with. */
+	Common::ScopedPtr<Common::SeekableReadStream> _stream;
+
 
 	// .--- Loader
 	/** Load a GFF4 struct. */
@@ -383,6 +391,9 @@ private:
 	uint32 getDataOffset(bool isReference, uint32 offset) const;
 	uint32 getDataOffset(const Field &field) const;
 
+	/** Return our stream, positioned at this offset. */
+	Common::SeekableReadStream &getStream(uint32 offset) const;
+
 	Common::SeekableReadStream *getData(const Field &field) const;
 	Common::SeekableReadStream *getField(uint32 fieldID, const Field *&field) const;
 	// '---
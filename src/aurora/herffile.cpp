@@ -28,6 +28,7 @@
 #include "src/common/error.h"
 #include "src/common/filepath.h"
 #include "src/common/memreadstream.h"
+#include "src/common/mappedfile.h"
 #include "src/common/encoding.h"
 #include "src/common/hash.h"
 
@@ -159,12 +160,26 @@ uint32 HERFFile::getResourceSize(uint32 index) const {
 Common::SeekableReadStream *HERFFile::getResource(uint32 index, bool tryNoCopy) const {
 	const IResource &res = getIResource(index);
 
-	if (tryNoCopy)
+	if (tryNoCopy) {
+		Common::SeekableReadStream *view = Common::createMemoryView(*_herf, res.offset, res.offset + res.size);
+		if (view)
+			return view;
+
 		return new Common::SeekableSubReadStream(_herf.get(), res.offset, res.offset + res.size);
+	}
+
+	return _herf->readStreamAt(res.offset, res.size);
+}
+
+bool HERFFile::getResourceLocation(uint32 index, Location &location) const {
+	const IResource &res = getIResource(index);
 
-	_herf->seek(res.offset);
+	location.stream = _herf.get();
+	location.offset = res.offset;
+	location.size   = res.size;
+	location.raw    = true;
 
-	return _herf->readStream(res.size);
+	return true;
 }
 
 Common::HashAlgo HERFFile::getNameHashAlgo() const {
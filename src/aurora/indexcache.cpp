@@ -0,0 +1,430 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A persistent on-disk cache of directory trees and archive resource tables.
+ */
+
+/* The cache file is a simple little-endian binary file:
+ *
+ * - Header: tag "PIDX", version, root path
+ * - Tree: a flag whether a tree follows, then all entries in preorder,
+ *   each with its name, directory flag, size, modification time and
+ *   number of children
+ * - Archives: the number of archives, then for each archive its path,
+ *   size, modification time and name hash algorithm, its data files
+ *   (name, path, size, modification time) and its resources (name,
+ *   hash, type, index, size, data file index)
+ *
+ * All strings are stored as a uint32 byte length followed by UTF-8 data.
+ */
+
+#include <cstdio>
+#include <cstring>
+
+#include "src/common/util.h"
+#include "src/common/error.h"
+#include "src/common/scopedptr.h"
+#include "src/common/filepath.h"
+#include "src/common/mappedfile.h"
+#include "src/common/writefile.h"
+#include "src/common/encoding.h"
+
+#include "src/aurora/indexcache.h"
+#include "src/aurora/keyfile.h"
+
+static const uint32 kIndexCacheID      = MKTAG('P', 'I', 'D', 'X');
+static const uint32 kIndexCacheVersion = 1;
+
+namespace Aurora {
+
+IndexCache::ArchiveTable::ArchiveTable() : size(Common::kFileInvalid), mtime(-1), nameHashAlgo(Common::kHashNone) {
+}
+
+
+static uint64 getFileSize(const Common::UString &path) {
+	if (!Common::FilePath::isRegularFile(path))
+		return Common::kFileInvalid;
+
+	return Common::FilePath::getFileSize(path);
+}
+
+static void writeString(Common::WriteStream &stream, const Common::UString &str) {
+	const uint32 length = std::strlen(str.c_str());
+
+	stream.writeUint32LE(length);
+	stream.write(str.c_str(), length);
+}
+
+static Common::UString readString(Common::SeekableReadStream &stream) {
+	const uint32 length = stream.readUint32LE();
+	if (length > (stream.size() - stream.pos()))
+		throw Common::Exception(Common::kReadError);
+
+	return Common::readStringFixed(stream, Common::kEncodingUTF8, length);
+}
+
+/** Read a count of elements, making sure that many could actually fit into the stream. */
+static uint32 readCount(Common::SeekableReadStream &stream) {
+	const uint32 count = stream.readUint32LE();
+	if (count > (stream.size() - stream.pos()))
+		throw Common::Exception(Common::kReadError);
+
+	return count;
+}
+
+static void writeEntry(Common::WriteStream &stream, const Common::FileTree::Entry &entry) {
+	writeString(stream, entry.name);
+
+	stream.writeByte(entry.directory ? 1 : 0);
+	stream.writeUint64LE(entry.size);
+	stream.writeSint64LE(entry.mtime);
+
+	stream.writeUint32LE(entry.children.size());
+	for (std::list<Common::FileTree::Entry>::const_iterator c = entry.children.begin(); c != entry.children.end(); ++c)
+		writeEntry(stream, *c);
+}
+
+/** Read an entry. The path of the root entry has to be set beforehand, all
+ *  other entries get their path from the path of the parent and their name. */
+static void readEntry(Common::SeekableReadStream &stream, Common::FileTree::Entry &entry,
+                      const Common::FileTree::Entry *parent = 0) {
+
+	entry.name = readString(stream);
+	if (parent)
+		entry.path = parent->path / entry.name.c_str();
+
+	entry.directory = stream.readByte() != 0;
+	entry.size      = stream.readUint64LE();
+	entry.mtime     = stream.readSint64LE();
+
+	const uint32 childCount = readCount(stream);
+	for (uint32 i = 0; i < childCount; i++) {
+		entry.children.push_back(Common::FileTree::Entry());
+
+		Common::FileTree::Entry &child = entry.children.back();
+		readEntry(stream, child, &entry);
+	}
+}
+
+/** Is this cached directory (and all directories below it) still up-to-date?
+ *
+ *  Adding, removing or renaming a file changes the modification time of the
+ *  directory it's in, so only directories need to be checked. Rewriting a file
+ *  in place doesn't, but archives are checked by their own size and modification
+ *  time once they're opened (see IndexCache::getArchiveTable()).
+ */
+static bool isDirectoryValid(const Common::FileTree::Entry &directory) {
+	if (directory.mtime != Common::FilePath::getModificationTime(directory.path.generic_string()))
+		return false;
+
+	for (std::list<Common::FileTree::Entry>::const_iterator c = directory.children.begin(); c != directory.children.end(); ++c)
+		if (c->directory && !isDirectoryValid(*c))
+			return false;
+
+	return true;
+}
+
+static bool isTreeValid(const Common::FileTree::Entry &root) {
+	if (root.directory)
+		return isDirectoryValid(root);
+
+	// Only a single file was opened
+	const Common::UString path = root.path.generic_string();
+
+	return (root.size  == getFileSize(path)) &&
+	       (root.mtime == Common::FilePath::getModificationTime(path));
+}
+
+
+IndexCache::IndexCache(const Common::UString &rootPath, const Common::UString &cacheFile) :
+	_rootPath(Common::FilePath::normalize(rootPath)), _cacheFile(cacheFile), _hasTree(false), _treeRef(0), _changed(false) {
+
+	if (_rootPath.empty())
+		_rootPath = rootPath;
+
+	if (_cacheFile.empty())
+		_cacheFile = getCacheFile(_rootPath);
+
+	load();
+}
+
+IndexCache::~IndexCache() {
+}
+
+const Common::UString &IndexCache::getRootPath() const {
+	return _rootPath;
+}
+
+Common::UString IndexCache::getCacheFile(const Common::UString &rootPath) {
+	const uint64 hash = Common::hashStringFNV64(Common::FilePath::normalize(rootPath));
+
+	return Common::FilePath::getUserDataFile(Common::UString::format("phaethon/indexcache/%016llX.idx",
+	                                                                 (unsigned long long) hash));
+}
+
+bool IndexCache::getTree(Common::FileTree &tree) {
+	if (!_hasTree || !isTreeValid(_tree))
+		return false;
+
+	tree.setRoot(std::move(_tree));
+
+	_hasTree = false;
+	_tree    = Common::FileTree::Entry();
+	_treeRef = &tree;
+
+	return true;
+}
+
+void IndexCache::setTree(const Common::FileTree &tree) {
+	_hasTree = false;
+	_tree    = Common::FileTree::Entry();
+	_treeRef = &tree;
+
+	_changed = true;
+}
+
+static bool isDataFileValid(const IndexCache::DataFile &dataFile) {
+	return (dataFile.size  == getFileSize(dataFile.path)) &&
+	       (dataFile.mtime == Common::FilePath::getModificationTime(dataFile.path));
+}
+
+const IndexCache::ArchiveTable *IndexCache::getArchiveTable(const Common::UString &path) const {
+	ArchiveMap::const_iterator a = _archives.find(path);
+	if (a == _archives.end())
+		return 0;
+
+	const ArchiveTable &table = *a->second;
+	if ((table.size  != getFileSize(path)) ||
+	    (table.mtime != Common::FilePath::getModificationTime(path)))
+		return 0;
+
+	for (std::vector<DataFile>::const_iterator d = table.dataFiles.begin(); d != table.dataFiles.end(); ++d)
+		if (!isDataFileValid(*d))
+			return 0;
+
+	return &table;
+}
+
+const IndexCache::ArchiveTable *IndexCache::addArchive(const Common::UString &path, const Archive &archive) {
+	Common::ScopedPtr<ArchiveTable> table(new ArchiveTable);
+
+	table->size  = getFileSize(path);
+	table->mtime = Common::FilePath::getModificationTime(path);
+
+	table->nameHashAlgo = archive.getNameHashAlgo();
+	table->resources    = archive.getResources();
+
+	uint32 resourceCount = 0;
+	for (Archive::ResourceList::const_iterator r = table->resources.begin(); r != table->resources.end(); ++r)
+		resourceCount = MAX<uint32>(resourceCount, r->index + 1);
+
+	table->resourceSizes.resize(resourceCount, 0xFFFFFFFF);
+	for (Archive::ResourceList::const_iterator r = table->resources.begin(); r != table->resources.end(); ++r)
+		table->resourceSizes[r->index] = archive.getResourceSize(r->index);
+
+	const KEYFile *key = dynamic_cast<const KEYFile *>(&archive);
+	if (key) {
+		const Common::UString keyDirectory = Common::FilePath::getDirectory(path);
+
+		const std::vector<Common::UString> &dataFiles = key->getDataFileList();
+		for (std::vector<Common::UString>::const_iterator d = dataFiles.begin(); d != dataFiles.end(); ++d) {
+			DataFile dataFile;
+
+			dataFile.name  = *d;
+			dataFile.path  = keyDirectory + "/" + *d;
+			dataFile.size  = getFileSize(dataFile.path);
+			dataFile.mtime = Common::FilePath::getModificationTime(dataFile.path);
+
+			table->dataFiles.push_back(dataFile);
+		}
+
+		table->dataFileIndices.resize(resourceCount, 0xFFFFFFFF);
+		for (Archive::ResourceList::const_iterator r = table->resources.begin(); r != table->resources.end(); ++r)
+			table->dataFileIndices[r->index] = key->getDataFileIndex(r->index);
+	}
+
+	ArchiveMap::iterator a = _archives.find(path);
+	if (a != _archives.end())
+		_archives.erase(a);
+
+	_changed = true;
+
+	return _archives.insert(std::make_pair(path, table.release())).first->second;
+}
+
+void IndexCache::load() {
+	if (!Common::FilePath::isRegularFile(_cacheFile))
+		return;
+
+	Common::MappedFile cache;
+	if (!cache.open(_cacheFile))
+		return;
+
+	try {
+		load(cache);
+	} catch (...) {
+		// A broken or outdated cache is not an error, we just start over
+		_hasTree = false;
+		_tree    = Common::FileTree::Entry();
+
+		_archives.clear();
+	}
+}
+
+void IndexCache::load(Common::SeekableReadStream &cache) {
+	if ((cache.readUint32BE() != kIndexCacheID) || (cache.readUint32LE() != kIndexCacheVersion))
+		throw Common::Exception("Not a current index cache file");
+
+	if (readString(cache) != _rootPath)
+		throw Common::Exception("Index cache file is for a different path");
+
+	_hasTree = cache.readByte() != 0;
+	if (_hasTree) {
+		_tree.path = _rootPath.c_str();
+		readEntry(cache, _tree);
+	}
+
+	const uint32 archiveCount = readCount(cache);
+	for (uint32 i = 0; i < archiveCount; i++) {
+		const Common::UString path = readString(cache);
+
+		Common::ScopedPtr<ArchiveTable> table(new ArchiveTable);
+
+		table->size  = cache.readUint64LE();
+		table->mtime = cache.readSint64LE();
+
+		table->nameHashAlgo = (Common::HashAlgo) cache.readSint32LE();
+
+		const uint32 dataFileCount = readCount(cache);
+		table->dataFiles.resize(dataFileCount);
+
+		for (std::vector<DataFile>::iterator d = table->dataFiles.begin(); d != table->dataFiles.end(); ++d) {
+			d->name  = readString(cache);
+			d->path  = readString(cache);
+			d->size  = cache.readUint64LE();
+			d->mtime = cache.readSint64LE();
+		}
+
+		const uint32 resourceCount = readCount(cache);
+
+		table->resourceSizes.resize(resourceCount, 0xFFFFFFFF);
+		if (dataFileCount > 0)
+			table->dataFileIndices.resize(resourceCount, 0xFFFFFFFF);
+
+		for (uint32 j = 0; j < resourceCount; j++) {
+			table->resources.push_back(Archive::Resource());
+			Archive::Resource &res = table->resources.back();
+
+			res.name  = readString(cache);
+			res.hash  = cache.readUint64LE();
+			res.type  = (FileType) cache.readSint32LE();
+			res.index = cache.readUint32LE();
+
+			if (res.index >= resourceCount)
+				throw Common::Exception("Resource index out of range (%u/%u)", res.index, resourceCount);
+
+			table->resourceSizes[res.index] = cache.readUint32LE();
+
+			const uint32 dataFileIndex = cache.readUint32LE();
+			if (dataFileCount > 0)
+				table->dataFileIndices[res.index] = dataFileIndex;
+		}
+
+		_archives.insert(std::make_pair(path, table.release()));
+	}
+}
+
+void IndexCache::save() {
+	if (!_changed)
+		return;
+
+	Common::FilePath::createDirectories(Common::FilePath::getDirectory(_cacheFile));
+
+	// Write into a temporary file first, so that we never leave a half-written cache behind
+	const Common::UString tmpFile = _cacheFile + ".tmp";
+
+	try {
+		Common::WriteFile cache(tmpFile);
+
+		save(cache);
+
+		cache.flush();
+		cache.close();
+
+		Common::FilePath::renameFile(tmpFile, _cacheFile);
+
+	} catch (Common::Exception &e) {
+		std::remove(tmpFile.c_str());
+
+		e.add("Failed to write index cache \"%s\"", _cacheFile.c_str());
+		throw;
+	}
+
+	_changed = false;
+}
+
+void IndexCache::save(Common::WriteStream &cache) const {
+	cache.writeUint32BE(kIndexCacheID);
+	cache.writeUint32LE(kIndexCacheVersion);
+
+	writeString(cache, _rootPath);
+
+	const Common::FileTree::Entry *tree = _treeRef ? &_treeRef->getRoot() : (_hasTree ? &_tree : 0);
+
+	cache.writeByte(tree ? 1 : 0);
+	if (tree)
+		writeEntry(cache, *tree);
+
+	cache.writeUint32LE(_archives.size());
+	for (ArchiveMap::const_iterator a = _archives.begin(); a != _archives.end(); ++a) {
+		const ArchiveTable &table = *a->second;
+
+		writeString(cache, a->first);
+
+		cache.writeUint64LE(table.size);
+		cache.writeSint64LE(table.mtime);
+
+		cache.writeSint32LE(table.nameHashAlgo);
+
+		cache.writeUint32LE(table.dataFiles.size());
+		for (std::vector<DataFile>::const_iterator d = table.dataFiles.begin(); d != table.dataFiles.end(); ++d) {
+			writeString(cache, d->name);
+			writeString(cache, d->path);
+
+			cache.writeUint64LE(d->size);
+			cache.writeSint64LE(d->mtime);
+		}
+
+		cache.writeUint32LE(table.resources.size());
+		for (Archive::ResourceList::const_iterator r = table.resources.begin(); r != table.resources.end(); ++r) {
+			writeString(cache, r->name);
+
+			cache.writeUint64LE(r->hash);
+			cache.writeSint32LE(r->type);
+			cache.writeUint32LE(r->index);
+
+			cache.writeUint32LE(table.resourceSizes[r->index]);
+			cache.writeUint32LE(table.dataFileIndices.empty() ? 0xFFFFFFFF : table.dataFileIndices[r->index]);
+		}
+	}
+}
+
+} // End of namespace Aurora
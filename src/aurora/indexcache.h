@@ -0,0 +1,170 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A persistent on-disk cache of directory trees and archive resource tables.
+ */
+
+#ifndef AURORA_INDEXCACHE_H
+#define AURORA_INDEXCACHE_H
+
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+#include "src/common/types.h"
+#include "src/common/ustring.h"
+#include "src/common/hash.h"
+#include "src/common/ptrmap.h"
+#include "src/common/filetree.h"
+
+#include "src/aurora/archive.h"
+
+namespace Common {
+	class SeekableReadStream;
+	class WriteStream;
+}
+
+namespace Aurora {
+
+/** A persistent, on-disk cache of the contents of a game directory.
+ *
+ *  The cache stores the directory tree, including file sizes, and the
+ *  resource tables of the archives found within, in a compact binary
+ *  file. Opening the same directory again then neither needs to walk
+ *  the file system nor parse any of the archives again.
+ *
+ *  The cached tree is valid as long as the modification times of all
+ *  its directories are unchanged, so checking it only needs one stat
+ *  per directory. Files rewritten in place aren't noticed there, but
+ *  a cached archive table is only valid as long as the size and
+ *  modification time of the archive file (and, for KEY files, of all
+ *  the data files it indexes) are unchanged, which is checked once the
+ *  archive is opened.
+ *
+ *  A cache file that can't be read, for example because it was written
+ *  by a different version, is silently ignored and will be overwritten.
+ */
+class IndexCache : boost::noncopyable {
+public:
+	/** A data file (BIF/BZF) indexed by a cached KEY file. */
+	struct DataFile {
+		Common::UString name; ///< The name of the data file, as found in the KEY.
+		Common::UString path; ///< The path of the data file on disk.
+
+		uint64 size;  ///< The size of the data file, or Common::kFileInvalid if it doesn't exist.
+		int64  mtime; ///< The modification time of the data file, or -1 if it doesn't exist.
+	};
+
+	/** The cached resource table of one archive file. */
+	struct ArchiveTable {
+		uint64 size;  ///< The size of the archive file.
+		int64  mtime; ///< The modification time of the archive file.
+
+		Common::HashAlgo nameHashAlgo; ///< The algorithm used for hashing resource names.
+
+		Archive::ResourceList resources;   ///< All resources within the archive.
+		std::vector<uint32> resourceSizes; ///< The sizes of all resources, by resource index.
+
+		std::vector<DataFile> dataFiles;     ///< KEY only: the indexed data files.
+		std::vector<uint32> dataFileIndices; ///< KEY only: the data file of each resource, by resource index.
+
+		ArchiveTable();
+	};
+
+	/** Open the cache for this directory (or file), reading the cache file if it exists.
+	 *
+	 *  @param rootPath  The path of the directory (or file) whose contents are cached.
+	 *  @param cacheFile The file the cache is stored in. If empty, getCacheFile()
+	 *                   is used to derive it from the root path.
+	 */
+	IndexCache(const Common::UString &rootPath, const Common::UString &cacheFile = "");
+	~IndexCache();
+
+	/** Return the (normalized) path whose contents are cached. */
+	const Common::UString &getRootPath() const;
+
+	/** Restore the cached directory tree, moving it into this FileTree.
+	 *
+	 *  When saving, the cache then reads the tree from this FileTree,
+	 *  so it has to be kept around, unchanged, as long as the cache lives.
+	 *
+	 *  @return true if a valid tree was cached, false otherwise.
+	 */
+	bool getTree(Common::FileTree &tree);
+	/** Put this directory tree into the cache.
+	 *
+	 *  The tree is not copied, so it has to be kept around, unchanged,
+	 *  as long as the cache lives.
+	 */
+	void setTree(const Common::FileTree &tree);
+
+	/** Return the cached resource table of this archive file.
+	 *
+	 *  @return The table, or 0 if this archive isn't cached or if the cached table is outdated.
+	 */
+	const ArchiveTable *getArchiveTable(const Common::UString &path) const;
+
+	/** Read the resource table of this archive into the cache.
+	 *
+	 *  For KEY files, the data files need to be already added to the
+	 *  archive, since their resource sizes are read as well. The data
+	 *  files are looked for relative to the KEY file's directory.
+	 *
+	 *  The returned table stays valid until this archive is added again,
+	 *  or until the cache is destroyed.
+	 *
+	 *  @param  path    The path of the archive file.
+	 *  @param  archive The archive, opened on this archive file.
+	 *  @return The new table of this archive.
+	 */
+	const ArchiveTable *addArchive(const Common::UString &path, const Archive &archive);
+
+	/** Write the cache file, if anything has changed since it was read. */
+	void save();
+
+	/** Return the path of the cache file for the contents of this directory (or file). */
+	static Common::UString getCacheFile(const Common::UString &rootPath);
+
+private:
+	typedef Common::PtrMap<Common::UString, ArchiveTable> ArchiveMap;
+
+	Common::UString _rootPath;
+	Common::UString _cacheFile;
+
+	/** The tree read from the cache file, until it's handed out by getTree(). */
+	bool _hasTree;
+	Common::FileTree::Entry _tree;
+
+	/** The tree handed out by getTree() or given to setTree(). */
+	const Common::FileTree *_treeRef;
+
+	ArchiveMap _archives;
+
+	bool _changed;
+
+	void load();
+	void load(Common::SeekableReadStream &cache);
+	void save(Common::WriteStream &cache) const;
+};
+
+} // End of namespace Aurora
+
+#endif // AURORA_INDEXCACHE_H
@@ -22,6 +22,7 @@
  *  Data files containing resources indexed in BioWare's KEY files.
  */
 
+#include "src/common/system.h"
 #include "src/common/error.h"
 
 #include "src/aurora/keydatafile.h"
@@ -42,6 +43,10 @@ uint32 KEYDataFile::getResourceSize(uint32 index) const {
 	return getRes(index).size;
 }
 
+bool KEYDataFile::getResourceLocation(uint32 UNUSED(index), Archive::Location &UNUSED(location)) const {
+	return false;
+}
+
 const KEYDataFile::Resource &KEYDataFile::getRes(uint32 index) const {
 	if (index >= _resources.size())
 		throw Common::Exception("Resource index out of range (%u/%u)", index, (uint)_resources.size());
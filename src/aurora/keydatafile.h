@@ -32,6 +32,7 @@
 #include "src/common/types.h"
 
 #include "src/aurora/types.h"
+#include "src/aurora/archive.h"
 
 namespace Common {
 	class SeekableReadStream;
@@ -51,8 +52,19 @@ public:
 	/** Return the size of a resource. */
 	uint32 getResourceSize(uint32 index) const;
 
-	/** Return a stream of the resource's contents. */
-	virtual Common::SeekableReadStream *getResource(uint32 index) const = 0;
+	/** Return a stream of the resource's contents.
+	 *
+	 *  @param  index The index of the resource we want.
+	 *  @param  tryNoCopy Try to return a view into the data file instead of copying.
+	 *  @return A (sub)stream of the resource's contents.
+	 */
+	virtual Common::SeekableReadStream *getResource(uint32 index, bool tryNoCopy = false) const = 0;
+
+	/** Find where the data of a resource is stored.
+	 *
+	 *  @see Archive::getResourceLocation()
+	 */
+	virtual bool getResourceLocation(uint32 index, Archive::Location &location) const;
 
 protected:
 	/** Resource information. */
@@ -0,0 +1,137 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A bounded cache of opened KEY data files.
+ */
+
+#include "src/common/util.h"
+#include "src/common/error.h"
+
+#include "src/aurora/keydatafilecache.h"
+#include "src/aurora/keydatafile.h"
+
+namespace Aurora {
+
+KEYDataFileCache::KEYDataFileCache(const Opener &opener, size_t capacity) :
+	_opener(opener), _capacity(MAX<size_t>(capacity, 1)) {
+
+}
+
+KEYDataFileCache::~KEYDataFileCache() {
+}
+
+size_t KEYDataFileCache::getCapacity() const {
+	return _capacity;
+}
+
+size_t KEYDataFileCache::getOpenCount() const {
+	boost::lock_guard<boost::mutex> lock(_mutex);
+
+	return _entries.size();
+}
+
+KEYDataFileCache::DataFilePtr KEYDataFileCache::getDataFile(const Common::UString &name) {
+	{
+		boost::unique_lock<boost::mutex> lock(_mutex);
+
+		while (true) {
+			EntryMap::iterator entry = _entryMap.find(name);
+			if (entry != _entryMap.end()) {
+				// Move it to the front of the list, as the most recently used data file
+				_entries.splice(_entries.begin(), _entries, entry->second);
+
+				return entry->second->second;
+			}
+
+			FailureMap::const_iterator f = _failures.find(name);
+			if (f != _failures.end())
+				throw Common::Exception("Failed to open KEY data file \"%s\": %s", name.c_str(), f->second.c_str());
+
+			// Nobody else is opening it, so it's our job
+			if (_opening.find(name) == _opening.end())
+				break;
+
+			_opened.wait(lock);
+		}
+
+		_opening.insert(name);
+	}
+
+	// Open the data file without holding the lock, so that other data files stay accessible
+	DataFilePtr dataFile;
+	try {
+		dataFile.reset(_opener(name));
+		if (!dataFile)
+			throw Common::Exception("No such KEY data file");
+
+	} catch (Common::Exception &e) {
+		{
+			boost::lock_guard<boost::mutex> lock(_mutex);
+
+			_failures.insert(std::make_pair(name, Common::UString(e.what())));
+			_opening.erase(name);
+		}
+		_opened.notify_all();
+
+		e.add("Failed to open KEY data file \"%s\"", name.c_str());
+		throw;
+
+	} catch (...) {
+		{
+			boost::lock_guard<boost::mutex> lock(_mutex);
+
+			_opening.erase(name);
+		}
+		_opened.notify_all();
+
+		throw;
+	}
+
+	{
+		boost::lock_guard<boost::mutex> lock(_mutex);
+
+		_opening.erase(name);
+		addEntry(name, dataFile);
+	}
+	_opened.notify_all();
+
+	return dataFile;
+}
+
+void KEYDataFileCache::addEntry(const Common::UString &name, const DataFilePtr &dataFile) {
+	while (_entries.size() >= _capacity) {
+		_entryMap.erase(_entries.back().first);
+		_entries.pop_back();
+	}
+
+	_entries.push_front(std::make_pair(name, dataFile));
+	_entryMap.insert(std::make_pair(name, _entries.begin()));
+}
+
+void KEYDataFileCache::clear() {
+	boost::lock_guard<boost::mutex> lock(_mutex);
+
+	_entryMap.clear();
+	_entries.clear();
+	_failures.clear();
+}
+
+} // End of namespace Aurora
@@ -0,0 +1,123 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A bounded cache of opened KEY data files.
+ */
+
+#ifndef AURORA_KEYDATAFILECACHE_H
+#define AURORA_KEYDATAFILECACHE_H
+
+#include <list>
+#include <memory>
+#include <functional>
+
+#include <boost/noncopyable.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+#include "src/common/types.h"
+#include "src/common/ustring.h"
+
+namespace Aurora {
+
+class KEYDataFile;
+
+/** A cache of opened KEY data files (BIF/BZF).
+ *
+ *  Data files are only opened once a resource within them is accessed,
+ *  and at most a fixed number of them is kept open at the same time.
+ *  When that limit is reached, the data file that was used least
+ *  recently is closed again. That way, opening a KEY file is fast, and
+ *  the number of open file handles stays bounded even in installations
+ *  with hundreds of data files.
+ *
+ *  Data files are handed out as shared pointers, so a data file that is
+ *  still in use stays valid even if the cache evicts it.
+ *
+ *  If a data file failed to open, the failure is remembered, and later
+ *  requests for the same data file throw again without retrying.
+ *
+ *  Data files are opened without holding the cache's lock, so a slow
+ *  open doesn't block requests for other data files. Concurrent requests
+ *  for a data file that is currently being opened wait for that open to
+ *  finish instead of opening it a second time.
+ */
+class KEYDataFileCache : boost::noncopyable {
+public:
+	typedef std::shared_ptr<KEYDataFile> DataFilePtr;
+
+	/** A function opening a data file, by its name as found in the KEY file. */
+	typedef std::function<KEYDataFile *(const Common::UString &name)> Opener;
+
+	static const size_t kDefaultCapacity = 32;
+
+	KEYDataFileCache(const Opener &opener, size_t capacity = kDefaultCapacity);
+	~KEYDataFileCache();
+
+	/** Return the maximum number of data files kept open. */
+	size_t getCapacity() const;
+	/** Return the number of data files currently held open by the cache. */
+	size_t getOpenCount() const;
+
+	/** Return this data file, opening it if necessary.
+	 *
+	 *  Throws an exception if the data file can't be opened.
+	 */
+	DataFilePtr getDataFile(const Common::UString &name);
+
+	/** Close all data files and forget about failures. */
+	void clear();
+
+private:
+	typedef std::pair<Common::UString, DataFilePtr> Entry;
+	typedef std::list<Entry> EntryList;
+
+	typedef boost::unordered_map<Common::UString, EntryList::iterator, Common::hashUStringCaseSensitive> EntryMap;
+	typedef boost::unordered_map<Common::UString, Common::UString, Common::hashUStringCaseSensitive> FailureMap;
+	typedef boost::unordered_set<Common::UString, Common::hashUStringCaseSensitive> NameSet;
+
+	Opener _opener;
+	size_t _capacity;
+
+	/** All open data files, most recently used first. */
+	EntryList _entries;
+	/** Data file name to place in the list. */
+	EntryMap _entryMap;
+
+	/** Data files that failed to open, with the reason. */
+	FailureMap _failures;
+
+	/** Data files currently being opened by some thread. */
+	NameSet _opening;
+
+	mutable boost::mutex _mutex;
+	/** Signaled whenever a data file finished opening, successfully or not. */
+	boost::condition_variable _opened;
+
+	/** Put this open data file at the front of the list, evicting the least recently used. */
+	void addEntry(const Common::UString &name, const DataFilePtr &dataFile);
+};
+
+} // End of namespace Aurora
+
+#endif // AURORA_KEYDATAFILECACHE_H
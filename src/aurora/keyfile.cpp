@@ -35,6 +35,7 @@
 
 #include "src/aurora/keyfile.h"
 #include "src/aurora/keydatafile.h"
+#include "src/aurora/keydatafilecache.h"
 
 static const uint32 kKEYID     = MKTAG('K', 'E', 'Y', ' ');
 static const uint32 kVersion1  = MKTAG('V', '1', ' ', ' ');
@@ -42,7 +43,7 @@ static const uint32 kVersion11 = MKTAG('V', '1', '.', '1');
 
 namespace Aurora {
 
-KEYFile::KEYFile(Common::SeekableReadStream *key) {
+KEYFile::KEYFile(Common::SeekableReadStream *key) : _dataFileCache(0) {
 	Common::ScopedPtr<Common::SeekableReadStream> keyStream(key);
 
 	load(*keyStream);
@@ -52,29 +53,41 @@ KEYFile::~KEYFile() {
 }
 
 bool KEYFile::haveDataFile(uint32 index) const {
-	return getIResource(index).dataFile != 0;
+	const IResource &iRes = getIResource(index);
+
+	return (iRes.dataFile != 0) || (_dataFileCache && (iRes.dataFileIndex < _dataFiles.size()));
+}
+
+uint32 KEYFile::getDataFileIndex(uint32 index) const {
+	return getIResource(index).dataFileIndex;
 }
 
 void KEYFile::addDataFile(uint32 dataFileIndex, KEYDataFile *dataFile) {
 	if (!dataFile)
 		throw Common::Exception("KEYFile::addDataFile(): dataFile == 0");
 
-	ResourceList::iterator   res = _resources.begin();
-	IResourceList::iterator iRes = _iResources.begin();
-	for (; (res != _resources.end()) && (iRes != _iResources.end()); ++res, ++iRes) {
-		// Merge information for all resources where the data file index matches
-		if (iRes->dataFileIndex != dataFileIndex)
-			continue;
+	if (dataFileIndex >= _dataFileResources.size())
+		return;
+
+	// Merge information for all resources within this data file
+	const std::vector<const Resource *> &resources = _dataFileResources[dataFileIndex];
+	for (std::vector<const Resource *>::const_iterator r = resources.begin(); r != resources.end(); ++r) {
+		const Resource &res = **r;
+		IResource &iRes = _iResources[res.index];
 
-		if (res->type != dataFile->getResourceType(iRes->resIndex))
+		if (res.type != dataFile->getResourceType(iRes.resIndex))
 			throw Common::Exception("Resource type doesn't match in data file (%d, %d, %d, %d, %d)",
-			                        res->index, iRes->dataFileIndex, iRes->resIndex,
-			                        res->type, dataFile->getResourceType(iRes->resIndex));
+			                        res.index, iRes.dataFileIndex, iRes.resIndex,
+			                        res.type, dataFile->getResourceType(iRes.resIndex));
 
-		iRes->dataFile = dataFile;
+		iRes.dataFile = dataFile;
 	}
 }
 
+void KEYFile::setDataFileCache(KEYDataFileCache *cache) {
+	_dataFileCache = cache;
+}
+
 const std::vector<Common::UString> &KEYFile::getDataFileList() const {
 	return _dataFiles;
 }
@@ -159,6 +172,8 @@ void KEYFile::readResList(Common::SeekableReadStream &key, uint32 offset) {
 		res->type  = (FileType) key.readUint16LE();
 		res->index = index;
 
+		iRes->type = res->type;
+
 		uint32 id = key.readUint32LE();
 
 		// The new flags field holds the data file index now. The rest contains fixed
@@ -172,6 +187,15 @@ void KEYFile::readResList(Common::SeekableReadStream &key, uint32 offset) {
 		// TODO: Fixed resources?
 		iRes->resIndex = id & 0xFFFFF;
 	}
+
+	// Sort the resources into buckets by data file, so that we don't have to look through them all again
+	_dataFileResources.resize(_dataFiles.size());
+
+	res  = _resources.begin();
+	iRes = _iResources.begin();
+	for (; (res != _resources.end()) && (iRes != _iResources.end()); ++res, ++iRes)
+		if (iRes->dataFileIndex < _dataFileResources.size())
+			_dataFileResources[iRes->dataFileIndex].push_back(&*res);
 }
 
 const Archive::ResourceList &KEYFile::getResources() const {
@@ -185,35 +209,76 @@ const KEYFile::IResource &KEYFile::getIResource(uint32 index) const {
 	return _iResources[index];
 }
 
+std::shared_ptr<KEYDataFile> KEYFile::getCachedDataFile(uint32 index, const IResource &iRes) const {
+	if (!_dataFileCache || (iRes.dataFileIndex >= _dataFiles.size()))
+		throw Common::Exception("Data files for resource %d missing", index);
+
+	std::shared_ptr<KEYDataFile> dataFile = _dataFileCache->getDataFile(_dataFiles[iRes.dataFileIndex]);
+
+	if (iRes.type != dataFile->getResourceType(iRes.resIndex))
+		throw Common::Exception("Resource type doesn't match in data file (%d, %d, %d, %d, %d)",
+		                        index, iRes.dataFileIndex, iRes.resIndex,
+		                        iRes.type, dataFile->getResourceType(iRes.resIndex));
+
+	return dataFile;
+}
+
 uint32 KEYFile::getResourceSize(uint32 index) const {
 	const IResource &iRes = getIResource(index);
-	if (!iRes.dataFile)
+	if (iRes.dataFile)
+		return iRes.dataFile->getResourceSize(iRes.resIndex);
+
+	if (!_dataFileCache)
 		return 0xFFFFFFFF;
 
-	return iRes.dataFile->getResourceSize(iRes.resIndex);
+	try {
+		return getCachedDataFile(index, iRes)->getResourceSize(iRes.resIndex);
+	} catch (Common::Exception &) {
+		return 0xFFFFFFFF;
+	}
+}
+
+Common::SeekableReadStream *KEYFile::getResource(uint32 index, bool tryNoCopy) const {
+	const IResource &iRes = getIResource(index);
+	if (iRes.dataFile)
+		return iRes.dataFile->getResource(iRes.resIndex, tryNoCopy);
+
+	try {
+		/* The cache might close the data file as soon as we let go of it, so
+		 * the returned stream must not read from the data file anymore. */
+		return getCachedDataFile(index, iRes)->getResource(iRes.resIndex, false);
+	} catch (Common::Exception &e) {
+		if (iRes.dataFileIndex < _dataFiles.size())
+			e.add("Failed to get resource %d from data file \"%s\"", index, _dataFiles[iRes.dataFileIndex].c_str());
+
+		throw;
+	}
 }
 
-Common::SeekableReadStream *KEYFile::getResource(uint32 index, bool UNUSED(tryNoCopy)) const {
+bool KEYFile::getResourceLocation(uint32 index, Location &location) const {
+	// Data files from the cache might be closed again at any time
 	const IResource &iRes = getIResource(index);
 	if (!iRes.dataFile)
-		throw Common::Exception("Data files for resource %d (\"%s\") missing", index,
-		                        _dataFiles[iRes.dataFileIndex].c_str());
+		return false;
 
-	return iRes.dataFile->getResource(iRes.resIndex);
+	return iRes.dataFile->getResourceLocation(iRes.resIndex, location);
 }
 
 std::vector<const Archive::Resource *> KEYFile::getResourceListForDataFile(const Common::UString &dataFile) const {
 	std::vector<const Archive::Resource *> list;
 
-	uint32 i = 0;
-	for (auto it = _resources.begin(); it != _resources.end(); ++it, i++) {
-		if (_dataFiles[getIResource(i).dataFileIndex] != dataFile)
-			continue;
-
-		list.push_back(&(*it));
-	}
+	for (size_t i = 0; i < _dataFiles.size(); i++)
+		if (_dataFiles[i] == dataFile)
+			list.insert(list.end(), _dataFileResources[i].begin(), _dataFileResources[i].end());
 
 	return list;
 }
 
+const std::vector<const Archive::Resource *> &KEYFile::getResourceListForDataFile(uint32 dataFileIndex) const {
+	if (dataFileIndex >= _dataFileResources.size())
+		throw Common::Exception("Data file index out of range (%u/%u)", dataFileIndex, (uint)_dataFileResources.size());
+
+	return _dataFileResources[dataFileIndex];
+}
+
 } // End of namespace Aurora
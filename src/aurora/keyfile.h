@@ -26,6 +26,7 @@
 #define AURORA_KEYFILE_H
 
 #include <vector>
+#include <memory>
 
 #include "src/common/types.h"
 #include "src/common/ustring.h"
@@ -41,6 +42,7 @@ namespace Common {
 namespace Aurora {
 
 class KEYDataFile;
+class KEYDataFileCache;
 
 /** Class to hold resource index information of a KEY file.
  *
@@ -80,12 +82,24 @@ public:
 	 */
 	void addDataFile(uint32 dataFileIndex, KEYDataFile *dataFile);
 
+	/** Open data files that weren't added with addDataFile() through this cache.
+	 *
+	 *  Data files are then only opened once a resource within them is
+	 *  accessed, and might be closed again when the cache evicts them.
+	 *  The cache needs to be kept around as long as the KEYFile object
+	 *  lives, but ownership of the cache is not transferred.
+	 */
+	void setDataFileCache(KEYDataFileCache *cache);
+
 	/** Return the list of data files (BIF/BZF) this KEY file indexes. */
 	const std::vector<Common::UString> &getDataFileList() const;
 
-	/** Do we have a data file associated for this resource? */
+	/** Do we have a data file, or a cache to open it from, associated for this resource? */
 	bool haveDataFile(uint32 index) const;
 
+	/** Return the index into the data file list of the data file containing this resource. */
+	uint32 getDataFileIndex(uint32 index) const;
+
 	/** Return the list of resources. */
 	const ResourceList &getResources() const;
 
@@ -93,8 +107,9 @@ public:
 	 *
 	 *  Note: The size of the resource is stored in data file.
 	 *        If the data files containing this resource's data
-	 *        was not added first with addDataFile(), this method
-	 *        will return 0xFFFFFFFF.
+	 *        was not added first with addDataFile(), and can't
+	 *        be opened through the data file cache either, this
+	 *        method will return 0xFFFFFFFF.
 	 */
 	uint32 getResourceSize(uint32 index) const;
 
@@ -102,17 +117,30 @@ public:
 	 *
 	 *  Note: Since the resource's data is stored in data files,
 	 *        this method will throw an error if the respective
-	 *        data file was not added first with addDataFile().
+	 *        data file was not added first with addDataFile(),
+	 *        and can't be opened through the data file cache.
+	 *
+	 *  Resources from data files opened through the cache are
+	 *  always returned as a copy, ignoring tryNoCopy, since the
+	 *  cache might close the data file while the returned stream
+	 *  is still in use.
 	 */
 	Common::SeekableReadStream *getResource(uint32 index, bool tryNoCopy = false) const;
 
+	/** Return where the resource's data is stored. */
+	bool getResourceLocation(uint32 index, Location &location) const;
+
+	/** Return all resources found in the data file(s) with this name. */
 	std::vector<const Archive::Resource *> getResourceListForDataFile(const Common::UString &dataFile) const;
+	/** Return all resources found in this data file, by index into the data file list. */
+	const std::vector<const Archive::Resource *> &getResourceListForDataFile(uint32 dataFileIndex) const;
 
 private:
 	/** Internal resource information. */
 	struct IResource {
 		uint32 dataFileIndex; ///< Index into the data file list.
 		uint32 resIndex;      ///< Index into the data file's resource table.
+		FileType type;        ///< The resource's type, to check against the data file.
 
 		KEYDataFile *dataFile; ///< The actual data file containing this resource.
 	};
@@ -128,12 +156,21 @@ private:
 	/** All managed data files (BIF/BZF). */
 	std::vector<Common::UString> _dataFiles;
 
+	/** The resources within each data file. */
+	std::vector< std::vector<const Resource *> > _dataFileResources;
+
+	/** Cache to open data files from on demand. */
+	KEYDataFileCache *_dataFileCache;
+
 	void load(Common::SeekableReadStream &key);
 
 	void readDataFileList(Common::SeekableReadStream &key, uint32 offset);
 	void readResList(Common::SeekableReadStream &key, uint32 offset);
 
 	const IResource &getIResource(uint32 index) const;
+
+	/** Open the data file of this resource through the cache. */
+	std::shared_ptr<KEYDataFile> getCachedDataFile(uint32 index, const IResource &iRes) const;
 };
 
 } // End of namespace Aurora
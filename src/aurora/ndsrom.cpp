@@ -30,7 +30,7 @@
 #include "src/common/ustring.h"
 #include "src/common/error.h"
 #include "src/common/memreadstream.h"
-#include "src/common/readfile.h"
+#include "src/common/mappedfile.h"
 #include "src/common/encoding.h"
 
 #include "src/aurora/ndsrom.h"
@@ -39,7 +39,7 @@
 namespace Aurora {
 
 NDSFile::NDSFile(const Common::UString &fileName) {
-	_nds.reset(new Common::ReadFile(fileName));
+	_nds.reset(openArchiveFile(fileName));
 
 	load(*_nds);
 }
@@ -139,13 +139,10 @@ bool NDSFile::isNDS(Common::SeekableReadStream &stream,
 }
 
 bool NDSFile::hasResource(Common::UString name) const {
-	name.makeLower();
+	const FileType type = TypeMan.getFileType(name);
+	name = TypeMan.setFileType(name, kFileTypeNone);
 
-	for (ResourceList::const_iterator r = _resources.begin(); r != _resources.end(); ++r)
-		if (TypeMan.setFileType(r->name, r->type) == name)
-			return true;
-
-	return false;
+	return findResource(name, type) != 0xFFFFFFFF;
 }
 
 const Archive::ResourceList &NDSFile::getResources() const {
@@ -166,14 +163,26 @@ uint32 NDSFile::getResourceSize(uint32 index) const {
 Common::SeekableReadStream *NDSFile::getResource(uint32 index, bool tryNoCopy) const {
 	const IResource &res = getIResource(index);
 
-	_nds->seek(res.offset);
+	if (tryNoCopy) {
+		Common::SeekableReadStream *view = Common::createMemoryView(*_nds, res.offset, res.offset + res.size);
+		if (view)
+			return view;
 
-	if (tryNoCopy)
 		return new Common::SeekableSubReadStream(_nds.get(), res.offset, res.offset + res.size);
+	}
 
-	_nds->seek(res.offset);
+	return _nds->readStreamAt(res.offset, res.size);
+}
 
-	return _nds->readStream(res.size);
+bool NDSFile::getResourceLocation(uint32 index, Location &location) const {
+	const IResource &res = getIResource(index);
+
+	location.stream = _nds.get();
+	location.offset = res.offset;
+	location.size   = res.size;
+	location.raw    = true;
+
+	return true;
 }
 
 } // End of namespace Aurora
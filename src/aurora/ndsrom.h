@@ -62,6 +62,9 @@ public:
 	/** Return a stream of the resource's contents. */
 	Common::SeekableReadStream *getResource(uint32 index, bool tryNoCopy = false) const;
 
+	/** Return where the resource's data is stored. */
+	bool getResourceLocation(uint32 index, Location &location) const;
+
 	/** Return the game title string stored in the NDS header. */
 	const Common::UString &getTitle() const;
 	/** Return the game code string stored in the NDS header. */
@@ -0,0 +1,217 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Reading the data of many archive resources in the order they're stored in.
+ */
+
+#include <cstring>
+
+#include <algorithm>
+
+#include "src/common/util.h"
+#include "src/common/error.h"
+#include "src/common/scopedptr.h"
+#include "src/common/thread.h"
+#include "src/common/readstream.h"
+#include "src/common/memreadstream.h"
+
+#include "src/aurora/readscheduler.h"
+
+namespace Aurora {
+
+ReadScheduler::ReadScheduler() : _scheduled(false) {
+}
+
+ReadScheduler::~ReadScheduler() {
+}
+
+size_t ReadScheduler::add(const Archive &archive, uint32 index) {
+	Request request;
+
+	request.archive     = &archive;
+	request.index       = index;
+	request.hasLocation = archive.getResourceLocation(index, request.location) && request.location.stream;
+
+	_requests.push_back(request);
+	_scheduled = false;
+
+	return _requests.size() - 1;
+}
+
+size_t ReadScheduler::getRequestCount() const {
+	return _requests.size();
+}
+
+size_t ReadScheduler::getReadCount() {
+	schedule();
+
+	return _reads.size();
+}
+
+void ReadScheduler::schedule() {
+	if (_scheduled)
+		return;
+
+	_order.resize(_requests.size());
+	for (size_t i = 0; i < _order.size(); i++)
+		_order[i] = i;
+
+	// Requests with a location first, grouped by stream and sorted by offset
+	std::stable_sort(_order.begin(), _order.end(), [this](size_t a, size_t b) {
+		const Request &requestA = _requests[a];
+		const Request &requestB = _requests[b];
+
+		if (requestA.hasLocation != requestB.hasLocation)
+			return requestA.hasLocation;
+		if (!requestA.hasLocation)
+			return false;
+
+		if (requestA.location.stream != requestB.location.stream)
+			return std::less<const Common::SeekableReadStream *>()(requestA.location.stream, requestB.location.stream);
+
+		return requestA.location.offset < requestB.location.offset;
+	});
+
+	_reads.clear();
+
+	for (size_t i = 0; i < _order.size(); i++) {
+		const Request &request = _requests[_order[i]];
+
+		if (!request.hasLocation) {
+			// Read through the archive, one by one
+			Read read;
+
+			read.stream       = 0;
+			read.offset       = 0;
+			read.size         = 0;
+			read.firstRequest = i;
+			read.requestCount = 1;
+
+			_reads.push_back(read);
+			continue;
+		}
+
+		const Archive::Location &location = request.location;
+
+		if (!_reads.empty()) {
+			Read &read = _reads.back();
+
+			const size_t readEnd     = read.offset + read.size;
+			const size_t locationEnd = location.offset + location.size;
+
+			if ((read.stream == location.stream) && (location.offset <= (readEnd + kMaxGap)) &&
+			    ((MAX(readEnd, locationEnd) - read.offset) <= kMaxReadSize)) {
+
+				read.size = MAX(readEnd, locationEnd) - read.offset;
+				read.requestCount++;
+				continue;
+			}
+		}
+
+		Read read;
+
+		read.stream       = location.stream;
+		read.offset       = location.offset;
+		read.size         = location.size;
+		read.firstRequest = i;
+		read.requestCount = 1;
+
+		_reads.push_back(read);
+	}
+
+	_scheduled = true;
+}
+
+void ReadScheduler::run(const Handler &handler, const ErrorHandler &errorHandler, size_t threadCount) {
+	schedule();
+
+	Common::parallelFor(_reads.size(), [this, &handler, &errorHandler](size_t i) {
+		runRead(_reads[i], handler, errorHandler);
+	}, threadCount);
+}
+
+void ReadScheduler::runRead(const Read &read, const Handler &handler, const ErrorHandler &errorHandler) {
+	Common::ScopedArray<byte> data;
+
+	if (read.stream) {
+		try {
+			data.reset(new byte[read.size]);
+
+			if (read.stream->readAt(read.offset, data.get(), read.size) != read.size)
+				throw Common::Exception(Common::kReadError);
+
+		} catch (...) {
+			// Let the archive try on its own, and produce a proper error for each request
+			data.reset();
+		}
+	}
+
+	for (size_t i = read.firstRequest; i < (read.firstRequest + read.requestCount); i++) {
+		const size_t id = _order[i];
+		const Request &request = _requests[id];
+
+		if (!data || !request.location.raw) {
+			runRequest(id, handler, errorHandler);
+			continue;
+		}
+
+		try {
+			const size_t offset = request.location.offset - read.offset;
+			const size_t size   = request.location.size;
+
+			Common::ScopedPtr<Common::MemoryReadStream> stream;
+			if (read.requestCount == 1) {
+				stream.reset(new Common::MemoryReadStream(data.release(), size, true));
+			} else {
+				Common::ScopedArray<byte> copy(new byte[size]);
+				std::memcpy(copy.get(), data.get() + offset, size);
+
+				stream.reset(new Common::MemoryReadStream(copy.release(), size, true));
+			}
+
+			handler(id, stream.release());
+
+		} catch (Common::Exception &e) {
+			errorHandler(id, e);
+		} catch (std::exception &e) {
+			Common::Exception se(e);
+
+			errorHandler(id, se);
+		}
+	}
+}
+
+void ReadScheduler::runRequest(size_t id, const Handler &handler, const ErrorHandler &errorHandler) {
+	const Request &request = _requests[id];
+
+	try {
+		handler(id, request.archive->getResource(request.index, true));
+
+	} catch (Common::Exception &e) {
+		errorHandler(id, e);
+	} catch (std::exception &e) {
+		Common::Exception se(e);
+
+		errorHandler(id, se);
+	}
+}
+
+} // End of namespace Aurora
@@ -0,0 +1,141 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Reading the data of many archive resources in the order they're stored in.
+ */
+
+#ifndef AURORA_READSCHEDULER_H
+#define AURORA_READSCHEDULER_H
+
+#include <vector>
+#include <functional>
+
+#include <boost/noncopyable.hpp>
+
+#include "src/common/types.h"
+#include "src/common/error.h"
+
+#include "src/aurora/archive.h"
+
+namespace Common {
+	class SeekableReadStream;
+}
+
+namespace Aurora {
+
+/** Reads the data of many archive resources, in the order they're stored in.
+ *
+ *  Reading the resources of an archive one after the other in the order of
+ *  their resource list jumps all over a BIF or a big ERF. Instead, the
+ *  ReadScheduler groups the requested resources by the stream they're stored
+ *  in, sorts them by their offset and merges neighbouring resources into one
+ *  bigger read. These reads are then done by a pool of threads, reading with
+ *  readAt() (pread() for files), so that the disk sees a few large, mostly
+ *  sequential reads.
+ *
+ *  Resources stored as-is are handed out straight from the merged read.
+ *  For packed resources, the archive itself unpacks the data, which the
+ *  merged read just pulled into the operating system's file cache.
+ *  Resources whose archive can't tell where their data is are read with a
+ *  plain Archive::getResource().
+ *
+ *  All archives need to be safe for concurrent getResource() calls, see
+ *  Archive::getResource().
+ */
+class ReadScheduler : boost::noncopyable {
+public:
+	/** Called with the data of a request. Ownership of the data is transferred. */
+	typedef std::function<void(size_t request, Common::SeekableReadStream *data)> Handler;
+	/** Called when reading or handling a request failed. */
+	typedef std::function<void(size_t request, Common::Exception &e)> ErrorHandler;
+
+	/** Neighbouring resources are merged if there's no more than this many bytes between them. */
+	static const size_t kMaxGap      = 64 * 1024;
+	/** Resources are merged into reads of at most this size. */
+	static const size_t kMaxReadSize = 8 * 1024 * 1024;
+
+	ReadScheduler();
+	~ReadScheduler();
+
+	/** Add a request for the data of a resource, and return the request's ID.
+	 *
+	 *  The requests are numbered in the order they're added, starting from 0.
+	 */
+	size_t add(const Archive &archive, uint32 index);
+
+	/** Return the number of requests. */
+	size_t getRequestCount() const;
+	/** Return the number of reads the requests were merged into. */
+	size_t getReadCount();
+
+	/** Read the data of all requests.
+	 *
+	 *  The handler is called for every request, on one of the reading threads,
+	 *  in roughly the order the data is stored in. Should reading the data or
+	 *  the handler throw, the error handler is called for this request instead.
+	 *  The reading threads are those of a Common::parallelFor(), so anything the
+	 *  handler itself spreads across threads runs on the reading thread alone.
+	 *
+	 *  @param handler      The function to handle the data of a request.
+	 *  @param errorHandler The function to handle a failed request.
+	 *  @param threadCount  The number of threads to read with. 0 means one per core.
+	 */
+	void run(const Handler &handler, const ErrorHandler &errorHandler, size_t threadCount = 0);
+
+private:
+	/** A requested resource. */
+	struct Request {
+		const Archive *archive;
+		uint32 index;
+
+		bool hasLocation;
+		Archive::Location location;
+	};
+
+	/** A read of one or more requested resources. */
+	struct Read {
+		Common::SeekableReadStream *stream; ///< The stream to read from, 0 to read through the archive.
+
+		size_t offset; ///< The offset of the read within the stream.
+		size_t size;   ///< The size of the read.
+
+		size_t firstRequest; ///< The first request of this read, within the sorted list of requests.
+		size_t requestCount; ///< The number of requests within this read.
+	};
+
+	std::vector<Request> _requests;
+
+	/** The IDs of the requests, sorted by their location. */
+	std::vector<size_t> _order;
+	std::vector<Read> _reads;
+
+	bool _scheduled;
+
+	/** Sort the requests and merge them into reads. */
+	void schedule();
+
+	void runRead(const Read &read, const Handler &handler, const ErrorHandler &errorHandler);
+	void runRequest(size_t id, const Handler &handler, const ErrorHandler &errorHandler);
+};
+
+} // End of namespace Aurora
+
+#endif // AURORA_READSCHEDULER_H
@@ -0,0 +1,243 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A prioritized index of the resources in all opened archives and directories.
+ */
+
+#include <algorithm>
+
+#include "src/common/strutil.h"
+#include "src/common/filepath.h"
+#include "src/common/readfile.h"
+
+#include "src/aurora/resman.h"
+#include "src/aurora/archive.h"
+#include "src/aurora/util.h"
+
+namespace Aurora {
+
+ResourceManager::Resource::Resource() : source(0xFFFFFFFF), priority(kPriorityNone), type(kFileTypeNone),
+	archive(0), index(0xFFFFFFFF) {
+}
+
+
+ResourceManager::ResourceManager() : _nextSource(0) {
+}
+
+ResourceManager::~ResourceManager() {
+}
+
+uint32 ResourceManager::getArchivePriority(FileType type) {
+	switch (type) {
+		case kFileTypeKEY:
+		case kFileTypeBIF:
+		case kFileTypeBZF:
+			return kPriorityKEY;
+
+		case kFileTypeRIM:
+			return kPriorityRIM;
+
+		case kFileTypeHAK:
+			return kPriorityHAK;
+
+		default:
+			break;
+	}
+
+	return kPriorityERF;
+}
+
+Common::UString ResourceManager::getResourceName(const Common::UString &name, uint64 hash) {
+	// Resources in some archives only have a hashed name. Use the hash as a name, then
+	if (name.empty())
+		return Common::composeString(hash);
+
+	return name;
+}
+
+bool ResourceManager::isBefore(const Resource &a, const Resource &b) {
+	if (a.priority != b.priority)
+		return a.priority > b.priority;
+
+	return a.source > b.source;
+}
+
+void ResourceManager::addResource(const Resource &resource) {
+	CopyList &copies = _resources[ResourceKey(resource.name, resource.type)];
+
+	copies.insert(std::upper_bound(copies.begin(), copies.end(), resource, &isBefore), resource);
+}
+
+void ResourceManager::removeResource(const Common::UString &name, FileType type, uint32 source) {
+	ResourceMap::iterator r = _resources.find(ResourceKey(name, type));
+	if (r == _resources.end())
+		return;
+
+	CopyList &copies = r->second;
+	for (CopyList::iterator c = copies.begin(); c != copies.end(); ++c) {
+		if (c->source == source) {
+			copies.erase(c);
+			break;
+		}
+	}
+
+	if (copies.empty())
+		_resources.erase(r);
+}
+
+uint32 ResourceManager::addArchive(const Archive &archive, uint32 priority) {
+	Common::StackLock lock(_mutex);
+
+	const uint32 id = _nextSource++;
+
+	Source &source = _sources[id];
+	source.priority = priority;
+	source.archive  = &archive;
+
+	Resource resource;
+	resource.source   = id;
+	resource.priority = priority;
+	resource.archive  = &archive;
+
+	const Archive::ResourceList &resources = archive.getResources();
+	for (Archive::ResourceList::const_iterator r = resources.begin(); r != resources.end(); ++r) {
+		resource.name  = getResourceName(r->name, r->hash);
+		resource.type  = r->type;
+		resource.index = r->index;
+
+		addResource(resource);
+	}
+
+	return id;
+}
+
+uint32 ResourceManager::addFiles(const std::vector<Common::UString> &paths, uint32 priority) {
+	Common::StackLock lock(_mutex);
+
+	const uint32 id = _nextSource++;
+
+	Source &source = _sources[id];
+	source.priority = priority;
+	source.archive  = 0;
+	source.paths    = paths;
+
+	Resource resource;
+	resource.source   = id;
+	resource.priority = priority;
+
+	for (std::vector<Common::UString>::const_iterator p = paths.begin(); p != paths.end(); ++p) {
+		resource.name = Common::FilePath::getStem(*p);
+		resource.type = TypeMan.getFileType(*p);
+		resource.path = *p;
+
+		addResource(resource);
+	}
+
+	return id;
+}
+
+void ResourceManager::removeSource(uint32 id) {
+	Common::StackLock lock(_mutex);
+
+	SourceMap::iterator s = _sources.find(id);
+	if (s == _sources.end())
+		return;
+
+	const Source &source = s->second;
+
+	if (source.archive) {
+		const Archive::ResourceList &resources = source.archive->getResources();
+		for (Archive::ResourceList::const_iterator r = resources.begin(); r != resources.end(); ++r)
+			removeResource(getResourceName(r->name, r->hash), r->type, id);
+	}
+
+	for (std::vector<Common::UString>::const_iterator p = source.paths.begin(); p != source.paths.end(); ++p)
+		removeResource(Common::FilePath::getStem(*p), TypeMan.getFileType(*p), id);
+
+	_sources.erase(s);
+}
+
+void ResourceManager::clear() {
+	Common::StackLock lock(_mutex);
+
+	_resources.clear();
+	_sources.clear();
+}
+
+size_t ResourceManager::getSourceCount() const {
+	Common::StackLock lock(_mutex);
+
+	return _sources.size();
+}
+
+bool ResourceManager::hasResource(const Common::UString &name, FileType type) const {
+	Common::StackLock lock(_mutex);
+
+	return _resources.find(ResourceKey(name, type)) != _resources.end();
+}
+
+bool ResourceManager::findResource(const Common::UString &name, FileType type, Resource &resource) const {
+	Common::StackLock lock(_mutex);
+
+	ResourceMap::const_iterator r = _resources.find(ResourceKey(name, type));
+	if (r == _resources.end())
+		return false;
+
+	resource = r->second.front();
+	return true;
+}
+
+ResourceManager::ResourceList ResourceManager::findAllResources(const Common::UString &name, FileType type) const {
+	Common::StackLock lock(_mutex);
+
+	ResourceMap::const_iterator r = _resources.find(ResourceKey(name, type));
+	if (r == _resources.end())
+		return ResourceList();
+
+	return r->second;
+}
+
+size_t ResourceManager::getShadowedCount(const Common::UString &name, FileType type) const {
+	Common::StackLock lock(_mutex);
+
+	ResourceMap::const_iterator r = _resources.find(ResourceKey(name, type));
+	if (r == _resources.end())
+		return 0;
+
+	return r->second.size() - 1;
+}
+
+Common::SeekableReadStream *ResourceManager::getResource(const Common::UString &name, FileType type) const {
+	Resource resource;
+	if (!findResource(name, type, resource))
+		return 0;
+
+	return getResource(resource);
+}
+
+Common::SeekableReadStream *ResourceManager::getResource(const Resource &resource) {
+	if (resource.archive)
+		return resource.archive->getResource(resource.index);
+
+	return new Common::ReadFile(resource.path);
+}
+
+} // End of namespace Aurora
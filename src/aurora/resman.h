@@ -0,0 +1,187 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A prioritized index of the resources in all opened archives and directories.
+ */
+
+#ifndef AURORA_RESMAN_H
+#define AURORA_RESMAN_H
+
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+#include <boost/unordered_map.hpp>
+
+#include "src/common/types.h"
+#include "src/common/ustring.h"
+#include "src/common/mutex.h"
+
+#include "src/aurora/types.h"
+#include "src/aurora/util.h"
+
+namespace Common {
+	class SeekableReadStream;
+}
+
+namespace Aurora {
+
+class Archive;
+
+/** The default priorities of resource sources.
+ *
+ *  Loosely modelled after the order in which the games resolve resources:
+ *  loose files in the override directory shadow everything, HAKs shadow
+ *  modules, modules shadow RIMs, and the base game data indexed by KEY
+ *  files is only used if nothing else provides a resource.
+ */
+enum ResourcePriority {
+	kPriorityNone     =   0,
+	kPriorityKEY      = 100, ///< Base game data, indexed by KEY files.
+	kPriorityRIM      = 200, ///< RIM files.
+	kPriorityERF      = 300, ///< ERF, MOD, NWM and SAV files, and other archives.
+	kPriorityHAK      = 400, ///< HAK files.
+	kPriorityOverride = 500  ///< Loose files in the override directory.
+};
+
+/** An index of the resources in all opened sources.
+ *
+ *  Each source, either an archive or a list of loose files, has a
+ *  priority. When several sources provide a resource with the same
+ *  name and type, the one with the highest priority wins and the others
+ *  are shadowed by it. If the priorities are equal, the source added
+ *  last wins.
+ *
+ *  All copies of a resource are kept in one hash table entry, in order
+ *  of resolution, so looking up the winning copy as well as the shadowed
+ *  copies takes constant time. Adding or removing a source only touches
+ *  the entries of that source's resources.
+ *
+ *  The manager does not take ownership of the archives; an archive has
+ *  to stay alive until its source has been removed or the manager has
+ *  been destroyed. All methods may be called from several threads.
+ */
+class ResourceManager : boost::noncopyable {
+public:
+	/** A copy of a resource, in one of the sources. */
+	struct Resource {
+		uint32 source;   ///< The ID of the source this copy is in.
+		uint32 priority; ///< The priority of the source.
+
+		Common::UString name; ///< The resource's name.
+		FileType        type; ///< The resource's type.
+
+		const Archive  *archive; ///< The archive this copy is in, or 0 for a loose file.
+		uint32          index;   ///< The copy's index within the archive.
+		Common::UString path;    ///< The path of a loose file.
+
+		Resource();
+	};
+
+	typedef std::vector<Resource> ResourceList;
+
+	ResourceManager();
+	~ResourceManager();
+
+	/** Return the default priority of an archive of this type. */
+	static uint32 getArchivePriority(FileType type);
+
+	/** Add all resources within an archive, and return the ID of the new source. */
+	uint32 addArchive(const Archive &archive, uint32 priority);
+	/** Add a list of loose files, and return the ID of the new source.
+	 *
+	 *  The resources' names and types are taken from the file names.
+	 */
+	uint32 addFiles(const std::vector<Common::UString> &paths, uint32 priority);
+
+	/** Remove all resources of this source. */
+	void removeSource(uint32 source);
+
+	/** Remove all sources. */
+	void clear();
+
+	/** Return the number of sources. */
+	size_t getSourceCount() const;
+
+	/** Does a resource with this name and type exist in any of the sources? */
+	bool hasResource(const Common::UString &name, FileType type) const;
+
+	/** Find the copy of a resource that wins over all others.
+	 *
+	 *  @param  name The name of the resource. It is compared case-insensitively.
+	 *  @param  type The type of the resource.
+	 *  @param  resource The winning copy of the resource will be stored here.
+	 *  @return true if the resource was found.
+	 */
+	bool findResource(const Common::UString &name, FileType type, Resource &resource) const;
+
+	/** Return all copies of a resource, in order of resolution.
+	 *
+	 *  The first copy in the list is the one that wins. All others are
+	 *  shadowed by it.
+	 */
+	ResourceList findAllResources(const Common::UString &name, FileType type) const;
+
+	/** Return how many copies of this resource are shadowed by the winning copy. */
+	size_t getShadowedCount(const Common::UString &name, FileType type) const;
+
+	/** Open the winning copy of a resource, or return 0 if it doesn't exist. */
+	Common::SeekableReadStream *getResource(const Common::UString &name, FileType type) const;
+
+	/** Open a specific copy of a resource. */
+	static Common::SeekableReadStream *getResource(const Resource &resource);
+
+private:
+	/** A source of resources. */
+	struct Source {
+		uint32 priority;
+
+		const Archive *archive;             ///< The archive, or 0 for loose files.
+		std::vector<Common::UString> paths; ///< The paths of the loose files.
+	};
+
+	/** All copies of one resource, in order of resolution. */
+	typedef std::vector<Resource> CopyList;
+
+	typedef boost::unordered_map<ResourceKey, CopyList, hashResourceKey> ResourceMap;
+	typedef boost::unordered_map<uint32, Source> SourceMap;
+
+	/** All copies of all resources. */
+	ResourceMap _resources;
+	/** All sources, by ID. */
+	SourceMap _sources;
+
+	/** The ID the next source will get. Later sources get higher IDs. */
+	uint32 _nextSource;
+
+	mutable Common::Mutex _mutex;
+
+	void addResource(const Resource &resource);
+	void removeResource(const Common::UString &name, FileType type, uint32 source);
+
+	/** Return the name a resource is indexed under. */
+	static Common::UString getResourceName(const Common::UString &name, uint64 hash);
+
+	static bool isBefore(const Resource &a, const Resource &b);
+};
+
+} // End of namespace Aurora
+
+#endif // AURORA_RESMAN_H
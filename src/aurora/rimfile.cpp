@@ -27,6 +27,7 @@
 #include "src/common/util.h"
 #include "src/common/strutil.h"
 #include "src/common/memreadstream.h"
+#include "src/common/mappedfile.h"
 #include "src/common/error.h"
 #include "src/common/encoding.h"
 
@@ -108,12 +109,26 @@ uint32 RIMFile::getResourceSize(uint32 index) const {
 Common::SeekableReadStream *RIMFile::getResource(uint32 index, bool tryNoCopy) const {
 	const IResource &res = getIResource(index);
 
-	if (tryNoCopy)
+	if (tryNoCopy) {
+		Common::SeekableReadStream *view = Common::createMemoryView(*_rim, res.offset, res.offset + res.size);
+		if (view)
+			return view;
+
 		return new Common::SeekableSubReadStream(_rim.get(), res.offset, res.offset + res.size);
+	}
+
+	return _rim->readStreamAt(res.offset, res.size);
+}
+
+bool RIMFile::getResourceLocation(uint32 index, Location &location) const {
+	const IResource &res = getIResource(index);
 
-	_rim->seek(res.offset);
+	location.stream = _rim.get();
+	location.offset = res.offset;
+	location.size   = res.size;
+	location.raw    = true;
 
-	return _rim->readStream(res.size);
+	return true;
 }
 
 } // End of namespace Aurora
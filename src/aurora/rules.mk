@@ -35,6 +35,7 @@ src_aurora_libaurora_la_SOURCES += \
     src/aurora/rimfile.h \
     src/aurora/keyfile.h \
     src/aurora/keydatafile.h \
+    src/aurora/keydatafilecache.h \
     src/aurora/biffile.h \
     src/aurora/bzffile.h \
     src/aurora/herffile.h \
@@ -44,6 +45,10 @@ src_aurora_libaurora_la_SOURCES += \
     src/aurora/gdaheaders.h \
     src/aurora/gff4file.h \
     src/aurora/gff4fields.h \
+    src/aurora/indexcache.h \
+    src/aurora/cachedarchive.h \
+    src/aurora/resman.h \
+    src/aurora/readscheduler.h \
     $(EMPTY)
 
 src_aurora_libaurora_la_SOURCES += \
@@ -57,6 +62,7 @@ src_aurora_libaurora_la_SOURCES += \
     src/aurora/rimfile.cpp \
     src/aurora/keyfile.cpp \
     src/aurora/keydatafile.cpp \
+    src/aurora/keydatafilecache.cpp \
     src/aurora/biffile.cpp \
     src/aurora/bzffile.cpp \
     src/aurora/herffile.cpp \
@@ -65,4 +71,8 @@ src_aurora_libaurora_la_SOURCES += \
     src/aurora/gdafile.cpp \
     src/aurora/gdaheaders.cpp \
     src/aurora/gff4file.cpp \
+    src/aurora/indexcache.cpp \
+    src/aurora/cachedarchive.cpp \
+    src/aurora/resman.cpp \
+    src/aurora/readscheduler.cpp \
     $(EMPTY)
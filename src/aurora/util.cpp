@@ -27,6 +27,9 @@
 #include "src/common/util.h"
 #include "src/common/ustring.h"
 #include "src/common/filepath.h"
+#include "src/common/scopedptr.h"
+#include "src/common/readfile.h"
+#include "src/common/mappedfile.h"
 
 #include "src/aurora/util.h"
 
@@ -384,6 +387,14 @@ FileTypeManager::FileTypeManager() {
 
 	_resourceTypes[kResourceTable].push_back(kFileType2DA);
 	_resourceTypes[kResourceTable].push_back(kFileTypeGDA);
+
+	/* Build all lookup tables right away. Archives are opened in background
+	 * threads, and they mustn't race each other building them lazily. */
+	buildExtensionLookup();
+	buildTypeLookup();
+
+	for (int i = 0; i < Common::kHashMAX; i++)
+		buildHashLookup((Common::HashAlgo) i);
 }
 
 FileTypeManager::~FileTypeManager() {
@@ -508,4 +519,26 @@ Common::UString getResourceTypeDescription(ResourceType type) {
 	return names[type];
 }
 
+Common::SeekableReadStream *openArchiveFile(const Common::UString &path) {
+	Common::ScopedPtr<Common::MappedFile> mappedFile(new Common::MappedFile);
+	if (mappedFile->open(path))
+		return mappedFile.release();
+
+	return new Common::ReadFile(path);
+}
+
+ResourceKey::ResourceKey(const Common::UString &n, FileType t) : name(n), type(t) {
+}
+
+bool ResourceKey::operator==(const ResourceKey &right) const {
+	return (type == right.type) && name.equalsIgnoreCase(right.name);
+}
+
+size_t hashResourceKey::operator()(const ResourceKey &key) const {
+	size_t seed = Common::hashUStringCaseInsensitive()(key.name);
+	boost::hash_combine(seed, (int) key.type);
+
+	return seed;
+}
+
 } // End of namespace Aurora
@@ -34,6 +34,10 @@
 
 #include "src/aurora/types.h"
 
+namespace Common {
+	class SeekableReadStream;
+}
+
 namespace Aurora {
 
 /** Return the human readable string of a Platform. */
@@ -42,6 +46,24 @@ Common::UString getPlatformDescription(Platform platform);
 /** Return the human readable description of a resource type. */
 Common::UString getResourceTypeDescription(ResourceType type);
 
+/** Open a file for archive access, preferring a memory mapping over buffered reads. */
+Common::SeekableReadStream *openArchiveFile(const Common::UString &path);
+
+/** A resource's name and type, for looking it up with its name compared case-insensitively. */
+struct ResourceKey {
+	Common::UString name;
+	FileType type;
+
+	ResourceKey(const Common::UString &n, FileType t);
+
+	bool operator==(const ResourceKey &right) const;
+};
+
+/** Hash a ResourceKey, ignoring the case of its name. */
+struct hashResourceKey {
+	size_t operator()(const ResourceKey &key) const;
+};
+
 
 class FileTypeManager : public Common::Singleton<FileTypeManager> {
 public:
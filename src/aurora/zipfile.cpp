@@ -53,6 +53,13 @@ Common::SeekableReadStream *ZIPFile::getResource(uint32 index, bool tryNoCopy) c
 	return _zipFile->getFile(index, tryNoCopy);
 }
 
+bool ZIPFile::getResourceLocation(uint32 index, Location &location) const {
+	location.stream = &_zipFile->getStream();
+	location.raw    = _zipFile->getFileLocation(index, location.offset, location.size);
+
+	return true;
+}
+
 void ZIPFile::load() {
 	const Common::ZipFile::FileList &files = _zipFile->getFiles();
 	for (Common::ZipFile::FileList::const_iterator file = files.begin(); file != files.end(); ++file) {
@@ -54,6 +54,9 @@ public:
 	/** Return a stream of the resource's contents. */
 	Common::SeekableReadStream *getResource(uint32 index, bool tryNoCopy = false) const;
 
+	/** Return where the resource's data is stored. */
+	bool getResourceLocation(uint32 index, Location &location) const;
+
 private:
 	/** The actual zip file. */
 	Common::ScopedPtr<Common::ZipFile> _zipFile;
@@ -24,9 +24,86 @@
 
 #include "src/version/version.h"
 
+#include "src/common/strutil.h"
+#include "src/common/error.h"
+
 #include "src/cline.h"
 
+static bool isOption(const Common::UString &arg, const char *shortName, const char *longName) {
+	return (arg == Common::UString(shortName)) || (arg == Common::UString(longName));
+}
+
+static bool parseExtractMode(const Common::UString &arg, ExtractMode &mode) {
+	if        (arg == Common::UString("raw")) {
+		mode = kExtractModeRaw;
+		return true;
+	} else if (arg == Common::UString("tga")) {
+		mode = kExtractModeTGA;
+		return true;
+	} else if (arg == Common::UString("wav")) {
+		mode = kExtractModeWAV;
+		return true;
+	}
+
+	return false;
+}
+
+/** Parse the arguments following "extract". */
+static Job parseExtractCommandLine(const std::vector<Common::UString> &argv) {
+	Job job;
+
+	job.operation = kOperationExtract;
+
+	for (size_t i = 2; i < argv.size(); i++) {
+		if (isOption(argv[i], "-h", "--help")) {
+			job.operation = kOperationHelp;
+			break;
+		}
+
+		const bool hasValue = (i + 1) < argv.size();
+
+		if        (isOption(argv[i], "-o", "--output") && hasValue) {
+			job.outPath = argv[++i];
+			continue;
+		} else if (isOption(argv[i], "-f", "--filter") && hasValue) {
+			job.filters.push_back(argv[++i]);
+			continue;
+		} else if (isOption(argv[i], "-m", "--mode") && hasValue) {
+			if (!parseExtractMode(argv[++i], job.extractMode)) {
+				job.operation = kOperationInvalid;
+				break;
+			}
+			continue;
+		} else if (isOption(argv[i], "-j", "--threads") && hasValue) {
+			try {
+				Common::parseString(argv[++i], job.threadCount);
+			} catch (Common::Exception &) {
+				job.operation = kOperationInvalid;
+				break;
+			}
+			continue;
+		}
+
+		// Unknown options, and a second path, make the command line invalid
+		if (argv[i].beginsWith("-") || !job.path.empty()) {
+			job.operation = kOperationInvalid;
+			break;
+		}
+
+		job.path = argv[i];
+	}
+
+	// Extracting needs something to extract
+	if ((job.operation == kOperationExtract) && job.path.empty())
+		job.operation = kOperationInvalid;
+
+	return job;
+}
+
 Job parseCommandLine(const std::vector<Common::UString> &argv) {
+	if ((argv.size() > 1) && (argv[1] == Common::UString("extract")))
+		return parseExtractCommandLine(argv);
+
 	Job job;
 
 	// No options at all means we operate on an empty path
@@ -72,8 +149,20 @@ Common::UString createHelpText(const Common::UString &name) {
 	text += Common::UString::format("%s - A FLOSS resource explorer for BioWare's Aurora engine games\n",
 	                                Version::getProjectName());
 	text += Common::UString::format("Usage: %s [options] [<path>]\n", name.c_str());
+	text += Common::UString::format("       %s extract [extract options] <path>\n", name.c_str());
 	text += Common::UString::format("  -h      --help              Display this text and exit.\n");
-	text += Common::UString::format("  -v      --version           Display version information and exit.");
+	text += Common::UString::format("  -v      --version           Display version information and exit.\n");
+	text += Common::UString::format("\n");
+	text += Common::UString::format("Extract options:\n");
+	text += Common::UString::format("  -o <dir>  --output <dir>    Extract into this directory. Defaults to the\n");
+	text += Common::UString::format("                              current directory.\n");
+	text += Common::UString::format("  -f <glob>  --filter <glob>  Only extract resources whose names match this\n");
+	text += Common::UString::format("                              pattern. Can be given more than once.\n");
+	text += Common::UString::format("  -m <mode>  --mode <mode>    raw: Write all resources as they are (default).\n");
+	text += Common::UString::format("                              tga: Convert images to TGA.\n");
+	text += Common::UString::format("                              wav: Convert sounds to PCM WAV.\n");
+	text += Common::UString::format("  -j <n>  --threads <n>       Use this many extraction threads. Defaults to\n");
+	text += Common::UString::format("                              the number of processor cores.");
 
 	return text;
 }
@@ -34,7 +34,15 @@ enum Operation {
 	kOperationInvalid = 0, ///< Invalid command line.
 	kOperationHelp       , ///< Show the help text.
 	kOperationVersion    , ///< Show version information.
-	kOperationPath         ///< Crawl through a game directory.
+	kOperationPath       , ///< Crawl through a game directory.
+	kOperationExtract      ///< Extract resources without opening the GUI.
+};
+
+/** How resources are written when extracting. */
+enum ExtractMode {
+	kExtractModeRaw = 0, ///< Write all resources as they are.
+	kExtractModeTGA    , ///< Convert image resources to TGA, skip all others.
+	kExtractModeWAV      ///< Convert sound resources to PCM WAV, skip all others.
 };
 
 /** Full description of the job this tool will be doing. */
@@ -42,7 +50,12 @@ struct Job {
 	Operation operation;  ///< The operation to perform.
 	Common::UString path; ///< The game directory to look through.
 
-	Job() : operation(kOperationInvalid) {
+	Common::UString outPath;              ///< The directory to extract into.
+	std::vector<Common::UString> filters; ///< Glob patterns of resource names to extract.
+	ExtractMode extractMode;              ///< How to write the extracted resources.
+	size_t threadCount;                   ///< Number of extraction threads, 0 for automatic.
+
+	Job() : operation(kOperationInvalid), outPath("."), extractMode(kExtractModeRaw), threadCount(0) {
 	}
 };
 
@@ -30,9 +30,13 @@
 #include <boost/noncopyable.hpp>
 
 #include "src/common/types.h"
+#include "src/common/util.h"
+#include "src/common/endianness.h"
+#include "src/common/scopedptr.h"
 #include "src/common/disposableptr.h"
 #include "src/common/error.h"
 #include "src/common/readstream.h"
+#include "src/common/mappedfile.h"
 
 namespace Common {
 
@@ -63,6 +67,15 @@ public:
 	/** Read a multi-bit value from the bit stream. */
 	virtual uint32 getBits(size_t n) = 0;
 
+	/** Read a multi-bit value from the bit stream, without consuming it.
+	 *
+	 *  Bits past the end of the stream are read as 0.
+	 */
+	virtual uint32 peekBits(size_t n) = 0;
+
+	/** Are the bits handed out in the order of MSB to LSB? */
+	virtual bool isMSBFirst() const = 0;
+
 	/** Add a bit to the n-bit value x, making it an (n+1)-bit value. */
 	virtual void addBit(uint32 &x, size_t n) = 0;
 
@@ -80,70 +93,149 @@ protected:
  * For example, a bit stream with the layout parameters 32, true, false
  * for valueBits, isLE and isMSB2LSB, reads 32bit little-endian values
  * from the data stream and hands out the bits in the order of LSB to MSB.
+ *
+ * Internally, the bits are held in a 64-bit cache window, which is refilled
+ * in units of up to 32 bits. This way, reading, peeking at and skipping up
+ * to 32 bits are simple shifts and masks. 64-bit values are split into two
+ * 32-bit units, in the order their bits are handed out.
+ *
+ * If the data stream is backed by memory (a MemoryReadStream or MappedFile),
+ * the units are read directly from that memory. Otherwise, the data stream
+ * is read in chunks into an internal buffer.
  */
 template<int valueBits, bool isLE, bool isMSB2LSB>
 class BitStreamImpl : boost::noncopyable, public BitStream {
 private:
+	static const size_t kUnitBits   = (valueBits > 32) ? 32 : valueBits;
+	static const size_t kUnitBytes  = kUnitBits / 8;
+	static const size_t kValueBytes = valueBits / 8;
+
+	/** Size of the internal buffer when reading from a non-memory stream. */
+	static const size_t kBufferSize = 4096;
+
 	DisposablePtr<SeekableReadStream> _stream; ///< The input stream.
 
-	uint64 _value;   ///< Current value.
-	uint8  _inValue; ///< Position within the current value.
+	ScopedArray<byte> _buffer; ///< Buffer for the input data, if it's not in memory.
+
+	const byte *_data;      ///< The input data currently available.
+	size_t      _dataStart; ///< Stream offset of the available input data.
+	size_t      _dataSize;  ///< Number of bytes of available input data.
+
+	size_t _end;  ///< Stream offset of the end of the last full value.
+	size_t _next; ///< Stream offset of the next unit to load into the cache.
+
+	uint64 _cache;     ///< The cache window.
+	size_t _cacheBits; ///< Number of valid bits in the cache window.
+
+	void init() {
+		if ((valueBits != 8) && (valueBits != 16) && (valueBits != 32) && (valueBits != 64))
+			throw Exception("BitStream: Invalid memory layout %d, %d, %d", valueBits, isLE, isMSB2LSB);
+
+		_end  = _stream->size() & ~((size_t) (kValueBytes - 1));
+		_next = MIN(_stream->pos(), _end);
+
+		_data = getStreamMemory(*_stream);
+		if (_data) {
+			_dataStart = 0;
+			_dataSize  = _end;
+		} else
+			_buffer.reset(new byte[kBufferSize]);
+	}
+
+	/** Make sure the unit at this stream offset is available in the input data. */
+	inline void fillData(size_t offset) {
+		if ((offset >= _dataStart) && ((offset - _dataStart + kUnitBytes) <= _dataSize))
+			return;
+
+		const size_t size = MIN(kBufferSize, _end - offset);
+
+		_dataStart = offset;
+		_dataSize  = _stream->readAt(offset, _buffer.get(), size);
+		_data      = _buffer.get();
+
+		if (_dataSize < kUnitBytes)
+			throw Exception(kReadError);
+	}
+
+	/** Read the unit at this stream offset. */
+	inline uint32 readUnit(size_t offset) {
+		fillData(offset);
+
+		// For 64-bit values, the half handed out first is either at the start or the end of the value
+		if ((valueBits == 64) && (isLE == isMSB2LSB))
+			offset ^= 4;
+
+		const byte *data = _data + (offset - _dataStart);
+
+		if (kUnitBits == 8)
+			return *data;
 
-	/** Read a data value. */
-	inline uint64 readData() {
 		if (isLE) {
-			if (valueBits ==  8)
-				return _stream->readByte();
-			if (valueBits == 16)
-				return _stream->readUint16LE();
-			if (valueBits == 32)
-				return _stream->readUint32LE();
-			if (valueBits == 64)
-				return _stream->readUint64LE();
+			if (kUnitBits == 16)
+				return READ_LE_UINT16(data);
+			if (kUnitBits == 32)
+				return READ_LE_UINT32(data);
 		} else {
-			if (valueBits ==  8)
-				return _stream->readByte();
-			if (valueBits == 16)
-				return _stream->readUint16BE();
-			if (valueBits == 32)
-				return _stream->readUint32BE();
-			if (valueBits == 64)
-				return _stream->readUint64BE();
+			if (kUnitBits == 16)
+				return READ_BE_UINT16(data);
+			if (kUnitBits == 32)
+				return READ_BE_UINT32(data);
 		}
 
 		assert(false);
 		return 0;
 	}
 
-	/** Read the next data value. */
-	inline void readValue() {
-		if ((size() - pos()) < valueBits)
-			throw Exception("BitStream::readValue(): End of bit stream reached");
+	/** Fill up the cache window, until it holds more than 32 bits or the end of the stream is reached. */
+	inline void fillCache() {
+		while ((_cacheBits <= (64 - kUnitBits)) && (_next < _end)) {
+			const uint64 unit = readUnit(_next);
 
-		_value = readData();
+			if (isMSB2LSB)
+				_cache |= unit << (64 - kUnitBits - _cacheBits);
+			else
+				_cache |= unit << _cacheBits;
 
-		// If we're reading the bits MSB first, we need to shift the value to that position
-		if (isMSB2LSB)
-			_value <<= 64 - valueBits;
+			_next      += kUnitBytes;
+			_cacheBits += kUnitBits;
 		}
+	}
+
+	/** Return the next n bits (1 <= n <= 32) in the cache window. Missing bits are 0. */
+	inline uint32 peekCache(size_t n) const {
+		if (isMSB2LSB)
+			return _cache >> (64 - n);
+
+		return _cache & (0xFFFFFFFFFFFFFFFFULL >> (64 - n));
+	}
+
+	/** Remove n bits (n < 64, n <= _cacheBits) from the cache window. */
+	inline void consumeCache(size_t n) {
+		if (isMSB2LSB)
+			_cache <<= n;
+		else
+			_cache >>= n;
+
+		_cacheBits -= n;
+	}
 
 public:
 	/** Create a bit stream using this input data stream and optionally delete it on destruction. */
 	BitStreamImpl(SeekableReadStream *stream, bool disposeAfterUse = false) :
-		_stream(stream, disposeAfterUse), _value(0), _inValue(0) {
+		_stream(stream, disposeAfterUse), _data(0), _dataStart(0), _dataSize(0),
+		_end(0), _next(0), _cache(0), _cacheBits(0) {
 
 		assert(_stream);
 
-		if ((valueBits != 8) && (valueBits != 16) && (valueBits != 32) && (valueBits != 64))
-			throw Exception("BitStream: Invalid memory layout %d, %d, %d", valueBits, isLE, isMSB2LSB);
+		init();
 	}
 
 	/** Create a bit stream using this input data stream. */
 	BitStreamImpl(SeekableReadStream &stream) :
-		_stream(&stream, false), _value(0), _inValue(0) {
+		_stream(&stream, false), _data(0), _dataStart(0), _dataSize(0),
+		_end(0), _next(0), _cache(0), _cacheBits(0) {
 
-		if ((valueBits != 8) && (valueBits != 16) && (valueBits != 32) && (valueBits != 64))
-			throw Exception("BitStream: Invalid memory layout %d, %d, %d", valueBits, isLE, isMSB2LSB);
+		init();
 	}
 
 	~BitStreamImpl() {
@@ -151,27 +243,7 @@ public:
 
 	/** Read a bit from the bit stream. */
 	uint32 getBit() {
-		// Check if we need the next value
-		if (_inValue == 0)
-			readValue();
-
-		// Get the current bit
-		int b = 0;
-		if (isMSB2LSB)
-			b = ((_value & 0x8000000000000000ULL) == 0) ? 0 : 1;
-		else
-			b = ((_value & 1) == 0) ? 0 : 1;
-
-		// Shift to the next bit
-		if (isMSB2LSB)
-			_value <<= 1;
-		else
-			_value >>= 1;
-
-		// Increase the position within the current value
-		_inValue = (_inValue + 1) % valueBits;
-
-		return b;
+		return getBits(1);
 	}
 
 	/** Read a multi-bit value from the bit stream. */
@@ -182,22 +254,38 @@ public:
 		if (n > 32)
 			throw Exception("Too many bits requested to be read");
 
-		// Read the number of bits
-		uint32 v = 0;
-
-		if (isMSB2LSB) {
-			while (n-- > 0)
-				v = (v << 1) | getBit();
-		} else {
-			for (uint32 i = 0; i < n; i++)
-				v = (v >> 1) | (((uint32) getBit()) << 31);
+		if (_cacheBits < n) {
+			fillCache();
 
-			v >>= (32 - n);
+			if (_cacheBits < n)
+				throw Exception("BitStream::getBits(): End of bit stream reached");
 		}
 
+		const uint32 v = peekCache(n);
+		consumeCache(n);
+
 		return v;
 	}
 
+	/** Read a multi-bit value from the bit stream, without consuming it. */
+	uint32 peekBits(size_t n) {
+		if (n == 0)
+			return 0;
+
+		if (n > 32)
+			throw Exception("Too many bits requested to be read");
+
+		if (_cacheBits < n)
+			fillCache();
+
+		return peekCache(n);
+	}
+
+	/** Are the bits handed out in the order of MSB to LSB? */
+	bool isMSBFirst() const {
+		return isMSB2LSB;
+	}
+
 	/** Add a bit to the n-bit value x, making it an (n+1)-bit value. */
 	void addBit(uint32 &x, size_t n) {
 		if (n >= 32)
@@ -211,34 +299,48 @@ public:
 
 	/** Rewind the bit stream back to the start. */
 	void rewind() {
-		_stream->seek(0);
+		_next = 0;
 
-		_value   = 0;
-		_inValue = 0;
+		_cache     = 0;
+		_cacheBits = 0;
 	}
 
 	/** Skip the specified amount of bits. */
 	void skip(size_t n) {
-		while (n-- > 0)
-			getBit();
+		if (n < _cacheBits) {
+			consumeCache(n);
+			return;
+		}
+
+		const size_t target = pos() + n;
+		if (target > size())
+			throw Exception("BitStream::skip(): End of bit stream reached");
+
+		// Drop the cache window and continue at the unit containing the target position
+		_next = (target / kUnitBits) * kUnitBytes;
+
+		_cache     = 0;
+		_cacheBits = 0;
+
+		const size_t remainder = target % kUnitBits;
+		if (remainder > 0) {
+			fillCache();
+			consumeCache(remainder);
+		}
 	}
 
 	/** Return the stream position in bits. */
 	size_t pos() const {
-		if (_stream->pos() == 0)
-			return 0;
-
-		size_t p = (_inValue == 0) ? _stream->pos() : ((_stream->pos() - 1) & ~((size_t) ((valueBits >> 3) - 1)));
-		return p * 8 + _inValue;
+		return _next * 8 - _cacheBits;
 	}
 
 	/** Return the stream size in bits. */
 	size_t size() const {
-		return (_stream->size() & ~((size_t) ((valueBits >> 3) - 1))) * 8;
+		return _end * 8;
 	}
 
 	bool eos() const {
-		return _stream->eos() || (pos() >= size());
+		return pos() >= size();
 	}
 };
 
@@ -23,10 +23,16 @@
  */
 
 #include <cassert>
+#include <cstring>
+
+#include <list>
+#include <memory>
 
 #include "src/common/util.h"
 #include "src/common/error.h"
 #include "src/common/scopedptr.h"
+#include "src/common/mutex.h"
+#include "src/common/thread.h"
 #include "src/common/memreadstream.h"
 #include "src/common/blowfish.h"
 
@@ -244,7 +250,7 @@ static uint32 F(const BlowfishContext &ctx, uint32 x) {
 	return ((ctx.S[0][a] + ctx.S[1][b]) ^ ctx.S[2][c]) + ctx.S[3][d];
 }
 
-static void blowfishEnc(BlowfishContext &ctx, uint32 &xl, uint32 &xr) {
+static void blowfishEnc(const BlowfishContext &ctx, uint32 &xl, uint32 &xr) {
 	for (size_t i = 0; i < kRoundCount; i++) {
 		xl = xl ^ ctx.P[i];
 		xr = F(ctx, xl) ^ xr;
@@ -258,7 +264,7 @@ static void blowfishEnc(BlowfishContext &ctx, uint32 &xl, uint32 &xr) {
 	xl = xl ^ ctx.P[kRoundCount + 1];
 }
 
-static void blowfishDec(BlowfishContext &ctx, uint32 &xl, uint32 &xr) {
+static void blowfishDec(const BlowfishContext &ctx, uint32 &xl, uint32 &xr) {
 	for (size_t i = kRoundCount + 1; i > 1; i--) {
 		xl = xl ^ ctx.P[i];
 		xr = F(ctx, xl) ^ xr;
@@ -314,7 +320,7 @@ static void blowfishSetKey(BlowfishContext &ctx, const byte *key, size_t keyLeng
 	}
 }
 
-static void blowfishECB(BlowfishContext &ctx, Mode mode, const byte *input, byte *output) {
+static void blowfishECB(const BlowfishContext &ctx, Mode mode, const byte *input, byte *output) {
 	uint32 X0 = READ_BE_UINT32(input);
 	uint32 X1 = READ_BE_UINT32(input + 4);
 
@@ -335,35 +341,154 @@ static void blowfishECB(BlowfishContext &ctx, Mode mode, const byte *input, byte
 }
 // '--- Blowfish, based on the implementation from mbed TLS ---'
 
-MemoryReadStream *blowfishEBC(SeekableReadStream &input, const std::vector<byte> &key, Mode mode) {
-	BlowfishContext ctx;
+/** The number of blocks processed side by side. */
+static const size_t kLaneCount = 4;
 
-	blowfishSetKey(ctx, &key[0], key.size());
+/** Process kLaneCount independent blocks at once.
+ *
+ *  Each round of a block depends on the S-box lookups of the round
+ *  before, so a single block leaves the CPU waiting on memory loads
+ *  most of the time. Interleaving the rounds of several blocks lets
+ *  their lookups overlap.
+ */
+static void blowfishLanes(const BlowfishContext &ctx, Mode mode, byte *data) {
+	uint32 xl[kLaneCount], xr[kLaneCount];
+	for (size_t j = 0; j < kLaneCount; j++) {
+		xl[j] = READ_BE_UINT32(data + j * kBlockSize);
+		xr[j] = READ_BE_UINT32(data + j * kBlockSize + 4);
+	}
 
-	size_t inputSize = input.size() - input.pos();
+	if (mode == kModeDecrypt) {
+		for (size_t i = kRoundCount + 1; i > 1; i--) {
+			for (size_t j = 0; j < kLaneCount; j++) {
+				xl[j] ^= ctx.P[i];
+				xr[j] ^= F(ctx, xl[j]);
 
-	// Round up to the next multiple of the block size
-	const size_t outputSize = ((inputSize + kBlockSize - 1) / kBlockSize) * kBlockSize;
+				SWAP(xl[j], xr[j]);
+			}
+		}
 
-	ScopedArray<byte> output(new byte[outputSize]);
+		for (size_t j = 0; j < kLaneCount; j++) {
+			SWAP(xl[j], xr[j]);
+
+			xr[j] ^= ctx.P[1];
+			xl[j] ^= ctx.P[0];
+		}
+
+	} else {
+		for (size_t i = 0; i < kRoundCount; i++) {
+			for (size_t j = 0; j < kLaneCount; j++) {
+				xl[j] ^= ctx.P[i];
+				xr[j] ^= F(ctx, xl[j]);
+
+				SWAP(xl[j], xr[j]);
+			}
+		}
+
+		for (size_t j = 0; j < kLaneCount; j++) {
+			SWAP(xl[j], xr[j]);
 
-	byte buffer[kBlockSize];
-	byte *data = output.get();
-	while (inputSize > 0) {
-		const size_t toRead = MIN<size_t>(inputSize, kBlockSize);
+			xr[j] ^= ctx.P[kRoundCount];
+			xl[j] ^= ctx.P[kRoundCount + 1];
+		}
+	}
+
+	for (size_t j = 0; j < kLaneCount; j++) {
+		WRITE_BE_UINT32(data + j * kBlockSize    , xl[j]);
+		WRITE_BE_UINT32(data + j * kBlockSize + 4, xr[j]);
+	}
+}
+
+/** Encrypt or decrypt a buffer, whose size is a multiple of the block size, in place. */
+static void blowfishBlocks(const BlowfishContext &ctx, Mode mode, byte *data, size_t size) {
+	assert((size % kBlockSize) == 0);
+
+	const size_t laneSize = kLaneCount * kBlockSize;
 
-		if (input.read(buffer, toRead) != toRead)
-			throw Exception(kReadError);
+	for (; size >= laneSize; data += laneSize, size -= laneSize)
+		blowfishLanes(ctx, mode, data);
 
-		if (toRead < kBlockSize)
-			std::memset(buffer + toRead, 0, kBlockSize - toRead);
+	for (; size > 0; data += kBlockSize, size -= kBlockSize)
+		blowfishECB(ctx, mode, data, data);
+}
 
-		blowfishECB(ctx, mode, buffer, data);
+/** The size of the pieces a large buffer is split into, to be processed in parallel. */
+static const size_t kParallelTaskSize = 256 * 1024;
+/** Below this size, a buffer is processed on the calling thread alone. */
+static const size_t kParallelMinSize  = 4 * kParallelTaskSize;
 
-		data      += toRead;
-		inputSize -= toRead;
+/** Encrypt or decrypt a buffer in place, splitting large buffers across several threads. */
+static void blowfishBuffer(const BlowfishContext &ctx, Mode mode, byte *data, size_t size) {
+	if (size < kParallelMinSize) {
+		blowfishBlocks(ctx, mode, data, size);
+		return;
 	}
 
+	const size_t taskCount = (size + kParallelTaskSize - 1) / kParallelTaskSize;
+
+	parallelFor(taskCount, [&ctx, mode, data, size](size_t i) {
+		const size_t offset = i * kParallelTaskSize;
+
+		blowfishBlocks(ctx, mode, data + offset, MIN(kParallelTaskSize, size - offset));
+	});
+}
+
+/** The number of expanded keys to remember. */
+static const size_t kKeyCacheSize = 8;
+
+/** Return the expanded key schedule of this key.
+ *
+ *  Expanding a key takes 521 block encryptions, so the last few expanded
+ *  keys are cached. Reading an encrypted archive usually decrypts many
+ *  pieces with the same key.
+ */
+static std::shared_ptr<const BlowfishContext> getContext(const std::vector<byte> &key) {
+	typedef std::pair<std::vector<byte>, std::shared_ptr<const BlowfishContext> > CacheEntry;
+
+	static Mutex cacheMutex;
+	static std::list<CacheEntry> cache;
+
+	if ((key.size() < kMinKeyLength) || (key.size() > kMaxKeyLength))
+		throw Exception("Invalid Blowfish key length %u", (uint) key.size());
+
+	StackLock lock(cacheMutex);
+
+	for (std::list<CacheEntry>::iterator c = cache.begin(); c != cache.end(); ++c) {
+		if (c->first == key) {
+			// Move it to the front, as the most recently used key
+			cache.splice(cache.begin(), cache, c);
+
+			return c->second;
+		}
+	}
+
+	std::shared_ptr<BlowfishContext> ctx = std::make_shared<BlowfishContext>();
+	blowfishSetKey(*ctx, &key[0], key.size());
+
+	cache.push_front(CacheEntry(key, ctx));
+	if (cache.size() > kKeyCacheSize)
+		cache.pop_back();
+
+	return ctx;
+}
+
+static MemoryReadStream *blowfishEBC(SeekableReadStream &input, const std::vector<byte> &key, Mode mode) {
+	std::shared_ptr<const BlowfishContext> ctx = getContext(key);
+
+	const size_t inputSize = input.size() - input.pos();
+
+	// Round up to the next multiple of the block size
+	const size_t outputSize = ((inputSize + kBlockSize - 1) / kBlockSize) * kBlockSize;
+
+	ScopedArray<byte> output(new byte[outputSize]);
+
+	if (input.read(output.get(), inputSize) != inputSize)
+		throw Exception(kReadError);
+
+	std::memset(output.get() + inputSize, 0, outputSize - inputSize);
+
+	blowfishBuffer(*ctx, mode, output.get(), outputSize);
+
 	return new MemoryReadStream(output.release(), outputSize, true);
 }
 
@@ -378,4 +503,148 @@ MemoryReadStream *decryptBlowfishEBC(SeekableReadStream &input, const std::vecto
 	return blowfishEBC(input, key, kModeDecrypt);
 }
 
+void encryptBlowfishEBC(byte *data, size_t size, const std::vector<byte> &key) {
+	if ((size % kBlockSize) != 0)
+		throw Exception("Blowfish operates on blocks of 8 bytes (%u)", (uint) size);
+
+	blowfishBuffer(*getContext(key), kModeEncrypt, data, size);
+}
+
+void decryptBlowfishEBC(byte *data, size_t size, const std::vector<byte> &key) {
+	if ((size % kBlockSize) != 0)
+		throw Exception("Blowfish operates on blocks of 8 bytes (%u)", (uint) size);
+
+	blowfishBuffer(*getContext(key), kModeDecrypt, data, size);
+}
+
+
+BlowfishReadStream::BlowfishReadStream(SeekableReadStream *parentStream, const std::vector<byte> &key,
+                                       bool disposeParentStream) :
+	_parentStream(parentStream, disposeParentStream), _size(0), _pos(0), _eos(false), _useCount(0) {
+
+	assert(parentStream);
+
+	_size = _parentStream->size();
+	if ((_size % kBlockSize) != 0)
+		throw Exception("Blowfish operates on blocks of 8 bytes (%u)", (uint) _size);
+
+	_context = getContext(key);
+
+	_chunks.reset(new Chunk[kChunkCount]);
+	for (size_t i = 0; i < kChunkCount; i++) {
+		_chunks[i].index   = SIZE_MAX;
+		_chunks[i].lastUse = 0;
+	}
+}
+
+BlowfishReadStream::~BlowfishReadStream() {
+}
+
+bool BlowfishReadStream::eos() const {
+	return _eos;
+}
+
+size_t BlowfishReadStream::pos() const {
+	return _pos;
+}
+
+size_t BlowfishReadStream::size() const {
+	return _size;
+}
+
+size_t BlowfishReadStream::seek(ptrdiff_t offset, Origin whence) {
+	const size_t oldPos = _pos;
+	const size_t newPos = evalSeek(offset, whence, _pos, 0, _size);
+	if (newPos > _size)
+		throw Exception(kSeekError);
+
+	_pos = newPos;
+	_eos = false;
+
+	return oldPos;
+}
+
+size_t BlowfishReadStream::read(void *dataPtr, size_t dataSize) {
+	const size_t readSize = readAt(_pos, dataPtr, dataSize);
+	if (readSize != dataSize)
+		_eos = true;
+
+	_pos += readSize;
+
+	return readSize;
+}
+
+void BlowfishReadStream::decrypt(byte *dest, size_t offset, size_t size) {
+	assert(((offset % kBlockSize) == 0) && ((size % kBlockSize) == 0));
+
+	if (_parentStream->readAt(offset, dest, size) != size)
+		throw Exception(kReadError);
+
+	blowfishBuffer(*_context, kModeDecrypt, dest, size);
+}
+
+const BlowfishReadStream::Chunk &BlowfishReadStream::getChunk(size_t index) {
+	Chunk *oldest = &_chunks[0];
+	for (size_t i = 0; i < kChunkCount; i++) {
+		if (_chunks[i].index == index) {
+			_chunks[i].lastUse = ++_useCount;
+			return _chunks[i];
+		}
+
+		if (_chunks[i].lastUse < oldest->lastUse)
+			oldest = &_chunks[i];
+	}
+
+	// Not decrypted yet. Replace the least recently used chunk
+	const size_t offset = index * kChunkSize;
+
+	oldest->index = SIZE_MAX;
+	decrypt(oldest->data, offset, MIN(kChunkSize, _size - offset));
+
+	oldest->index   = index;
+	oldest->lastUse = ++_useCount;
+
+	return *oldest;
+}
+
+size_t BlowfishReadStream::readAt(size_t offset, void *dataPtr, size_t dataSize) {
+	if (offset >= _size)
+		return 0;
+
+	dataSize = MIN(dataSize, _size - offset);
+
+	byte *data = static_cast<byte *>(dataPtr);
+
+	StackLock lock(_mutex);
+
+	size_t left = dataSize;
+	while (left > 0) {
+		const size_t index       = offset / kChunkSize;
+		const size_t chunkOffset = offset % kChunkSize;
+
+		// Whole chunks in the middle of a large read are decrypted straight into the destination
+		if ((chunkOffset == 0) && (left >= kChunkSize)) {
+			const size_t size = (left / kChunkSize) * kChunkSize;
+
+			decrypt(data, offset, size);
+
+			data   += size;
+			offset += size;
+			left   -= size;
+			continue;
+		}
+
+		const Chunk &chunk = getChunk(index);
+
+		const size_t size = MIN(left, MIN(kChunkSize, _size - index * kChunkSize) - chunkOffset);
+		std::memcpy(data, chunk.data + chunkOffset, size);
+
+		data   += size;
+		offset += size;
+		left   -= size;
+	}
+
+	return dataSize;
+}
+
 } // End of namespace Common
@@ -26,19 +26,105 @@
 #define COMMON_BLOWFISH_H
 
 #include <vector>
+#include <memory>
+
+#include <boost/noncopyable.hpp>
 
 #include "src/common/types.h"
+#include "src/common/scopedptr.h"
+#include "src/common/disposableptr.h"
+#include "src/common/mutex.h"
+#include "src/common/readstream.h"
 
 namespace Common {
 
-class SeekableReadStream;
 class MemoryReadStream;
 
+struct BlowfishContext;
+
 /** Encrypt the stream with the Blowfish algorithm in EBC mode. */
 MemoryReadStream *encryptBlowfishEBC(SeekableReadStream &input, const std::vector<byte> &key);
 /** Decrypt the stream with the Blowfish algorithm in EBC mode. */
 MemoryReadStream *decryptBlowfishEBC(SeekableReadStream &input, const std::vector<byte> &key);
 
+/** Encrypt a buffer in place with the Blowfish algorithm in EBC mode.
+ *
+ *  The size of the buffer has to be a multiple of 8. Several blocks are
+ *  processed side by side, and large buffers are split across threads.
+ */
+void encryptBlowfishEBC(byte *data, size_t size, const std::vector<byte> &key);
+/** Decrypt a buffer in place with the Blowfish algorithm in EBC mode.
+ *
+ *  The size of the buffer has to be a multiple of 8. Several blocks are
+ *  processed side by side, and large buffers are split across threads.
+ */
+void decryptBlowfishEBC(byte *data, size_t size, const std::vector<byte> &key);
+
+/** A stream decrypting Blowfish (EBC mode) encrypted data on demand.
+ *
+ *  In EBC mode, every block of 8 bytes is encrypted independently, so
+ *  any part of the data can be decrypted without touching the rest.
+ *  This stream only decrypts the chunks of the encrypted data that a
+ *  read actually covers, and keeps a few of the most recently used
+ *  decrypted chunks around.
+ *
+ *  Contrary to decryptBlowfishEBC(), which decrypts everything at once
+ *  into memory, this makes it possible to work with large encrypted
+ *  files without holding a decrypted copy of them.
+ *
+ *  The encrypted data is only read with readAt(). If the parent stream
+ *  supports concurrent readAt() calls, so does this stream.
+ */
+class BlowfishReadStream : boost::noncopyable, public SeekableReadStream {
+public:
+	/** Decrypt this parent stream, whose size has to be a multiple of 8, with this key. */
+	BlowfishReadStream(SeekableReadStream *parentStream, const std::vector<byte> &key,
+	                   bool disposeParentStream = true);
+	~BlowfishReadStream();
+
+	bool eos() const;
+
+	size_t pos() const;
+	size_t size() const;
+
+	size_t seek(ptrdiff_t offset, Origin whence = kOriginBegin);
+	size_t read(void *dataPtr, size_t dataSize);
+	size_t readAt(size_t offset, void *dataPtr, size_t dataSize);
+
+private:
+	/** The size of a chunk of decrypted data. A multiple of the Blowfish block size. */
+	static const size_t kChunkSize  = 4096;
+	/** The number of decrypted chunks to keep. */
+	static const size_t kChunkCount = 16;
+
+	/** A chunk of decrypted data. */
+	struct Chunk {
+		size_t index;   ///< The index of this chunk within the stream, or SIZE_MAX if unused.
+		uint64 lastUse; ///< When this chunk was last used.
+
+		byte data[kChunkSize];
+	};
+
+	DisposablePtr<SeekableReadStream> _parentStream;
+
+	std::shared_ptr<const BlowfishContext> _context;
+
+	size_t _size;
+	size_t _pos;
+	bool   _eos;
+
+	ScopedArray<Chunk> _chunks;
+	uint64 _useCount;
+
+	Mutex _mutex;
+
+	/** Read and decrypt the data of this range of the parent stream into dest. */
+	void decrypt(byte *dest, size_t offset, size_t size);
+
+	/** Return the chunk with this index, decrypting it if necessary. */
+	const Chunk &getChunk(size_t index);
+};
+
 } // End of namespace Common
 
 #endif // COMMON_BLOWFISH_H
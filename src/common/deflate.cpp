@@ -22,6 +22,9 @@
  *  Compress (deflate) and decompress (inflate) using zlib's DEFLATE algorithm.
  */
 
+#include <cassert>
+#include <cstring>
+
 #include <zlib.h>
 
 #include <boost/scope_exit.hpp>
@@ -29,6 +32,7 @@
 #include "src/common/deflate.h"
 #include "src/common/error.h"
 #include "src/common/scopedptr.h"
+#include "src/common/util.h"
 #include "src/common/memreadstream.h"
 
 namespace Common {
@@ -93,4 +97,268 @@ SeekableReadStream *decompressDeflate(ReadStream &input, size_t inputSize,
 	return new MemoryReadStream(decompressedData, outputSize, true);
 }
 
+
+/** The size of the window, the history buffer inflate might reference. */
+static const size_t kDeflateWindowSize = 1 << kWindowBitsMax;
+/** The size of the compressed data chunks fed to zlib. */
+static const size_t kDeflateInputSize  = 16384;
+
+struct DeflateReadStream::Checkpoint {
+	size_t outputPos; ///< The position within the decompressed data.
+	size_t inputPos;  ///< The position within the compressed data.
+	int bits;         ///< The number of bits of the previous input byte not yet consumed.
+
+	/** The decompressed data leading up to this checkpoint. */
+	ScopedArray<byte> window;
+	size_t windowSize;
+};
+
+DeflateReadStream::DeflateReadStream(SeekableReadStream *input, size_t outputSize, int windowBits,
+                                     bool disposeInput, size_t checkpointSpan) :
+	_input(input, disposeInput), _inputSize(0), _inputPos(0), _size(outputSize), _pos(0), _decodedPos(0),
+	_eos(false), _streamEnd(false), _windowBits(windowBits), _checkpointSpan(checkpointSpan),
+	_strm(new z_stream), _windowEnd(0) {
+
+	assert(_input);
+
+	_inputSize = _input->size();
+
+	_inputBuffer.reset(new byte[kDeflateInputSize]);
+	_window.reset(new byte[kDeflateWindowSize]);
+
+	init(_windowBits);
+}
+
+DeflateReadStream::~DeflateReadStream() {
+	inflateEnd(_strm.get());
+}
+
+void DeflateReadStream::init(int windowBits) {
+	_strm->zalloc   = Z_NULL;
+	_strm->zfree    = Z_NULL;
+	_strm->opaque   = Z_NULL;
+	_strm->avail_in = 0;
+	_strm->next_in  = Z_NULL;
+
+	const int zResult = inflateInit2(_strm.get(), windowBits);
+	if (zResult != Z_OK)
+		throw Exception("Could not initialize zlib inflate: %s (%d)", zError(zResult), zResult);
+}
+
+void DeflateReadStream::restart() {
+	inflateEnd(_strm.get());
+	init(_windowBits);
+
+	_inputPos   = 0;
+	_decodedPos = 0;
+	_windowEnd  = 0;
+	_streamEnd  = false;
+}
+
+void DeflateReadStream::restart(const Checkpoint &checkpoint) {
+	// A checkpoint is always in the middle of raw DEFLATE data, past any headers
+	inflateEnd(_strm.get());
+	init(kWindowBitsMaxRaw);
+
+	_inputPos = checkpoint.inputPos;
+
+	if (checkpoint.bits > 0) {
+		// Feed the rest of the partially consumed byte
+		byte value;
+		if (_input->readAt(checkpoint.inputPos - 1, &value, 1) != 1)
+			throw Exception(kReadError);
+
+		inflatePrime(_strm.get(), checkpoint.bits, value >> (8 - checkpoint.bits));
+	}
+
+	inflateSetDictionary(_strm.get(), checkpoint.window.get(), checkpoint.windowSize);
+
+	std::memcpy(_window.get(), checkpoint.window.get(), checkpoint.windowSize);
+
+	_windowEnd  = checkpoint.windowSize;
+	_decodedPos = checkpoint.outputPos;
+	_streamEnd  = false;
+}
+
+void DeflateReadStream::fillInput() {
+	const size_t size = MIN(kDeflateInputSize, _inputSize - _inputPos);
+	if ((size > 0) && (_input->readAt(_inputPos, _inputBuffer.get(), size) != size))
+		throw Exception(kReadError);
+
+	_inputPos += size;
+
+	_strm->next_in  = _inputBuffer.get();
+	_strm->avail_in = size;
+}
+
+void DeflateReadStream::inflateChunk() {
+	if (_streamEnd)
+		throw Exception("Failed to inflate: output buffer not completely filled");
+
+	// Start over at the beginning of the ring buffer once it's full
+	if (_windowEnd == kDeflateWindowSize)
+		_windowEnd = 0;
+
+	const size_t chunkSize = kDeflateWindowSize - _windowEnd;
+
+	_strm->next_out  = _window.get() + _windowEnd;
+	_strm->avail_out = chunkSize;
+
+	// With checkpoints, let inflate stop at each block boundary, so that we can record one there
+	const int flush = (_checkpointSpan > 0) ? Z_BLOCK : Z_NO_FLUSH;
+
+	while (_strm->avail_out == chunkSize) {
+		if (_strm->avail_in == 0)
+			fillInput();
+
+		const bool inputEmpty = _strm->avail_in == 0;
+
+		const int zResult = inflate(_strm.get(), flush);
+		if (zResult == Z_STREAM_END) {
+			_streamEnd = true;
+			break;
+		}
+
+		if ((zResult == Z_BUF_ERROR) && inputEmpty)
+			throw Exception("Failed to inflate: premature end of input data");
+
+		if ((zResult != Z_OK) && (zResult != Z_BUF_ERROR))
+			throw Exception("Failed to inflate: %s (%d)", zError(zResult), zResult);
+
+		// Are we at a block boundary, and not after the last block?
+		if ((flush == Z_BLOCK) && (_strm->data_type & 128) && !(_strm->data_type & 64)) {
+			const size_t produced = chunkSize - _strm->avail_out;
+
+			addCheckpoint(_windowEnd + produced, _decodedPos + produced);
+		}
+	}
+
+	const size_t produced = chunkSize - _strm->avail_out;
+	if (produced == 0)
+		throw Exception("Failed to inflate: output buffer not completely filled");
+
+	_windowEnd  += produced;
+	_decodedPos += produced;
+}
+
+void DeflateReadStream::addCheckpoint(size_t windowEnd, size_t decodedPos) {
+	const size_t lastPos = _checkpoints.empty() ? 0 : _checkpoints.back()->outputPos;
+	if ((decodedPos <= lastPos) || ((decodedPos - lastPos) < _checkpointSpan))
+		return;
+
+	ScopedPtr<Checkpoint> checkpoint(new Checkpoint);
+
+	checkpoint->outputPos  = decodedPos;
+	checkpoint->inputPos   = _inputPos - _strm->avail_in;
+	checkpoint->bits       = _strm->data_type & 7;
+	checkpoint->windowSize = MIN(decodedPos, kDeflateWindowSize);
+
+	checkpoint->window.reset(new byte[checkpoint->windowSize]);
+
+	// Unwrap the ring buffer, so that the window ends with the latest data
+	byte *window = checkpoint->window.get();
+	if (windowEnd >= checkpoint->windowSize) {
+		std::memcpy(window, _window.get() + windowEnd - checkpoint->windowSize, checkpoint->windowSize);
+	} else {
+		const size_t tailSize = checkpoint->windowSize - windowEnd;
+
+		std::memcpy(window, _window.get() + kDeflateWindowSize - tailSize, tailSize);
+		std::memcpy(window + tailSize, _window.get(), windowEnd);
+	}
+
+	_checkpoints.push_back(checkpoint.release());
+}
+
+const DeflateReadStream::Checkpoint *DeflateReadStream::findCheckpoint(size_t position) const {
+	const Checkpoint *checkpoint = 0;
+
+	for (std::vector<Checkpoint *>::const_iterator c = _checkpoints.begin(); c != _checkpoints.end(); ++c) {
+		if ((*c)->outputPos > position)
+			break;
+
+		checkpoint = *c;
+	}
+
+	return checkpoint;
+}
+
+bool DeflateReadStream::eos() const {
+	return _eos;
+}
+
+size_t DeflateReadStream::pos() const {
+	return _pos;
+}
+
+size_t DeflateReadStream::size() const {
+	return _size;
+}
+
+size_t DeflateReadStream::seek(ptrdiff_t offset, Origin whence) {
+	const size_t oldPos = _pos;
+	const size_t newPos = evalSeek(offset, whence, _pos, 0, _size);
+	if (newPos > _size)
+		throw Exception(kSeekError);
+
+	seekDecoder(newPos);
+
+	_pos = newPos;
+	_eos = false;
+
+	return oldPos;
+}
+
+size_t DeflateReadStream::read(void *dataPtr, size_t dataSize) {
+	if (dataSize > (_size - _pos)) {
+		dataSize = _size - _pos;
+		_eos = true;
+	}
+
+	_pos += readData(_pos, static_cast<byte *>(dataPtr), dataSize);
+
+	return dataSize;
+}
+
+size_t DeflateReadStream::readAt(size_t offset, void *dataPtr, size_t dataSize) {
+	if (offset >= _size)
+		return 0;
+
+	return readData(offset, static_cast<byte *>(dataPtr), MIN(dataSize, _size - offset));
+}
+
+void DeflateReadStream::seekDecoder(size_t position) {
+	// The start of the latest inflated chunk is the furthest back we can go without inflating again
+	const size_t chunkStart = _decodedPos - _windowEnd;
+
+	const Checkpoint *checkpoint = findCheckpoint(position);
+	if (checkpoint && ((checkpoint->outputPos > _decodedPos) || (position < chunkStart)))
+		restart(*checkpoint);
+	else if (position < chunkStart)
+		restart();
+
+	while (_decodedPos < position)
+		inflateChunk();
+}
+
+size_t DeflateReadStream::readData(size_t position, byte *data, size_t dataSize) {
+	seekDecoder(position);
+
+	size_t left = dataSize;
+	while (left > 0) {
+		if (position == _decodedPos)
+			inflateChunk();
+
+		const size_t available = _decodedPos - position;
+		const size_t chunk     = MIN(available, left);
+
+		std::memcpy(data, _window.get() + _windowEnd - available, chunk);
+
+		data     += chunk;
+		left     -= chunk;
+		position += chunk;
+	}
+
+	return dataSize;
+}
+
 } // End of namespace Common
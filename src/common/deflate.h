@@ -26,6 +26,11 @@
 #define COMMON_DEFLATE_H
 
 #include "src/common/types.h"
+#include "src/common/scopedptr.h"
+#include "src/common/ptrvector.h"
+#include "src/common/readstream.h"
+
+struct z_stream_s;
 
 namespace Common {
 
@@ -35,9 +40,6 @@ namespace Common {
  *   of the decompressed data beforehand
  */
 
-class ReadStream;
-class SeekableReadStream;
-
 static const int kWindowBitsMax    =  15;
 static const int kWindowBitsMaxRaw = -kWindowBitsMax;
 
@@ -73,6 +75,103 @@ byte *decompressDeflate(const byte *data, size_t inputSize,
 SeekableReadStream *decompressDeflate(ReadStream &input, size_t inputSize,
                                       size_t outputSize, int windowBits);
 
+/** A stream that decompresses (inflates) DEFLATE data on demand.
+ *
+ *  Unlike decompressDeflate(), which inflates everything in one go into a
+ *  buffer of the full decompressed size, this stream only ever holds a
+ *  small, fixed amount of compressed and decompressed data in memory, and
+ *  inflates more as it is being read.
+ *
+ *  Seeking forward inflates and throws away the data in between. Seeking
+ *  backward, further back than the last inflated chunk, restarts at the
+ *  beginning of the compressed data. Unless checkpoints are enabled: then
+ *  the decompressor state (the position within the compressed data and the
+ *  last 32KB of output) is remembered about every checkpointSpan bytes of
+ *  output, and inflating restarts at the closest checkpoint instead.
+ *
+ *  The compressed input is only ever read with readAt(), so several
+ *  DeflateReadStreams can share the same input stream.
+ *
+ *  readAt() inflates onwards from wherever the decompressor currently is
+ *  (or from the closest checkpoint), without seeking back afterwards. A
+ *  SeekableSubReadStream reading through this stream therefore inflates
+ *  everything only once. Like read(), it's not safe to call concurrently.
+ *
+ *  Note that since inflating is deferred, broken compressed data is only
+ *  detected, and an exception thrown, when reading.
+ */
+class DeflateReadStream : public SeekableReadStream {
+public:
+	/** Create a stream inflating DEFLATE data.
+	 *
+	 *  @param input          The compressed data, from its beginning to its end.
+	 *  @param outputSize     The size of the decompressed data.
+	 *  @param windowBits     The base two logarithm of the window size (the size
+	 *                        of the history buffer). See the zlib documentation
+	 *                        on inflateInit2() for details.
+	 *  @param disposeInput   Should the input stream be deleted together with this stream?
+	 *  @param checkpointSpan Record a checkpoint about every this many bytes of output.
+	 *                        If 0, no checkpoints are recorded at all.
+	 */
+	DeflateReadStream(SeekableReadStream *input, size_t outputSize, int windowBits,
+	                  bool disposeInput = true, size_t checkpointSpan = 0);
+	~DeflateReadStream();
+
+	bool eos() const;
+
+	size_t pos() const;
+	size_t size() const;
+
+	size_t seek(ptrdiff_t offset, Origin whence = kOriginBegin);
+
+	size_t read(void *dataPtr, size_t dataSize);
+	size_t readAt(size_t offset, void *dataPtr, size_t dataSize);
+
+private:
+	struct Checkpoint;
+
+	DisposablePtr<SeekableReadStream> _input;
+
+	size_t _inputSize; ///< The size of the compressed data.
+	size_t _inputPos;  ///< The position of the next compressed data to feed to zlib.
+
+	size_t _size;       ///< The size of the decompressed data.
+	size_t _pos;        ///< The current position within the decompressed data.
+	size_t _decodedPos; ///< The amount of decompressed data inflated so far.
+
+	bool _eos;
+	bool _streamEnd;
+
+	int _windowBits;
+	size_t _checkpointSpan;
+
+	ScopedPtr<z_stream_s> _strm;
+
+	ScopedArray<byte> _inputBuffer;
+
+	/** The last inflated data. This is a ring buffer, of which the data
+	 *  from the start to _windowEnd is the latest chunk that was inflated. */
+	ScopedArray<byte> _window;
+	size_t _windowEnd;
+
+	PtrVector<Checkpoint> _checkpoints;
+
+	void init(int windowBits);
+	void restart();
+	void restart(const Checkpoint &checkpoint);
+
+	void fillInput();
+	void inflateChunk();
+	void addCheckpoint(size_t windowEnd, size_t decodedPos);
+
+	const Checkpoint *findCheckpoint(size_t position) const;
+
+	/** Get the decompressor to where the data at this position is in, or is next added to, the window. */
+	void seekDecoder(size_t position);
+	/** Copy decompressed data from this position, inflating more as needed. */
+	size_t readData(size_t position, byte *data, size_t dataSize);
+};
+
 } // End of namespace Common
 
 #endif // COMMON_DEFLATE_H
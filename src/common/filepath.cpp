@@ -40,8 +40,10 @@ using boost::filesystem::exists;
 using boost::filesystem::is_regular_file;
 using boost::filesystem::is_directory;
 using boost::filesystem::file_size;
+using boost::filesystem::last_write_time;
 using boost::filesystem::directory_iterator;
 using boost::filesystem::create_directories;
+using boost::filesystem::rename;
 
 // boost-string_algo
 using boost::equals;
@@ -78,6 +80,15 @@ size_t FilePath::getFileSize(const UString &p) {
 	return size;
 }
 
+int64 FilePath::getModificationTime(const UString &p) {
+	try {
+		return (int64) last_write_time(p.c_str());
+	} catch (...) {
+	}
+
+	return -1;
+}
+
 UString FilePath::getFile(const UString &p) {
 	path file(p.c_str());
 
@@ -347,6 +358,14 @@ bool FilePath::createDirectories(const UString &path) {
 	}
 }
 
+void FilePath::renameFile(const UString &oldPath, const UString &newPath) {
+	try {
+		rename(oldPath.c_str(), newPath.c_str());
+	} catch (std::exception &se) {
+		throw Exception(se);
+	}
+}
+
 UString FilePath::escapeStringLiteral(const UString &str) {
 	const boost::regex esc("[\\^\\.\\$\\|\\(\\)\\[\\]\\*\\+\\?\\/\\\\]");
 	const std::string  rep("\\\\\\1&");
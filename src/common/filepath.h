@@ -58,6 +58,13 @@ public:
 	 */
 	static size_t getFileSize(const UString &p);
 
+	/** Return the time a file or directory was last modified.
+	 *
+	 *  @param  p The file or directory to look up.
+	 *  @return The modification time in seconds since the epoch, or -1 if not a valid path.
+	 */
+	static int64 getModificationTime(const UString &p);
+
 	/** Return a file name without its path.
 	 *
 	 *  Example: "/path/to/file.ext" > "file.ext"
@@ -201,6 +208,15 @@ public:
 	 */
 	static bool createDirectories(const UString &path);
 
+	/** Rename a file, replacing the target file if it already exists.
+	 *
+	 *  Unlike std::rename(), this also replaces an existing target on Windows.
+	 *
+	 *  @param oldPath The current path of the file.
+	 *  @param newPath The path to move the file to.
+	 */
+	static void renameFile(const UString &oldPath, const UString &newPath);
+
 	/** Escape a string literal for use in a regexp. */
 	static UString escapeStringLiteral(const UString &str);
 
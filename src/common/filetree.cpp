@@ -22,20 +22,28 @@
  *  A tree structure of files in directories.
  */
 
+#include <utility>
+
 #include "src/common/filetree.h"
 #include "src/common/filepath.h"
 #include "src/common/error.h"
 
 namespace Common {
 
-FileTree::Entry::Entry() {
+FileTree::Entry::Entry() : directory(false), size(kFileInvalid), mtime(-1) {
 }
 
-FileTree::Entry::Entry(const boost::filesystem::path &p) : name(p.filename().generic_string()), path(p) {
+FileTree::Entry::Entry(const boost::filesystem::path &p) : name(p.filename().generic_string()), path(p),
+	directory(boost::filesystem::is_directory(p)), size(kFileInvalid), mtime(-1) {
+
+	if (!directory)
+		size = FilePath::getFileSize(p.generic_string());
+
+	mtime = FilePath::getModificationTime(p.generic_string());
 }
 
 bool FileTree::Entry::isDirectory() const {
-	return boost::filesystem::is_directory(path);
+	return directory;
 }
 
 
@@ -46,9 +54,7 @@ FileTree::~FileTree() {
 }
 
 void FileTree::clear() {
-	_root.name.clear();
-	_root.path.clear();
-	_root.children.clear();
+	_root = Entry();
 }
 
 bool FileTree::isEmpty() const {
@@ -59,6 +65,10 @@ const FileTree::Entry &FileTree::getRoot() const {
 	return _root;
 }
 
+void FileTree::setRoot(Entry &&root) {
+	_root = std::move(root);
+}
+
 void FileTree::readPath(const UString &path, int recurseDepth) {
 	return readPath(boost::filesystem::path(path.c_str()), recurseDepth);
 }
@@ -72,8 +82,7 @@ void FileTree::readPath(boost::filesystem::path path, int recurseDepth) {
 
 	path = FilePath::normalize(path.generic_string().c_str()).c_str();
 
-	_root.name = path.filename().generic_string();
-	_root.path = path;
+	_root = Entry(path);
 
 	// If we can't or shouldn't recurse, we're done
 	if (boost::filesystem::is_regular_file(path) || (recurseDepth == 0))
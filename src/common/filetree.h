@@ -29,6 +29,7 @@
 
 #include <list>
 
+#include "src/common/types.h"
 #include "src/common/ustring.h"
 
 namespace Common {
@@ -43,6 +44,13 @@ public:
 		/** The full normalized path of the file or directory. */
 		boost::filesystem::path path;
 
+		/** Is this entry a directory? */
+		bool directory;
+		/** The size of the file, or kFileInvalid for directories. */
+		size_t size;
+		/** The time the file or directory was last modified, or -1 if unknown. */
+		int64 mtime;
+
 		/** The files and directories inside this directory entry. */
 		std::list<Entry> children;
 
@@ -64,6 +72,9 @@ public:
 	/** Return the root node. */
 	const Entry &getRoot() const;
 
+	/** Replace the whole tree with this root node, for example one restored from a cache. */
+	void setRoot(Entry &&root);
+
 	/** Fill the tree with this path.
 	 *
 	 *  @param  p The path to read.
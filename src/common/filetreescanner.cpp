@@ -0,0 +1,216 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Reading a tree of files in directories in the background.
+ */
+
+#include <utility>
+
+#include "src/common/util.h"
+#include "src/common/filetreescanner.h"
+#include "src/common/filepath.h"
+
+namespace Common {
+
+/** Copy an entry, without its children. */
+static FileTree::Entry copyEntry(const FileTree::Entry &entry) {
+	FileTree::Entry copy;
+
+	copy.name      = entry.name;
+	copy.path      = entry.path;
+	copy.directory = entry.directory;
+	copy.size      = entry.size;
+	copy.mtime     = entry.mtime;
+
+	return copy;
+}
+
+
+FileTreeScanner::Batch::Batch(const boost::filesystem::path &d) : directory(d) {
+}
+
+
+FileTreeScanner::FileTreeScanner(size_t batchSize) : _batchSize(MAX<size_t>(batchSize, 1)),
+	_source(nullptr), _finished(false) {
+}
+
+FileTreeScanner::~FileTreeScanner() {
+	try {
+		cancel();
+	} catch (...) {
+	}
+}
+
+void FileTreeScanner::scan(const UString &path) {
+	boost::filesystem::path p(path.c_str());
+
+	// The path needs to exist
+	if (!boost::filesystem::exists(p))
+		throw Exception("Path \"%s\" does not exist", p.generic_string().c_str());
+
+	p = FilePath::normalize(p.generic_string().c_str()).c_str();
+
+	_tree   = FileTree::Entry(p);
+	_root   = copyEntry(_tree);
+	_source = nullptr;
+
+	createThread();
+}
+
+void FileTreeScanner::scan(const FileTree::Entry &root) {
+	_root   = copyEntry(root);
+	_source = &root;
+
+	createThread();
+}
+
+void FileTreeScanner::cancel() {
+	destroyThread();
+
+	_finished = true;
+}
+
+void FileTreeScanner::wait() {
+	waitThread();
+}
+
+bool FileTreeScanner::isFinished() const {
+	return _finished;
+}
+
+const FileTree::Entry &FileTreeScanner::getRoot() const {
+	return _root;
+}
+
+bool FileTreeScanner::takeBatches(std::list<Batch> &batches, std::list<Exception> &errors) {
+	// Check before taking, so that we can't miss the last batches
+	const bool finished = _finished;
+
+	StackLock lock(_mutex);
+
+	batches.splice(batches.end(), _batches);
+	errors.splice(errors.end(), _errors);
+
+	return !finished;
+}
+
+void FileTreeScanner::getTree(FileTree &tree) {
+	wait();
+
+	tree.setRoot(std::move(_tree));
+	_tree = FileTree::Entry();
+}
+
+void FileTreeScanner::threadMethod() {
+	if (_source)
+		streamTree();
+	else
+		readTree();
+
+	_finished = true;
+}
+
+void FileTreeScanner::readTree() {
+	if (!_tree.isDirectory())
+		return;
+
+	std::list<FileTree::Entry *> directories(1, &_tree);
+	while (!directories.empty() && !shouldQuitThread()) {
+		FileTree::Entry &directory = *directories.front();
+		directories.pop_front();
+
+		Batch batch(directory.path);
+
+		try {
+			boost::filesystem::directory_iterator itEnd;
+			for (boost::filesystem::directory_iterator itDir(directory.path); itDir != itEnd; ++itDir) {
+				if (shouldQuitThread())
+					return;
+
+				directory.children.push_back(FileTree::Entry(itDir->path()));
+				addEntry(batch, directory.children.back());
+			}
+
+		} catch (Exception &e) {
+			e.add("Failed to read path \"%s\"", directory.path.generic_string().c_str());
+
+			pushError(e);
+		} catch (std::exception &e) {
+			Exception se(e);
+
+			se.add("Failed to read path \"%s\"", directory.path.generic_string().c_str());
+			pushError(se);
+		}
+
+		pushBatch(batch);
+
+		for (std::list<FileTree::Entry>::iterator c = directory.children.begin(); c != directory.children.end(); ++c)
+			if (c->isDirectory())
+				directories.push_back(&*c);
+	}
+}
+
+void FileTreeScanner::streamTree() {
+	std::list<const FileTree::Entry *> directories(1, _source);
+	while (!directories.empty() && !shouldQuitThread()) {
+		const FileTree::Entry &directory = *directories.front();
+		directories.pop_front();
+
+		Batch batch(directory.path);
+
+		for (std::list<FileTree::Entry>::const_iterator c = directory.children.begin();
+		     c != directory.children.end(); ++c) {
+
+			addEntry(batch, *c);
+
+			if (c->isDirectory())
+				directories.push_back(&*c);
+		}
+
+		pushBatch(batch);
+	}
+}
+
+void FileTreeScanner::addEntry(Batch &batch, const FileTree::Entry &entry) {
+	batch.entries.push_back(copyEntry(entry));
+
+	// Hand out big directories in pieces, so that they show up early
+	if (batch.entries.size() >= _batchSize)
+		pushBatch(batch);
+}
+
+void FileTreeScanner::pushBatch(Batch &batch) {
+	if (batch.entries.empty())
+		return;
+
+	StackLock lock(_mutex);
+
+	_batches.push_back(Batch(batch.directory));
+	_batches.back().entries.swap(batch.entries);
+}
+
+void FileTreeScanner::pushError(const Exception &error) {
+	StackLock lock(_mutex);
+
+	_errors.push_back(error);
+}
+
+} // End of namespace Common
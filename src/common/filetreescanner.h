@@ -0,0 +1,137 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Reading a tree of files in directories in the background.
+ */
+
+#ifndef COMMON_FILETREESCANNER_H
+#define COMMON_FILETREESCANNER_H
+
+#include "src/common/atomic.h"
+
+#include <list>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "src/common/types.h"
+#include "src/common/ustring.h"
+#include "src/common/error.h"
+#include "src/common/mutex.h"
+#include "src/common/thread.h"
+#include "src/common/filetree.h"
+
+namespace Common {
+
+/** Read a FileTree in a background thread, breadth-first, and hand out the found entries in batches.
+ *
+ *  The batches of a directory always come after the batch holding the directory
+ *  itself, so a consumer can build up its own tree level by level while the
+ *  deeper levels are still being read.
+ *
+ *  A scanner can only be used for one scan.
+ */
+class FileTreeScanner : public Thread {
+public:
+	/** Entries found in one directory. */
+	struct Batch {
+		/** The full normalized path of the directory the entries are in. */
+		boost::filesystem::path directory;
+		/** The entries, without their children. */
+		std::vector<FileTree::Entry> entries;
+
+		Batch(const boost::filesystem::path &d);
+	};
+
+	/** The default maximum number of entries in one batch. */
+	static const size_t kBatchSize = 256;
+
+	FileTreeScanner(size_t batchSize = kBatchSize);
+	~FileTreeScanner();
+
+	/** Start reading the tree of this path.
+	 *
+	 *  @param path The path to read. Subdirectories are read without any depth limit.
+	 */
+	void scan(const UString &path);
+
+	/** Start handing out the entries of an already read tree, for example one restored from a cache.
+	 *
+	 *  The tree is not copied, so it has to stay unchanged until the scan
+	 *  finished or was cancelled.
+	 */
+	void scan(const FileTree::Entry &root);
+
+	/** Stop the scan. Once this returns, no further batches will be added. */
+	void cancel();
+	/** Wait for the scan to finish. */
+	void wait();
+
+	/** Has the scan finished, or was it cancelled? */
+	bool isFinished() const;
+
+	/** Return the root entry of the scan, without its children. */
+	const FileTree::Entry &getRoot() const;
+
+	/** Move all batches found so far to the end of this list.
+	 *
+	 *  @param batches The list to add to.
+	 *  @param errors  Failures to read a directory, which were skipped.
+	 *  @return true if there might be more batches to come, false if the scan finished.
+	 */
+	bool takeBatches(std::list<Batch> &batches, std::list<Exception> &errors);
+
+	/** Move the complete tree read from the disk into this FileTree.
+	 *
+	 *  Only valid once a scan of a path has finished.
+	 */
+	void getTree(FileTree &tree);
+
+private:
+	size_t _batchSize;
+
+	/** The tree we are reading from the disk. */
+	FileTree::Entry _tree;
+	/** The tree we are handing out, if it has already been read. */
+	const FileTree::Entry *_source;
+
+	/** The root entry, without its children. */
+	FileTree::Entry _root;
+
+	boost::atomic<bool> _finished;
+
+	Mutex _mutex;
+	std::list<Batch> _batches;
+	std::list<Exception> _errors;
+
+	void threadMethod();
+
+	void readTree();
+	void streamTree();
+
+	void addEntry(Batch &batch, const FileTree::Entry &entry);
+	void pushBatch(Batch &batch);
+	void pushError(const Exception &error);
+};
+
+} // End of namespace Common
+
+#endif // COMMON_FILETREESCANNER_H
@@ -31,7 +31,7 @@
 
 namespace Common {
 
-Huffman::Symbol::Symbol(uint32 c, uint32 s) : code(c), symbol(s) {
+Huffman::TableEntry::TableEntry() : value(0), length(0) {
 }
 
 
@@ -59,38 +59,146 @@ void Huffman::init(uint8 maxLength, size_t codeCount, const uint32 *codes,
 
 	assert(maxLength <= 32);
 
-	_codes.resize(maxLength);
-	_symbols.resize(codeCount);
-
+	_codes.resize(codeCount);
 	for (size_t i = 0; i < codeCount; i++) {
-		// The symbol. If none were specified, just assume it's identical to the code index
-		uint32 symbol = symbols ? symbols[i] : i;
+		assert((lengths[i] > 0) && (lengths[i] <= maxLength));
 
-		// Put the code and symbol into the correct list
-		_codes[lengths[i] - 1].push_back(Symbol(codes[i], symbol));
+		_codes[i].code   = codes[i];
+		_codes[i].length = lengths[i];
 
-		// And put the pointer to the symbol/code struct into the symbol list.
-		_symbols[i] = &_codes[lengths[i] - 1].back();
+		// The symbol. If none were specified, just assume it's identical to the code index
+		_codes[i].symbol = symbols ? symbols[i] : i;
 	}
+
+	_tableBits = MIN(maxLength, kLookupBits);
+
+	buildTables();
 }
 
 Huffman::~Huffman() {
 }
 
 void Huffman::setSymbols(const uint32 *symbols) {
-	for (size_t i = 0; i < _symbols.size(); i++)
-		_symbols[i]->symbol = symbols ? *symbols++ : i;
+	for (size_t i = 0; i < _codes.size(); i++)
+		_codes[i].symbol = symbols ? *symbols++ : i;
+
+	buildTables();
+}
+
+void Huffman::buildTables() {
+	for (int i = 0; i < 2; i++) {
+		const bool msbFirst = i == 0;
+
+		_tables[i].clear();
+		_tables[i].resize(1 << _tableBits);
+
+		buildTable(_tables[i], 0, _tableBits, _codes, msbFirst);
+	}
+}
+
+/** Return the lowest n bits of x. */
+static inline uint32 lowBits(uint32 x, uint8 n) {
+	return (n >= 32) ? x : (x & ((1U << n) - 1));
+}
+
+void Huffman::buildTable(Table &table, size_t offset, uint8 tableBits,
+                         const std::vector<Code> &codes, bool msbFirst) {
+
+	/* A code of length n is read either with its most significant bit first,
+	 * or with its least significant bit first. For a table indexed with the
+	 * next tableBits bits of the bitstream, a short code therefore either
+	 * occupies the top or the bottom bits of the index, and the remaining
+	 * index bits belong to the code following it. A code longer than the
+	 * table index continues into a sub table. */
+
+	std::vector<Code> longCodes;
+
+	for (std::vector<Code>::const_iterator c = codes.begin(); c != codes.end(); ++c) {
+		if (c->length > tableBits) {
+			longCodes.push_back(*c);
+			continue;
+		}
+
+		const uint8  fillBits  = tableBits - c->length;
+		const uint32 fillCount = 1U << fillBits;
+
+		for (uint32 fill = 0; fill < fillCount; fill++) {
+			const uint32 index = msbFirst ? ((c->code << fillBits) | fill) : (c->code | (fill << c->length));
+
+			TableEntry &entry = table[offset + index];
+
+			// Don't let an ambiguous short code override a code we already have
+			if (entry.length != 0)
+				continue;
+
+			entry.value  = c->symbol;
+			entry.length = c->length;
+		}
+	}
+
+	// Sort the long codes into sub tables, by the bits that index this table
+	while (!longCodes.empty()) {
+		const Code &first = longCodes.front();
+
+		const uint32 prefix = msbFirst ? (first.code >> (first.length - tableBits)) : lowBits(first.code, tableBits);
+
+		std::vector<Code> subCodes, otherCodes;
+		uint8 maxLength = 0;
+
+		for (std::vector<Code>::const_iterator c = longCodes.begin(); c != longCodes.end(); ++c) {
+			const uint32 codePrefix = msbFirst ? (c->code >> (c->length - tableBits)) : lowBits(c->code, tableBits);
+			if (codePrefix != prefix) {
+				otherCodes.push_back(*c);
+				continue;
+			}
+
+			Code subCode = *c;
+
+			subCode.length -= tableBits;
+			subCode.code    = msbFirst ? lowBits(c->code, subCode.length) : (c->code >> tableBits);
+
+			subCodes.push_back(subCode);
+			maxLength = MAX(maxLength, subCode.length);
+		}
+
+		const uint8  subTableBits   = MIN(maxLength, kLookupBits);
+		const size_t subTableOffset = table.size();
+
+		TableEntry &entry = table[offset + prefix];
+		if (entry.length == 0) {
+			entry.value  = subTableOffset;
+			entry.length = -((int8) subTableBits);
+
+			table.resize(subTableOffset + (1 << subTableBits));
+
+			buildTable(table, subTableOffset, subTableBits, subCodes, msbFirst);
+		}
+
+		longCodes.swap(otherCodes);
+	}
 }
 
 uint32 Huffman::getSymbol(BitStream &bits) const {
-	uint32 code = 0;
+	const Table &table = _tables[bits.isMSBFirst() ? 0 : 1];
+
+	size_t offset    = 0;
+	uint8  tableBits = _tableBits;
+
+	while (true) {
+		const TableEntry &entry = table[offset + bits.peekBits(tableBits)];
+
+		if (entry.length > 0) {
+			bits.skip(entry.length);
+			return entry.value;
+		}
+
+		if (entry.length == 0)
+			break;
 
-	for (size_t i = 0; i < _codes.size(); i++) {
-		bits.addBit(code, i);
+		bits.skip(tableBits);
 
-		for (CodeList::const_iterator cCode = _codes[i].begin(); cCode != _codes[i].end(); ++cCode)
-			if (code == cCode->code)
-				return cCode->symbol;
+		offset    = entry.value;
+		tableBits = -entry.length;
 	}
 
 	throw Exception("Unknown Huffman code");
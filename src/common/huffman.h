@@ -26,7 +26,6 @@
 #define COMMON_HUFFMAN_H
 
 #include <vector>
-#include <list>
 
 #include "src/common/types.h"
 
@@ -43,7 +42,14 @@ struct HuffmanTable {
 	const uint32 *symbols; ///< The symbols, 0 if identical to the codes.
 };
 
-/** Decode a Huffman'd bitstream. */
+/** Decode a Huffman'd bitstream.
+ *
+ *  The codes are decoded with lookup tables, built once on construction:
+ *  the decoder peeks at the next kLookupBits bits of the bitstream and
+ *  finds the symbol of any code up to that length with a single table
+ *  access. Longer codes continue into sub tables, indexed by the bits
+ *  following the first kLookupBits bits.
+ */
 class Huffman {
 public:
 	/** Construct a Huffman decoder.
@@ -66,25 +72,42 @@ public:
 	uint32 getSymbol(BitStream &bits) const;
 
 private:
-	struct Symbol {
+	/** The number of bits the first level lookup table is indexed with. */
+	static const uint8 kLookupBits = 9;
+
+	struct Code {
 		uint32 code;
+		uint8  length;
 		uint32 symbol;
+	};
 
-		Symbol(uint32 c, uint32 s);
+	/** An entry in a lookup table. */
+	struct TableEntry {
+		/** The symbol, or for a sub table, the offset of that sub table. */
+		uint32 value;
+		/** The length of the code, or the negated number of index bits of a sub table. 0 for invalid codes. */
+		int8 length;
+
+		TableEntry();
 	};
 
-	typedef std::list<Symbol>     CodeList;
-	typedef std::vector<CodeList> CodeLists;
-	typedef std::vector<Symbol *> SymbolList;
+	typedef std::vector<TableEntry> Table;
+
+	/** All codes, in the order they were given. */
+	std::vector<Code> _codes;
 
-	/** Lists of codes and their symbols, sorted by code length. */
-	CodeLists _codes;
+	/** The number of bits the first level table is indexed with. */
+	uint8 _tableBits;
 
-	/** Sorted list of pointers to the symbols. */
-	SymbolList _symbols;
+	/** The lookup tables, for bitstreams handing out bits MSB first and LSB first. */
+	Table _tables[2];
 
 	void init(uint8 maxLength, size_t codeCount, const uint32 *codes,
 	          const uint8 *lengths, const uint32 *symbols);
+
+	void buildTables();
+	void buildTable(Table &table, size_t offset, uint8 tableBits,
+	                const std::vector<Code> &codes, bool msbFirst);
 };
 
 } // End of namespace Common
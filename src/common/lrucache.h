@@ -0,0 +1,203 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A least-recently-used cache of shared objects, limited by their size in bytes.
+ */
+
+#ifndef COMMON_LRUCACHE_H
+#define COMMON_LRUCACHE_H
+
+#include <list>
+#include <memory>
+
+#include <boost/noncopyable.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/functional/hash.hpp>
+
+#include "src/common/types.h"
+#include "src/common/mutex.h"
+
+namespace Common {
+
+/** A least-recently-used cache of shared objects, limited by their size in bytes.
+ *
+ *  The values are held in shared pointers, so a value that's evicted from the
+ *  cache stays alive as long as someone is still using it. Only the values
+ *  still in the cache count against the budget.
+ *
+ *  All methods are thread-safe.
+ */
+template<typename Key, typename Value, class Hash = boost::hash<Key> >
+class LRUCache : boost::noncopyable {
+public:
+	typedef std::shared_ptr<const Value> ValuePtr;
+
+	/** Create a cache holding values of up to this many bytes in total. */
+	LRUCache(size_t budget) : _budget(budget), _size(0), _hits(0), _misses(0), _evictions(0) {
+	}
+
+	~LRUCache() {
+	}
+
+	/** Return the value cached for this key, or an empty pointer if there is none. */
+	ValuePtr get(const Key &key) {
+		StackLock lock(_mutex);
+
+		typename EntryMap::iterator e = _map.find(key);
+		if (e == _map.end()) {
+			_misses++;
+			return ValuePtr();
+		}
+
+		_hits++;
+
+		// Move it to the front, as the most recently used value
+		_entries.splice(_entries.begin(), _entries, e->second);
+
+		return e->second->value;
+	}
+
+	/** Add a value of this size, replacing any value already cached for this key.
+	 *
+	 *  The least recently used values are evicted until the value fits.
+	 *  Values bigger than the whole budget aren't cached at all.
+	 *
+	 *  @return true if the value was added.
+	 */
+	bool insert(const Key &key, const ValuePtr &value, size_t size) {
+		StackLock lock(_mutex);
+
+		removeEntry(key);
+
+		if (size > _budget)
+			return false;
+
+		while ((_budget - _size) < size) {
+			removeEntry(_entries.back().key);
+			_evictions++;
+		}
+
+		_entries.push_front(Entry(key, value, size));
+		_map.insert(std::make_pair(key, _entries.begin()));
+
+		_size += size;
+
+		return true;
+	}
+
+	/** Remove the value cached for this key, if any. */
+	void remove(const Key &key) {
+		StackLock lock(_mutex);
+
+		removeEntry(key);
+	}
+
+	/** Remove all values. */
+	void clear() {
+		StackLock lock(_mutex);
+
+		_map.clear();
+		_entries.clear();
+
+		_size = 0;
+	}
+
+	/** Return the number of bytes this cache may hold. */
+	size_t getBudget() const {
+		return _budget;
+	}
+
+	/** Return the number of bytes currently held by the cache. */
+	size_t getSize() const {
+		StackLock lock(_mutex);
+
+		return _size;
+	}
+
+	/** Return the number of values currently held by the cache. */
+	size_t getCount() const {
+		StackLock lock(_mutex);
+
+		return _entries.size();
+	}
+
+	/** Return the number of lookups that found a value. */
+	uint64 getHits() const {
+		StackLock lock(_mutex);
+
+		return _hits;
+	}
+
+	/** Return the number of lookups that didn't find a value. */
+	uint64 getMisses() const {
+		StackLock lock(_mutex);
+
+		return _misses;
+	}
+
+	/** Return the number of values removed to make room for new ones. */
+	uint64 getEvictions() const {
+		StackLock lock(_mutex);
+
+		return _evictions;
+	}
+
+private:
+	struct Entry {
+		Key key;
+		ValuePtr value;
+		size_t size;
+
+		Entry(const Key &k, const ValuePtr &v, size_t s) : key(k), value(v), size(s) {
+		}
+	};
+
+	typedef std::list<Entry> EntryList;
+	typedef boost::unordered_map<Key, typename EntryList::iterator, Hash> EntryMap;
+
+	const size_t _budget;
+	size_t _size;
+
+	uint64 _hits;
+	uint64 _misses;
+	uint64 _evictions;
+
+	/** All values, the most recently used first. */
+	EntryList _entries;
+	EntryMap _map;
+
+	mutable Mutex _mutex;
+
+	void removeEntry(const Key &key) {
+		typename EntryMap::iterator e = _map.find(key);
+		if (e == _map.end())
+			return;
+
+		_size -= e->second->size;
+
+		_entries.erase(e->second);
+		_map.erase(e);
+	}
+};
+
+} // End of namespace Common
+
+#endif // COMMON_LRUCACHE_H
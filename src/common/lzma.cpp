@@ -26,11 +26,15 @@
 #include "src/common/types.h"
 #include <lzma.h>
 
+#include <cassert>
+#include <cstring>
+
 #include <boost/scope_exit.hpp>
 
 #include "src/common/lzma.h"
 #include "src/common/scopedptr.h"
 #include "src/common/error.h"
+#include "src/common/util.h"
 #include "src/common/memreadstream.h"
 
 namespace Common {
@@ -127,4 +131,201 @@ SeekableReadStream *decompressLZMA1(ReadStream &input, size_t inputSize, size_t
 	return new MemoryReadStream(outputData, outputSize, true);
 }
 
+
+/** The size of the compressed data chunks fed to liblzma. */
+static const size_t kLZMAInputSize  = 16384;
+/** The size of the decompressed data chunks. */
+static const size_t kLZMAOutputSize = 32768;
+
+struct LZMAReadStream::Decoder {
+	lzma_filter filters[2];
+	lzma_stream strm;
+
+	Decoder() {
+		const lzma_stream init = LZMA_STREAM_INIT;
+		strm = init;
+
+		filters[0].id      = LZMA_FILTER_LZMA1;
+		filters[0].options = 0;
+		filters[1].id      = LZMA_VLI_UNKNOWN;
+		filters[1].options = 0;
+	}
+
+	~Decoder() {
+		kLZMAAllocator.free(0, filters[0].options);
+		lzma_end(&strm);
+	}
+};
+
+LZMAReadStream::LZMAReadStream(SeekableReadStream *input, size_t outputSize, bool disposeInput) :
+	_input(input, disposeInput), _inputSize(0), _inputStart(0), _inputPos(0), _size(outputSize), _pos(0),
+	_decodedPos(0), _eos(false), _streamEnd(false), _decoder(new Decoder), _outputSize(0) {
+
+	assert(_input);
+
+	_inputSize = _input->size();
+
+	if (!lzma_filter_decoder_is_supported(_decoder->filters[0].id))
+		throw Exception("LZMA1 compression not supported");
+
+	uint32 propsSize;
+	if (lzma_properties_size(&propsSize, &_decoder->filters[0]) != LZMA_OK)
+		throw Exception("Can't get LZMA1 properties size");
+
+	if (propsSize > _inputSize)
+		throw Exception("LZMA1 properties size larger than input data");
+
+	ScopedArray<byte> props(new byte[propsSize]);
+	if (_input->readAt(0, props.get(), propsSize) != propsSize)
+		throw Exception(kReadError);
+
+	if (lzma_properties_decode(&_decoder->filters[0], &kLZMAAllocator, props.get(), propsSize) != LZMA_OK)
+		throw Exception("Failed to decode LZMA1 properties");
+
+	_inputStart = propsSize;
+
+	_inputBuffer.reset(new byte[kLZMAInputSize]);
+	_output.reset(new byte[kLZMAOutputSize]);
+
+	restart();
+}
+
+LZMAReadStream::~LZMAReadStream() {
+}
+
+void LZMAReadStream::restart() {
+	lzma_ret lzmaRet = LZMA_OK;
+
+	if ((lzmaRet = lzma_raw_decoder(&_decoder->strm, _decoder->filters)) != LZMA_OK)
+		throw Exception("Failed to create raw LZMA1 decoder: %d", (int) lzmaRet);
+
+	_decoder->strm.next_in  = 0;
+	_decoder->strm.avail_in = 0;
+
+	_inputPos   = _inputStart;
+	_decodedPos = 0;
+	_outputSize = 0;
+	_streamEnd  = false;
+}
+
+void LZMAReadStream::fillInput() {
+	const size_t size = MIN(kLZMAInputSize, _inputSize - _inputPos);
+	if ((size > 0) && (_input->readAt(_inputPos, _inputBuffer.get(), size) != size))
+		throw Exception(kReadError);
+
+	_inputPos += size;
+
+	_decoder->strm.next_in  = _inputBuffer.get();
+	_decoder->strm.avail_in = size;
+}
+
+void LZMAReadStream::decodeChunk() {
+	if (_streamEnd)
+		throw Exception("Failed to uncompress LZMA1 data: output buffer not completely filled");
+
+	lzma_stream &strm = _decoder->strm;
+
+	strm.next_out  = _output.get();
+	strm.avail_out = kLZMAOutputSize;
+
+	while (strm.avail_out == kLZMAOutputSize) {
+		if (strm.avail_in == 0)
+			fillInput();
+
+		const bool inputEmpty = strm.avail_in == 0;
+
+		const lzma_ret lzmaRet = lzma_code(&strm, inputEmpty ? LZMA_FINISH : LZMA_RUN);
+		if (lzmaRet == LZMA_STREAM_END) {
+			_streamEnd = true;
+			break;
+		}
+
+		if (lzmaRet != LZMA_OK)
+			throw Exception("Failed to uncompress LZMA1 data: %d", (int) lzmaRet);
+
+		if (inputEmpty && (strm.avail_out == kLZMAOutputSize))
+			throw Exception("Failed to uncompress LZMA1 data: premature end of input data");
+	}
+
+	_outputSize = kLZMAOutputSize - strm.avail_out;
+	if (_outputSize == 0)
+		throw Exception("Failed to uncompress LZMA1 data: output buffer not completely filled");
+
+	_decodedPos += _outputSize;
+}
+
+bool LZMAReadStream::eos() const {
+	return _eos;
+}
+
+size_t LZMAReadStream::pos() const {
+	return _pos;
+}
+
+size_t LZMAReadStream::size() const {
+	return _size;
+}
+
+size_t LZMAReadStream::seek(ptrdiff_t offset, Origin whence) {
+	const size_t oldPos = _pos;
+	const size_t newPos = evalSeek(offset, whence, _pos, 0, _size);
+	if (newPos > _size)
+		throw Exception(kSeekError);
+
+	seekDecoder(newPos);
+
+	_pos = newPos;
+	_eos = false;
+
+	return oldPos;
+}
+
+size_t LZMAReadStream::read(void *dataPtr, size_t dataSize) {
+	if (dataSize > (_size - _pos)) {
+		dataSize = _size - _pos;
+		_eos = true;
+	}
+
+	_pos += readData(_pos, static_cast<byte *>(dataPtr), dataSize);
+
+	return dataSize;
+}
+
+size_t LZMAReadStream::readAt(size_t offset, void *dataPtr, size_t dataSize) {
+	if (offset >= _size)
+		return 0;
+
+	return readData(offset, static_cast<byte *>(dataPtr), MIN(dataSize, _size - offset));
+}
+
+void LZMAReadStream::seekDecoder(size_t position) {
+	// The start of the latest decompressed chunk is the furthest back we can go without restarting
+	if (position < (_decodedPos - _outputSize))
+		restart();
+
+	while (_decodedPos < position)
+		decodeChunk();
+}
+
+size_t LZMAReadStream::readData(size_t position, byte *data, size_t dataSize) {
+	seekDecoder(position);
+
+	size_t left = dataSize;
+	while (left > 0) {
+		if (position == _decodedPos)
+			decodeChunk();
+
+		const size_t available = _decodedPos - position;
+		const size_t chunk     = MIN(available, left);
+
+		std::memcpy(data, _output.get() + _outputSize - available, chunk);
+
+		data     += chunk;
+		left     -= chunk;
+		position += chunk;
+	}
+
+	return dataSize;
+}
+
 } // End of namespace Common
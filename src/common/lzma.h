@@ -26,12 +26,11 @@
 #define COMMON_LZMA_H
 
 #include "src/common/types.h"
+#include "src/common/scopedptr.h"
+#include "src/common/readstream.h"
 
 namespace Common {
 
-class ReadStream;
-class SeekableReadStream;
-
 /** Decompress using the LZMA1 algorithm.
  *
  *  @param  data       The compressed input data.
@@ -56,6 +55,85 @@ byte *decompressLZMA1(const byte *data, size_t inputSize, size_t outputSize);
  */
 SeekableReadStream *decompressLZMA1(ReadStream &input, size_t inputSize, size_t outputSize);
 
+/** A stream that decompresses LZMA1 data on demand.
+ *
+ *  Unlike decompressLZMA1(), which decompresses everything in one go into
+ *  a buffer of the full decompressed size, this stream only ever holds a
+ *  small, fixed amount of compressed and decompressed data in memory, and
+ *  decompresses more as it is being read.
+ *
+ *  Seeking forward decompresses and throws away the data in between.
+ *  Seeking backward, further back than the last decompressed chunk,
+ *  restarts at the beginning of the compressed data.
+ *
+ *  The compressed input is only ever read with readAt(), so several
+ *  LZMAReadStreams can share the same input stream.
+ *
+ *  readAt() decompresses onwards from wherever the decoder currently is,
+ *  without seeking back afterwards, so that reading sequentially through
+ *  a SeekableSubReadStream decompresses everything only once.
+ *
+ *  Note that since decompression is deferred, broken compressed data is
+ *  only detected, and an exception thrown, when reading.
+ */
+class LZMAReadStream : public SeekableReadStream {
+public:
+	/** Create a stream decompressing LZMA1 data.
+	 *
+	 *  @param input        The compressed data, including the LZMA1 properties,
+	 *                      from its beginning to its end.
+	 *  @param outputSize   The size of the decompressed data.
+	 *  @param disposeInput Should the input stream be deleted together with this stream?
+	 */
+	LZMAReadStream(SeekableReadStream *input, size_t outputSize, bool disposeInput = true);
+	~LZMAReadStream();
+
+	bool eos() const;
+
+	size_t pos() const;
+	size_t size() const;
+
+	size_t seek(ptrdiff_t offset, Origin whence = kOriginBegin);
+
+	size_t read(void *dataPtr, size_t dataSize);
+	size_t readAt(size_t offset, void *dataPtr, size_t dataSize);
+
+private:
+	/** The liblzma decoder state. */
+	struct Decoder;
+
+	DisposablePtr<SeekableReadStream> _input;
+
+	size_t _inputSize;  ///< The size of the compressed data.
+	size_t _inputStart; ///< The position of the compressed data, after the properties.
+	size_t _inputPos;   ///< The position of the next compressed data to feed to liblzma.
+
+	size_t _size;       ///< The size of the decompressed data.
+	size_t _pos;        ///< The current position within the decompressed data.
+	size_t _decodedPos; ///< The amount of decompressed data decoded so far.
+
+	bool _eos;
+	bool _streamEnd;
+
+	ScopedPtr<Decoder> _decoder;
+
+	ScopedArray<byte> _inputBuffer;
+
+	/** The latest decompressed chunk. */
+	ScopedArray<byte> _output;
+	size_t _outputSize;
+
+	void restart();
+
+	void fillInput();
+	void decodeChunk();
+
+	/** Get the decoder to where the data at this position is in, or is next added to, the output. */
+	void seekDecoder(size_t position);
+	/** Copy decompressed data from this position, decompressing more as needed. */
+	size_t readData(size_t position, byte *data, size_t dataSize);
+};
+
 } // End of namespace Common
 
 #endif // COMMON_LZMA_H
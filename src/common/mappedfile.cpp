@@ -0,0 +1,276 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Implementing the stream reading interfaces for memory-mapped files.
+ */
+
+#include "src/common/system.h"
+
+#if defined(WIN32)
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+	#include <io.h>
+#else
+	#include <sys/types.h>
+	#include <sys/stat.h>
+	#include <sys/mman.h>
+#endif
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+
+#include "src/common/mappedfile.h"
+#include "src/common/memreadstream.h"
+#include "src/common/util.h"
+#include "src/common/error.h"
+#include "src/common/ustring.h"
+#include "src/common/platform.h"
+
+namespace Common {
+
+MappedFile::MappedFile() : _data(0), _size(kSizeInvalid), _pos(0), _isOpen(false), _eos(false), _mapping(0) {
+}
+
+MappedFile::MappedFile(const UString &fileName) : _data(0), _size(kSizeInvalid), _pos(0),
+	_isOpen(false), _eos(false), _mapping(0) {
+
+	if (!open(fileName))
+		throw Exception("Can't map file \"%s\"", fileName.c_str());
+}
+
+MappedFile::~MappedFile() {
+	close();
+}
+
+#if defined(WIN32)
+
+static bool mapFile(std::FILE *file, const byte *&data, size_t &size, void *&mapping) {
+	HANDLE handle = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(file)));
+	if (handle == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(handle, &fileSize) || (fileSize.QuadPart < 0) ||
+	    ((uint64)fileSize.QuadPart > (uint64)SIZE_MAX))
+		return false;
+
+	size = (size_t)fileSize.QuadPart;
+	if (size == 0)
+		return true;
+
+	HANDLE fileMapping = CreateFileMappingW(handle, 0, PAGE_READONLY, 0, 0, 0);
+	if (!fileMapping)
+		return false;
+
+	void *view = MapViewOfFile(fileMapping, FILE_MAP_READ, 0, 0, 0);
+	if (!view) {
+		CloseHandle(fileMapping);
+		return false;
+	}
+
+	data    = static_cast<const byte *>(view);
+	mapping = fileMapping;
+
+	return true;
+}
+
+static void unmapFile(const byte *data, size_t UNUSED(size), void *mapping) {
+	if (data)
+		UnmapViewOfFile(data);
+	if (mapping)
+		CloseHandle(static_cast<HANDLE>(mapping));
+}
+
+#else
+
+static bool mapFile(std::FILE *file, const byte *&data, size_t &size, void *&UNUSED(mapping)) {
+	const int fd = fileno(file);
+
+	struct stat fileStat;
+	if ((fd < 0) || (fstat(fd, &fileStat) != 0) || (fileStat.st_size < 0) ||
+	    ((uint64)fileStat.st_size > (uint64)SIZE_MAX))
+		return false;
+
+	size = (size_t)fileStat.st_size;
+	if (size == 0)
+		return true;
+
+	void *view = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (view == MAP_FAILED)
+		return false;
+
+	data = static_cast<const byte *>(view);
+
+	return true;
+}
+
+static void unmapFile(const byte *data, size_t size, void *UNUSED(mapping)) {
+	if (data)
+		munmap(const_cast<byte *>(data), size);
+}
+
+#endif
+
+bool MappedFile::open(const UString &fileName) {
+	close();
+
+	std::FILE *file = Platform::openFile(fileName, Platform::kFileModeRead);
+	if (!file)
+		return false;
+
+	// The mapping stays valid after the file itself has been closed
+	const bool mapped = mapFile(file, _data, _size, _mapping);
+	std::fclose(file);
+
+	if (!mapped) {
+		close();
+		return false;
+	}
+
+	_isOpen = true;
+
+	return true;
+}
+
+void MappedFile::close() {
+	unmapFile(_data, _size, _mapping);
+
+	_data    = 0;
+	_size    = kSizeInvalid;
+	_pos     = 0;
+	_mapping = 0;
+
+	_isOpen = false;
+	_eos    = false;
+}
+
+bool MappedFile::isOpen() const {
+	return _isOpen;
+}
+
+bool MappedFile::eos() const {
+	if (!_isOpen)
+		return true;
+
+	return _eos;
+}
+
+size_t MappedFile::pos() const {
+	if (!_isOpen)
+		return kPositionInvalid;
+
+	return _pos;
+}
+
+size_t MappedFile::size() const {
+	return _size;
+}
+
+size_t MappedFile::seek(ptrdiff_t offset, Origin whence) {
+	if (!_isOpen)
+		throw Exception(kSeekError);
+
+	const size_t oldPos = _pos;
+	const size_t newPos = evalSeek(offset, whence, _pos, 0, _size);
+	if (newPos > _size)
+		throw Exception(kSeekError);
+
+	_pos = newPos;
+	_eos = false;
+
+	return oldPos;
+}
+
+size_t MappedFile::read(void *dataPtr, size_t dataSize) {
+	if (!_isOpen)
+		return 0;
+
+	assert(dataPtr);
+
+	if (dataSize > (_size - _pos)) {
+		dataSize = _size - _pos;
+		_eos = true;
+	}
+
+	if (dataSize > 0)
+		std::memcpy(dataPtr, _data + _pos, dataSize);
+
+	_pos += dataSize;
+
+	return dataSize;
+}
+
+size_t MappedFile::readAt(size_t offset, void *dataPtr, size_t dataSize) {
+	if (!_isOpen || (offset >= _size))
+		return 0;
+
+	assert(dataPtr);
+
+	dataSize = MIN(dataSize, _size - offset);
+	std::memcpy(dataPtr, _data + offset, dataSize);
+
+	return dataSize;
+}
+
+const byte *MappedFile::getData() const {
+	return _data;
+}
+
+
+static bool findStreamMemory(const SeekableReadStream &stream, const byte *&data) {
+	const MappedFile *mappedFile = dynamic_cast<const MappedFile *>(&stream);
+	if (mappedFile && mappedFile->isOpen()) {
+		data = mappedFile->getData();
+		return true;
+	}
+
+	const MemoryReadStream *memoryStream = dynamic_cast<const MemoryReadStream *>(&stream);
+	if (memoryStream) {
+		data = memoryStream->getData();
+		return true;
+	}
+
+	return false;
+}
+
+const byte *getStreamMemory(const SeekableReadStream &stream) {
+	const byte *data = 0;
+	findStreamMemory(stream, data);
+
+	return data;
+}
+
+MemoryReadStream *createMemoryView(const SeekableReadStream &stream, size_t begin, size_t end) {
+	const byte *data = 0;
+	if (!findStreamMemory(stream, data))
+		return 0;
+
+	if ((begin > end) || (end > stream.size()))
+		throw Exception(kReadError);
+
+	if (begin == end)
+		return new MemoryReadStream(static_cast<const byte *>(0), 0);
+
+	return new MemoryReadStream(data + begin, end - begin);
+}
+
+} // End of namespace Common
@@ -0,0 +1,108 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Implementing the stream reading interfaces for memory-mapped files.
+ */
+
+#ifndef COMMON_MAPPEDFILE_H
+#define COMMON_MAPPEDFILE_H
+
+#include <boost/noncopyable.hpp>
+
+#include "src/common/types.h"
+#include "src/common/readstream.h"
+
+namespace Common {
+
+class UString;
+class MemoryReadStream;
+
+/** A file reading class that maps the whole file read-only into memory.
+ *
+ *  Reading and seeking never touch the operating system, and the file
+ *  contents can be accessed directly with getData(). Since the size is
+ *  only limited by the address space, files larger than 2GB can be read
+ *  on 64-bit systems.
+ */
+class MappedFile : boost::noncopyable, public SeekableReadStream {
+public:
+	MappedFile();
+	MappedFile(const UString &fileName);
+	~MappedFile();
+
+	/** Try to map the file with the given fileName.
+	 *
+	 *  @param  fileName the name of the file to map
+	 *  @return true if file was mapped successfully, false otherwise
+	 */
+	bool open(const UString &fileName);
+
+	/** Unmap the file, if mapped. */
+	void close();
+
+	/** Checks if the object mapped a file successfully.
+	 *
+	 *  @return true if any file is mapped, false otherwise.
+	 */
+	bool isOpen() const;
+
+	bool eos() const;
+
+	size_t pos() const;
+	size_t size() const;
+
+	size_t seek(ptrdiff_t offset, Origin whence = kOriginBegin);
+	size_t read(void *dataPtr, size_t dataSize);
+	size_t readAt(size_t offset, void *dataPtr, size_t dataSize);
+
+	/** Return the start of the mapped file contents. */
+	const byte *getData() const;
+
+private:
+	const byte *_data; ///< The mapped file contents.
+	size_t _size;      ///< The file's size.
+	size_t _pos;       ///< The current position within the file.
+
+	bool _isOpen;
+	bool _eos;
+
+	void *_mapping; ///< OS-specific mapping handle.
+};
+
+/** Return a pointer to the memory directly backing this stream.
+ *
+ *  This is the case for a MappedFile and a MemoryReadStream. For all
+ *  other streams, 0 is returned.
+ */
+const byte *getStreamMemory(const SeekableReadStream &stream);
+
+/** Create a zero-copy view of the range [begin, end) of a memory-backed stream.
+ *
+ *  The view does not own the memory and is only valid as long as the
+ *  original stream exists. If the stream is not backed by memory (see
+ *  getStreamMemory()), 0 is returned. If the range lies outside the
+ *  stream, a kReadError exception is thrown.
+ */
+MemoryReadStream *createMemoryView(const SeekableReadStream &stream, size_t begin, size_t end);
+
+} // End of namespace Common
+
+#endif // COMMON_MAPPEDFILE_H
@@ -92,6 +92,7 @@ public:
 	~MemoryReadStream() { }
 
 	size_t read(void *dataPtr, size_t dataSize);
+	size_t readAt(size_t offset, void *dataPtr, size_t dataSize);
 
 	bool eos() const;
 
@@ -80,7 +80,7 @@ size_t MemoryWriteStream::size() const {
 
 
 MemoryWriteStreamDynamic::MemoryWriteStreamDynamic(bool disposeMemory, size_t capacity) :
-	_data(0, disposeMemory), _ptr(0), _capacity(0), _size(0) {
+	_data(0, disposeMemory), _capacity(0), _size(0), _pos(0) {
 
 	reserve(capacity);
 }
@@ -101,7 +101,6 @@ void MemoryWriteStreamDynamic::reserve(size_t s) {
 
 	_data.dispose();
 	_data.reset(newData);
-	_ptr = _data.get() + _size;
 }
 
 void MemoryWriteStreamDynamic::ensureCapacity(size_t newLen) {
@@ -114,12 +113,12 @@ void MemoryWriteStreamDynamic::ensureCapacity(size_t newLen) {
 size_t MemoryWriteStreamDynamic::write(const void *dataPtr, size_t dataSize) {
 	assert(dataPtr);
 
-	ensureCapacity(_size + dataSize);
+	ensureCapacity(_pos + dataSize);
 
-	std::memcpy(_ptr, dataPtr, dataSize);
+	std::memcpy(_data.get() + _pos, dataPtr, dataSize);
 
-	_ptr  += dataSize;
-	_size += dataSize;
+	_pos += dataSize;
+	_size = MAX(_size, _pos);
 
 	return dataSize;
 }
@@ -131,15 +130,30 @@ void MemoryWriteStreamDynamic::setDisposable(bool disposeMemory) {
 void MemoryWriteStreamDynamic::dispose() {
 	_data.dispose();
 
-	_ptr      = 0;
 	_size     = 0;
+	_pos      = 0;
 	_capacity = 0;
 }
 
+size_t MemoryWriteStreamDynamic::pos() const {
+	return _pos;
+}
+
 size_t MemoryWriteStreamDynamic::size() const {
 	return _size;
 }
 
+size_t MemoryWriteStreamDynamic::seek(ptrdiff_t offset, SeekableReadStream::Origin whence) {
+	const size_t oldPos = _pos;
+	const size_t newPos = SeekableReadStream::evalSeek(offset, whence, _pos, 0, _size);
+	if (newPos > _size)
+		throw Exception(kSeekError);
+
+	_pos = newPos;
+
+	return oldPos;
+}
+
 byte *MemoryWriteStreamDynamic::getData() {
 	return _data.get();
 }
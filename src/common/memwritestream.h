@@ -90,7 +90,7 @@ private:
  *
  *  As long as more memory can be allocated, writing into the stream won't fail.
  */
-class MemoryWriteStreamDynamic : boost::noncopyable, public WriteStream {
+class MemoryWriteStreamDynamic : boost::noncopyable, public SeekableWriteStream {
 public:
 	MemoryWriteStreamDynamic(bool disposeMemory = false, size_t capacity = 0);
 	~MemoryWriteStreamDynamic();
@@ -102,18 +102,21 @@ public:
 	void setDisposable(bool disposeMemory);
 	void dispose();
 
+	/** Return the current writing position. */
+	size_t pos() const;
 	/** Return the number of bytes written to this stream in total. */
 	size_t size() const;
 
+	size_t seek(ptrdiff_t offset, SeekableReadStream::Origin whence = SeekableReadStream::kOriginBegin);
+
 	byte *getData();
 
 private:
 	DisposableArray<byte> _data;
 
-	byte *_ptr;
-
 	size_t _capacity;
 	size_t _size;
+	size_t _pos;
 
 	void ensureCapacity(size_t newLen);
 };
@@ -22,9 +22,17 @@
  *  Implementing the stream reading interfaces for files.
  */
 
+#include "src/common/system.h"
+
+#if !defined(WIN32)
+	#include <unistd.h>
+#endif
+
 #include <cassert>
 
 #include "src/common/readfile.h"
+#include "src/common/util.h"
+#include "src/common/scopedptr.h"
 #include "src/common/error.h"
 #include "src/common/ustring.h"
 #include "src/common/platform.h"
@@ -43,16 +51,35 @@ ReadFile::~ReadFile() {
 	close();
 }
 
-static long getInitialSize(std::FILE *handle) {
+/* Seek and tell with 64-bit offsets, so that files bigger than 2GB can
+ * be read on systems where long is only 32 bits wide. */
+
+static int seekFile(std::FILE *handle, int64 offset, int whence) {
+#if defined(WIN32)
+	return _fseeki64(handle, offset, whence);
+#else
+	return fseeko(handle, (off_t)offset, whence);
+#endif
+}
+
+static int64 tellFile(std::FILE *handle) {
+#if defined(WIN32)
+	return _ftelli64(handle);
+#else
+	return (int64)ftello(handle);
+#endif
+}
+
+static int64 getInitialSize(std::FILE *handle) {
 	if (!handle)
 		return -1;
 
-	if (std::fseek(handle, 0, SEEK_END) != 0)
+	if (seekFile(handle, 0, SEEK_END) != 0)
 		return -1;
 
-	long fileSize = std::ftell(handle);
+	int64 fileSize = tellFile(handle);
 
-	if (std::fseek(handle, 0, SEEK_SET) != 0)
+	if (seekFile(handle, 0, SEEK_SET) != 0)
 		return -1;
 
 	return fileSize;
@@ -61,7 +88,7 @@ static long getInitialSize(std::FILE *handle) {
 bool ReadFile::open(const UString &fileName) {
 	close();
 
-	long fileSize = -1;
+	int64 fileSize = -1;
 	if (!(_handle  = Platform::openFile(fileName, Platform::kFileModeRead)) ||
 	    ((fileSize = getInitialSize(_handle)) < 0)) {
 
@@ -69,7 +96,8 @@ bool ReadFile::open(const UString &fileName) {
 		return false;
 	}
 
-	if ((uint64)((unsigned long)fileSize) > (uint64)0x7FFFFFFFULL) {
+	// Positions need to fit into a ptrdiff_t for seeking
+	if ((uint64)fileSize > (uint64)(SIZE_MAX >> 1)) {
 		warning("ReadFile \"%s\" is too big", fileName.c_str());
 
 		close();
@@ -81,6 +109,38 @@ bool ReadFile::open(const UString &fileName) {
 	return true;
 }
 
+void ReadFile::openTemporary(ReadStream &data) {
+	close();
+
+	if (!(_handle = std::tmpfile()))
+		throw Exception("Can't create a temporary file");
+
+	static const size_t kBufferSize = 64 * 1024;
+	ScopedArray<byte> buffer(new byte[kBufferSize]);
+
+	try {
+		size_t n;
+		while ((n = data.read(buffer.get(), kBufferSize)) > 0)
+			if (std::fwrite(buffer.get(), 1, n, _handle) != n)
+				throw Exception(kWriteError);
+
+		if (!data.eos() || (std::fflush(_handle) != 0))
+			throw Exception(kWriteError);
+
+		const int64 fileSize = getInitialSize(_handle);
+		if ((fileSize < 0) || ((uint64)fileSize > (uint64)(SIZE_MAX >> 1)))
+			throw Exception(kWriteError);
+
+		_size = (size_t)fileSize;
+
+	} catch (Exception &e) {
+		close();
+
+		e.add("Failed to write temporary file");
+		throw;
+	}
+}
+
 void ReadFile::close() {
 	if (_handle)
 		std::fclose(_handle);
@@ -104,7 +164,11 @@ size_t ReadFile::pos() const {
 	if (!_handle)
 		return kPositionInvalid;
 
-	return (size_t)std::ftell(_handle);
+	const int64 p = tellFile(_handle);
+	if (p < 0)
+		return kPositionInvalid;
+
+	return (size_t)p;
 }
 
 size_t ReadFile::size() const {
@@ -121,10 +185,10 @@ size_t ReadFile::seek(ptrdiff_t offset, Origin whence) {
 
 	size_t oldPos = pos();
 
-	if (std::fseek(_handle, offset, kSeekToWhence[whence]) != 0)
+	if (seekFile(_handle, offset, kSeekToWhence[whence]) != 0)
 		throw Exception(kSeekError);
 
-	long p = std::ftell(_handle);
+	const int64 p = tellFile(_handle);
 	if ((p < 0) || ((size_t)p > _size))
 		throw Exception(kSeekError);
 
@@ -139,4 +203,37 @@ size_t ReadFile::read(void *dataPtr, size_t dataSize) {
 	return std::fread(dataPtr, 1, dataSize, _handle);
 }
 
+size_t ReadFile::readAt(size_t offset, void *dataPtr, size_t dataSize) {
+	if (!_handle || (offset >= _size))
+		return 0;
+
+	assert(dataPtr);
+
+	dataSize = MIN(dataSize, _size - offset);
+
+#if defined(WIN32)
+	StackLock lock(_readAtMutex);
+
+	return SeekableReadStream::readAt(offset, dataPtr, dataSize);
+#else
+	/* pread() neither uses nor moves the file offset, and bypasses the stdio
+	 * buffer. Since we only ever read, the buffer can't hold stale data. */
+
+	const int fd = fileno(_handle);
+
+	byte *data = static_cast<byte *>(dataPtr);
+
+	size_t readSize = 0;
+	while (readSize < dataSize) {
+		const ssize_t n = pread(fd, data + readSize, dataSize - readSize, (off_t)(offset + readSize));
+		if (n <= 0)
+			break;
+
+		readSize += (size_t)n;
+	}
+
+	return readSize;
+#endif
+}
+
 } // End of namespace Common
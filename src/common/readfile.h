@@ -31,6 +31,7 @@
 
 #include "src/common/types.h"
 #include "src/common/readstream.h"
+#include "src/common/mutex.h"
 
 namespace Common {
 
@@ -50,6 +51,17 @@ public:
 	 */
 	bool open(const UString &fileName);
 
+	/** Copy the rest of a stream into an anonymous temporary file, and open that file.
+	 *
+	 *  The file is created with std::tmpfile(), so it has no name in the file
+	 *  system and is removed again when it's closed. This keeps large data
+	 *  that has no file of its own, like decompressed archive members, out of
+	 *  memory. When creating or writing the file fails, an exception is thrown.
+	 *
+	 *  @param data the data to write into the temporary file.
+	 */
+	void openTemporary(ReadStream &data);
+
 	/** Close the file, if open. */
 	void close();
 
@@ -67,9 +79,19 @@ public:
 	size_t seek(ptrdiff_t offset, Origin whence = kOriginBegin);
 	size_t read(void *dataPtr, size_t dataSize);
 
+	/** Read from an absolute position in the file.
+	 *
+	 *  On POSIX systems, this uses pread() and is safe for concurrent callers.
+	 *  Elsewhere, the seek and read are serialized with a mutex, which is still
+	 *  safe for concurrent readAt() calls, but not for a concurrent read().
+	 */
+	size_t readAt(size_t offset, void *dataPtr, size_t dataSize);
+
 protected:
 	std::FILE *_handle; ///< The actual file handle.
 	size_t _size;       ///< The file's size.
+
+	Mutex _readAtMutex; ///< Serializes readAt() where pread() is not available.
 };
 
 } // End of namespace Common
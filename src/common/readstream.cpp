@@ -51,6 +51,7 @@
 
 #include "src/common/readstream.h"
 #include "src/common/memreadstream.h"
+#include "src/common/util.h"
 #include "src/common/error.h"
 #include "src/common/scopedptr.h"
 
@@ -80,6 +81,28 @@ SeekableReadStream::SeekableReadStream() {
 SeekableReadStream::~SeekableReadStream() {
 }
 
+size_t SeekableReadStream::readAt(size_t offset, void *dataPtr, size_t dataSize) {
+	if (offset >= size())
+		return 0;
+
+	const size_t oldPos = seek(offset);
+
+	const size_t readSize = read(dataPtr, dataSize);
+
+	seek(oldPos);
+
+	return readSize;
+}
+
+MemoryReadStream *SeekableReadStream::readStreamAt(size_t offset, size_t dataSize) {
+	ScopedArray<byte> buf(new byte[dataSize]);
+
+	if (readAt(offset, buf.get(), dataSize) != dataSize)
+		throw Exception(kReadError);
+
+	return new MemoryReadStream(buf.release(), dataSize, true);
+}
+
 size_t SeekableReadStream::evalSeek(ptrdiff_t offset, Origin whence, size_t pos, size_t begin, size_t size) {
 	switch (whence) {
 		case kOriginEnd:
@@ -130,8 +153,10 @@ SeekableSubReadStream::SeekableSubReadStream(SeekableReadStream *parentStream, s
 
 	assert(_begin <= _end);
 
+	if (_begin > _parentStream->size())
+		throw Exception(kSeekError);
+
 	_pos = begin;
-	_parentStream->seek(_pos);
 }
 
 SeekableSubReadStream::~SeekableSubReadStream() {
@@ -155,13 +180,39 @@ size_t SeekableSubReadStream::seek(ptrdiff_t offset, Origin whence) {
 		throw Exception(kSeekError);
 
 	_pos = newPos;
-
-	_parentStream->seek(_pos);
 	_eos = false; // reset eos on successful seek
 
 	return oldPos;
 }
 
+bool SeekableSubReadStream::eos() const {
+	return _eos;
+}
+
+size_t SeekableSubReadStream::read(void *dataPtr, size_t dataSize) {
+	if (dataSize > (size_t)(_end - _pos)) {
+		dataSize = _end - _pos;
+		_eos = true;
+	}
+
+	const size_t readSize = _parentStream->readAt(_pos, dataPtr, dataSize);
+	if (readSize != dataSize)
+		_eos = true;
+
+	_pos += readSize;
+
+	return readSize;
+}
+
+size_t SeekableSubReadStream::readAt(size_t offset, void *dataPtr, size_t dataSize) {
+	if (offset >= size())
+		return 0;
+
+	dataSize = MIN(dataSize, size() - offset);
+
+	return _parentStream->readAt(_begin + offset, dataPtr, dataSize);
+}
+
 
 SeekableSubReadStreamEndian::SeekableSubReadStreamEndian(SeekableReadStream *parentStream,
 		size_t begin, size_t end, bool bigEndian, bool disposeParentStream) :
@@ -318,6 +318,30 @@ public:
 		return seek(offset, kOriginCurrent);
 	}
 
+	/** Read data from an absolute position in the stream, without going
+	 *  through the stream position indicator.
+	 *
+	 *  Streams that can read from an arbitrary offset without moving a shared
+	 *  cursor (memory buffers, memory-mapped files, pread()) override this,
+	 *  and are then safe to be read with readAt() from several threads at once.
+	 *  The default implementation seeks, reads and seeks back, and is therefore
+	 *  not safe for concurrent callers. It also clears the end-of-file indicator.
+	 *
+	 *  @param  offset   the position, from the beginning of the stream, to read from.
+	 *  @param  dataPtr  pointer to a buffer into which the data is read.
+	 *  @param  dataSize number of bytes to be read.
+	 *  @return the number of bytes which were actually read.
+	 */
+	virtual size_t readAt(size_t offset, void *dataPtr, size_t dataSize);
+
+	/** Read the specified amount of data from an absolute position into a
+	 *  new[]'ed buffer, which then is wrapped into a MemoryReadStream.
+	 *
+	 *  Like readAt(), this does not touch the stream position indicator.
+	 *  When reading fails, a kReadError exception is thrown.
+	 */
+	MemoryReadStream *readStreamAt(size_t offset, size_t dataSize);
+
 	/** Evaluate the seek offset relative to whence into a position from the beginning. */
 	static size_t evalSeek(ptrdiff_t offset, Origin whence, size_t pos, size_t begin, size_t size);
 };
@@ -351,10 +375,12 @@ protected:
 
 /** SeekableSubReadStream provides access to a SeekableReadStream restricted to
  *  the range [begin, end).
- *  The same caveats apply to SeekableSubReadStream as do to SeekableReadStream.
  *
- *  Manipulating the parent stream directly /will/ mess up a substream.
- *  @see SubReadStream
+ *  Unlike SubReadStream, a SeekableSubReadStream keeps its own position and
+ *  only reads from the parent stream with readAt(). It therefore neither
+ *  disturbs nor depends on the position of the parent stream, and several
+ *  substreams of the same parent can be used at once, even from several
+ *  threads if the parent stream's readAt() is thread-safe.
  */
 class SeekableSubReadStream : public SubReadStream, public SeekableReadStream {
 public:
@@ -367,6 +393,11 @@ public:
 
 	size_t seek(ptrdiff_t offset, Origin whence = kOriginBegin);
 
+	bool eos() const;
+
+	size_t read(void *dataPtr, size_t dataSize);
+	size_t readAt(size_t offset, void *dataPtr, size_t dataSize);
+
 protected:
 	SeekableReadStream *_parentStream;
 
@@ -377,8 +408,7 @@ protected:
 /** This is a wrapper around SeekableSubReadStream, but it adds non-endian
  *  read methods whose endianness is set on the stream creation.
  *
- *  Manipulating the parent stream directly /will/ mess up a substream.
- *  @see SubReadStream
+ *  @see SeekableSubReadStream
  */
 class SeekableSubReadStreamEndian : public SeekableSubReadStream {
 private:
@@ -30,6 +30,7 @@ src_common_libcommon_la_SOURCES += \
     src/common/ptrlist.h \
     src/common/ptrvector.h \
     src/common/ptrmap.h \
+    src/common/lrucache.h \
     src/common/system.h \
     src/common/noreturn.h \
     src/common/fallthrough.h \
@@ -52,10 +53,12 @@ src_common_libcommon_la_SOURCES += \
     src/common/deflate.h \
     src/common/lzma.h \
     src/common/readfile.h \
+    src/common/mappedfile.h \
     src/common/writefile.h \
     src/common/filepath.h \
     src/common/filelist.h \
     src/common/filetree.h \
+    src/common/filetreescanner.h \
     src/common/zipfile.h \
     src/common/bitstream.h \
     src/common/huffman.h \
@@ -87,10 +90,12 @@ src_common_libcommon_la_SOURCES += \
     src/common/error.cpp \
     src/common/ustring.cpp \
     src/common/readfile.cpp \
+    src/common/mappedfile.cpp \
     src/common/writefile.cpp \
     src/common/filepath.cpp \
     src/common/filelist.cpp \
     src/common/filetree.cpp \
+    src/common/filetreescanner.cpp \
     src/common/zipfile.cpp \
     src/common/huffman.cpp \
     src/common/sinewindows.cpp \
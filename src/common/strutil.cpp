@@ -344,4 +344,34 @@ template UString composeString<unsigned long     >(unsigned long      value);
 template UString composeString<  signed long long>(  signed long long value);
 template UString composeString<unsigned long long>(unsigned long long value);
 
+bool matchGlob(const char *pattern, const char *str) {
+	// Position to backtrack to on a mismatch after the last '*'
+	const char *starPattern = 0, *starStr = 0;
+
+	while (*str) {
+		if (*pattern == '*') {
+			starPattern = ++pattern;
+			starStr     = str;
+			continue;
+		}
+
+		if ((*pattern == '?') || (*pattern && (std::tolower((unsigned char) *pattern) == std::tolower((unsigned char) *str)))) {
+			pattern++;
+			str++;
+			continue;
+		}
+
+		if (!starPattern)
+			return false;
+
+		pattern = starPattern;
+		str     = ++starStr;
+	}
+
+	while (*pattern == '*')
+		pattern++;
+
+	return *pattern == '\0';
+}
+
 } // End of namespace Common
@@ -57,6 +57,13 @@ template<typename T> void parseString(const UString &str, T &value, bool allowEm
 /** Convert any POD integer, float/double or bool type into a string. */
 template<typename T> UString composeString(T value);
 
+/** Case-insensitively match a string against a glob pattern.
+ *
+ *  '*' matches any number of characters, including none, and '?' matches
+ *  exactly one character. Only ASCII letters are folded.
+ */
+bool matchGlob(const char *pattern, const char *str);
+
 } // End of namespace Common
 
 #endif // COMMON_STRUTIL_H
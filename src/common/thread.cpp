@@ -22,7 +22,18 @@
  *  Threading helpers.
  */
 
+#include "src/common/atomic.h"
+
+#include <exception>
+#include <list>
+#include <algorithm>
+
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
 #include "src/common/thread.h"
+#include "src/common/util.h"
+#include "src/common/mutex.h"
 
 namespace Common {
 
@@ -49,11 +60,182 @@ void Thread::createThread() {
 void Thread::destroyThread() {
 	_shouldQuit = true;
 
-	_thread.join();
+	if (_thread.joinable())
+		_thread.join();
+}
+
+void Thread::waitThread() {
+	if (_thread.joinable())
+		_thread.join();
 }
 
 bool Thread::shouldQuitThread() const {
 	return _shouldQuit;
 }
 
+
+/** Is the current thread working for a parallelFor()? */
+static thread_local bool tInParallelFor = false;
+
+/** One parallelFor() call, worked on by the calling thread and its helpers. */
+struct ParallelForJob : boost::noncopyable {
+	size_t count;
+	const std::function<void(size_t)> &func;
+
+	boost::atomic<size_t> nextIndex;
+
+	size_t helpersWanted;  ///< How many more pool threads may join. Guarded by the pool's mutex.
+	size_t helpersRunning; ///< How many pool threads are working on it. Guarded by the pool's mutex.
+
+	Mutex errorMutex;
+	std::exception_ptr error;
+
+	ParallelForJob(size_t c, const std::function<void(size_t)> &f) : count(c), func(f), nextIndex(0),
+		helpersWanted(0), helpersRunning(0) {
+	}
+
+	/** Call func for the next free index, until none are left. */
+	void work() {
+		try {
+			for (size_t i = nextIndex++; i < count; i = nextIndex++)
+				func(i);
+
+		} catch (...) {
+			// Don't start any more indices
+			nextIndex = count;
+
+			StackLock lock(errorMutex);
+			if (!error)
+				error = std::current_exception();
+		}
+	}
+};
+
+/** The threads helping out with parallelFor() calls.
+ *
+ *  Threads are only started once they're first needed, and are then kept
+ *  around, so that a parallelFor() doesn't pay for creating and joining
+ *  threads every time. The pool only ever grows, up to the largest number
+ *  of helpers a single parallelFor() asked for.
+ */
+class ParallelForPool : boost::noncopyable {
+public:
+	ParallelForPool() : _threadCount(0), _quit(false) {
+	}
+
+	~ParallelForPool() {
+		{
+			boost::lock_guard<boost::mutex> lock(_mutex);
+			_quit = true;
+		}
+
+		_wake.notify_all();
+		_threads.join_all();
+	}
+
+	/** Let up to helperCount pool threads work on this job. */
+	void start(ParallelForJob &job, size_t helperCount) {
+		{
+			boost::lock_guard<boost::mutex> lock(_mutex);
+
+			for ( ; _threadCount < helperCount; _threadCount++)
+				_threads.create_thread([this]() { run(); });
+
+			job.helpersWanted = helperCount;
+			_jobs.push_back(&job);
+		}
+
+		_wake.notify_all();
+	}
+
+	/** Stop handing out this job, and wait for the helpers still working on it. */
+	void finish(ParallelForJob &job) {
+		boost::unique_lock<boost::mutex> lock(_mutex);
+
+		std::list<ParallelForJob *>::iterator j = std::find(_jobs.begin(), _jobs.end(), &job);
+		if (j != _jobs.end())
+			_jobs.erase(j);
+
+		while (job.helpersRunning > 0)
+			_done.wait(lock);
+	}
+
+private:
+	boost::mutex _mutex;
+
+	boost::condition_variable _wake; ///< Signaled when a job was added, or the pool shuts down.
+	boost::condition_variable _done; ///< Signaled when a helper stopped working on a job.
+
+	/** The jobs that still want more helpers. */
+	std::list<ParallelForJob *> _jobs;
+
+	boost::thread_group _threads;
+	size_t _threadCount;
+
+	bool _quit;
+
+	void run() {
+		// Everything the pool threads run is part of a parallelFor()
+		tInParallelFor = true;
+
+		boost::unique_lock<boost::mutex> lock(_mutex);
+
+		while (true) {
+			while (!_quit && _jobs.empty())
+				_wake.wait(lock);
+
+			if (_quit)
+				return;
+
+			ParallelForJob &job = *_jobs.front();
+			if (--job.helpersWanted == 0)
+				_jobs.pop_front();
+
+			job.helpersRunning++;
+
+			lock.unlock();
+			job.work();
+			lock.lock();
+
+			job.helpersRunning--;
+			_done.notify_all();
+		}
+	}
+};
+
+static ParallelForPool &getParallelForPool() {
+	static ParallelForPool pool;
+
+	return pool;
+}
+
+void parallelFor(size_t count, const std::function<void(size_t)> &func, size_t threadCount) {
+	if (count == 0)
+		return;
+
+	if (threadCount == 0)
+		threadCount = boost::thread::hardware_concurrency();
+
+	threadCount = tInParallelFor ? 1 : CLIP<size_t>(threadCount, 1, count);
+
+	ParallelForJob job(count, func);
+
+	// The calling thread works as well
+	if (threadCount > 1)
+		getParallelForPool().start(job, threadCount - 1);
+
+	const bool wasInParallelFor = tInParallelFor;
+	tInParallelFor = true;
+
+	job.work();
+
+	tInParallelFor = wasInParallelFor;
+
+	if (threadCount > 1)
+		getParallelForPool().finish(job);
+
+	if (job.error)
+		std::rethrow_exception(job.error);
+}
+
 } // End of namespace Common
@@ -27,6 +27,8 @@
 
 #include "src/common/atomic.h"
 
+#include <functional>
+
 #include <boost/noncopyable.hpp>
 
 #include <boost/thread/thread.hpp>
@@ -44,6 +46,8 @@ protected:
 	void createThread();
 	/** Request the thread to quit and wait for it to finish. */
 	void destroyThread();
+	/** Wait for the thread to finish on its own. */
+	void waitThread();
 
 	/** The thread method should call this periodically to query if it should quit. */
 	bool shouldQuitThread() const;
@@ -63,6 +67,28 @@ private:
 	friend struct ThreadHelper;
 };
 
+/** Call a function for every index from 0 to count - 1, spread across several threads.
+ *
+ *  The indices are handed out one by one, in order, to the calling thread and
+ *  up to threadCount - 1 helper threads. A parallelFor() called from within
+ *  another parallelFor() runs on the calling thread alone, so nesting never
+ *  multiplies the number of threads.
+ *
+ *  The helper threads come from a pool shared by all parallelFor() calls.
+ *  The pool is started on first use and then kept around, so a call only
+ *  costs waking up the helpers, not creating threads. Helpers that haven't
+ *  picked up the work by the time the calling thread is done are skipped.
+ *
+ *  If func throws, no further indices are started, and the first exception is
+ *  rethrown on the calling thread once all threads have finished.
+ *
+ *  @param count       The number of indices to call func for.
+ *  @param func        The function to call with each index.
+ *  @param threadCount The maximum number of threads to use, including the
+ *                     calling thread. 0 means one per hardware thread.
+ */
+void parallelFor(size_t count, const std::function<void(size_t)> &func, size_t threadCount = 0);
+
 } // End of namespace Common
 
 #endif // COMMON_THREAD_H
@@ -32,10 +32,10 @@
 
 namespace Common {
 
-WriteFile::WriteFile() : _handle(0), _size(0) {
+WriteFile::WriteFile() : _handle(0), _pos(0), _size(0) {
 }
 
-WriteFile::WriteFile(const UString &fileName) : _handle(0), _size(0) {
+WriteFile::WriteFile(const UString &fileName) : _handle(0), _pos(0), _size(0) {
 	if (!open(fileName))
 		throw Exception("Can't open file \"%s\" for writing", fileName.c_str());
 }
@@ -73,6 +73,7 @@ void WriteFile::close() {
 		std::fclose(_handle);
 
 	_handle = 0;
+	_pos    = 0;
 	_size   = 0;
 }
 
@@ -95,13 +96,46 @@ size_t WriteFile::write(const void *dataPtr, size_t dataSize) {
 	assert(dataPtr);
 
 	const size_t written = std::fwrite(dataPtr, 1, dataSize, _handle);
-	_size += written;
+
+	_pos += written;
+	_size = MAX(_size, _pos);
 
 	return written;
 }
 
+size_t WriteFile::pos() const {
+	return _pos;
+}
+
 size_t WriteFile::size() const {
 	return _size;
 }
 
+/* Seek with 64-bit offsets, so that files bigger than 2GB can be
+ * written on systems where long is only 32 bits wide. */
+static int seekFile(std::FILE *handle, int64 offset) {
+#if defined(WIN32)
+	return _fseeki64(handle, offset, SEEK_SET);
+#else
+	return fseeko(handle, (off_t)offset, SEEK_SET);
+#endif
+}
+
+size_t WriteFile::seek(ptrdiff_t offset, SeekableReadStream::Origin whence) {
+	if (!_handle)
+		throw Exception(kSeekError);
+
+	const size_t oldPos = _pos;
+	const size_t newPos = SeekableReadStream::evalSeek(offset, whence, _pos, 0, _size);
+	if (newPos > _size)
+		throw Exception(kSeekError);
+
+	if (seekFile(_handle, newPos) != 0)
+		throw Exception(kSeekError);
+
+	_pos = newPos;
+
+	return oldPos;
+}
+
 } // End of namespace Common
@@ -37,7 +37,7 @@ namespace Common {
 class UString;
 
 /** A simple streaming file writing class. */
-class WriteFile : boost::noncopyable, public WriteStream {
+class WriteFile : boost::noncopyable, public SeekableWriteStream {
 public:
 	WriteFile();
 	WriteFile(const UString &fileName);
@@ -63,12 +63,17 @@ public:
 
 	size_t write(const void *dataPtr, size_t dataSize);
 
+	/** Return the current writing position within the current file. */
+	size_t pos() const;
 	/** Return the number of bytes written to the current file in total. */
 	size_t size() const;
 
+	size_t seek(ptrdiff_t offset, SeekableReadStream::Origin whence = SeekableReadStream::kOriginBegin);
+
 protected:
 	std::FILE *_handle; ///< The actual file handle.
 
+	size_t _pos;
 	size_t _size;
 };
 
@@ -96,4 +96,11 @@ void WriteStream::writeString(const UString &str) {
 		throw Exception(kWriteError);
 }
 
+
+SeekableWriteStream::SeekableWriteStream() {
+}
+
+SeekableWriteStream::~SeekableWriteStream() {
+}
+
 } // End of namespace Common
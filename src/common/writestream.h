@@ -54,6 +54,7 @@
 #include "src/common/endianness.h"
 #include "src/common/util.h"
 #include "src/common/error.h"
+#include "src/common/readstream.h"
 
 namespace Common {
 
@@ -199,6 +200,32 @@ public:
 	void writeString(const UString &str);
 };
 
+/** A writable data stream that allows going back to already written data,
+ *  for example to fill in a header once all following data is written. */
+class SeekableWriteStream : public WriteStream {
+public:
+	SeekableWriteStream();
+	~SeekableWriteStream();
+
+	/** Return the current writing position. */
+	virtual size_t pos() const = 0;
+
+	/** Return the number of bytes in the stream, i.e. the end of the data written so far. */
+	virtual size_t size() const = 0;
+
+	/** Sets the writing position, as with SeekableReadStream::seek().
+	 *
+	 *  Seeking past the end of the data written so far is not possible.
+	 *  On error, or when trying to seek outside the stream, a kSeekError
+	 *  exception is thrown.
+	 *
+	 *  @param  offset the relative offset in bytes.
+	 *  @param  whence the seek reference: kOriginBegin, kOriginCurrent or kOriginEnd.
+	 *  @return the previous position of the stream, before seeking.
+	 */
+	virtual size_t seek(ptrdiff_t offset, SeekableReadStream::Origin whence = SeekableReadStream::kOriginBegin) = 0;
+};
+
 } // End of namespace Common
 
 #endif // COMMON_WRITESTREAM_H
@@ -27,6 +27,8 @@
 #include "src/common/zipfile.h"
 #include "src/common/error.h"
 #include "src/common/util.h"
+#include "src/common/scopedptr.h"
+#include "src/common/strutil.h"
 #include "src/common/encoding.h"
 #include "src/common/memreadstream.h"
 #include "src/common/deflate.h"
@@ -55,49 +57,62 @@ void ZipFile::load(SeekableReadStream &zip) {
 	uint16 centralDirDisk = zip.readUint16LE();
 
 	uint16 curDiskDirs = zip.readUint16LE();
-	uint16 totalDirs   = zip.readUint16LE();
+	size_t totalDirs   = zip.readUint16LE();
 
-	if ((curDisk != 0) || (curDisk != centralDirDisk) || (curDiskDirs != totalDirs))
-		throw Exception("Unsupported multi-disk ZIP file");
+	size_t centralDirSize = zip.readUint32LE();
+	size_t centralDirPos  = zip.readUint32LE();
 
-	zip.skip(4); // Size of central directory
+	// The ZIP64 record, if there is one, supersedes the saturated values in the regular one
+	if (!readZIP64End(zip, endPos, totalDirs, centralDirSize, centralDirPos))
+		if ((curDisk != 0) || (curDisk != centralDirDisk) || (curDiskDirs != totalDirs))
+			throw Exception("Unsupported multi-disk ZIP file");
 
-	uint32 centralDirPos = zip.readUint32LE();
-	zip.seek(centralDirPos);
-
-	uint32 tag = zip.readUint32LE();
-	if (tag != 0x02014B50)
-		throw Exception("Unknown ZIP record %08X", tag);
+	// Read the whole central directory at once
+	ScopedPtr<MemoryReadStream> centralDir(zip.readStreamAt(centralDirPos, centralDirSize));
 
 	_iFiles.reserve(totalDirs);
-	while (tag == 0x02014B50) {
+	while ((centralDir->size() - centralDir->pos()) >= 4) {
+		uint32 tag = centralDir->readUint32LE();
+		if (tag == 0x05054B50)
+			break; // Digital signature, ends the central directory
+
+		if (tag != 0x02014B50)
+			throw Exception("Unknown ZIP record %08X", tag);
+
 		 File  file;
 		IFile iFile;
 
-		zip.skip(20);
+		centralDir->skip(6); // Version made by, version needed, flags
+
+		iFile.compMethod = centralDir->readUint16LE();
+
+		centralDir->skip(8); // Time, date, CRC
 
-		iFile.size = zip.readUint32LE();
+		iFile.compSize = centralDir->readUint32LE();
+		iFile.size     = centralDir->readUint32LE();
 
-		uint16 nameLength    = zip.readUint16LE();
-		uint16 extraLength   = zip.readUint16LE();
-		uint16 commentLength = zip.readUint16LE();
-		uint16 diskNum       = zip.readUint16LE();
+		uint16 nameLength    = centralDir->readUint16LE();
+		uint16 extraLength   = centralDir->readUint16LE();
+		uint16 commentLength = centralDir->readUint16LE();
+		uint16 diskNum       = centralDir->readUint16LE();
 
-		if (diskNum != 0)
+		// 0xFFFF means the disk number is in the ZIP64 extra field. We only support one disk anyway
+		if ((diskNum != 0) && (diskNum != 0xFFFF))
 			throw Exception("Unsupported multi-disk ZIP file");
 
-		zip.skip(6); // File attributes
+		centralDir->skip(6); // File attributes
 
-		iFile.offset = zip.readUint32LE();
+		iFile.offset = centralDir->readUint32LE();
 
-		file.name = readStringFixed(zip, kEncodingASCII, nameLength).toLower();
+		file.name = readStringFixed(*centralDir, kEncodingASCII, nameLength).toLower();
 
-		zip.skip(extraLength);
-		zip.skip(commentLength);
+		const size_t extraPos = centralDir->pos();
 
-		tag = zip.readUint32LE();
-		if ((tag != 0x02014B50) && (tag != 0x06054B50))
-			throw Exception("Unknown ZIP record %08X", tag);
+		SeekableSubReadStream extra(centralDir.get(), extraPos, extraPos + extraLength);
+		readZIP64Extra(extra, iFile);
+
+		centralDir->skip(extraLength);
+		centralDir->skip(commentLength);
 
 		// Ignore empty file names
 		if (!file.name.empty()) {
@@ -106,6 +121,8 @@ void ZipFile::load(SeekableReadStream &zip) {
 			// file attributes.
 
 			if (*(--file.name.end()) != '/') {
+				iFile.dataOffset = getDataOffset(zip, iFile.offset);
+
 				file.index = _iFiles.size();
 
 				_files.push_back(file);
@@ -115,6 +132,94 @@ void ZipFile::load(SeekableReadStream &zip) {
 	}
 }
 
+bool ZipFile::readZIP64End(SeekableReadStream &zip, size_t endPos,
+		size_t &totalDirs, size_t &dirSize, size_t &dirPos) {
+
+	// The ZIP64 end of central directory locator sits right in front of the regular record
+	static const size_t kLocatorSize = 20;
+	static const size_t kRecordSize  = 56;
+
+	if (endPos < kLocatorSize)
+		return false;
+
+	byte locator[kLocatorSize];
+	if (zip.readAt(endPos - kLocatorSize, locator, kLocatorSize) != kLocatorSize)
+		return false;
+
+	if (READ_LE_UINT32(locator) != 0x07064B50)
+		return false;
+
+	const uint32 recordDisk = READ_LE_UINT32(locator +  4);
+	const uint64 recordPos  = READ_LE_UINT64(locator +  8);
+	const uint32 diskCount  = READ_LE_UINT32(locator + 16);
+
+	if ((recordDisk != 0) || (diskCount > 1))
+		throw Exception("Unsupported multi-disk ZIP file");
+
+	if ((recordPos > zip.size()) || ((zip.size() - recordPos) < kRecordSize))
+		throw Exception("Invalid ZIP64 end of central directory locator");
+
+	byte record[kRecordSize];
+	if (zip.readAt(recordPos, record, kRecordSize) != kRecordSize)
+		throw Exception(kReadError);
+
+	const uint32 tag = READ_LE_UINT32(record);
+	if (tag != 0x06064B50)
+		throw Exception("Unknown ZIP record %08X", tag);
+
+	const uint32 curDisk        = READ_LE_UINT32(record + 16);
+	const uint32 centralDirDisk = READ_LE_UINT32(record + 20);
+	const uint64 curDiskDirs    = READ_LE_UINT64(record + 24);
+	const uint64 allDirs        = READ_LE_UINT64(record + 32);
+	const uint64 centralDirSize = READ_LE_UINT64(record + 40);
+	const uint64 centralDirPos  = READ_LE_UINT64(record + 48);
+
+	if ((curDisk != 0) || (curDisk != centralDirDisk) || (curDiskDirs != allDirs))
+		throw Exception("Unsupported multi-disk ZIP file");
+
+	if ((centralDirPos > zip.size()) || (centralDirSize > (zip.size() - centralDirPos)))
+		throw Exception("Invalid ZIP64 central directory (%s, %s)",
+		                composeString(centralDirPos).c_str(), composeString(centralDirSize).c_str());
+
+	// Only an estimate, used to reserve memory
+	totalDirs = MIN<uint64>(allDirs, centralDirSize / 46);
+
+	dirSize = centralDirSize;
+	dirPos  = centralDirPos;
+
+	return true;
+}
+
+void ZipFile::readZIP64Extra(SeekableReadStream &extra, IFile &file) {
+	while ((extra.size() - extra.pos()) >= 4) {
+		const uint16 id   = extra.readUint16LE();
+		const uint16 size = extra.readUint16LE();
+
+		if (id != 0x0001) {
+			extra.skip(size);
+			continue;
+		}
+
+		const size_t fieldPos = extra.pos();
+		SeekableSubReadStream field(&extra, fieldPos, fieldPos + size);
+
+		// The values are only present when saturated in the entry, and always in this order
+		size_t *values[] = { &file.size, &file.compSize, &file.offset };
+		for (size_t i = 0; i < ARRAYSIZE(values); i++) {
+			if (*values[i] != 0xFFFFFFFF)
+				continue;
+
+			const uint64 value = field.readUint64LE();
+			if (value > SIZE_MAX)
+				throw Exception("ZIP64 value too large for this platform (%s)", composeString(value).c_str());
+
+			*values[i] = value;
+		}
+
+		return;
+	}
+}
+
 const ZipFile::FileList &ZipFile::getFiles() const {
 	return _files;
 }
@@ -126,29 +231,22 @@ const ZipFile::IFile &ZipFile::getIFile(uint32 index) const {
 	return _iFiles[index];
 }
 
-void ZipFile::getFileProperties(SeekableReadStream &zip, const IFile &file,
-		uint16 &compMethod, uint32 &compSize, uint32 &realSize) const {
+size_t ZipFile::getDataOffset(SeekableReadStream &zip, size_t offset) {
+	static const size_t kHeaderSize = 30;
 
-	zip.seek(file.offset);
+	byte header[kHeaderSize];
+	if (zip.readAt(offset, header, kHeaderSize) != kHeaderSize)
+		throw Exception(kReadError);
 
-	uint32 tag = zip.readUint32LE();
+	const uint32 tag = READ_LE_UINT32(header);
 	if (tag != 0x04034B50)
 		throw Exception("Unknown ZIP record %08X", tag);
 
-	zip.skip(4);
-
-	compMethod = zip.readUint16LE();
-
-	zip.skip(8);
+	// The sizes in the local header might be saturated or zero. We use the ones from the central directory
+	const uint16 nameLength  = READ_LE_UINT16(header + 26);
+	const uint16 extraLength = READ_LE_UINT16(header + 28);
 
-	compSize = zip.readUint32LE();
-	realSize = zip.readUint32LE();
-
-	uint16 nameLength  = zip.readUint16LE();
-	uint16 extraLength = zip.readUint16LE();
-
-	zip.skip(nameLength);
-	zip.skip(extraLength);
+	return offset + kHeaderSize + nameLength + extraLength;
 }
 
 size_t ZipFile::getFileSize(uint32 index) const {
@@ -158,68 +256,82 @@ size_t ZipFile::getFileSize(uint32 index) const {
 SeekableReadStream *ZipFile::getFile(uint32 index, bool tryNoCopy) const {
 	const IFile &file = getIFile(index);
 
-	uint16 compMethod;
-	uint32 compSize;
-	uint32 realSize;
+	const size_t begin = file.dataOffset;
+	const size_t end   = file.dataOffset + file.compSize;
+
+	if ((end < begin) || (end > _zip->size()))
+		throw Exception("Invalid ZIP file data (%s, %s)",
+		                composeString(begin).c_str(), composeString(file.compSize).c_str());
+
+	/* Decompression reads the compressed data for as long as the returned stream lives,
+	 * so only read it directly out of the ZIP if the caller allowed us to depend on it. */
+	if (!tryNoCopy) {
+		MemoryReadStream *compData = _zip->readStreamAt(begin, file.compSize);
+		if (file.compMethod == 0)
+			return compData;
 
-	getFileProperties(*_zip, file, compMethod, compSize, realSize);
+		return decompressFile(compData, file.compMethod, file.compSize, file.size);
+	}
+
+	if (file.compMethod == 0)
+		return new SeekableSubReadStream(_zip.get(), begin, end);
+
+	return decompressFile(new SeekableSubReadStream(_zip.get(), begin, end),
+	                      file.compMethod, file.compSize, file.size);
+}
+
+SeekableReadStream &ZipFile::getStream() const {
+	return *_zip;
+}
+
+bool ZipFile::getFileLocation(uint32 index, size_t &offset, size_t &size) const {
+	const IFile &file = getIFile(index);
 
-	if (tryNoCopy && (compMethod == 0))
-		return new SeekableSubReadStream(_zip.get(), _zip->pos(), _zip->pos() + compSize);
+	offset = file.dataOffset;
+	size   = file.compSize;
 
-	return decompressFile(*_zip, compMethod, compSize, realSize);
+	return file.compMethod == 0;
 }
 
-SeekableReadStream *ZipFile::decompressFile(SeekableReadStream &zip, uint32 method,
-		uint32 compSize, uint32 realSize) {
+SeekableReadStream *ZipFile::decompressFile(SeekableReadStream *zip, uint32 method,
+		size_t compSize, size_t realSize) {
+
+	ScopedPtr<SeekableReadStream> compData(zip);
 
 	if (method == 0) {
 		// Uncompressed
 
-		return zip.readStream(compSize);
+		return compData->readStream(compSize);
 	}
 
 	if (method != 8)
 		throw Exception("Unhandled Zip compression %d", method);
 
-	return decompressDeflate(zip, compSize, realSize, kWindowBitsMaxRaw);
+	// Inflate on demand, instead of holding both the compressed and decompressed data in memory
+	return new DeflateReadStream(compData.release(), realSize, kWindowBitsMaxRaw);
 }
 
-#define BUFREADCOMMENT (0x400)
 size_t ZipFile::findCentralDirectoryEnd(SeekableReadStream &zip) {
-	const size_t uSizeFile = zip.size();
-	const size_t uMaxBack  = MIN<size_t>(0xFFFF, uSizeFile); // Maximum size of global comment
-
-	byte buf[BUFREADCOMMENT + 4];
-
-	size_t uPosFound = 0;
-	size_t uBackRead = 4;
-	while ((uPosFound == 0) && (uBackRead < uMaxBack)) {
-		uBackRead = MIN<size_t>(uMaxBack, uBackRead + BUFREADCOMMENT);
-
-		const size_t uReadPos  = uSizeFile - uBackRead;
-		const size_t uReadSize = MIN<size_t>(BUFREADCOMMENT + 4, uSizeFile - uReadPos);
+	static const size_t kRecordSize     = 22;
+	static const size_t kMaxCommentSize = 0xFFFF;
 
-		try {
-			zip.seek(uReadPos);
-		} catch (...) {
-			return 0;
-		}
+	const size_t zipSize = zip.size();
+	if (zipSize < kRecordSize)
+		return 0;
 
-		if (zip.read(buf, uReadSize) != uReadSize) {
-			uPosFound = 0;
-			break;
-		}
+	// Read the whole area the record can be in at once, and search it backwards
+	const size_t tailSize = MIN<size_t>(zipSize, kRecordSize + kMaxCommentSize);
+	const size_t tailPos  = zipSize - tailSize;
 
-		for (size_t i = (uReadSize - 3); i-- > 0; )
-			if (READ_LE_UINT32(buf + i) == 0x06054B50) {
-				uPosFound = uReadPos + i;
-				break;
-			}
+	ScopedArray<byte> tail(new byte[tailSize]);
+	if (zip.readAt(tailPos, tail.get(), tailSize) != tailSize)
+		return 0;
 
-	}
+	for (size_t i = tailSize - kRecordSize + 1; i-- > 0; )
+		if (READ_LE_UINT32(tail.get() + i) == 0x06054B50)
+			return tailPos + i;
 
-	return uPosFound;
+	return 0;
 }
 
 } // End of namespace Common
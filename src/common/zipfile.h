@@ -58,14 +58,31 @@ public:
 	/** Return the size of a file. */
 	size_t getFileSize(uint32 index) const;
 
-	/** Return a stream of the file's contents. */
+	/** Return a stream of the file's contents.
+	 *
+	 *  Unless tryNoCopy is set, the returned stream owns all the data
+	 *  it reads, and stays valid after the ZipFile is destroyed.
+	 *  Otherwise, it might read from the ZIP's stream directly.
+	 */
 	SeekableReadStream *getFile(uint32 index, bool tryNoCopy = false) const;
 
+	/** Return the stream the ZIP file is read from. */
+	SeekableReadStream &getStream() const;
+
+	/** Find where the file's (compressed) data is stored within the ZIP.
+	 *
+	 *  @return true if the file is stored uncompressed.
+	 */
+	bool getFileLocation(uint32 index, size_t &offset, size_t &size) const;
+
 private:
-	/** Internal file information. */
+	/** Internal file information, collected once when loading the ZIP. */
 	struct IFile {
-		uint32 offset; ///< The offset of the file within the ZIP.
-		uint32 size;   ///< The file's size.
+		size_t offset;     ///< The offset of the file's local header within the ZIP.
+		size_t dataOffset; ///< The offset of the file's data within the ZIP.
+		size_t size;       ///< The file's size.
+		size_t compSize;   ///< The size of the file's compressed data.
+		uint16 compMethod; ///< The method the file was compressed with.
 	};
 
 	typedef std::vector<IFile> IFileList;
@@ -81,12 +98,38 @@ private:
 	void load(SeekableReadStream &zip);
 	size_t findCentralDirectoryEnd(SeekableReadStream &zip);
 
-	static SeekableReadStream *decompressFile(SeekableReadStream &zip, uint32 method,
-			uint32 compSize, uint32 realSize);
+	/** Read the ZIP64 end of central directory record, if there is one.
+	 *
+	 *  @param  zip        The ZIP file.
+	 *  @param  endPos     The position of the (regular) end of central directory record.
+	 *  @param  totalDirs  The number of entries in the central directory.
+	 *  @param  dirSize    The size of the central directory.
+	 *  @param  dirPos     The position of the central directory.
+	 *  @return true if there was a ZIP64 record.
+	 */
+	static bool readZIP64End(SeekableReadStream &zip, size_t endPos,
+			size_t &totalDirs, size_t &dirSize, size_t &dirPos);
+
+	/** Read the ZIP64 extended information out of a central directory entry's extra field.
+	 *
+	 *  Only the values that are saturated in the entry itself are stored in the extra field.
+	 */
+	static void readZIP64Extra(SeekableReadStream &extra, IFile &file);
+
+	/** Read the local header of a file, and return the offset of the file's data.
+	 *
+	 *  The header is read positionally, the position of the zip stream is not changed.
+	 */
+	static size_t getDataOffset(SeekableReadStream &zip, size_t offset);
+
+	/** Return a stream of a file's decompressed data.
+	 *
+	 *  @param zip The file's compressed data. Ownership is transferred.
+	 */
+	static SeekableReadStream *decompressFile(SeekableReadStream *zip, uint32 method,
+			size_t compSize, size_t realSize);
 
 	const IFile &getIFile(uint32 index) const;
-	void getFileProperties(SeekableReadStream &zip, const IFile &file,
-			uint16 &compMethod, uint32 &compSize, uint32 &realSize) const;
 };
 
 } // End of namespace Common
@@ -0,0 +1,596 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Headless extraction of resources.
+ */
+
+#include "src/common/atomic.h"
+
+#include <cstdio>
+#include <vector>
+#include <set>
+#include <map>
+#include <chrono>
+
+#include <boost/noncopyable.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "src/common/util.h"
+#include "src/common/error.h"
+#include "src/common/ustring.h"
+#include "src/common/strutil.h"
+#include "src/common/scopedptr.h"
+#include "src/common/ptrvector.h"
+#include "src/common/mutex.h"
+#include "src/common/thread.h"
+#include "src/common/filepath.h"
+#include "src/common/filetree.h"
+#include "src/common/writefile.h"
+
+#include "src/aurora/util.h"
+#include "src/aurora/archive.h"
+#include "src/aurora/keyfile.h"
+#include "src/aurora/biffile.h"
+#include "src/aurora/bzffile.h"
+#include "src/aurora/erffile.h"
+#include "src/aurora/rimfile.h"
+#include "src/aurora/zipfile.h"
+#include "src/aurora/herffile.h"
+#include "src/aurora/ndsrom.h"
+#include "src/aurora/readscheduler.h"
+
+#include "src/images/decoder.h"
+#include "src/images/loader.h"
+#include "src/images/dumptga.h"
+
+#include "src/sound/sound.h"
+#include "src/sound/audiostream.h"
+#include "src/sound/dumpwav.h"
+
+#include "src/cline.h"
+#include "src/extract.h"
+
+static bool isArchiveType(Aurora::FileType type) {
+	switch (type) {
+		case Aurora::kFileTypeKEY:
+		case Aurora::kFileTypeZIP:
+		case Aurora::kFileTypeERF:
+		case Aurora::kFileTypeMOD:
+		case Aurora::kFileTypeNWM:
+		case Aurora::kFileTypeSAV:
+		case Aurora::kFileTypeHAK:
+		case Aurora::kFileTypeRIM:
+		case Aurora::kFileTypeHERF:
+		case Aurora::kFileTypeNDS:
+			return true;
+
+		default:
+			break;
+	}
+
+	return false;
+}
+
+/** A single resource to extract. */
+struct ExtractTask {
+	const Aurora::Archive *archive; ///< The archive containing the resource, 0 for a plain file.
+	uint32 index;                   ///< The index of the resource within the archive.
+
+	Common::UString inPath;  ///< The path of the plain file, if this isn't an archive resource.
+	Common::UString outPath; ///< The path of the file to write.
+
+	Aurora::FileType type; ///< The resource's file type.
+	uint64 size;           ///< The size of the resource's data.
+
+	ExtractTask() : archive(0), index(0xFFFFFFFF), type(Aurora::kFileTypeNone), size(0) {
+	}
+};
+
+/** Collects the resources to extract and extracts them on a pool of threads.
+ *
+ *  Walking the file tree, opening the archives and deciding on output paths
+ *  is done up-front on the main thread, which leaves the workers with nothing
+ *  but independent per-resource tasks.
+ *
+ *  The resources within archives are handed to an Aurora::ReadScheduler,
+ *  which reads them in the order they're stored in, merging neighbouring
+ *  resources into larger reads, on a pool of threads. Plain files are then
+ *  extracted by workers taking the next task from a shared atomic cursor,
+ *  so a thread stuck on one big file doesn't hold up the others.
+ *
+ *  Both pools are Common::parallelFor() ones, so each task is extracted (and
+ *  images decompressed) on its worker thread alone.
+ */
+class Extractor : boost::noncopyable {
+public:
+	Extractor(const Job &job);
+	~Extractor();
+
+	void collect();
+	void extract();
+
+	void printSummary() const;
+
+private:
+	const Job *_job;
+
+	Common::PtrVector<Aurora::Archive> _archives;
+	Common::PtrVector<Aurora::KEYDataFile> _dataFiles;
+
+	std::vector<ExtractTask> _tasks;
+	std::set<Common::UString> _outDirs;
+
+	/** The output paths of all tasks, case-folded, so that no two tasks write the same file. */
+	std::set<Common::UString> _outPaths;
+
+	/** The KEY data files opened so far, by their path, so that KEYs sharing one open it only once. */
+	std::map<Common::UString, Aurora::KEYDataFile *> _dataFilePaths;
+
+	size_t _renamed; ///< Number of tasks whose output path was taken, and which were renamed.
+	size_t _skipped; ///< Number of tasks skipped because another KEY already lists the same resource.
+
+	/** The tasks extracting plain files, by index into the task list. */
+	std::vector<size_t> _fileTasks;
+
+	boost::atomic<size_t> _extracted;
+	boost::atomic<size_t> _failed;
+	boost::atomic<uint64> _bytesRead;
+	boost::atomic<uint64> _bytesWritten;
+
+	double _seconds;
+
+	Common::Mutex _printMutex;
+
+	void addEntry(const Common::FileTree::Entry &entry, const Common::UString &outDir);
+	void addArchive(const Common::UString &path, Aurora::FileType type, const Common::UString &outDir);
+	void addKEYDataFiles(Aurora::KEYFile &key, const Common::UString &path, const Common::UString &outDir);
+	void addResources(const Aurora::Archive &archive,
+	                  const std::vector<const Aurora::Archive::Resource *> &resources,
+	                  const Common::UString &outDir, bool renameDuplicates = true);
+
+	/** Queue a task, unless it's filtered out.
+	 *
+	 *  If the output path is already taken, the task is either renamed or skipped.
+	 */
+	bool addTask(ExtractTask &task, const Common::UString &name, const Common::UString &outDir,
+	             bool renameDuplicates = true);
+
+	/** Find an output path that's not yet taken, by numbering the file name. */
+	Common::UString findFreeOutPath(const Common::UString &outDir, const Common::UString &name);
+
+	Aurora::Archive *openArchive(const Common::UString &path, Aurora::FileType type);
+	Aurora::KEYDataFile *openDataFile(const Common::UString &path, Aurora::FileType type);
+
+	void extractFile(const ExtractTask &task);
+
+	/** Extract a task's resource out of this stream. Ownership of the stream is transferred. */
+	void finishTask(const ExtractTask &task, Common::SeekableReadStream *res);
+	void failTask(const ExtractTask &task, Common::Exception &e);
+
+	uint64 extractTask(const ExtractTask &task, Common::SeekableReadStream *res);
+
+	void printWarning(Common::Exception &e);
+};
+
+Extractor::Extractor(const Job &job) : _job(&job), _renamed(0), _skipped(0),
+	_extracted(0), _failed(0), _bytesRead(0), _bytesWritten(0), _seconds(0.0) {
+}
+
+Extractor::~Extractor() {
+	// The KEYs reference their data files
+	_archives.clear();
+	_dataFiles.clear();
+}
+
+void Extractor::collect() {
+	Common::FileTree files;
+	files.readPath(_job->path, -1);
+
+	const Common::FileTree::Entry &root = files.getRoot();
+	if (root.isDirectory()) {
+		for (std::list<Common::FileTree::Entry>::const_iterator c = root.children.begin(); c != root.children.end(); ++c)
+			addEntry(*c, _job->outPath);
+	} else
+		addEntry(root, _job->outPath);
+}
+
+void Extractor::addEntry(const Common::FileTree::Entry &entry, const Common::UString &outDir) {
+	const Common::UString outPath = outDir + "/" + entry.name;
+
+	if (entry.isDirectory()) {
+		for (std::list<Common::FileTree::Entry>::const_iterator c = entry.children.begin(); c != entry.children.end(); ++c)
+			addEntry(*c, outPath);
+
+		return;
+	}
+
+	const Common::UString path = entry.path.generic_string();
+	const Aurora::FileType type = TypeMan.getFileType(entry.name);
+
+	// BIF and BZF files are only accessible through their KEY file
+	if ((type == Aurora::kFileTypeBIF) || (type == Aurora::kFileTypeBZF))
+		return;
+
+	if (isArchiveType(type)) {
+		try {
+			addArchive(path, type, (type == Aurora::kFileTypeKEY) ? outDir : outPath);
+		} catch (Common::Exception &e) {
+			e.add("Failed to load archive \"%s\"", path.c_str());
+			printWarning(e);
+		}
+
+		return;
+	}
+
+	ExtractTask task;
+
+	task.inPath = path;
+	task.type   = type;
+	task.size   = Common::FilePath::getFileSize(path);
+
+	addTask(task, entry.name, outDir);
+}
+
+void Extractor::addArchive(const Common::UString &path, Aurora::FileType type, const Common::UString &outDir) {
+	Aurora::Archive *archive = openArchive(path, type);
+	_archives.push_back(archive);
+
+	if (type == Aurora::kFileTypeKEY) {
+		addKEYDataFiles(static_cast<Aurora::KEYFile &>(*archive), path, outDir);
+		return;
+	}
+
+	const Aurora::Archive::ResourceList &resources = archive->getResources();
+
+	std::vector<const Aurora::Archive::Resource *> list;
+	list.reserve(resources.size());
+
+	for (Aurora::Archive::ResourceList::const_iterator r = resources.begin(); r != resources.end(); ++r)
+		list.push_back(&*r);
+
+	addResources(*archive, list, outDir);
+}
+
+void Extractor::addKEYDataFiles(Aurora::KEYFile &key, const Common::UString &path, const Common::UString &outDir) {
+	/* The data files are named relative to the directory of the KEY. Their
+	 * resources are extracted into a directory for each data file, mirroring
+	 * the data files' place in the game directory. */
+
+	const Common::UString keyDir = Common::FilePath::getDirectory(path);
+
+	const std::vector<Common::UString> &dataFiles = key.getDataFileList();
+	for (size_t i = 0; i < dataFiles.size(); i++) {
+		bool shared = false;
+
+		try {
+			const Common::UString dataPath = Common::FilePath::normalize(keyDir + "/" + dataFiles[i]);
+			if (dataPath.empty() || !Common::FilePath::isRegularFile(dataPath))
+				throw Common::Exception("No such file \"%s\"", (keyDir + "/" + dataFiles[i]).c_str());
+
+			// Patch KEYs might list the data files of another KEY again. Those are only opened once.
+			Aurora::KEYDataFile *&dataFile = _dataFilePaths[dataPath];
+
+			shared = dataFile != 0;
+			if (!shared)
+				dataFile = openDataFile(dataPath, TypeMan.getFileType(dataFiles[i]));
+
+			key.addDataFile(i, dataFile);
+
+		} catch (Common::Exception &e) {
+			e.add("Failed to load KEY data file \"%s\"", dataFiles[i].c_str());
+			printWarning(e);
+
+			continue;
+		}
+
+		/* If another KEY already listed this data file, its resources are queued already.
+		 * The same names then mean the same data, so don't write them again. */
+		addResources(key, key.getResourceListForDataFile(i), outDir + "/" + dataFiles[i], !shared);
+	}
+}
+
+void Extractor::addResources(const Aurora::Archive &archive,
+                             const std::vector<const Aurora::Archive::Resource *> &resources,
+                             const Common::UString &outDir, bool renameDuplicates) {
+
+	for (std::vector<const Aurora::Archive::Resource *>::const_iterator r = resources.begin();
+	     r != resources.end(); ++r) {
+
+		Common::UString name = (*r)->name;
+		if (name.empty())
+			name = Common::composeString((*r)->hash);
+
+		ExtractTask task;
+
+		task.archive = &archive;
+		task.index   = (*r)->index;
+		task.type    = (*r)->type;
+		task.size    = archive.getResourceSize((*r)->index);
+
+		addTask(task, TypeMan.setFileType(name, (*r)->type), outDir, renameDuplicates);
+	}
+}
+
+bool Extractor::addTask(ExtractTask &task, const Common::UString &name, const Common::UString &outDir,
+                        bool renameDuplicates) {
+
+	if (!_job->filters.empty()) {
+		bool matches = false;
+		for (std::vector<Common::UString>::const_iterator f = _job->filters.begin(); f != _job->filters.end(); ++f)
+			if ((matches = Common::matchGlob(f->c_str(), name.c_str())))
+				break;
+
+		if (!matches)
+			return false;
+	}
+
+	const Aurora::ResourceType resType = TypeMan.getResourceType(task.type);
+
+	Common::UString outName = name;
+	switch (_job->extractMode) {
+		case kExtractModeTGA:
+			if (resType != Aurora::kResourceImage)
+				return false;
+
+			outName = TypeMan.setFileType(name, Aurora::kFileTypeTGA);
+			break;
+
+		case kExtractModeWAV:
+			if (resType != Aurora::kResourceSound)
+				return false;
+
+			outName = TypeMan.setFileType(name, Aurora::kFileTypeWAV);
+			break;
+
+		default:
+			break;
+	}
+
+	// Two tasks writing the same file at the same time would corrupt it
+	task.outPath = outDir + "/" + outName;
+	if (!_outPaths.insert(task.outPath.toLower()).second) {
+		if (!renameDuplicates) {
+			_skipped++;
+			return false;
+		}
+
+		task.outPath = findFreeOutPath(outDir, outName);
+		_renamed++;
+	}
+
+	_outDirs.insert(outDir);
+	_tasks.push_back(task);
+
+	return true;
+}
+
+Common::UString Extractor::findFreeOutPath(const Common::UString &outDir, const Common::UString &name) {
+	const Common::UString stem      = Common::FilePath::getStem(name);
+	const Common::UString extension = Common::FilePath::getExtension(name);
+
+	for (size_t i = 1; ; i++) {
+		const Common::UString outPath = outDir + "/" + stem + "_" + Common::composeString(i) + extension;
+
+		if (_outPaths.insert(outPath.toLower()).second)
+			return outPath;
+	}
+}
+
+Aurora::KEYDataFile *Extractor::openDataFile(const Common::UString &path, Aurora::FileType type) {
+	Aurora::KEYDataFile *dataFile = 0;
+	switch (type) {
+		case Aurora::kFileTypeBIF:
+			dataFile = new Aurora::BIFFile(Aurora::openArchiveFile(path));
+			break;
+
+		case Aurora::kFileTypeBZF:
+			dataFile = new Aurora::BZFFile(Aurora::openArchiveFile(path));
+			break;
+
+		default:
+			throw Common::Exception("Unknown KEY data file type %d", type);
+	}
+
+	_dataFiles.push_back(dataFile);
+	return dataFile;
+}
+
+Aurora::Archive *Extractor::openArchive(const Common::UString &path, Aurora::FileType type) {
+	Common::ScopedPtr<Common::SeekableReadStream> stream(Aurora::openArchiveFile(path));
+
+	switch (type) {
+		case Aurora::kFileTypeZIP:
+			return new Aurora::ZIPFile(stream.release());
+
+		case Aurora::kFileTypeERF:
+		case Aurora::kFileTypeMOD:
+		case Aurora::kFileTypeNWM:
+		case Aurora::kFileTypeSAV:
+		case Aurora::kFileTypeHAK:
+			return new Aurora::ERFFile(stream.release());
+
+		case Aurora::kFileTypeRIM: {
+			const bool isERF = Aurora::ERFFile::isERFID(stream->readUint32BE());
+			stream->seek(0);
+
+			if (isERF)
+				return new Aurora::ERFFile(stream.release());
+
+			return new Aurora::RIMFile(stream.release());
+		}
+
+		case Aurora::kFileTypeKEY:
+			return new Aurora::KEYFile(stream.release());
+
+		case Aurora::kFileTypeHERF:
+			return new Aurora::HERFFile(stream.release());
+
+		case Aurora::kFileTypeNDS:
+			return new Aurora::NDSFile(stream.release());
+
+		default:
+			break;
+	}
+
+	throw Common::Exception("Invalid archive file \"%s\"", path.c_str());
+}
+
+void Extractor::extract() {
+	for (std::set<Common::UString>::const_iterator d = _outDirs.begin(); d != _outDirs.end(); ++d)
+		Common::FilePath::createDirectories(*d);
+
+	size_t threadCount = _job->threadCount;
+	if (threadCount == 0)
+		threadCount = boost::thread::hardware_concurrency();
+
+	threadCount = CLIP<size_t>(threadCount, 1, MAX<size_t>(_tasks.size(), 1));
+
+	// Archive resources are read in the order they're stored in, with merged reads
+	Aurora::ReadScheduler scheduler;
+	std::vector<size_t> requestTasks;
+
+	_fileTasks.clear();
+	for (size_t i = 0; i < _tasks.size(); i++) {
+		if (!_tasks[i].archive) {
+			_fileTasks.push_back(i);
+			continue;
+		}
+
+		scheduler.add(*_tasks[i].archive, _tasks[i].index);
+		requestTasks.push_back(i);
+	}
+
+	std::printf("Extracting %u resources with %u threads...\n", (uint)_tasks.size(), (uint)threadCount);
+	if (scheduler.getRequestCount() > 0)
+		std::printf("Reading %u archive resources in %u reads...\n",
+		            (uint)scheduler.getRequestCount(), (uint)scheduler.getReadCount());
+
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	scheduler.run([this, &requestTasks](size_t request, Common::SeekableReadStream *res) {
+		finishTask(_tasks[requestTasks[request]], res);
+	}, [this, &requestTasks](size_t request, Common::Exception &e) {
+		failTask(_tasks[requestTasks[request]], e);
+	}, threadCount);
+
+	Common::parallelFor(_fileTasks.size(), [this](size_t i) {
+		extractFile(_tasks[_fileTasks[i]]);
+	}, threadCount);
+
+	_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Extractor::extractFile(const ExtractTask &task) {
+	try {
+		finishTask(task, Aurora::openArchiveFile(task.inPath));
+
+	} catch (Common::Exception &e) {
+		failTask(task, e);
+	} catch (std::exception &e) {
+		Common::Exception se(e);
+
+		failTask(task, se);
+	}
+}
+
+void Extractor::finishTask(const ExtractTask &task, Common::SeekableReadStream *res) {
+	const uint64 written = extractTask(task, res);
+
+	_extracted++;
+	_bytesRead    += task.size;
+	_bytesWritten += written;
+}
+
+void Extractor::failTask(const ExtractTask &task, Common::Exception &e) {
+	e.add("Failed to extract \"%s\"", task.outPath.c_str());
+	printWarning(e);
+
+	_failed++;
+}
+
+uint64 Extractor::extractTask(const ExtractTask &task, Common::SeekableReadStream *stream) {
+	Common::ScopedPtr<Common::SeekableReadStream> res(stream);
+
+	switch (_job->extractMode) {
+		case kExtractModeTGA: {
+			Common::ScopedPtr<Images::Decoder> image(Images::loadImage(*res, task.type));
+
+			Images::dumpTGA(task.outPath, *image);
+
+			return Common::FilePath::getFileSize(task.outPath);
+		}
+
+		case kExtractModeWAV: {
+			Common::ScopedPtr<Sound::AudioStream> sound(Sound::SoundManager::makeAudioStream(res.get()));
+			res.release();
+
+			Common::WriteFile file(task.outPath);
+
+			Sound::dumpWAV(file, *sound);
+			file.flush();
+
+			return file.size();
+		}
+
+		default:
+			break;
+	}
+
+	Common::WriteFile file(task.outPath);
+
+	file.writeStream(*res);
+	file.flush();
+
+	return file.size();
+}
+
+void Extractor::printWarning(Common::Exception &e) {
+	Common::StackLock lock(_printMutex);
+
+	Common::printException(e, "WARNING: ");
+}
+
+void Extractor::printSummary() const {
+	const double seconds = MAX(_seconds, 0.001);
+
+	const uint64 bytesRead    = _bytesRead;
+	const uint64 bytesWritten = _bytesWritten;
+
+	std::printf("Extracted %u resources in %.2lfs (%u failed)\n",
+	            (uint)_extracted, seconds, (uint)_failed);
+	if ((_renamed > 0) || (_skipped > 0))
+		std::printf("Renamed %u resources with duplicate names, skipped %u listed by several KEYs\n",
+		            (uint)_renamed, (uint)_skipped);
+	std::printf("Read %s, wrote %s: %.1lf resources/s, %s/s\n",
+	            Common::FilePath::getHumanReadableSize(bytesRead).c_str(),
+	            Common::FilePath::getHumanReadableSize(bytesWritten).c_str(),
+	            _extracted / seconds,
+	            Common::FilePath::getHumanReadableSize((size_t)(bytesRead / seconds)).c_str());
+}
+
+void extractResources(const Job &job) {
+	Extractor extractor(job);
+
+	extractor.collect();
+	extractor.extract();
+
+	extractor.printSummary();
+}
@@ -0,0 +1,39 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Headless extraction of resources.
+ */
+
+#ifndef EXTRACT_H
+#define EXTRACT_H
+
+struct Job;
+
+/** Extract all resources found in the job's path that match the job's filters.
+ *
+ *  The path can be a directory, which is then searched recursively, or a
+ *  single file. Archives (KEY, ERF, RIM, ZIP, HERF, NDS) are expanded into a
+ *  directory of their resources, all other files are treated as resources
+ *  themselves. The resources are then extracted by a pool of worker threads.
+ */
+void extractResources(const Job &job);
+
+#endif // EXTRACT_H
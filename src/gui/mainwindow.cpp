@@ -22,8 +22,6 @@
  *  Phaethon's main window.
  */
 
-#include <deque>
-
 #include <QAction>
 #include <QApplication>
 #include <QMenuBar>
@@ -62,6 +60,7 @@
 
 #include "src/sound/sound.h"
 #include "src/sound/audiostream.h"
+#include "src/sound/dumpwav.h"
 
 #include "src/version/version.h"
 
@@ -71,8 +70,7 @@ W_OBJECT_IMPL(MainWindow)
 
 MainWindow::MainWindow(QWidget *parent, const char *title, const QSize &size, const char *path) :
 	QMainWindow(parent), _status(statusBar()), _treeView(nullptr), _treeModel(nullptr), _proxyModel(nullptr),
-	_rootPath(""), _panelResourceInfo(nullptr), _panelManager(new PanelManager()),
-	_watcher(new QFutureWatcher<void>(this)) {
+	_rootPath(""), _panelResourceInfo(nullptr), _panelManager(new PanelManager()) {
 	/* Window setup. */
 	setWindowTitle(title);
 	resize(size);
@@ -183,6 +181,10 @@ MainWindow::MainWindow(QWidget *parent, const char *title, const QSize &size, co
 	_splitterTopBottom->addWidget(logBox);
 
 	// Resource info frame
+	_panelManager->setLog([this](const QString &text) {
+		slotLog(text);
+	});
+
 	_panelManager->registerPanel(new PanelPreviewEmpty(nullptr), Aurora::kResourceNone);
 	_panelManager->registerPanel(new PanelPreviewSound(nullptr), Aurora::kResourceSound);
 	_panelManager->registerPanel(new PanelPreviewImage(nullptr), Aurora::kResourceImage);
@@ -239,9 +241,15 @@ MainWindow::MainWindow(QWidget *parent, const char *title, const QSize &size, co
 }
 
 MainWindow::~MainWindow() {
+	saveIndexCache();
+
 	delete _panelManager;
 }
 
+Aurora::IndexCache *MainWindow::getIndexCache() const {
+	return _indexCache.get();
+}
+
 void MainWindow::slotLog(const QString &text) {
 	_log->append(text);
 }
@@ -284,6 +292,7 @@ void MainWindow::open(const QString &path) {
 	if (_rootPath == path)
 		return;
 
+	// Also cancels populating the previously opened path
 	close();
 
 	_rootPath = path;
@@ -292,18 +301,39 @@ void MainWindow::open(const QString &path) {
 	_status.push("Populating resource tree...");
 
 	try {
-		_files.readPath(Common::UString(path.toStdString()), -1);
+		const Common::UString rootPath(path.toStdString());
+
+		_indexCache.reset(new Aurora::IndexCache(rootPath));
+		_treeModel.reset(new ResourceTree(this, _treeView));
+
+		/* Reuse the directory tree from the last time this path was opened, if nothing
+		 * changed since. Otherwise, the directory tree is read in the background. */
+		if (_indexCache->getTree(_files))
+			_treeModel->populate(_files.getRoot());
+		else
+			_treeModel->populate(rootPath);
+
 	} catch (Common::Exception &e) {
 		_status.pop();
 
+		_treeModel.reset(nullptr);
+		_indexCache.reset(nullptr);
+		_files.clear();
+
 		Common::printException(e, "WARNING: ");
 		return;
 	}
 
-	_treeModel.reset(new ResourceTree(this, _treeView));
+	// Show the tree right away, the deeper levels are filled in while the user browses
+	_proxyModel->setSourceModel(_treeModel.get());
+	_proxyModel->sort(0);
+
+	_treeView->setModel(_proxyModel.get());
+	_treeView->expandToDepth(0);
+	_treeView->show();
 
-	// Enters populate thread in here.
-	_treeModel->populate(_files.getRoot());
+	QObject::connect(_treeView->selectionModel(), &QItemSelectionModel::selectionChanged,
+		this, &MainWindow::resourceSelect);
 
 	_log->append(tr("Set root: %1").arg(path));
 
@@ -311,22 +341,26 @@ void MainWindow::open(const QString &path) {
 }
 
 void MainWindow::openFinish() {
-	_proxyModel->setSourceModel(_treeModel.get());
-	_proxyModel->sort(0);
-
-	_treeView->setModel(_proxyModel.get());
-	_treeView->expandToDepth(0);
-	_treeView->show();
 	_treeView->resizeColumnToContents(0);
 
-	QObject::connect(_treeView->selectionModel(), &QItemSelectionModel::selectionChanged,
-		this, &MainWindow::resourceSelect);
+	// We had to read the directory tree, so remember it for next time
+	if (_files.isEmpty() && _indexCache) {
+		try {
+			_treeModel->getFileTree(_files);
+			_indexCache->setTree(_files);
+		} catch (Common::Exception &e) {
+			Common::printException(e, "WARNING: ");
+		}
+	}
+
+	saveIndexCache();
 
 	_status.pop();
 }
 
 void MainWindow::close() {
 	_panelManager->setItem(nullptr);
+	_panelManager->waitForPreviews();
 
 	_panelResourceInfo->setButtonsForClosedDir();
 	_panelResourceInfo->clearLabels();
@@ -334,6 +368,11 @@ void MainWindow::close() {
 	_treeModel.reset(nullptr);
 	_currentItem = nullptr;
 
+	saveIndexCache();
+	_indexCache.reset(nullptr);
+
+	_files.clear();
+
 	_rootPath = "";
 
 	_actionClose->setEnabled(false);
@@ -341,6 +380,17 @@ void MainWindow::close() {
 	_status.pop();
 }
 
+void MainWindow::saveIndexCache() {
+	if (!_indexCache)
+		return;
+
+	try {
+		_indexCache->save();
+	} catch (Common::Exception &e) {
+		Common::printException(e, "WARNING: ");
+	}
+}
+
 void MainWindow::statusPush(const QString &text) {
 	_status.push(text);
 }
@@ -349,11 +399,20 @@ void MainWindow::statusPop() {
 	_status.pop();
 }
 
+void MainWindow::statusProgress(int value, int maximum, const std::function<void()> &cancel) {
+	_status.showProgress(value, maximum, cancel);
+}
+
+void MainWindow::statusProgressHide() {
+	_status.hideProgress();
+}
+
 void MainWindow::resourceSelect(const QItemSelection &selected, const QItemSelection &UNUSED(deselected)) {
 	const QModelIndexList index = _proxyModel->mapSelectionToSource(selected).indexes();
 	_currentItem = _treeModel->itemFromIndex(index.at(0));
 
 	_panelResourceInfo->update(_currentItem);
+	_panelResourceInfo->setResolution(_treeModel->getResolution(*_currentItem));
 
 	if (!_currentItem->isDir() && !_currentItem->isArchive())
 		_panelManager->setItem(_currentItem);
@@ -418,7 +477,7 @@ void MainWindow::exportTGA() {
 	} BOOST_SCOPE_EXIT_END
 
 	try {
-		QScopedPointer<Images::Decoder> image(_currentItem->getImage());
+		const std::shared_ptr<const Images::Decoder> image = _currentItem->getImage();
 
 		image->dumpTGA(fileName.toStdString());
 
@@ -427,16 +486,6 @@ void MainWindow::exportTGA() {
 	}
 }
 
-struct SoundBuffer {
-	static const size_t kBufferSize = 4096;
-
-	int16 buffer[kBufferSize];
-	int samples;
-
-	SoundBuffer() : samples(0) {
-	}
-};
-
 void MainWindow::exportBMUMP3Impl(Common::SeekableReadStream &bmu, Common::WriteStream &mp3) {
 	if ((bmu.size() <= 8) ||
 		(bmu.readUint32BE() != MKTAG('B', 'M', 'U', ' ')) ||
@@ -479,69 +528,6 @@ void MainWindow::exportBMUMP3() {
 	}
 }
 
-uint64 getSoundLength(Sound::AudioStream *sound) {
-	Sound::RewindableAudioStream *rewSound = dynamic_cast<Sound::RewindableAudioStream *>(sound);
-	if (!rewSound)
-		return Sound::RewindableAudioStream::kInvalidLength;
-
-	return rewSound->getLength();
-}
-
-void MainWindow::exportWAVImpl(Sound::AudioStream *sound, Common::WriteStream &wav) {
-	assert(sound);
-
-	const uint16 channels = sound->getChannels();
-	const uint32 rate     = sound->getRate();
-
-	std::deque<SoundBuffer> buffers;
-
-	uint64 length = getSoundLength(sound);
-	if (length != Sound::RewindableAudioStream::kInvalidLength)
-		buffers.resize((length / (SoundBuffer::kBufferSize / channels)) + 1);
-
-	uint32 samples = 0;
-	std::deque<SoundBuffer>::iterator buffer = buffers.begin();
-	while (!sound->endOfStream()) {
-		if (buffer == buffers.end()) {
-			buffers.push_back(SoundBuffer());
-			buffer = --buffers.end();
-		}
-
-		buffer->samples = sound->readBuffer(buffer->buffer, SoundBuffer::kBufferSize);
-
-		if (buffer->samples > 0)
-			samples += buffer->samples;
-
-		++buffer;
-	}
-
-	samples /= channels;
-
-	const uint32 dataSize   = samples * channels * 2;
-	const uint32 byteRate   = rate * channels * 2;
-	const uint16 blockAlign = channels * 2;
-
-	wav.writeUint32BE(MKTAG('R', 'I', 'F', 'F'));
-	wav.writeUint32LE(36 + dataSize);
-	wav.writeUint32BE(MKTAG('W', 'A', 'V', 'E'));
-
-	wav.writeUint32BE(MKTAG('f', 'm', 't', ' '));
-	wav.writeUint32LE(16);
-	wav.writeUint16LE(1);
-	wav.writeUint16LE(channels);
-	wav.writeUint32LE(rate);
-	wav.writeUint32LE(byteRate);
-	wav.writeUint16LE(blockAlign);
-	wav.writeUint16LE(16);
-
-	wav.writeUint32BE(MKTAG('d', 'a', 't', 'a'));
-	wav.writeUint32LE(dataSize);
-
-	for (std::deque<SoundBuffer>::const_iterator b = buffers.begin(); b != buffers.end(); ++b)
-		for (int i = 0; i < b->samples; i++)
-			wav.writeUint16LE(b->buffer[i]);
-}
-
 void MainWindow::exportWAV() {
 	if (!_currentItem)
 		return;
@@ -566,7 +552,7 @@ void MainWindow::exportWAV() {
 
 		Common::WriteFile file(fileName.toStdString());
 
-		exportWAVImpl(sound.get(), file);
+		Sound::dumpWAV(file, *sound);
 		file.flush();
 
 	} catch (Common::Exception &e) {
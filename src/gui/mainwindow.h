@@ -26,7 +26,8 @@
 #define GUI_MAINWINDOW_H
 
 #include <QMainWindow>
-#include <QFutureWatcher>
+
+#include "src/aurora/indexcache.h"
 
 #include "src/common/filetree.h"
 #include "src/common/scopedptr.h"
@@ -59,6 +60,9 @@ public:
 	MainWindow(QWidget *parent, const char *title, const QSize &size, const char *path);
 	~MainWindow();
 
+	/** Return the index cache of the opened path, or 0 if there is none. */
+	Aurora::IndexCache *getIndexCache() const;
+
 private /*slots*/:
 	void slotLog(const QString &text);
 	W_SLOT(slotLog, W_Access::Private)
@@ -96,13 +100,17 @@ private:
 
 	void close();
 
+	/** Write the index cache of the opened path, so that it can be reopened quickly. */
+	void saveIndexCache();
+
 	void statusPush(const QString &text);
 	void statusPop();
+	void statusProgress(int value, int maximum, const std::function<void()> &cancel);
+	void statusProgressHide();
 
 	void resourceSelect(const QItemSelection &selected, const QItemSelection &deselected);
 
 	void exportBMUMP3Impl(Common::SeekableReadStream &bmu, Common::WriteStream &mp3);
-	void exportWAVImpl(Sound::AudioStream *sound, Common::WriteStream &wav);
 
 	StatusBar _status;
 
@@ -126,7 +134,9 @@ private:
 	QFrame *_resPreviewFrame;
 	QTextEdit *_log;
 
+	/** The directory tree restored from the index cache, or read while populating. */
 	Common::FileTree _files;
+	Common::ScopedPtr<Aurora::IndexCache> _indexCache;
 	Common::ScopedPtr<ResourceTree> _treeModel;
 	Common::ScopedPtr<ProxyModel> _proxyModel;
 	QString _rootPath;
@@ -137,8 +147,6 @@ private:
 
 	PanelManager *_panelManager;
 
-	QFutureWatcher<void> *_watcher;
-
 	friend class ResourceTree;
 };
 
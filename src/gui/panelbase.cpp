@@ -32,7 +32,7 @@
 namespace GUI {
 
 PanelBase::PanelBase(QWidget *parent) :
-	QFrame(parent) {
+	QFrame(parent), _jobs(nullptr) {
 	hide();
 }
 
@@ -48,4 +48,8 @@ void PanelBase::setParent(QLayout *layout) {
 	layout->addWidget(this);
 }
 
+void PanelBase::setJobs(PreviewJobs *jobs) {
+	_jobs = jobs;
+}
+
 } // End of namespace GUI
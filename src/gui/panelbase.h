@@ -37,6 +37,7 @@ class QWidget;
 namespace GUI {
 
 class ResourceTreeItem;
+class PreviewJobs;
 
 class PanelBase : public QFrame {
 public:
@@ -46,6 +47,11 @@ public:
 	virtual void hide();
 
 	void setParent(QLayout *layout);
+	void setJobs(PreviewJobs *jobs);
+
+protected:
+	/** Decodes the previews in the background. */
+	PreviewJobs *_jobs;
 };
 
 } // End of namespace GUI
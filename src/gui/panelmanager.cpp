@@ -52,6 +52,8 @@ void PanelManager::registerPanel(PanelBase *panel, Aurora::ResourceType type) {
 		panel->setParent(_layout);
 	}
 
+	panel->setJobs(&_jobs);
+
 	_panels.emplace(type, panel);
 }
 
@@ -63,10 +65,17 @@ void PanelManager::setLayout(QLayout *layout) {
 	}
 }
 
+void PanelManager::setLog(const PreviewJobs::LogFunction &log) {
+	_jobs.setLog(log);
+}
+
 void PanelManager::setItem(const ResourceTreeItem *item) {
 	if (!_layout)
 		return;
 
+	// Whatever was still being decoded for the previous item isn't needed anymore
+	_jobs.cancel();
+
 	Aurora::ResourceType type;
 
 	if (!item)
@@ -77,6 +86,10 @@ void PanelManager::setItem(const ResourceTreeItem *item) {
 	showPanel(type, item);
 }
 
+void PanelManager::waitForPreviews() {
+	_jobs.wait();
+}
+
 void PanelManager::showPanel(Aurora::ResourceType type, const ResourceTreeItem *item) {
 	auto result = _panels.find(type);
 	if (result != _panels.end()) {
@@ -30,6 +30,8 @@
 
 #include "src/aurora/types.h"
 
+#include "src/gui/previewjobs.h"
+
 class QLayout;
 
 namespace GUI {
@@ -44,7 +46,10 @@ public:
 
 	void registerPanel(PanelBase *panel, Aurora::ResourceType type);
 	void setLayout(QLayout *layout);
+	void setLog(const PreviewJobs::LogFunction &log);
 	void setItem(const ResourceTreeItem *item);
+	/** Wait for the previews still decoding, before the archives they read from are closed. */
+	void waitForPreviews();
 	PanelBase *getPanelByType(Aurora::ResourceType type);
 
 private:
@@ -54,6 +59,8 @@ private:
 	QLayout *_layout;
 	PanelBase *_currentPanel;
 	std::map<Aurora::ResourceType, PanelBase *> _panels;
+
+	PreviewJobs _jobs;
 };
 
 } // End of namespace GUI
@@ -35,9 +35,16 @@
 
 #include "verdigris/wobjectimpl.h"
 
+#include "src/common/readstream.h"
+#include "src/common/scopedptr.h"
+
 #include "src/gui/panelpreviewimage.h"
+#include "src/gui/previewjobs.h"
 #include "src/gui/resourcetreeitem.h"
 
+#include "src/images/convert.h"
+#include "src/images/loader.h"
+
 // FIXME: Zooming is kind of broken.
 
 namespace GUI {
@@ -139,34 +146,79 @@ static void cleanupImage(void *info) {
 	delete[] image;
 }
 
+/** An image decoded in the background. */
+struct DecodedImage {
+	std::shared_ptr<const Images::Decoder> image;
+	QImage qImage;
+
+	bool decoded; ///< Was the image decoded anew, instead of taken from the cache?
+
+	DecodedImage() : decoded(false) {
+	}
+};
+
 void PanelPreviewImage::loadImage() {
-	Common::ScopedPtr<Images::Decoder> image(_currentItem->getImage());
+	std::shared_ptr<DecodedImage> result = std::make_shared<DecodedImage>();
+
+	// Even an image that was decoded before still needs to be converted
+	result->image = _currentItem->findImage();
+
+	// Like in ResourceTreeItem::getImage(), the data is read around the data cache
+	const ResourceCache::DataReader reader = _currentItem->getDataReader();
+
+	const Aurora::FileType type = _currentItem->getFileType();
+	const ResourceTreeItem *item = _currentItem;
 
-	if ((image->getMipMapCount() == 0) || (image->getLayerCount() == 0))
+	_jobs->start(item->getName(), [result, reader, type]() {
+		if (!result->image) {
+			Common::ScopedPtr<Common::SeekableReadStream> data(reader());
+
+			result->image.reset(Images::loadImage(*data, type));
+			result->decoded = true;
+		}
+
+		result->qImage = convertImage(*result->image);
+
+	}, [this, result, item]() {
+		if (result->decoded)
+			item->addImage(result->image);
+
+		setImage(result->qImage);
+	});
+}
+
+void PanelPreviewImage::setImage(const QImage &image) {
+	if (image.isNull())
 		return;
 
+	_labelDimensions->setText(QString("(%1x%2)").arg(image.width()).arg(image.height()));
+
+	_originalPixmap = QPixmap::fromImage(image);
+	_originalSize = _originalPixmap.size();
+
+	_labelImage->setPixmap(_originalPixmap);
+	_labelImage->adjustSize();
+	_labelImage->setFixedSize(_originalSize);
+}
+
+QImage PanelPreviewImage::convertImage(const Images::Decoder &image) {
+	if ((image.getMipMapCount() == 0) || (image.getLayerCount() == 0))
+		return QImage();
+
 	int32 width = 0, height = 0;
-	getImageDimensions(*image, width, height);
+	getImageDimensions(image, width, height);
 	if ((width <= 0) || (height <= 0))
 		throw Common::Exception("Invalid image dimensions (%d x %d)", width, height);
 
-	_labelDimensions->setText(QString("(%1x%2)").arg(width).arg(height));
-
 	Common::ScopedArray<byte> rgbaData(new byte[width * height * 4]);
 	std::memset(rgbaData.get(), 0, width * height * 4);
 
-	convertImage(*image, rgbaData.get());
+	convertImage(image, rgbaData.get());
 
 	QImage qImage(rgbaData.get(), width, height, QImage::Format_RGBA8888, cleanupImage, rgbaData.get());
 	rgbaData.release();
 
-	_originalPixmap = QPixmap::fromImage(qImage.mirrored());
-	_originalSize = _originalPixmap.size();
-
-	_labelImage->setPixmap(_originalPixmap);
-	_labelImage->adjustSize();
-	_labelImage->setFixedSize(_originalSize);
-
+	return qImage.mirrored();
 }
 
 void PanelPreviewImage::convertImage(const Images::Decoder &image, byte *dataOut) {
@@ -175,74 +227,10 @@ void PanelPreviewImage::convertImage(const Images::Decoder &image, byte *dataOut
 
 	for (size_t i = 0; i < image.getLayerCount(); i++) {
 		const Images::Decoder::MipMap &mipMap = image.getMipMap(0, i);
-		const byte *mipMapData = mipMap.data.get();
-
-		uint32 count = mipMap.width * mipMap.height;
-		while (count-- > 0)
-			writePixel(mipMapData, image.getFormat(), dataOut);
-	}
-}
+		const size_t count = mipMap.width * mipMap.height;
 
-void PanelPreviewImage::writePixel(const byte *&dataIn, Images::PixelFormat format, byte *&dataOut) {
-	switch (format) {
-		case Images::kPixelFormatR8G8B8:
-			*dataOut++ = dataIn[0];
-			*dataOut++ = dataIn[1];
-			*dataOut++ = dataIn[2];
-			*dataOut++ = 0xFF;
-			dataIn    += 3;
-			break;
-
-		case Images::kPixelFormatB8G8R8:
-			*dataOut++ = dataIn[2];
-			*dataOut++ = dataIn[1];
-			*dataOut++ = dataIn[0];
-			*dataOut++ = 0xFF;
-			dataIn    += 3;
-			break;
-
-		case Images::kPixelFormatR8G8B8A8:
-			*dataOut++ = dataIn[0];
-			*dataOut++ = dataIn[1];
-			*dataOut++ = dataIn[2];
-			*dataOut++ = dataIn[3];
-			dataIn    += 4;
-			break;
-
-		case Images::kPixelFormatB8G8R8A8:
-			*dataOut++ = dataIn[2];
-			*dataOut++ = dataIn[1];
-			*dataOut++ = dataIn[0];
-			*dataOut++ = dataIn[3];
-			dataIn    += 4;
-			break;
-
-		case Images::kPixelFormatR5G6B5:
-			{
-				const uint16 color = READ_LE_UINT16(dataIn);
-
-				*dataOut++ =  color & 0x001F;
-				*dataOut++ = (color & 0x07E0) >>  5;
-				*dataOut++ = (color & 0xF800) >> 11;
-				*dataOut++ = 0xFF;
-				dataIn    += 2;
-			}
-			break;
-
-		case Images::kPixelFormatA1R5G5B5:
-			{
-				const uint16 color = READ_LE_UINT16(dataIn);
-
-				*dataOut++ =  color & 0x001F;
-				*dataOut++ = (color & 0x03E0) >>  5;
-				*dataOut++ = (color & 0x7C00) >> 10;
-				*dataOut++ = (color & 0x8000) ? 0xFF : 0x00;
-				dataIn    += 2;
-			}
-			break;
-
-		default:
-			throw Common::Exception("Unsupported pixel format: %d", (int) format);
+		Images::convertToR8G8B8A8(dataOut, mipMap.data.get(), count, image.getFormat());
+		dataOut += count * 4;
 	}
 }
 
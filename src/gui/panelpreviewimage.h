@@ -86,12 +86,14 @@ private:
 
 	Qt::TransformationMode _mode; ///< Linear/nearest.
 
-	/** Opens the image path contained in _currentItem and displays it. */
+	/** Decodes the image contained in _currentItem in the background, then displays it. */
 	void  loadImage();
+	/** Displays a decoded image. */
+	void  setImage(const QImage &image);
 
-	void  convertImage(const Images::Decoder &image, byte *dataOut);
-	void  writePixel(const byte *&dataIn, Images::PixelFormat format, byte *&dataOut);
-	void  getImageDimensions(const Images::Decoder &image, int32 &width, int32 &height);
+	static QImage convertImage(const Images::Decoder &image);
+	static void   convertImage(const Images::Decoder &image, byte *dataOut);
+	static void   getImageDimensions(const Images::Decoder &image, int32 &width, int32 &height);
 	void  getSize(int &fullWidth, int &fullHeight, int &currentWidth, int &currentHeight) const;
 	void  fit(bool onlyWidth, bool grow);
 	float getCurrentZoomLevel() const;
@@ -28,6 +28,7 @@
 #include <QFormLayout>
 #include <QLabel>
 #include <QTableView>
+#include <QThread>
 
 #include "verdigris/wobjectimpl.h"
 
@@ -38,6 +39,7 @@
 #include "src/common/scopedptr.h"
 
 #include "src/gui/panelpreviewtable.h"
+#include "src/gui/previewjobs.h"
 #include "src/gui/resourcetreeitem.h"
 
 namespace GUI {
@@ -77,12 +79,54 @@ void PanelPreviewTable::show(const ResourceTreeItem *item) {
 	}
 }
 
+/** A table read in the background. */
+struct ReadTable {
+	ResourceCache::DataCache::ValuePtr data;
+
+	bool read; ///< Was the data read anew, instead of taken from the cache?
+
+	Common::ScopedPtr<QStandardItemModel> model;
+
+	ReadTable() : read(false) {
+	}
+};
+
 void PanelPreviewTable::setTableData(bool isGDA) {
 	_model->clear();
 
-	Common::ScopedPtr<Aurora::TwoDAFile> twoDA;
+	std::shared_ptr<ReadTable> result = std::make_shared<ReadTable>();
+	result->data = _currentItem->findResourceData();
+
+	const ResourceCache::DataReader reader = _currentItem->getDataReader();
+	const ResourceTreeItem *item = _currentItem;
+
+	QThread *guiThread = thread();
 
-	Common::ScopedPtr<Common::SeekableReadStream> stream(_currentItem->getResourceData());
+	_jobs->start(item->getName(), [result, reader, isGDA, guiThread]() {
+		if (!result->data) {
+			Common::ScopedPtr<Common::SeekableReadStream> stream(reader());
+
+			result->data = ResourceCache::readData(*stream);
+			result->read = true;
+		}
+
+		result->model.reset(createModel(ResourceCache::createDataStream(result->data), isGDA));
+
+		// The model is built in this worker thread, but it's used in the GUI thread
+		result->model->moveToThread(guiThread);
+
+	}, [this, result, item]() {
+		if (result->read)
+			item->addResourceData(result->data);
+
+		_tableView->setModel(result->model.get());
+		_model.reset(result->model.release());
+	});
+}
+
+QStandardItemModel *PanelPreviewTable::createModel(Common::SeekableReadStream *tableStream, bool isGDA) {
+	Common::ScopedPtr<Common::SeekableReadStream> stream(tableStream);
+	Common::ScopedPtr<Aurora::TwoDAFile> twoDA;
 
 	if (isGDA) {
 		Common::ScopedPtr<Aurora::GDAFile> gda(new Aurora::GDAFile(stream.release()));
@@ -91,10 +135,12 @@ void PanelPreviewTable::setTableData(bool isGDA) {
 		twoDA.reset(new Aurora::TwoDAFile(*stream));
 	}
 
+	Common::ScopedPtr<QStandardItemModel> model(new QStandardItemModel(nullptr));
+
 	const std::vector<Common::UString> &headers = twoDA->getHeaders();
 
 	for (size_t i = 0; i < headers.size(); i++) {
-		_model->setHorizontalHeaderItem(i, new QStandardItem(QString(headers[i].c_str())));
+		model->setHorizontalHeaderItem(i, new QStandardItem(QString(headers[i].c_str())));
 	}
 
 	for (size_t i = 0; i < twoDA->getRowCount(); i++) {
@@ -103,8 +149,10 @@ void PanelPreviewTable::setTableData(bool isGDA) {
 			const Common::UString &cellData = twoDA->getRow(i).getString(j);
 			rowData << new QStandardItem(QString(cellData.c_str()));
 		}
-		_model->appendRow(rowData);
+		model->appendRow(rowData);
 	}
+
+	return model.release();
 }
 
 } // End of namespace GUI
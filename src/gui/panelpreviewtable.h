@@ -56,7 +56,10 @@ private:
 	Common::ScopedPtr<QStandardItemModel> _model;
 	QTableView *_tableView;
 
+	/** Reads the table contained in _currentItem in the background, then displays it. */
 	void setTableData(bool isGDA);
+
+	static QStandardItemModel *createModel(Common::SeekableReadStream *stream, bool isGDA);
 };
 
 } // End of namespace GUI
@@ -32,10 +32,13 @@
 
 #include "verdigris/wobjectimpl.h"
 
+#include "src/common/readstream.h"
+#include "src/common/scopedptr.h"
 #include "src/common/encoding.h"
 #include "src/common/system.h"
 
 #include "src/gui/panelpreviewtext.h"
+#include "src/gui/previewjobs.h"
 #include "src/gui/resourcetreeitem.h"
 #include "src/gui/panelbase.h"
 
@@ -78,22 +81,66 @@ void PanelPreviewText::show(const ResourceTreeItem *item) {
 
 	Common::Encoding defaultEncoding = Common::kEncodingCP1252;
 	_encodingBox->setCurrentIndex(defaultEncoding);
-	_textEdit->setText(getEncodedText(defaultEncoding));
+	loadText(defaultEncoding);
 }
 
 void PanelPreviewText::slotEncodingChanged(int index) {
-	_textEdit->setText(getEncodedText(Common::Encoding(index)));
+	loadText(Common::Encoding(index));
 }
 
-QString PanelPreviewText::getEncodedText(Common::Encoding encoding) {
-	Common::ScopedPtr<Common::SeekableReadStream> stream(_currentItem->getResourceData());
-	Common::UString converted;
+/** A text converted in the background. */
+struct ConvertedText {
+	ResourceCache::DataCache::ValuePtr data;
 
-	try {
-		converted = Common::readString(*stream.get(), encoding);
-	} catch (const Common::Exception &e) {
-		emit log("Exception: " + QString(e.what()));
+	bool read; ///< Was the data read anew, instead of taken from the cache?
+
+	QString text;
+	QString error; ///< Why the conversion failed, if it did.
+
+	ConvertedText() : read(false) {
 	}
+};
+
+void PanelPreviewText::loadText(Common::Encoding encoding) {
+	_textEdit->clear();
+
+	std::shared_ptr<ConvertedText> result = std::make_shared<ConvertedText>();
+
+	// Switching the encoding needs the same data again, so we keep it in the cache
+	result->data = _currentItem->findResourceData();
+
+	const ResourceCache::DataReader reader = _currentItem->getDataReader();
+	const ResourceTreeItem *item = _currentItem;
+
+	_jobs->start(item->getName(), [result, reader, encoding]() {
+		try {
+			if (!result->data) {
+				Common::ScopedPtr<Common::SeekableReadStream> stream(reader());
+
+				result->data = ResourceCache::readData(*stream);
+				result->read = true;
+			}
+
+			Common::ScopedPtr<Common::SeekableReadStream> stream(ResourceCache::createDataStream(result->data));
+			result->text = getEncodedText(*stream, encoding);
+
+		} catch (const Common::Exception &e) {
+			result->error = e.what();
+		}
+
+	}, [this, result, item]() {
+		if (result->read)
+			item->addResourceData(result->data);
+
+		if (!result->error.isEmpty())
+			emit log("Exception: " + result->error);
+
+		_textEdit->setText(result->text);
+	});
+}
+
+QString PanelPreviewText::getEncodedText(Common::SeekableReadStream &stream, Common::Encoding encoding) {
+	const Common::UString converted = Common::readString(stream, encoding);
 
 	return QString(converted.c_str());
 }
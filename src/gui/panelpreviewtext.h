@@ -55,7 +55,10 @@ private:
 	const ResourceTreeItem *_currentItem;
 
 	void setText(const QString &text);
-	QString getEncodedText(Common::Encoding encoding);
+
+	/** Converts the text contained in _currentItem in the background, then displays it. */
+	void loadText(Common::Encoding encoding);
+	static QString getEncodedText(Common::SeekableReadStream &stream, Common::Encoding encoding);
 };
 
 } // End of namespace GUI
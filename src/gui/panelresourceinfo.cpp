@@ -56,13 +56,16 @@ PanelResourceInfo::PanelResourceInfo(QWidget *parent) : QFrame(parent) {
 	_labelSize = new QLabel(tr("Size:"), this);
 	_labelFileType = new QLabel(tr("File type:"), this);
 	_labelResType = new QLabel(tr("Resource type:"), this);
+	_labelResolution = new QLabel(tr("Resolution:"), this);
 
 	_labelName->setSizePolicy(QSizePolicy::Ignored, QSizePolicy::Fixed);
+	_labelResolution->setSizePolicy(QSizePolicy::Ignored, QSizePolicy::Fixed);
 
 	layoutLabels->addWidget(_labelName);
 	layoutLabels->addWidget(_labelSize);
 	layoutLabels->addWidget(_labelFileType);
 	layoutLabels->addWidget(_labelResType);
+	layoutLabels->addWidget(_labelResolution);
 
 	layoutButtons->addWidget(_buttonExportRaw);
 	layoutButtons->addWidget(_buttonExportBMUMP3);
@@ -194,11 +197,16 @@ void PanelResourceInfo::setLabels(const ResourceTreeItem *item) {
 	_labelResType->setText(labelResType);
 }
 
+void PanelResourceInfo::setResolution(const QString &resolution) {
+	_labelResolution->setText("Resolution: " + resolution);
+}
+
 void PanelResourceInfo::clearLabels() {
 	_labelName->setText("Resource name:");
 	_labelSize->setText("Size:");
 	_labelFileType->setText("File type:");
 	_labelResType->setText("Resource type:");
+	_labelResolution->setText("Resolution:");
 }
 
 void PanelResourceInfo::setButtonsForClosedDir() {
@@ -43,6 +43,8 @@ public:
 
 	/** Updates the labels which display information about the resource. */
 	void setLabels(const GUI::ResourceTreeItem *item);
+	/** Updates the label showing which copy of the resource wins over the others. */
+	void setResolution(const QString &resolution);
 
 	/** Calls showExportButtons and setLabels. */
 	void update(const GUI::ResourceTreeItem *item);
@@ -89,6 +91,7 @@ private:
 	QLabel *_labelSize;
 	QLabel *_labelFileType;
 	QLabel *_labelResType;
+	QLabel *_labelResolution;
 };
 
 } // End of namespace GUI
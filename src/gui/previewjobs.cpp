@@ -0,0 +1,163 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+/** @file
+ *  Decoding resource previews in the background.
+ */
+
+#include <chrono>
+
+#include <QFutureWatcher>
+#include <QtConcurrentRun>
+
+#include "src/common/error.h"
+
+#include "src/gui/previewjobs.h"
+
+namespace GUI {
+
+/** Two threads, so that the latest preview can decode while a stale one
+ *  still finishes. Decoding can't be interrupted midway. */
+static const int kThreadCount = 2;
+
+struct PreviewJobs::Job {
+	uint32 generation;
+
+	QString name;
+
+	Function decode;
+	Function show;
+
+	bool started; ///< Was the job still current when a worker thread picked it up?
+	bool failed;  ///< Did decoding throw?
+
+	Common::Exception error;
+
+	double milliseconds; ///< How long decoding took.
+
+	Job() : generation(0), started(false), failed(false), milliseconds(0.0) {
+	}
+};
+
+
+PreviewJobs::PreviewJobs() : _generation(0) {
+	_pool.setMaxThreadCount(kThreadCount);
+}
+
+PreviewJobs::~PreviewJobs() {
+	wait();
+
+	// The jobs are done, but their finished signals might still be waiting in the event queue
+	for (Watcher *watcher : _watchers)
+		delete watcher;
+}
+
+void PreviewJobs::setLog(const LogFunction &log) {
+	_log = log;
+}
+
+void PreviewJobs::start(const QString &name, const Function &decode, const Function &show) {
+	std::shared_ptr<Job> job = std::make_shared<Job>();
+
+	job->generation = ++_generation;
+	job->name       = name;
+	job->decode     = decode;
+	job->show       = show;
+
+	Watcher *watcher = new Watcher;
+	_watchers.insert(watcher);
+
+	QObject::connect(watcher, &Watcher::finished, [this, job, watcher]() {
+		finish(job, watcher);
+	});
+
+	watcher->setFuture(QtConcurrent::run(&_pool, [this, job]() {
+		run(*job);
+	}));
+}
+
+void PreviewJobs::cancel() {
+	++_generation;
+}
+
+void PreviewJobs::wait() {
+	cancel();
+
+	_pool.waitForDone();
+}
+
+void PreviewJobs::run(Job &job) {
+	// Don't even bother if the user has already moved on
+	if (job.generation != _generation)
+		return;
+
+	job.started = true;
+
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	try {
+		job.decode();
+	} catch (Common::Exception &e) {
+		job.error  = e;
+		job.failed = true;
+	} catch (std::exception &e) {
+		job.error  = Common::Exception(e);
+		job.failed = true;
+	}
+
+	job.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void PreviewJobs::finish(const std::shared_ptr<Job> &job, Watcher *watcher) {
+	_watchers.erase(watcher);
+	watcher->deleteLater();
+
+	// Let go of the decoded data here, and not in whichever thread drops the job last
+	const Function show = job->show;
+
+	job->decode = Function();
+	job->show   = Function();
+
+	if (!job->started)
+		return;
+
+	const bool stale = job->generation != _generation;
+
+	if (_log) {
+		QString text = QObject::tr("Decoded preview of \"%1\" in %2 ms").arg(job->name).arg(job->milliseconds, 0, 'f', 1);
+		if (stale)
+			text += QObject::tr(" (discarded)");
+
+		_log(text);
+	}
+
+	if (stale)
+		return;
+
+	if (job->failed) {
+		job->error.add("Failed to decode preview of \"%s\"", job->name.toStdString().c_str());
+		Common::printException(job->error, "WARNING: ");
+
+		return;
+	}
+
+	show();
+}
+
+} // End of namespace GUI
@@ -0,0 +1,105 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+/** @file
+ *  Decoding resource previews in the background.
+ */
+
+#ifndef GUI_PREVIEWJOBS_H
+#define GUI_PREVIEWJOBS_H
+
+#include "src/common/atomic.h"
+
+#include <set>
+#include <memory>
+#include <functional>
+
+#include <boost/noncopyable.hpp>
+
+#include <QString>
+#include <QThreadPool>
+
+#include "src/common/types.h"
+
+template<typename T> class QFutureWatcher;
+
+namespace GUI {
+
+/** Decodes resource previews in worker threads, so that the GUI stays responsive.
+ *
+ *  Only the preview of the latest selected resource matters. Starting a job
+ *  makes all earlier ones stale: if they haven't started yet, they're skipped,
+ *  and if they're already decoding, their results are thrown away.
+ *
+ *  The time each preview took to decode is written to the log.
+ */
+class PreviewJobs : boost::noncopyable {
+public:
+	typedef std::function<void()> Function;
+	typedef std::function<void(const QString &)> LogFunction;
+
+	PreviewJobs();
+	~PreviewJobs();
+
+	/** Set the function to write the decoding times to. */
+	void setLog(const LogFunction &log);
+
+	/** Start decoding a preview, making all earlier jobs stale.
+	 *
+	 *  @param name   The name of the previewed resource, for the log.
+	 *  @param decode Decodes the preview. Runs in a worker thread, so it mustn't
+	 *                touch any widgets or resource tree items.
+	 *  @param show   Shows the decoded preview. Runs in the GUI thread, and only
+	 *                if the job didn't go stale and decoding succeeded.
+	 */
+	void start(const QString &name, const Function &decode, const Function &show);
+
+	/** Make all jobs stale. */
+	void cancel();
+	/** Make all jobs stale, and wait for the ones still decoding to finish.
+	 *
+	 *  Jobs read their resource's data themselves, so this needs to be
+	 *  called before the archives they might read from are closed.
+	 */
+	void wait();
+
+private:
+	struct Job;
+
+	typedef QFutureWatcher<void> Watcher;
+
+	QThreadPool _pool;
+
+	/** The generation of the latest job. All jobs of older generations are stale. */
+	boost::atomic<uint32> _generation;
+
+	/** Watching the jobs that haven't finished yet. */
+	std::set<Watcher *> _watchers;
+
+	LogFunction _log;
+
+	/** Run a job in a worker thread. */
+	void run(Job &job);
+	/** Show or discard the results of a finished job. */
+	void finish(const std::shared_ptr<Job> &job, Watcher *watcher);
+};
+
+} // End of namespace GUI
+
+#endif // GUI_PREVIEWJOBS_H
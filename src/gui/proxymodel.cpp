@@ -35,11 +35,15 @@ namespace GUI {
 W_OBJECT_IMPL(ProxyModel)
 
 bool ProxyModel::lessThan(const QModelIndex &left, const QModelIndex &right) const {
-	ResourceTree *model = qobject_cast<ResourceTree *>(sourceModel());
+	ResourceTree *model = static_cast<ResourceTree *>(sourceModel());
 
 	ResourceTreeItem *itemLeft = model->itemFromIndex(left);
 	ResourceTreeItem *itemRight = model->itemFromIndex(right);
 
+	// Archive members are added to the tree already sorted by name
+	if ((itemLeft->getSource() == kSourceArchiveFile) && (itemRight->getSource() == kSourceArchiveFile))
+		return left.row() < right.row();
+
 	bool compare = QString::compare(itemLeft->getName(), itemRight->getName(), Qt::CaseInsensitive) < 0;
 
 	bool leftDir = itemLeft->isDir();
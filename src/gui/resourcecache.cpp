@@ -0,0 +1,160 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A cache of resource data and decoded images, shared by all preview panels.
+ */
+
+#include <boost/functional/hash.hpp>
+
+#include "src/common/error.h"
+#include "src/common/scopedptr.h"
+#include "src/common/memreadstream.h"
+
+#include "src/images/decoder.h"
+
+#include "src/gui/resourcecache.h"
+
+DECLARE_SINGLETON(GUI::ResourceCache)
+
+namespace GUI {
+
+/** A stream of cached data, keeping the data alive even when it's evicted from the cache. */
+class CachedDataReadStream : public Common::MemoryReadStream {
+public:
+	CachedDataReadStream(const ResourceCache::DataCache::ValuePtr &data) :
+		Common::MemoryReadStream(data->empty() ? 0 : &(*data)[0], data->size()), _data(data) {
+	}
+
+private:
+	ResourceCache::DataCache::ValuePtr _data;
+};
+
+/** Return the number of bytes held by an image. */
+static size_t getImageSize(const Images::Decoder &image) {
+	size_t size = sizeof(image);
+
+	for (size_t layer = 0; layer < image.getLayerCount(); layer++)
+		for (size_t mipMap = 0; mipMap < image.getMipMapCount(); mipMap++)
+			size += image.getMipMap(mipMap, layer).size;
+
+	return size;
+}
+
+
+ResourceCache::Key::Key(const Aurora::Archive &a, uint32 i) : archive(&a), index(i) {
+}
+
+ResourceCache::Key::Key(const Common::UString &p) : archive(0), index(0xFFFFFFFF), path(p) {
+}
+
+bool ResourceCache::Key::operator==(const Key &right) const {
+	return (archive == right.archive) && (index == right.index) && (path == right.path);
+}
+
+size_t ResourceCache::hashKey::operator()(const Key &key) const {
+	size_t seed = Common::hashUStringCaseSensitive()(key.path);
+
+	boost::hash_combine(seed, key.archive);
+	boost::hash_combine(seed, key.index);
+
+	return seed;
+}
+
+
+ResourceCache::ResourceCache() : _data(kDataBudget), _images(kImageBudget) {
+}
+
+ResourceCache::~ResourceCache() {
+}
+
+Common::SeekableReadStream *ResourceCache::getData(const Key &key, const DataReader &reader) {
+	DataCache::ValuePtr data = findData(key);
+	if (data)
+		return createDataStream(data);
+
+	Common::ScopedPtr<Common::SeekableReadStream> stream(reader());
+	if (stream->size() > kMaxDataSize)
+		return stream.release();
+
+	data = readData(*stream);
+
+	addData(key, data);
+
+	return createDataStream(data);
+}
+
+ResourceCache::DataCache::ValuePtr ResourceCache::findData(const Key &key) {
+	return _data.get(key);
+}
+
+void ResourceCache::addData(const Key &key, const DataCache::ValuePtr &data) {
+	if (data->size() > kMaxDataSize)
+		return;
+
+	_data.insert(key, data, data->size());
+}
+
+ResourceCache::DataCache::ValuePtr ResourceCache::readData(Common::SeekableReadStream &stream) {
+	std::shared_ptr<std::vector<byte> > data = std::make_shared<std::vector<byte> >(stream.size());
+	if (!data->empty() && (stream.read(&(*data)[0], data->size()) != data->size()))
+		throw Common::Exception(Common::kReadError);
+
+	return data;
+}
+
+Common::SeekableReadStream *ResourceCache::createDataStream(const DataCache::ValuePtr &data) {
+	return new CachedDataReadStream(data);
+}
+
+std::shared_ptr<const Images::Decoder> ResourceCache::getImage(const Key &key, const ImageDecoder &decoder) {
+	ImageCache::ValuePtr image = _images.get(key);
+	if (image)
+		return image;
+
+	image.reset(decoder());
+
+	addImage(key, image);
+
+	return image;
+}
+
+std::shared_ptr<const Images::Decoder> ResourceCache::findImage(const Key &key) {
+	return _images.get(key);
+}
+
+void ResourceCache::addImage(const Key &key, const std::shared_ptr<const Images::Decoder> &image) {
+	_images.insert(key, image, getImageSize(*image));
+}
+
+void ResourceCache::clear() {
+	_data.clear();
+	_images.clear();
+}
+
+const ResourceCache::DataCache &ResourceCache::getDataCache() const {
+	return _data;
+}
+
+const ResourceCache::ImageCache &ResourceCache::getImageCache() const {
+	return _images;
+}
+
+} // End of namespace GUI
@@ -0,0 +1,136 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A cache of resource data and decoded images, shared by all preview panels.
+ */
+
+#ifndef GUI_RESOURCECACHE_H
+#define GUI_RESOURCECACHE_H
+
+#include <vector>
+#include <memory>
+#include <functional>
+
+#include "src/common/types.h"
+#include "src/common/ustring.h"
+#include "src/common/singleton.h"
+#include "src/common/lrucache.h"
+
+namespace Common {
+	class SeekableReadStream;
+}
+
+namespace Aurora {
+	class Archive;
+}
+
+namespace Images {
+	class Decoder;
+}
+
+namespace GUI {
+
+/** A cache of resource data and decoded images, shared by all preview panels.
+ *
+ *  Selecting a resource again, switching the encoding of a text preview, or
+ *  measuring a sound's duration and then playing it all need the same data.
+ *  The cache keeps the most recently used resource data, already unpacked,
+ *  and the most recently decoded images, each within a budget of bytes.
+ *
+ *  The resources of archives are identified by the archive's address, so
+ *  the cache needs to be cleared when archives are closed.
+ */
+class ResourceCache : public Common::Singleton<ResourceCache> {
+public:
+	/** Identifies a resource: an index within an archive, or the path of a plain file. */
+	struct Key {
+		const Aurora::Archive *archive; ///< The archive containing the resource, 0 for a plain file.
+		uint32 index;                   ///< The index of the resource within the archive.
+
+		Common::UString path; ///< The path of a plain file.
+
+		Key(const Aurora::Archive &a, uint32 i);
+		Key(const Common::UString &p);
+
+		bool operator==(const Key &right) const;
+	};
+
+	struct hashKey {
+		size_t operator()(const Key &key) const;
+	};
+
+	typedef Common::LRUCache<Key, std::vector<byte>, hashKey> DataCache;
+	typedef Common::LRUCache<Key, Images::Decoder  , hashKey> ImageCache;
+
+	/** Read a resource's data. */
+	typedef std::function<Common::SeekableReadStream *()> DataReader;
+	/** Decode a resource's image. */
+	typedef std::function<Images::Decoder *()> ImageDecoder;
+
+	static const size_t kDataBudget  =  64 * 1024 * 1024;
+	static const size_t kImageBudget = 128 * 1024 * 1024;
+
+	/** Resources bigger than this are read anew every time, and don't push everything else out. */
+	static const size_t kMaxDataSize = kDataBudget / 4;
+
+	ResourceCache();
+	~ResourceCache();
+
+	/** Return a stream of a resource's data, reading it with the reader if it isn't cached. */
+	Common::SeekableReadStream *getData(const Key &key, const DataReader &reader);
+
+	/** Return a resource's data if it is cached, or an empty pointer if it isn't. */
+	DataCache::ValuePtr findData(const Key &key);
+	/** Add a resource's data that was read elsewhere. Data that's too big is ignored. */
+	void addData(const Key &key, const DataCache::ValuePtr &data);
+
+	/** Read all of a stream's data, in a form that can be added to the cache. Safe in any thread. */
+	static DataCache::ValuePtr readData(Common::SeekableReadStream &stream);
+	/** Return a stream of this data, keeping it alive as long as the stream exists. */
+	static Common::SeekableReadStream *createDataStream(const DataCache::ValuePtr &data);
+
+	/** Return a resource's image, decoding it with the decoder if it isn't cached. */
+	std::shared_ptr<const Images::Decoder> getImage(const Key &key, const ImageDecoder &decoder);
+
+	/** Return a resource's image if it is cached, or an empty pointer if it isn't. */
+	std::shared_ptr<const Images::Decoder> findImage(const Key &key);
+	/** Add a resource's image that was decoded elsewhere. */
+	void addImage(const Key &key, const std::shared_ptr<const Images::Decoder> &image);
+
+	/** Remove all cached data and images. */
+	void clear();
+
+	/** Return the cache of resource data, for its statistics. */
+	const DataCache &getDataCache() const;
+	/** Return the cache of decoded images, for its statistics. */
+	const ImageCache &getImageCache() const;
+
+private:
+	DataCache  _data;
+	ImageCache _images;
+};
+
+} // End of namespace GUI
+
+/** Shortcut for accessing the resource cache. */
+#define ResCache ::GUI::ResourceCache::instance()
+
+#endif // GUI_RESOURCECACHE_H
@@ -22,11 +22,15 @@
  *  Phaethon's tree of game resource files.
  */
 
+#include <algorithm>
+#include <iterator>
+
 #include <QDir>
-#include <QFuture>
+#include <QTimer>
 #include <QFutureWatcher>
-#include <QtConcurrentRun>
+#include <QtConcurrentMap>
 #include <QFileInfo>
+#include <QStringList>
 #include <QModelIndex>
 #include <QVariant>
 
@@ -38,18 +42,23 @@
 #include "src/aurora/bzffile.h"
 #include "src/aurora/erffile.h"
 #include "src/aurora/keyfile.h"
+#include "src/aurora/keydatafilecache.h"
 #include "src/aurora/rimfile.h"
 #include "src/aurora/zipfile.h"
 #include "src/aurora/herffile.h"
 #include "src/aurora/ndsrom.h"
+#include "src/aurora/cachedarchive.h"
+#include "src/aurora/util.h"
 
 #include "src/common/filepath.h"
 #include "src/common/readfile.h"
+#include "src/common/memreadstream.h"
 #include "src/common/system.h"
 
 #include "src/gui/mainwindow.h"
 #include "src/gui/resourcetree.h"
 #include "src/gui/resourcetreeitem.h"
+#include "src/gui/resourcecache.h"
 
 #define USTR(x) (Common::UString((x).toStdString()))
 
@@ -57,39 +66,259 @@ namespace GUI {
 
 W_OBJECT_IMPL(ResourceTree)
 
+/** Compressed nested archives up to this size are decompressed into memory. Bigger ones go into a temporary file. */
+static const size_t kNestedArchiveMemorySize = 64 * 1024 * 1024;
+
+/** Open an archive found within another archive.
+ *
+ *  Archives stored uncompressed are read straight out of their parent archive,
+ *  without copying. Compressed archives need to be decompressed once, since
+ *  parsing them seeks all over the place.
+ */
+static Common::SeekableReadStream *openNestedArchive(ResourceTreeItem &item) {
+	const Archive &archive = item.getArchive();
+	if (!archive.owner)
+		throw Common::Exception("No archive opened");
+
+	Common::ScopedPtr<Common::SeekableReadStream> stream(archive.owner->getResource(archive.index, true));
+
+	// A substream of (or a memory view into) the parent, or data already decompressed into memory
+	if (dynamic_cast<Common::SeekableSubReadStream *>(stream.get()) ||
+	    dynamic_cast<Common::MemoryReadStream *>(stream.get()))
+		return stream.release();
+
+	if (stream->size() <= kNestedArchiveMemorySize)
+		return stream->readStream(stream->size());
+
+	Common::ScopedPtr<Common::ReadFile> file(new Common::ReadFile);
+	file->openTemporary(*stream);
+
+	return file.release();
+}
+
+/** Create the archive for an archive file of this type, taking over the stream. */
+static Aurora::Archive *createArchive(Aurora::FileType type, Common::SeekableReadStream *archiveStream,
+                                      const Common::UString &path) {
+
+	Common::ScopedPtr<Common::SeekableReadStream> stream(archiveStream);
+
+	switch (type) {
+		case Aurora::kFileTypeZIP:
+			return new Aurora::ZIPFile(stream.release());
+
+		case Aurora::kFileTypeERF:
+		case Aurora::kFileTypeMOD:
+		case Aurora::kFileTypeNWM:
+		case Aurora::kFileTypeSAV:
+		case Aurora::kFileTypeHAK:
+			return new Aurora::ERFFile(stream.release());
+
+		case Aurora::kFileTypeRIM: {
+			const bool isERF = Aurora::ERFFile::isERFID(stream->readUint32BE());
+			stream->seek(0);
+
+			if (isERF)
+				return new Aurora::ERFFile(stream.release());
+
+			return new Aurora::RIMFile(stream.release());
+		}
+
+		case Aurora::kFileTypeKEY:
+			return new Aurora::KEYFile(stream.release());
+
+		case Aurora::kFileTypeHERF:
+			return new Aurora::HERFFile(stream.release());
+
+		case Aurora::kFileTypeNDS:
+			return new Aurora::NDSFile(stream.release());
+
+		default:
+			break;
+	}
+
+	throw Common::Exception("Invalid archive file \"%s\"", path.c_str());
+}
+
+/** Return the data files of a KEY, which might have been restored from the index cache. */
+static std::vector<Common::UString> getKEYDataFileList(const Aurora::Archive &key) {
+	const Aurora::CachedArchive *cached = dynamic_cast<const Aurora::CachedArchive *>(&key);
+	if (cached)
+		return cached->getDataFileList();
+
+	return static_cast<const Aurora::KEYFile &>(key).getDataFileList();
+}
+
+/** Return the resources of a KEY found in this data file. */
+static const std::vector<const Aurora::Archive::Resource *> &getKEYResourceListForDataFile(const Aurora::Archive &key,
+                                                                                           uint32 dataFileIndex) {
+
+	const Aurora::CachedArchive *cached = dynamic_cast<const Aurora::CachedArchive *>(&key);
+	if (cached)
+		return cached->getResourceListForDataFile(dataFileIndex);
+
+	return static_cast<const Aurora::KEYFile &>(key).getResourceListForDataFile(dataFileIndex);
+}
+
+/** How often the entries found by the directory scanner are moved into the tree, in ms. */
+static const int kPopulateInterval = 10;
+
+/** The number of archive members added to the tree in one go. */
+static const size_t kArchiveMemberChunkSize = 1024;
+
 ResourceTree::ResourceTree(MainWindow *mainWindow, QObject *parent) : QAbstractItemModel(parent),
-	_mainWindow(mainWindow) {
+	_mainWindow(mainWindow), _populateTimer(new QTimer(this)), _memberTimer(new QTimer(this)), _indexedKEYs(false) {
 	_root.reset(new ResourceTreeItem("Filename"));
 	_iconProvider.reset(new QFileIconProvider());
+
+	_keyDataFiles.reset(new Aurora::KEYDataFileCache([this](const Common::UString &file) {
+		return openKEYDataFile(file);
+	}));
+
+	connect(_populateTimer, &QTimer::timeout, this, &ResourceTree::populateStep);
+	connect(_memberTimer, &QTimer::timeout, this, &ResourceTree::fetchMemberStep);
+}
+
+void ResourceTree::populate(const Common::UString &path) {
+	_scanner.reset(new Common::FileTreeScanner);
+	_scanner->scan(path);
+
+	startPopulate();
 }
 
 void ResourceTree::populate(const Common::FileTree::Entry &rootEntry) {
-	ResourceTreeItem *treeRoot = new ResourceTreeItem(rootEntry);
+	_scanner.reset(new Common::FileTreeScanner);
+	_scanner->scan(rootEntry);
+
+	startPopulate();
+}
+
+void ResourceTree::startPopulate() {
+	ResourceTreeItem *treeRoot = new ResourceTreeItem(_names, _scanner->getRoot(), true);
 	_root->addChild(treeRoot);
 
-	connect(_mainWindow->_watcher, &QFutureWatcher<void>::finished, _mainWindow, &MainWindow::openFinish);
-	QFuture<void> future = QtConcurrent::run(this, &ResourceTree::populate, rootEntry, treeRoot);
-	_mainWindow->_watcher->setFuture(future);
+	if (treeRoot->getSource() == kSourceDirectory)
+		_directories.insert(std::make_pair(treeRoot->getPath(), treeRoot));
+
+	_populateTimer->start(kPopulateInterval);
 }
 
-void ResourceTree::populate(const Common::FileTree::Entry &entry, ResourceTreeItem *parent) {
-	for (std::list<Common::FileTree::Entry>::const_iterator childIter = entry.children.begin();
-		 childIter != entry.children.end(); ++childIter) {
+void ResourceTree::populateStep() {
+	std::list<Common::FileTreeScanner::Batch> batches;
+	std::list<Common::Exception> errors;
 
-		ResourceTreeItem *child = new ResourceTreeItem(*childIter);
+	const bool scanning = _scanner->takeBatches(batches, errors);
 
-		if (child->getFileType() == Aurora::kFileTypeKEY) {
-			_keys.push_back(child);
+	for (std::list<Common::Exception>::iterator e = errors.begin(); e != errors.end(); ++e)
+		Common::printException(*e, "WARNING: ");
+
+	while (!batches.empty()) {
+		Common::FileTreeScanner::Batch &batch = batches.front();
+
+		// Insert consecutive pieces of the same directory in one go
+		std::list<Common::FileTreeScanner::Batch>::iterator next = std::next(batches.begin());
+		while ((next != batches.end()) && (next->directory == batch.directory)) {
+			batch.entries.insert(batch.entries.end(), std::make_move_iterator(next->entries.begin()),
+			                     std::make_move_iterator(next->entries.end()));
+
+			next = batches.erase(next);
 		}
 
-		parent->addChild(child);
-		populate(*childIter, child);
+		populateDirectory(QString::fromUtf8(batch.directory.generic_string().c_str()), batch.entries);
+
+		batches.pop_front();
 	}
+
+	if (scanning)
+		return;
+
+	_populateTimer->stop();
+
+	_mainWindow->openFinish();
+}
+
+void ResourceTree::populateDirectory(const QString &directory, const std::vector<Common::FileTree::Entry> &entries) {
+	std::map<QString, ResourceTreeItem *>::const_iterator d = _directories.find(directory);
+	if ((d == _directories.end()) || entries.empty())
+		return;
+
+	ResourceTreeItem *parent = d->second;
+	const bool isOverride = _overrideDirectories.find(directory) != _overrideDirectories.end();
+
+	QList<ResourceTreeItem *> items;
+	std::vector<ResourceTreeItem *> keys;
+	std::vector<Common::UString> overrideFiles;
+
+	for (std::vector<Common::FileTree::Entry>::const_iterator e = entries.begin(); e != entries.end(); ++e) {
+		ResourceTreeItem *child = new ResourceTreeItem(_names, *e);
+		items.push_back(child);
+
+		if (e->isDirectory()) {
+			_directories.insert(std::make_pair(child->getPath(), child));
+
+			if (isOverride || e->name.equalsIgnoreCase("override"))
+				_overrideDirectories.insert(child->getPath());
+
+		} else if (isOverride)
+			overrideFiles.push_back(e->path.generic_string());
+
+		if (child->getFileType() == Aurora::kFileTypeKEY)
+			keys.push_back(child);
+	}
+
+	insertItems(parent->childCount(), items, indexFromItem(parent));
+
+	if (!overrideFiles.empty())
+		indexOverride(overrideFiles);
+
+	for (std::vector<ResourceTreeItem *>::iterator k = keys.begin(); k != keys.end(); ++k) {
+		_keys.push_back(*k);
+
+		// The KEYs have already been indexed, so this late one needs to be added right away
+		if (_indexedKEYs)
+			indexKEY(**k);
+	}
+}
+
+void ResourceTree::getFileTree(Common::FileTree &tree) {
+	if (!_scanner)
+		throw Common::Exception("Resource tree not populated");
+
+	_scanner->getTree(tree);
 }
 
 ResourceTree::~ResourceTree() {
-	_archives.clear();
-	_keyDataFiles.clear();
+	// Stop reading the directory tree and adding archive members
+	_populateTimer->stop();
+	_memberTimer->stop();
+	_scanner.reset();
+
+	// Wait for the archives still being opened, and throw them away
+	if (!_openJobs.empty()) {
+		for (ArchiveOpenJobList::iterator j = _openJobs.begin(); j != _openJobs.end(); ++j) {
+			(*j)->watcher->cancel();
+			(*j)->watcher->waitForFinished();
+		}
+
+		_openJobs.clear();
+		_mainWindow->statusProgressHide();
+	}
+
+	_resMan.clear();
+	_indexedArchives.clear();
+	_indexedArchiveNames.clear();
+
+	// The cached resources are identified by the archives we're about to close
+	ResCache.clear();
+
+	_cachedArchives.clear();
+
+	/* Nested archives might read straight out of their parent archive, so
+	 * they have to go first. Their paths start with their parent's path, so
+	 * they are sorted behind it. */
+	while (!_archives.empty())
+		_archives.erase(--_archives.end());
+
+	_keyDataFiles->clear();
 }
 
 ResourceTreeItem *ResourceTree::itemFromIndex(const QModelIndex &index) const {
@@ -99,6 +328,13 @@ ResourceTreeItem *ResourceTree::itemFromIndex(const QModelIndex &index) const {
 	return static_cast<ResourceTreeItem *>(index.internalPointer());
 }
 
+QModelIndex ResourceTree::indexFromItem(ResourceTreeItem *item) const {
+	if (!item || (item == _root.get()))
+		return QModelIndex();
+
+	return createIndex(item->row(), 0, item);
+}
+
 QModelIndex ResourceTree::index(int row, int col, const QModelIndex &parent) const {
 	ResourceTreeItem *item = itemFromIndex(parent)->childAt(row);
 
@@ -164,7 +400,11 @@ QVariant ResourceTree::headerData(int UNUSED(section), Qt::Orientation orientati
 }
 
 bool ResourceTree::canFetchMore(const QModelIndex &index) const {
-	return itemFromIndex(index)->isArchive();
+	ResourceTreeItem *item = itemFromIndex(index);
+	if (!item->isArchive())
+		return false;
+
+	return !item->getArchive().addedMembers || (_pendingMembers.find(item) != _pendingMembers.end());
 }
 
 void ResourceTree::fetchMore(const QModelIndex &index) {
@@ -172,86 +412,368 @@ void ResourceTree::fetchMore(const QModelIndex &index) {
 		return;
 
 	ResourceTreeItem *item = itemFromIndex(index);
-
-	// We already added the archive members. Nothing to do
-	Archive &archive = item->getArchive();
-	if (archive.addedMembers)
+	if (!item->isArchive())
 		return;
 
-	_mainWindow->statusPush(tr("Loading archive") + item->getName() + "...");
+	if (!item->getArchive().addedMembers) {
+		// Opening the archive might take a while, so this continues once the archive is open
+		if (openArchives(*item))
+			return;
+
+		listArchiveMembers(*item);
+	}
+
+	fetchArchiveMembers(*item, index);
+}
+
+bool ResourceTree::hasChildren(const QModelIndex &index) const {
+	if (!index.isValid())
+		return true;
+
+	if (itemFromIndex(index)->isArchive())
+		return true;
+
+	return itemFromIndex(index)->hasChildren();
+}
+
+ResourceTree::ArchiveMembers::ArchiveMembers() : added(0) {
+}
+
+void ResourceTree::addArchiveMember(std::vector<ArchiveMember> &members, Aurora::Archive &archive,
+                                    const Aurora::Archive::Resource &resource) {
+
+	members.push_back(ArchiveMember());
+
+	ArchiveMember &member = members.back();
+
+	member.archive  = &archive;
+	member.resource = &resource;
+	member.name     = _names.intern(ResourceTreeItem::getResourceName(resource));
+	member.key      = member.name.toCaseFolded();
+}
+
+void ResourceTree::listArchiveMembers(ResourceTreeItem &item) {
+	// Even if this fails, we won't try again
+	Archive &archive = item.getArchive();
+	archive.addedMembers = true;
+
+	_mainWindow->statusPush(tr("Loading archive") + item.getName() + "...");
 	BOOST_SCOPE_EXIT((&_mainWindow)) {
 		_mainWindow->statusPop();
 	} BOOST_SCOPE_EXIT_END
 
-	if (item->getFileType() == Aurora::kFileTypeBIF) {
-		for (ResourceTreeItem *keyItem : _keys) {
-			Aurora::KEYFile *keyFile = static_cast<Aurora::KEYFile *>(getArchive(*keyItem));
-			const auto &dataFiles = keyFile->getDataFileList();
-			for (const Common::UString &dataFile : dataFiles) {
-				if (dataFile.endsWith(USTR(item->getName()))) {
-					archive.data = keyFile;
-					insertItemsFromArchive(archive, *item, index);
-				}
+	std::vector<ArchiveMember> members;
+
+	if (item.getFileType() == Aurora::kFileTypeBIF) {
+		indexKEYs();
+
+		KEYDataFileRefMap::const_iterator refs = _keyDataFileRefs.find(getDataFileKey(USTR(item.getPath())));
+		if (refs == _keyDataFileRefs.end())
+			return;
+
+		for (const KEYDataFileRef &ref : refs->second) {
+			archive.data = ref.key;
+
+			for (auto res : getKEYResourceListForDataFile(*ref.key, ref.index))
+				addArchiveMember(members, *ref.key, *res);
+		}
+
+	} else {
+		// Load the archive, if necessary
+		if (!archive.data) {
+			try {
+				archive.data = getCachedArchive(item);
+			} catch (Common::Exception &e) {
+				// If that fails, print the error and treat this archive as empty
+
+				e.add("Failed to load archive \"%s\"", item.getName().toStdString().c_str());
+				Common::printException(e, "WARNING: ");
+
+				return;
 			}
 		}
+
+		const Aurora::Archive::ResourceList &resources = archive.data->getResources();
+		for (Aurora::Archive::ResourceList::const_iterator r = resources.begin(); r != resources.end(); ++r)
+			addArchiveMember(members, *archive.data, *r);
+	}
+
+	if (members.empty())
 		return;
+
+	/* Sort once by the case-folded names, and add the members in this order.
+	 * The proxy model then sorts archive members by their row alone. */
+	std::stable_sort(members.begin(), members.end(), [](const ArchiveMember &a, const ArchiveMember &b) {
+		return a.key < b.key;
+	});
+
+	_pendingMembers[&item].members.swap(members);
+}
+
+void ResourceTree::fetchArchiveMembers(ResourceTreeItem &item, const QModelIndex &index) {
+	ArchiveMemberMap::iterator p = _pendingMembers.find(&item);
+	if (p == _pendingMembers.end())
+		return;
+
+	ArchiveMembers &pending = p->second;
+
+	const size_t count = std::min(kArchiveMemberChunkSize, pending.members.size() - pending.added);
+
+	QList<ResourceTreeItem *> items;
+	items.reserve(count);
+
+	for (size_t i = pending.added; i < (pending.added + count); i++) {
+		const ArchiveMember &member = pending.members[i];
+
+		items.push_back(new ResourceTreeItem(member.name, member.archive, *member.resource));
 	}
 
-	// Load the archive, if necessary
-	if (!archive.data) {
-		try {
-			archive.data = getArchive(*item);
-		} catch (Common::Exception &e) {
-			// If that fails, print the error and treat this archive as empty
+	pending.added += count;
 
-			e.add("Failed to load archive \"%s\"", item->getName().toStdString().c_str());
-			Common::printException(e, "WARNING: ");
+	insertItems(item.childCount(), items, index);
 
-			return;
-		}
+	if (pending.added >= pending.members.size()) {
+		_pendingMembers.erase(p);
+		return;
 	}
 
-	insertItemsFromArchive(archive, *item, index);
+	// Add the rest while the GUI is idle, so that the user doesn't have to scroll to the end to get them
+	if (!_memberTimer->isActive())
+		_memberTimer->start(0);
+}
 
-	archive.addedMembers = true;
+void ResourceTree::fetchMemberStep() {
+	if (!_pendingMembers.empty()) {
+		ResourceTreeItem *item = _pendingMembers.begin()->first;
+
+		fetchArchiveMembers(*item, indexFromItem(item));
+	}
+
+	if (_pendingMembers.empty())
+		_memberTimer->stop();
 }
 
-bool ResourceTree::hasChildren(const QModelIndex &index) const {
-	if (!index.isValid())
-		return true;
+ResourceTree::ArchiveOpenRequest::ArchiveOpenRequest() : item(nullptr), type(Aurora::kFileTypeNone),
+	archive(nullptr) {
+}
 
-	if (itemFromIndex(index)->isArchive())
-		return true;
+ResourceTree::ArchiveOpenRequest::~ArchiveOpenRequest() {
+	delete archive;
+}
 
-	return itemFromIndex(index)->hasChildren();
+ResourceTree::ArchiveOpenJob::ArchiveOpenJob(size_t count) : requests(count), target(nullptr),
+	watcher(nullptr), cancelled(false) {
 }
 
-void ResourceTree::insertItemsFromArchive(Archive &archive, const ResourceTreeItem &item,
-                                          const QModelIndex &parentIndex) {
-	QList<ResourceTreeItem *> items;
+bool ResourceTree::needsOpening(ResourceTreeItem &item) const {
+	// Archives within archives are read through their parent, which only the GUI thread may do
+	if ((item.getSource() != kSourceFile) || item.getArchive().data)
+		return false;
 
-	if (item.getFileType() == Aurora::kFileTypeBIF) {
-		const QString localArchivePath = item.getParent()->getName() + "/" + item.getName();
-		auto resList = static_cast<Aurora::KEYFile *>(archive.data)->getResourceListForDataFile(localArchivePath.toStdString().c_str());
-		for (auto res : resList) {
-			items.push_back(new ResourceTreeItem(archive.data, localArchivePath, *res));
-		}
-	} else {
-		auto &resources = archive.data->getResources();
-		for (auto r = resources.begin(); r != resources.end(); ++r) {
-			items.push_back(new ResourceTreeItem(archive.data, item.getPath(), *r));
+	const QString path = item.getPath();
+	if (_archives.find(path) != _archives.end())
+		return false;
+
+	// Restoring an archive from the index cache is quick
+	Aurora::IndexCache *indexCache = _mainWindow->getIndexCache();
+	if (indexCache && ((_cachedArchives.find(path) != _cachedArchives.end()) || indexCache->getArchiveTable(USTR(path))))
+		return false;
+
+	return true;
+}
+
+bool ResourceTree::openArchives(ResourceTreeItem &target) {
+	for (ArchiveOpenJobList::const_iterator j = _openJobs.begin(); j != _openJobs.end(); ++j)
+		if (((*j)->target == &target) && !(*j)->cancelled)
+			return true;
+
+	std::vector<ResourceTreeItem *> items;
+
+	if (target.getFileType() == Aurora::kFileTypeBIF) {
+		// The members of a BIF are listed in the KEYs
+		if (!_indexedKEYs)
+			for (ResourceTreeItem *keyItem : _keys)
+				if (needsOpening(*keyItem))
+					items.push_back(keyItem);
+
+	} else if (needsOpening(target))
+		items.push_back(&target);
+
+	if (items.empty())
+		return false;
+
+	ArchiveOpenJob *job = new ArchiveOpenJob(items.size());
+	_openJobs.push_back(job);
+
+	job->target = &target;
+
+	for (size_t i = 0; i < items.size(); i++) {
+		job->requests[i].item = items[i];
+		job->requests[i].path = USTR(items[i]->getPath());
+		job->requests[i].type = items[i]->getFileType();
+	}
+
+	job->watcher = new QFutureWatcher<void>(this);
+
+	connect(job->watcher, &QFutureWatcher<void>::progressValueChanged, this, &ResourceTree::updateOpenProgress);
+	connect(job->watcher, &QFutureWatcher<void>::finished, this, [this, job]() {
+		openArchivesFinished(job);
+	});
+
+	job->watcher->setFuture(QtConcurrent::map(job->requests, &ResourceTree::openArchive));
+
+	updateOpenProgress();
+	return true;
+}
+
+void ResourceTree::openArchive(ArchiveOpenRequest &request) {
+	try {
+		request.archive = createArchive(request.type, Aurora::openArchiveFile(request.path), request.path);
+	} catch (Common::Exception &e) {
+		e.add("Failed to load archive \"%s\"", request.path.c_str());
+
+		request.error = e;
+	} catch (std::exception &e) {
+		Common::Exception se(e);
+
+		se.add("Failed to load archive \"%s\"", request.path.c_str());
+		request.error = se;
+	}
+}
+
+void ResourceTree::openArchivesFinished(ArchiveOpenJob *job) {
+	ArchiveOpenJobList::iterator j = std::find(_openJobs.begin(), _openJobs.end(), job);
+	if (j == _openJobs.end())
+		return;
+
+	job->watcher->deleteLater();
+
+	ResourceTreeItem *target = job->target;
+	bool targetFailed = false;
+
+	if (!job->cancelled) {
+		Aurora::IndexCache *indexCache = _mainWindow->getIndexCache();
+
+		for (ArchiveOpenRequest &request : job->requests) {
+			if (!request.archive) {
+				Common::printException(request.error, "WARNING: ");
+
+				targetFailed = targetFailed || (request.item == target);
+				continue;
+			}
+
+			// Another job might have been quicker
+			if (_archives.find(request.item->getPath()) != _archives.end())
+				continue;
+
+			Aurora::Archive *arch = addArchive(*request.item, request.archive);
+			request.archive = nullptr;
+
+			if (indexCache)
+				indexCache->addArchive(request.path, *arch);
+			indexArchive(*request.item, *arch);
+
+			if (request.item == target)
+				target->getArchive().data = arch;
 		}
 	}
-	archive.addedMembers = true;
 
-	insertItems(0, items, parentIndex);
+	const bool cancelled = job->cancelled;
+
+	_openJobs.erase(j);
+	updateOpenProgress();
+
+	if (cancelled || target->getArchive().addedMembers)
+		return;
+
+	// We already told the user why the archive failed to open, so just treat it as empty
+	if (targetFailed) {
+		target->getArchive().addedMembers = true;
+		return;
+	}
+
+	listArchiveMembers(*target);
+	fetchArchiveMembers(*target, indexFromItem(target));
+}
+
+void ResourceTree::updateOpenProgress() {
+	int value = 0, maximum = 0;
+	for (ArchiveOpenJobList::const_iterator j = _openJobs.begin(); j != _openJobs.end(); ++j) {
+		if ((*j)->cancelled)
+			continue;
+
+		value   += (*j)->watcher->progressValue();
+		maximum += (*j)->requests.size();
+	}
+
+	if (maximum == 0) {
+		_mainWindow->statusProgressHide();
+		return;
+	}
+
+	// The progress of opening a single archive is unknown, so only show that something is happening
+	_mainWindow->statusProgress(value, (maximum > 1) ? maximum : 0, [this]() {
+		cancelOpenArchives();
+	});
+}
+
+void ResourceTree::cancelOpenArchives() {
+	// The archives currently being opened still need to finish, but everything else stops right away
+	for (ArchiveOpenJobList::iterator j = _openJobs.begin(); j != _openJobs.end(); ++j) {
+		(*j)->cancelled = true;
+		(*j)->watcher->cancel();
+	}
+
+	_mainWindow->statusProgressHide();
+}
+
+QString ResourceTree::getDataFileKey(const Common::UString &path) {
+	// KEYs were made for case-insensitive filesystems, so their data file names might not match in case
+	return QString::fromUtf8(Common::FilePath::normalize(path).c_str()).toLower();
+}
+
+void ResourceTree::indexKEYs() {
+	if (_indexedKEYs)
+		return;
+
+	_indexedKEYs = true;
+
+	for (ResourceTreeItem *keyItem : _keys)
+		indexKEY(*keyItem);
+}
+
+void ResourceTree::indexKEY(ResourceTreeItem &keyItem) {
+	const Common::UString rootPath = USTR(_root->childAt(0)->getPath());
+
+	Aurora::Archive *key = 0;
+	try {
+		key = getCachedArchive(keyItem);
+	} catch (Common::Exception &e) {
+		e.add("Failed to load KEY \"%s\"", keyItem.getName().toStdString().c_str());
+		Common::printException(e, "WARNING: ");
+
+		return;
+	}
+
+	const std::vector<Common::UString> dataFiles = getKEYDataFileList(*key);
+	for (size_t i = 0; i < dataFiles.size(); i++) {
+		KEYDataFileRef ref;
+		ref.key   = key;
+		ref.index = i;
+
+		_keyDataFileRefs[getDataFileKey(rootPath + "/" + dataFiles[i])].push_back(ref);
+	}
 }
 
 void ResourceTree::insertItems(size_t position, QList<ResourceTreeItem*> &items, const QModelIndex &parent) {
+	if (items.empty())
+		return;
+
 	ResourceTreeItem *parentItem = itemFromIndex(parent);
 
 	beginInsertRows(parent, position, position + items.size() - 1);
 
+	parentItem->reserveChildren(items.size());
 	for (const auto &item : items)
 	{
 		parentItem->addChild(item);
@@ -265,102 +787,155 @@ Aurora::Archive *ResourceTree::getArchive(ResourceTreeItem &item) {
 	if (a != _archives.end())
 		return a->second;
 
-	Common::ScopedPtr<Common::SeekableReadStream> stream(item.getResourceData());
+	Common::ScopedPtr<Common::SeekableReadStream> stream;
+	if (item.getSource() == kSourceFile)
+		stream.reset(Aurora::openArchiveFile(USTR(item.getPath())));
+	else
+		stream.reset(openNestedArchive(item));
 
-	Aurora::Archive *arch = nullptr;
-	switch (item.getFileType()) {
-		case Aurora::kFileTypeZIP:
-			arch = new Aurora::ZIPFile(stream.release());
-			break;
+	return addArchive(item, createArchive(item.getFileType(), stream.release(), USTR(item.getPath())));
+}
 
-		case Aurora::kFileTypeERF:
-		case Aurora::kFileTypeMOD:
-		case Aurora::kFileTypeNWM:
-		case Aurora::kFileTypeSAV:
-		case Aurora::kFileTypeHAK:
-			arch = new Aurora::ERFFile(stream.release());
-			break;
+Aurora::Archive *ResourceTree::addArchive(ResourceTreeItem &item, Aurora::Archive *arch) {
+	if (item.getFileType() == Aurora::kFileTypeKEY)
+		static_cast<Aurora::KEYFile *>(arch)->setDataFileCache(_keyDataFiles.get());
 
-		case Aurora::kFileTypeRIM: {
-			const bool isERF = Aurora::ERFFile::isERFID(stream->readUint32BE());
-			stream->seek(0);
+	_archives.insert(std::make_pair(item.getPath(), arch));
+	return arch;
+}
 
-			if (isERF)
-				arch = new Aurora::ERFFile(stream.release());
-			else
-				arch = new Aurora::RIMFile(stream.release());
-			break;
-		}
+Aurora::Archive *ResourceTree::getCachedArchive(ResourceTreeItem &item) {
+	// Only archive files directly on disk can be found in the index cache
+	Aurora::IndexCache *indexCache = _mainWindow->getIndexCache();
+	if (!indexCache || (item.getSource() != kSourceFile)) {
+		Aurora::Archive *arch = getArchive(item);
+		indexArchive(item, *arch);
 
-		case Aurora::kFileTypeKEY: {
-			Aurora::KEYFile *key = new Aurora::KEYFile(stream.release());
-			loadKEYDataFiles(*key);
+		return arch;
+	}
 
-			arch = key;
-			break;
-		}
+	ArchiveMap::iterator c = _cachedArchives.find(item.getPath());
+	if (c != _cachedArchives.end())
+		return c->second;
 
-		case Aurora::kFileTypeHERF:
-			arch = new Aurora::HERFFile(stream.release());
-			break;
+	const Common::UString path = USTR(item.getPath());
 
-		case Aurora::kFileTypeNDS:
-			arch = new Aurora::NDSFile(stream.release());
-			break;
+	const Aurora::IndexCache::ArchiveTable *table = indexCache->getArchiveTable(path);
+	if (!table) {
+		// Not cached yet (or outdated), so parse the archive now and remember its resource table
+		Aurora::Archive *arch = getArchive(item);
+		indexCache->addArchive(path, *arch);
+		indexArchive(item, *arch);
 
-		default:
-			throw Common::Exception("Invalid archive file \"%s\"", item.getPath().toStdString().c_str());
+		return arch;
 	}
 
-	_archives.insert(std::make_pair(item.getPath(), arch));
+	ResourceTreeItem *archiveItem = &item;
+	Aurora::Archive *arch = new Aurora::CachedArchive(*table, [this, archiveItem]() {
+		return getArchive(*archiveItem);
+	});
+
+	_cachedArchives.insert(std::make_pair(item.getPath(), arch));
+	indexArchive(item, *arch);
+
 	return arch;
 }
 
-Aurora::KEYDataFile *ResourceTree::getKEYDataFile(const QString &file) {
-	KEYDataFileMap::iterator d = _keyDataFiles.find(file);
-	if (d != _keyDataFiles.end())
-		return d->second;
+QString ResourceTree::getResolution(ResourceTreeItem &item) const {
+	const Aurora::Archive *archive = 0;
+	uint32 index = 0xFFFFFFFF;
+	Common::UString path;
+
+	if (item.getSource() == kSourceArchiveFile) {
+		archive = item.getArchive().owner;
+		index   = item.getArchive().index;
+	} else if (item.getSource() == kSourceFile)
+		path = Common::FilePath::normalize(USTR(item.getPath()), false);
+	else
+		return "-";
+
+	const Common::UString name = Common::FilePath::getStem(USTR(item.getName()));
+
+	const Aurora::ResourceManager::ResourceList copies = _resMan.findAllResources(name, item.getFileType());
+
+	size_t position = copies.size();
+	for (size_t i = 0; i < copies.size(); i++) {
+		if (archive ? ((copies[i].archive == archive) && (copies[i].index == index)) :
+		              (!copies[i].archive && (Common::FilePath::normalize(copies[i].path, false) == path))) {
+			position = i;
+			break;
+		}
+	}
+
+	// Nested archives and files outside of override directories don't take part in the resolution
+	if (position == copies.size())
+		return "-";
+
+	if (position > 0)
+		return tr("Shadowed by %1").arg(getSourceName(copies[0]));
+
+	if (copies.size() == 1)
+		return tr("Only copy");
+
+	QStringList shadowed;
+	for (size_t i = 1; i < copies.size(); i++)
+		shadowed << getSourceName(copies[i]);
+
+	return tr("Wins over %1").arg(shadowed.join(", "));
+}
+
+QString ResourceTree::getSourceName(const Aurora::ResourceManager::Resource &copy) const {
+	if (!copy.archive)
+		return QString::fromUtf8(Common::FilePath::getFile(copy.path).c_str());
+
+	std::map<const Aurora::Archive *, QString>::const_iterator a = _indexedArchiveNames.find(copy.archive);
+	if (a == _indexedArchiveNames.end())
+		return "?";
+
+	return a->second;
+}
+
+void ResourceTree::indexArchive(const ResourceTreeItem &item, const Aurora::Archive &archive) {
+	// Archives nested within other archives don't take part in the resource resolution
+	if (item.getSource() != kSourceFile)
+		return;
+
+	if (!_indexedArchives.insert(item.getPath()).second)
+		return;
+
+	_indexedArchiveNames[&archive] = item.getName();
 
-	Common::UString path = Common::FilePath::normalize(USTR(_root->childAt(0)->getPath() + "/" + file));
+	_resMan.addArchive(archive, Aurora::ResourceManager::getArchivePriority(item.getFileType()));
+}
+
+void ResourceTree::indexOverride(const std::vector<Common::UString> &files) {
+	_resMan.addFiles(files, Aurora::kPriorityOverride);
+}
+
+Aurora::KEYDataFile *ResourceTree::openKEYDataFile(const Common::UString &file) {
+	const Common::UString fullPath = USTR(_root->childAt(0)->getPath()) + "/" + file;
+
+	Common::UString path = Common::FilePath::normalize(fullPath);
 	if (path.empty())
-		throw Common::Exception("No such file or directory \"%s\"", (_root->getPath() + "/" + file).toStdString().c_str());
+		throw Common::Exception("No such file or directory \"%s\"", fullPath.c_str());
 
-	Aurora::FileType type = TypeMan.getFileType(file.toStdString().c_str());
+	Aurora::FileType type = TypeMan.getFileType(file);
 
 	Aurora::KEYDataFile *dataFile = 0;
 	switch (type) {
 		case Aurora::kFileTypeBIF:
-			dataFile = new Aurora::BIFFile(new Common::ReadFile(path));
+			dataFile = new Aurora::BIFFile(Aurora::openArchiveFile(path));
 			break;
 
 		case Aurora::kFileTypeBZF:
-			dataFile = new Aurora::BZFFile(new Common::ReadFile(path));
+			dataFile = new Aurora::BZFFile(Aurora::openArchiveFile(path));
 			break;
 
 		default:
 			throw Common::Exception("Unknown KEY data file type %d\n", type);
 	}
 
-	_keyDataFiles.insert(std::make_pair(file, dataFile));
 	return dataFile;
 }
 
-void ResourceTree::loadKEYDataFiles(Aurora::KEYFile &key) {
-	const std::vector<Common::UString> dataFiles = key.getDataFileList();
-	for (size_t i = 0; i < dataFiles.size(); i++) {
-		try {
-			_mainWindow->statusPush(tr("Loading data file") + QString::fromUtf8(dataFiles[i].c_str()) + "...");
-
-			Aurora::KEYDataFile *dataFile = getKEYDataFile(QString::fromUtf8(dataFiles[i].c_str()));
-			key.addDataFile(i, dataFile);
-
-			_mainWindow->statusPop();
-		} catch (Common::Exception &e) {
-			e.add("Failed to load KEY data file \"%s\"", dataFiles[i].c_str());
-			_mainWindow->statusPop();
-			Common::printException(e, "WARNING: ");
-		}
-	}
-}
-
 } // End of namespace GUI
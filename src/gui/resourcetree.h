@@ -25,6 +25,9 @@
 #ifndef GUI_RESOURCETREE_H
 #define GUI_RESOURCETREE_H
 
+#include <set>
+#include <map>
+
 #include <QAbstractItemModel>
 #include <QFileIconProvider>
 
@@ -32,12 +35,22 @@
 
 #include "src/aurora/archive.h"
 #include "src/aurora/util.h"
+#include "src/aurora/resman.h"
 
 #include "src/common/filetree.h"
+#include "src/common/filetreescanner.h"
 #include "src/common/ptrmap.h"
+#include "src/common/ptrlist.h"
+#include "src/common/error.h"
 
 #include "src/images/decoder.h"
 
+#include "src/gui/resourcetreeitem.h"
+
+class QTimer;
+
+template<typename T> class QFutureWatcher;
+
 namespace Common {
 	class SeekableReadStream;
 }
@@ -53,6 +66,7 @@ namespace Images {
 namespace Aurora {
 	class KEYFile;
 	class KEYDataFile;
+	class KEYDataFileCache;
 }
 
 namespace GUI {
@@ -68,15 +82,26 @@ public:
 	ResourceTree(MainWindow *mainWindow, QObject *parent = 0);
 	~ResourceTree();
 
+	/** Start filling the tree with the contents of this path, read in the background. */
+	void populate(const Common::UString &path);
+	/** Start filling the tree with an already read directory tree.
+	 *
+	 *  The directory tree has to stay unchanged until the tree is populated.
+	 */
 	void populate(const Common::FileTree::Entry &rootEntry);
-	void populate(const Common::FileTree::Entry &rootEntry, ResourceTreeItem *parent);
 
-	void insertItemsFromArchive(Archive &archive, const ResourceTreeItem &item, const QModelIndex &parentIndex);
+	/** Move the directory tree read by populate(path) into this FileTree, once populated. */
+	void getFileTree(Common::FileTree &tree);
+
 	void insertItems(size_t position, QList<ResourceTreeItem *> &items, const QModelIndex &parentIndex);
 
 	Aurora::Archive     *getArchive(ResourceTreeItem &item);
-	Aurora::KEYDataFile *getKEYDataFile(const QString &file);
-	void                loadKEYDataFiles(Aurora::KEYFile &key);
+	Aurora::Archive     *getCachedArchive(ResourceTreeItem &item);
+	Aurora::KEYDataFile *openKEYDataFile(const Common::UString &file);
+
+	/** Describe which copy of this resource wins over the other copies in the
+	 *  opened archives and override directories, and which ones it shadows. */
+	QString getResolution(ResourceTreeItem &item) const;
 
 	/** Return the item in the tree structure that corresponds to the given index. */
 	ResourceTreeItem *itemFromIndex(const QModelIndex &index) const;
@@ -95,7 +120,7 @@ public:
 	/** Return the header data. */
 	QVariant headerData(int section, Qt::Orientation orientation, int role) const;
 
-	/** Define what file types should have an expand arrow in the tree. */
+	/** Return whether the archive at index still has members that aren't in the tree yet. */
 	bool canFetchMore(const QModelIndex &index) const;
 
 	/** Return whether the item for index actually has children. */
@@ -107,21 +132,167 @@ public:
 	/** Return row count -- how many children the given index has. */
 	int rowCount(const QModelIndex &parent = QModelIndex()) const override;
 
-	/** Add children to the given index. */
+	/** Add the next chunk of archive members to the archive at index, opening it if necessary. */
 	void fetchMore(const QModelIndex &index);
 
 private:
 	Common::ScopedPtr<ResourceTreeItem> _root;
 	MainWindow *_mainWindow;
 
+	/** The names of all items, shared among items with the same name. */
+	NamePool _names;
+
+	/** Reads the directory tree in the background while we populate. */
+	Common::ScopedPtr<Common::FileTreeScanner> _scanner;
+	/** Periodically moves the entries found by the scanner into the tree. */
+	QTimer *_populateTimer;
+
+	/** All directory items added so far, by their generic path (with "/" separators, like ResourceTreeItem::getPath()). */
+	std::map<QString, ResourceTreeItem *> _directories;
+	/** The paths of all override directories and their subdirectories. */
+	std::set<QString> _overrideDirectories;
+
+	/** Start moving the entries found by the scanner into the tree. */
+	void startPopulate();
+	/** Move all entries the scanner found since the last call into the tree. */
+	void populateStep();
+	/** Insert the entries of one directory as children of its item. */
+	void populateDirectory(const QString &directory, const std::vector<Common::FileTree::Entry> &entries);
+
+	/** Return the model index of an item. */
+	QModelIndex indexFromItem(ResourceTreeItem *item) const;
+
+	/** An archive member, listed but not yet added to the tree. */
+	struct ArchiveMember {
+		Aurora::Archive *archive;                  ///< The archive containing the member.
+		const Aurora::Archive::Resource *resource; ///< The member within the archive.
+
+		QString name; ///< The name of the member's item, from the name pool.
+		QString key;  ///< The case-folded name, to sort by.
+	};
+
+	/** The members of an archive, sorted by name, and how many of them have been added to the tree. */
+	struct ArchiveMembers {
+		std::vector<ArchiveMember> members;
+		size_t added;
+
+		ArchiveMembers();
+	};
+
+	typedef std::map<ResourceTreeItem *, ArchiveMembers> ArchiveMemberMap;
+
+	/** The members of all opened archives that haven't been completely added to the tree yet. */
+	ArchiveMemberMap _pendingMembers;
+	/** Adds the pending archive members in chunks while the GUI is idle. */
+	QTimer *_memberTimer;
+
+	/** Open an archive and list its members, sorted. */
+	void listArchiveMembers(ResourceTreeItem &item);
+	/** Add the next chunk of an archive's listed members to the tree. */
+	void fetchArchiveMembers(ResourceTreeItem &item, const QModelIndex &index);
+	/** Add the next chunk of members of the first archive with pending members. */
+	void fetchMemberStep();
+
+	void addArchiveMember(std::vector<ArchiveMember> &members, Aurora::Archive &archive,
+	                      const Aurora::Archive::Resource &resource);
+
+	/** An archive file to open in the background. */
+	struct ArchiveOpenRequest : boost::noncopyable {
+		ResourceTreeItem *item; ///< The archive's item. Only ever touched by the GUI thread.
+
+		Common::UString  path; ///< The path of the archive file.
+		Aurora::FileType type; ///< The type of the archive file.
+
+		Aurora::Archive  *archive; ///< The opened archive, owned by the request until it's added.
+		Common::Exception error;   ///< Why the archive couldn't be opened.
+
+		ArchiveOpenRequest();
+		~ArchiveOpenRequest();
+	};
+
+	/** Archive files opened together in the background, on the global thread pool. */
+	struct ArchiveOpenJob : boost::noncopyable {
+		std::vector<ArchiveOpenRequest> requests;
+
+		/** The archive whose members are listed once all requests are done. */
+		ResourceTreeItem *target;
+		/** Watches the worker threads. */
+		QFutureWatcher<void> *watcher;
+		/** Has the user cancelled the job? Only touched by the GUI thread. */
+		bool cancelled;
+
+		ArchiveOpenJob(size_t count);
+	};
+
+	typedef Common::PtrList<ArchiveOpenJob> ArchiveOpenJobList;
+
+	/** All archive files currently being opened in the background. */
+	ArchiveOpenJobList _openJobs;
+
+	/** Does this archive still need to be opened from scratch, and can this be done in the background? */
+	bool needsOpening(ResourceTreeItem &item) const;
+	/** Start opening the archives needed to list the members of this archive in the background.
+	 *
+	 *  @return true if the archives are being opened, false if nothing needs to be opened.
+	 */
+	bool openArchives(ResourceTreeItem &target);
+	/** Add the archives of a finished job, and list and add the members of its target. */
+	void openArchivesFinished(ArchiveOpenJob *job);
+	/** Show the progress of all running jobs in the status bar. */
+	void updateOpenProgress();
+	/** Stop opening archives in the background, discarding what's already opened. */
+	void cancelOpenArchives();
+
+	/** Open an archive file. Runs in a worker thread. */
+	static void openArchive(ArchiveOpenRequest &request);
+
+	/** Take over an opened archive and remember it as the archive of this item. */
+	Aurora::Archive *addArchive(ResourceTreeItem &item, Aurora::Archive *arch);
+
 	Common::ScopedPtr<QFileIconProvider> _iconProvider;
 
-	typedef Common::PtrMap<QString, Aurora::Archive>     ArchiveMap;
-	typedef Common::PtrMap<QString, Aurora::KEYDataFile> KEYDataFileMap;
+	typedef Common::PtrMap<QString, Aurora::Archive> ArchiveMap;
 	std::vector<ResourceTreeItem *> _keys;
 
 	ArchiveMap _archives;
-	KEYDataFileMap _keyDataFiles;
+	ArchiveMap _cachedArchives;
+
+	/** The data files of all KEYs, opened on demand. */
+	Common::ScopedPtr<Aurora::KEYDataFileCache> _keyDataFiles;
+
+	/** A data file, as indexed by a KEY. */
+	struct KEYDataFileRef {
+		Aurora::Archive *key; ///< The KEY indexing the data file.
+		uint32 index;         ///< The index into the KEY's data file list.
+	};
+
+	typedef std::map<QString, std::vector<KEYDataFileRef> > KEYDataFileRefMap;
+
+	/** All data files indexed by any of the KEYs, by normalized path. */
+	KEYDataFileRefMap _keyDataFileRefs;
+	bool _indexedKEYs;
+
+	/** Open all KEYs and map the paths of their data files. */
+	void indexKEYs();
+	/** Open a KEY and map the paths of its data files. */
+	void indexKEY(ResourceTreeItem &keyItem);
+
+	Aurora::ResourceManager _resMan;
+	/** The paths of all archives already added to the resource manager. */
+	std::set<QString> _indexedArchives;
+	/** The names of all archives already added to the resource manager, by archive. */
+	std::map<const Aurora::Archive *, QString> _indexedArchiveNames;
+
+	/** Return a name for the source this copy of a resource is in, for display. */
+	QString getSourceName(const Aurora::ResourceManager::Resource &copy) const;
+
+	/** Add an archive file on disk to the resource manager, unless it is already in there. */
+	void indexArchive(const ResourceTreeItem &item, const Aurora::Archive &archive);
+	/** Add these files within an override directory to the resource manager. */
+	void indexOverride(const std::vector<Common::UString> &files);
+
+	/** Return the key of a data file path in the data file map. */
+	static QString getDataFileKey(const Common::UString &path);
 };
 
 } // End of namespace GUI
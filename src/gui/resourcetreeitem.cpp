@@ -23,80 +23,75 @@
  */
 
 #include "src/common/strutil.h"
-#include "src/common/filepath.h"
 #include "src/common/readfile.h"
 
 #include "src/gui/resourcetreeitem.h"
+#include "src/gui/resourcecache.h"
+
+#include "src/images/loader.h"
 
 namespace GUI {
 
-ResourceTreeItem::ResourceTreeItem(const Common::FileTree::Entry &entry) :
-	_parent(nullptr), _name(QString::fromUtf8(entry.name.c_str())),
+QString NamePool::intern(const QString &name) {
+	QSet<QString>::const_iterator n = _names.constFind(name);
+	if (n != _names.constEnd())
+		return *n;
+
+	_names.insert(name);
+	return name;
+}
+
+
+ResourceTreeItem::ResourceTreeItem(NamePool &names, const Common::FileTree::Entry &entry, bool topmost) :
+	_parent(nullptr), _name(names.intern(QString::fromUtf8(entry.name.c_str()))), _row(0),
 	_source(entry.isDirectory() ? kSourceDirectory : kSourceFile) {
 
-	_path = QString::fromUtf8(entry.path.string().c_str());
+	if (topmost)
+		_path = QString::fromUtf8(entry.path.generic_string().c_str());
 
 	_archive.data = nullptr;
 	_archive.owner = nullptr;
 	_archive.addedMembers = false;
 	_archive.index = 0xFFFFFFFF;
 
-	_size = Common::kFileInvalid;
-	if (_source == kSourceFile)
-		_size = Common::FilePath::getFileSize(entry.path.generic_string().c_str());
+	_size = entry.size;
 
 	if (_source == kSourceDirectory)
 		_fileType = Aurora::kFileTypeNone;
 	else
-		_fileType = TypeMan.getFileType(_name.toStdString());
+		_fileType = TypeMan.getFileType(entry.name);
 
 	if (_source == kSourceDirectory)
 		_resourceType = Aurora::kResourceNone;
 	else
-		_resourceType = TypeMan.getResourceType(_name.toStdString());
+		_resourceType = TypeMan.getResourceType(_fileType);
 
 	_triedDuration = getResourceType() != Aurora::kResourceSound;
 	_duration = Sound::RewindableAudioStream::kInvalidLength;
 }
 
-ResourceTreeItem::ResourceTreeItem(Aurora::Archive *archive, const QString &archivePath,
+ResourceTreeItem::ResourceTreeItem(const QString &name, Aurora::Archive *archive,
                                    const Aurora::Archive::Resource &resource) :
-	_parent(nullptr), _name(QString::fromUtf8(TypeMan.setFileType(resource.name, resource.type).c_str())),
-	_source(kSourceArchiveFile) {
-
-	Common::UString resName = resource.name;
-	if (resName.empty())
-		resName = Common::composeString(resource.hash);
-
-	resName = TypeMan.setFileType(resName, resource.type);
-	_name = QString::fromUtf8(resName.c_str());
+	_parent(nullptr), _name(name), _row(0), _source(kSourceArchiveFile) {
 
 	_archive.data = nullptr;
 	_archive.owner = archive;
 	_archive.addedMembers = false;
 	_archive.index = resource.index;
 
-	_path = archivePath + "/" + _name;
+	// Looking up the size might need to open a data file, so only do that when asked
+	_size = -1;
 
-	_size = archive->getResourceSize(resource.index);
-
-	if (_source == kSourceDirectory)
-		_fileType = Aurora::kFileTypeNone;
-	else
-		_fileType = TypeMan.getFileType(_name.toStdString());
-
-	if (_source == kSourceDirectory)
-		_resourceType = Aurora::kResourceNone;
-	else
-		_resourceType = TypeMan.getResourceType(_name.toStdString());
+	_fileType     = TypeMan.getFileType(Common::UString(_name.toStdString()));
+	_resourceType = TypeMan.getResourceType(_fileType);
 
 	_triedDuration = getResourceType() != Aurora::kResourceSound;
 	_duration = Sound::RewindableAudioStream::kInvalidLength;
 }
 
 ResourceTreeItem::ResourceTreeItem(const QString &data) : _parent(nullptr), _name(data), _size(0),
-	_triedDuration(0), _duration(0), _source(kSourceNone),
-	_fileType(Aurora::kFileTypeNone), _resourceType(Aurora::kResourceNone) {
+	_duration(0), _row(0), _fileType(Aurora::kFileTypeNone), _resourceType(Aurora::kResourceNone),
+	_source(kSourceNone), _triedDuration(0) {
 
 	_archive.data = 0;
 	_archive.owner = 0;
@@ -107,8 +102,18 @@ ResourceTreeItem::ResourceTreeItem(const QString &data) : _parent(nullptr), _nam
 ResourceTreeItem::~ResourceTreeItem() {
 }
 
+QString ResourceTreeItem::getResourceName(const Aurora::Archive::Resource &resource) {
+	Common::UString resName = resource.name;
+	if (resName.empty())
+		resName = Common::composeString(resource.hash);
+
+	return QString::fromUtf8(TypeMan.setFileType(resName, resource.type).c_str());
+}
+
 void ResourceTreeItem::addChild(ResourceTreeItem *child) {
-	child->setParent(this);
+	child->_parent = this;
+	child->_row    = _children.size();
+
 	_children.push_back(std::unique_ptr<ResourceTreeItem>(child));
 }
 
@@ -116,11 +121,21 @@ bool ResourceTreeItem::insertChild(size_t position, ResourceTreeItem *child) {
 	if (position >= _children.size())
 		return false;
 
+	child->_parent = this;
+
 	_children.insert(_children.begin() + position, std::unique_ptr<ResourceTreeItem>(child));
 
+	// Everything behind the new child moved down by one
+	for (size_t i = position; i < _children.size(); i++)
+		_children[i]->_row = i;
+
 	return true;
 }
 
+void ResourceTreeItem::reserveChildren(size_t count) {
+	_children.reserve(_children.size() + count);
+}
+
 ResourceTreeItem *ResourceTreeItem::childAt(int row) const {
 	return _children[row].get();
 }
@@ -130,23 +145,13 @@ int ResourceTreeItem::childCount() const {
 }
 
 int ResourceTreeItem::row() const {
-	if (_parent) {
-		for (size_t i = 0; i < _parent->_children.size(); i++) {
-			if (_parent->_children[i].get() == this)
-				return i;
-		}
-	}
-	return 0;
+	return _row;
 }
 
 ResourceTreeItem *ResourceTreeItem::getParent() const {
 	return _parent;
 }
 
-void ResourceTreeItem::setParent(ResourceTreeItem *parent) {
-	_parent = parent;
-}
-
 bool ResourceTreeItem::hasChildren() const {
 	return _children.size();
 }
@@ -159,16 +164,22 @@ bool ResourceTreeItem::isDir() const {
 	return _source == kSourceDirectory;
 }
 
-const QString &ResourceTreeItem::getPath() const {
-	return _path;
+QString ResourceTreeItem::getPath() const {
+	if (!_path.isNull() || !_parent)
+		return _path;
+
+	return _parent->getPath() + "/" + _name;
 }
 
 qint64 ResourceTreeItem::getSize() const {
+	if ((_size < 0) && (_source == kSourceArchiveFile) && _archive.owner)
+		_size = _archive.owner->getResourceSize(_archive.index);
+
 	return _size;
 }
 
 Source ResourceTreeItem::getSource() const {
-	return _source;
+	return (Source) _source;
 }
 
 Aurora::FileType ResourceTreeItem::getFileType() const {
@@ -179,97 +190,104 @@ Aurora::ResourceType ResourceTreeItem::getResourceType() const {
 	return _resourceType;
 }
 
-Common::SeekableReadStream *ResourceTreeItem::getResourceData() const {
-	try {
-		switch (_source) {
-			case kSourceDirectory:
-				throw Common::Exception("Can't get file data of a directory");
+ResourceCache::Key ResourceTreeItem::getCacheKey() const {
+	switch (_source) {
+		case kSourceDirectory:
+			throw Common::Exception("Can't get file data of a directory");
+
+		case kSourceFile:
+			return ResourceCache::Key(Common::UString(getPath().toStdString()));
+
+		case kSourceArchiveFile:
+			if (!_archive.owner)
+				throw Common::Exception("No archive opened");
+
+			return ResourceCache::Key(*_archive.owner, _archive.index);
+
+		default:
+			throw Common::Exception("kSourceArchive is not handled by getResourceData");
+	}
+}
+
+ResourceCache::DataReader ResourceTreeItem::getDataReader() const {
+	switch (_source) {
+		case kSourceFile: {
+			const std::string path = getPath().toStdString();
+
+			return [path]() -> Common::SeekableReadStream * {
+				return new Common::ReadFile(path.c_str());
+			};
+		}
 
-			case kSourceFile:
-				return new Common::ReadFile(_path.toStdString().c_str());
+		case kSourceArchiveFile: {
+			if (!_archive.owner)
+				throw Common::Exception("No archive opened");
 
-			case kSourceArchiveFile:
-				if (!_archive.owner)
-					throw Common::Exception("No archive opened");
+			// Without tryNoCopy, the returned stream doesn't depend on the archive anymore
+			const Aurora::Archive *archive = _archive.owner;
+			const uint32 index = _archive.index;
 
-				return _archive.owner->getResource(_archive.index);
-			default:
-				throw Common::Exception("kSourceArchive is not handled by getResourceData");
+			return [archive, index]() {
+				return archive->getResource(index);
+			};
 		}
+
+		default:
+			break;
+	}
+
+	throw Common::Exception("Can't read data of a directory or an unopened archive");
+}
+
+Common::SeekableReadStream *ResourceTreeItem::readResourceData() const {
+	return getDataReader()();
+}
+
+Common::SeekableReadStream *ResourceTreeItem::getResourceData() const {
+	try {
+		return ResCache.getData(getCacheKey(), [this]() {
+			return readResourceData();
+		});
 	} catch (Common::Exception &e) {
 		e.add("Failed to get resource data for resource \"%s\"", _name.toStdString().c_str());
 		throw;
 	}
-
-	assert(false);
-	return nullptr;
 }
 
-Images::Decoder *ResourceTreeItem::getImage() const {
+std::shared_ptr<const Images::Decoder> ResourceTreeItem::getImage() const {
 	if (getResourceType() != Aurora::kResourceImage)
 		throw Common::Exception("\"%s\" is not an image resource", getName().toStdString().c_str());
 
-	Common::ScopedPtr<Common::SeekableReadStream> res(getResourceData());
-
-	Images::Decoder *img = nullptr;
 	try {
-		img = getImage(*res, _fileType);
+		// The image is cached instead of its data, so the data is read around the data cache
+		return ResCache.getImage(getCacheKey(), [this]() {
+			Common::ScopedPtr<Common::SeekableReadStream> res(readResourceData());
+
+			return Images::loadImage(*res, _fileType);
+		});
 	} catch (Common::Exception &e) {
 		e.add("Failed to get image from \"%s\"", getName().toStdString().c_str());
 		throw;
 	}
-
-	return img;
 }
 
-Images::Decoder *ResourceTreeItem::getImage(Common::SeekableReadStream &res, Aurora::FileType type) const {
-	Images::Decoder *img = nullptr;
-	switch (type) {
-		case Aurora::kFileTypeDDS:
-			img = new Images::DDS(res);
-			break;
-
-		case Aurora::kFileTypeTPC:
-			img = new Images::TPC(res);
-			break;
-
-		// TXB may be actually TPC
-		case Aurora::kFileTypeTXB:
-		case Aurora::kFileTypeTXB2:
-			try {
-				img = new Images::TXB(res);
-			} catch (Common::Exception &e1) {
-
-				try {
-					res.seek(0);
-					img = new Images::TPC(res);
-
-				} catch (Common::Exception &e2) {
-					e1.add(e2);
-
-					throw e1;
-				}
-			}
-			break;
-
-		case Aurora::kFileTypeTGA:
-			img = new Images::TGA(res);
-			break;
+std::shared_ptr<const Images::Decoder> ResourceTreeItem::findImage() const {
+	if (getResourceType() != Aurora::kResourceImage)
+		throw Common::Exception("\"%s\" is not an image resource", getName().toStdString().c_str());
 
-		case Aurora::kFileTypeSBM:
-			img = new Images::SBM(res);
-			break;
+	return ResCache.findImage(getCacheKey());
+}
 
-		case Aurora::kFileTypeCUR:
-		case Aurora::kFileTypeCURS:
-			img = new Images::WinIconImage(res);
-			break;
+ResourceCache::DataCache::ValuePtr ResourceTreeItem::findResourceData() const {
+	return ResCache.findData(getCacheKey());
+}
 
-		default:
-			throw Common::Exception("Unsupported image type %d", type);
-	}
+void ResourceTreeItem::addResourceData(const ResourceCache::DataCache::ValuePtr &data) const {
+	ResCache.addData(getCacheKey(), data);
+}
 
-	return img;
+void ResourceTreeItem::addImage(const std::shared_ptr<const Images::Decoder> &image) const {
+	ResCache.addImage(getCacheKey(), image);
 }
 
 Archive &ResourceTreeItem::getArchive() {
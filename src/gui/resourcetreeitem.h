@@ -25,7 +25,10 @@
 #ifndef GUI_RESOURCETREEITEM_H
 #define GUI_RESOURCETREEITEM_H
 
+#include <memory>
+
 #include <QString>
+#include <QSet>
 
 #include "src/aurora/archive.h"
 #include "src/aurora/util.h"
@@ -42,6 +45,8 @@
 #include "src/sound/sound.h"
 #include "src/sound/audiostream.h"
 
+#include "src/gui/resourcecache.h"
+
 namespace GUI {
 
 enum Source {
@@ -55,28 +60,55 @@ enum Source {
 struct Archive {
 	Aurora::Archive *owner;
 	Aurora::Archive *data;
-	bool   addedMembers;
 	uint32 index;
+	bool   addedMembers;
 };
 
-class ResourceTreeItem {
+/** A pool of item names, so that items with the same name share one copy of it. */
+class NamePool {
 public:
-	/** Filesystem item constructor. */
-	ResourceTreeItem(const Common::FileTree::Entry &entry);
+	/** Return the pooled copy of this name, adding it if necessary. */
+	QString intern(const QString &name);
 
-	/** Archive item constructor */
-	ResourceTreeItem(Aurora::Archive *archive, const QString &archivePath,
-	                 const Aurora::Archive::Resource &resource);
+private:
+	QSet<QString> _names;
+};
+
+/** An item in the resource tree.
+ *
+ *  Items only store their name, relative to their parent. Only the topmost
+ *  item stores its full path, the paths of all others are built on demand.
+ */
+class ResourceTreeItem {
+public:
+	/** Filesystem item constructor.
+	 *
+	 *  @param names   The pool to take the item name from.
+	 *  @param entry   The file or directory this item represents.
+	 *  @param topmost Is this the topmost item, the one all other paths are relative to?
+	 */
+	ResourceTreeItem(NamePool &names, const Common::FileTree::Entry &entry, bool topmost = false);
+
+	/** Archive item constructor.
+	 *
+	 *  @param name     The name of the archive member, as returned by getResourceName().
+	 *  @param archive  The archive containing the member.
+	 *  @param resource The member within the archive.
+	 */
+	ResourceTreeItem(const QString &name, Aurora::Archive *archive, const Aurora::Archive::Resource &resource);
 
 	/** Root item constructor. */
 	ResourceTreeItem(const QString &data);
 
 	~ResourceTreeItem();
 
-	inline bool isArchive() {
-		return TypeMan.getResourceType(_fileType) == Aurora::kResourceArchive;
+	inline bool isArchive() const {
+		return _resourceType == Aurora::kResourceArchive;
 	}
 
+	/** Return the name an item for this archive member would have. */
+	static QString getResourceName(const Aurora::Archive::Resource &resource);
+
 	// Model structure
 	bool             hasChildren() const;
 	bool             insertChild(size_t position, ResourceTreeItem *child);
@@ -85,7 +117,7 @@ public:
 	ResourceTreeItem *childAt(int row) const;
 	ResourceTreeItem *getParent() const;
 	void             addChild(ResourceTreeItem *child);
-	void             setParent(ResourceTreeItem *parent);
+	void             reserveChildren(size_t count);
 
 	// Both model and file info
 	const QString &getName() const; ///< Doubles as filename.
@@ -95,33 +127,50 @@ public:
 	Aurora::ResourceType getResourceType() const;
 	bool                 isDir() const;
 	qint64               getSize() const;
-	const QString       &getPath() const;
+	QString              getPath() const;
 	Source               getSource() const;
 
 	// Resource information
-	Archive                    &getArchive();
-	Common::SeekableReadStream *getResourceData() const;
-	Images::Decoder            *getImage() const;
-	Images::Decoder            *getImage(Common::SeekableReadStream &res, Aurora::FileType type) const;
-	Sound::AudioStream         *getAudioStream() const;
-	uint64                      getSoundDuration() const;
+	Archive                                &getArchive();
+	Common::SeekableReadStream             *getResourceData() const;
+	std::shared_ptr<const Images::Decoder>  getImage() const;
+	Sound::AudioStream                     *getAudioStream() const;
+	uint64                                  getSoundDuration() const;
+
+	// Resource information for decoding in worker threads. The reader doesn't touch this item,
+	// so it can be called in any thread, as long as the archive stays open.
+	ResourceCache::DataReader               getDataReader() const;
+	ResourceCache::DataCache::ValuePtr      findResourceData() const;
+	void                                    addResourceData(const ResourceCache::DataCache::ValuePtr &data) const;
+	std::shared_ptr<const Images::Decoder>  findImage() const;
+	void                                    addImage(const std::shared_ptr<const Images::Decoder> &image) const;
 
 private:
 	ResourceTreeItem *_parent;
 	std::vector<std::unique_ptr<ResourceTreeItem> > _children;
-	QString _name; ///< The filename. This is what the tree view displays.
 
-	QString _path;
-	qint64 _size;
+	QString _name; ///< The filename, from the name pool. This is what the tree view displays.
+	QString _path; ///< The full path. Only set for the topmost item.
+
+	mutable qint64 _size; ///< The size, or -1 if an archive member's size wasn't looked up yet.
 
-	mutable bool _triedDuration;
 	mutable uint64 _duration;
 
 	Archive _archive;
 
-	Source _source;
+	uint32 _row; ///< The index of this item within its parent's children.
+
 	Aurora::FileType _fileType;
 	Aurora::ResourceType _resourceType;
+
+	uint8 _source; ///< The Source, as a byte to keep the item small.
+
+	mutable bool _triedDuration;
+
+	/** Return the key identifying this resource in the resource cache. */
+	ResourceCache::Key getCacheKey() const;
+	/** Read the resource's data, bypassing the resource cache. */
+	Common::SeekableReadStream *readResourceData() const;
 };
 
 } // End of namespace GUI
@@ -28,6 +28,7 @@ src_gui_libgui_la_SOURCES += \
     src/gui/mainwindow.h \
     src/gui/resourcetree.h \
     src/gui/resourcetreeitem.h \
+    src/gui/resourcecache.h \
     src/gui/proxymodel.h \
     src/gui/statusbar.h \
     src/gui/panelresourceinfo.h \
@@ -38,6 +39,7 @@ src_gui_libgui_la_SOURCES += \
     src/gui/panelpreviewtable.h \
     src/gui/panelbase.h \
     src/gui/panelmanager.h \
+    src/gui/previewjobs.h \
     $(EMPTY)
 
 src_gui_libgui_la_SOURCES += \
@@ -45,6 +47,7 @@ src_gui_libgui_la_SOURCES += \
     src/gui/mainwindow.cpp \
     src/gui/resourcetree.cpp \
     src/gui/resourcetreeitem.cpp \
+    src/gui/resourcecache.cpp \
     src/gui/proxymodel.cpp \
     src/gui/statusbar.cpp \
     src/gui/panelresourceinfo.cpp \
@@ -55,4 +58,5 @@ src_gui_libgui_la_SOURCES += \
     src/gui/panelpreviewtable.cpp \
     src/gui/panelmanager.cpp \
     src/gui/panelbase.cpp \
+    src/gui/previewjobs.cpp \
     $(EMPTY)
@@ -24,6 +24,8 @@
  */
 
 #include <QStatusBar>
+#include <QProgressBar>
+#include <QPushButton>
 
 #include "src/gui/statusbar.h"
 
@@ -31,6 +33,24 @@ namespace GUI {
 
 StatusBar::StatusBar(QStatusBar *statusBar) {
 	_statusBar = statusBar;
+
+	_progressBar  = new QProgressBar(_statusBar);
+	_cancelButton = new QPushButton(QObject::tr("Cancel"), _statusBar);
+
+	_progressBar->setMaximumWidth(200);
+
+	_statusBar->addPermanentWidget(_progressBar);
+	_statusBar->addPermanentWidget(_cancelButton);
+
+	_progressBar->hide();
+	_cancelButton->hide();
+
+	QObject::connect(_cancelButton, &QPushButton::clicked, [this]() {
+		// The callback might well hide the progress bar, so don't call it in place
+		const std::function<void()> cancel = _cancel;
+		if (cancel)
+			cancel();
+	});
 }
 
 void StatusBar::setText(const QString &text) {
@@ -46,4 +66,21 @@ void StatusBar::pop() {
 	_statusBar->showMessage(_text);
 }
 
+void StatusBar::showProgress(int value, int maximum, const std::function<void()> &cancel) {
+	_cancel = cancel;
+
+	_progressBar->setRange(0, maximum);
+	_progressBar->setValue(value);
+
+	_progressBar->show();
+	_cancelButton->show();
+}
+
+void StatusBar::hideProgress() {
+	_cancel = std::function<void()>();
+
+	_progressBar->hide();
+	_cancelButton->hide();
+}
+
 } // End of namespace GUI
@@ -26,9 +26,13 @@
 #ifndef GUI_STATUSBAR_H
 #define GUI_STATUSBAR_H
 
+#include <functional>
+
 #include <QString>
 
 class QStatusBar;
+class QProgressBar;
+class QPushButton;
 
 namespace GUI {
 
@@ -39,9 +43,24 @@ public:
 	void push(const QString &text, int timeout = 0);
 	void pop();
 
+	/** Show a progress bar with a cancel button, or update the one already shown.
+	 *
+	 *  @param value   The progress so far.
+	 *  @param maximum The value at which the task is done. If 0, the progress bar only shows activity.
+	 *  @param cancel  Called when the user clicks on the cancel button.
+	 */
+	void showProgress(int value, int maximum, const std::function<void()> &cancel);
+	/** Hide the progress bar and cancel button again. */
+	void hideProgress();
+
 private:
 	QStatusBar *_statusBar;
 	QString _text;
+
+	QProgressBar *_progressBar;
+	QPushButton  *_cancelButton;
+
+	std::function<void()> _cancel;
 };
 
 } // End of namespace GUI
@@ -0,0 +1,232 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Converting rows of pixels between formats.
+ */
+
+#include <cstring>
+
+#include "src/common/util.h"
+#include "src/common/error.h"
+
+#include "src/images/convert.h"
+
+#if defined(__SSSE3__)
+	#include <tmmintrin.h>
+
+	#define CONVERT_SSE2  1
+	#define CONVERT_SSSE3 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+	#include <emmintrin.h>
+
+	#define CONVERT_SSE2 1
+#endif
+
+namespace Images {
+
+/* All conversions produce 32-bit pixels. The target layout is described by
+ * the byte positions of the red and blue channel, green and alpha always
+ * being the second and fourth byte.
+ *
+ * Note that the 16-bit formats are not expanded to 8 bits per channel.
+ */
+
+/** Write one pixel into the target layout. */
+template<int redPos, int bluePos>
+static inline void writePixel(byte *dest, byte r, byte g, byte b, byte a) {
+	dest[redPos ] = r;
+	dest[1      ] = g;
+	dest[bluePos] = b;
+	dest[3      ] = a;
+}
+
+#if defined(CONVERT_SSE2)
+
+/** Pack four 32-bit lanes of separated channels into four pixels of the target layout. */
+template<int redPos, int bluePos>
+static inline __m128i packPixels(__m128i r, __m128i g, __m128i b, __m128i a) {
+	return _mm_or_si128(_mm_or_si128(_mm_slli_epi32(r, redPos * 8), _mm_slli_epi32(g, 8)),
+	                    _mm_or_si128(_mm_slli_epi32(b, bluePos * 8), a));
+}
+
+/** Convert four 16-bit pixels, each in the low half of a 32-bit lane. */
+template<int redPos, int bluePos>
+static inline __m128i convert16(__m128i c, PixelFormat format) {
+	const __m128i mask5 = _mm_set1_epi32(0x1F);
+	const __m128i mask6 = _mm_set1_epi32(0x3F);
+
+	if (format == kPixelFormatR5G6B5) {
+		const __m128i r = _mm_srli_epi32(c, 11);
+		const __m128i g = _mm_and_si128(_mm_srli_epi32(c, 5), mask6);
+		const __m128i b = _mm_and_si128(c, mask5);
+
+		return packPixels<redPos, bluePos>(r, g, b, _mm_set1_epi32((int) 0xFF000000));
+	}
+
+	// A1R5G5B5: Spread the alpha bit over the whole alpha byte
+	const __m128i r = _mm_and_si128(_mm_srli_epi32(c, 10), mask5);
+	const __m128i g = _mm_and_si128(_mm_srli_epi32(c,  5), mask5);
+	const __m128i b = _mm_and_si128(c, mask5);
+	const __m128i a = _mm_and_si128(_mm_srai_epi32(_mm_slli_epi32(c, 16), 31), _mm_set1_epi32((int) 0xFF000000));
+
+	return packPixels<redPos, bluePos>(r, g, b, a);
+}
+
+#endif // CONVERT_SSE2
+
+/** Convert pixels with 3 bytes each. */
+template<int redPos, int bluePos>
+static void convert24(byte *dest, const byte *src, size_t count, bool srcRGB) {
+	size_t i = 0;
+
+#if defined(CONVERT_SSSE3)
+	/* Shuffle four pixels at a time into place. We load 16 bytes for the 12
+	 * bytes we use, so we need to stop before the last 2 pixels. */
+
+	const bool swap = srcRGB != (redPos == 0);
+
+	const __m128i shuffle = swap ?
+		_mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10,  9, -1) :
+		_mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1,  9, 10, 11, -1);
+	const __m128i alpha = _mm_set1_epi32((int) 0xFF000000);
+
+	for (; (i + 6) <= count; i += 4, src += 12, dest += 16) {
+		const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dest), _mm_or_si128(_mm_shuffle_epi8(pixels, shuffle), alpha));
+	}
+#endif
+
+	for (; i < count; i++, src += 3, dest += 4) {
+		if (srcRGB)
+			writePixel<redPos, bluePos>(dest, src[0], src[1], src[2], 0xFF);
+		else
+			writePixel<redPos, bluePos>(dest, src[2], src[1], src[0], 0xFF);
+	}
+}
+
+/** Convert pixels with 4 bytes each. */
+template<int redPos, int bluePos>
+static void convert32(byte *dest, const byte *src, size_t count, bool srcRGB) {
+	if (srcRGB == (redPos == 0)) {
+		std::memcpy(dest, src, count * 4);
+		return;
+	}
+
+	size_t i = 0;
+
+#if defined(CONVERT_SSE2)
+	// Swap the first and third byte of four pixels at a time
+
+	const __m128i maskGA = _mm_set1_epi32((int) 0xFF00FF00);
+	const __m128i mask   = _mm_set1_epi32(0x000000FF);
+
+	for (; (i + 4) <= count; i += 4, src += 16, dest += 16) {
+		const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+
+		const __m128i ga = _mm_and_si128(pixels, maskGA);
+		const __m128i c0 = _mm_slli_epi32(_mm_and_si128(pixels, mask), 16);
+		const __m128i c2 = _mm_and_si128(_mm_srli_epi32(pixels, 16), mask);
+
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dest), _mm_or_si128(ga, _mm_or_si128(c0, c2)));
+	}
+#endif
+
+	for (; i < count; i++, src += 4, dest += 4) {
+		if (srcRGB)
+			writePixel<redPos, bluePos>(dest, src[0], src[1], src[2], src[3]);
+		else
+			writePixel<redPos, bluePos>(dest, src[2], src[1], src[0], src[3]);
+	}
+}
+
+/** Convert pixels with 16 bits each. */
+template<int redPos, int bluePos>
+static void convert16(byte *dest, const byte *src, size_t count, PixelFormat format) {
+	size_t i = 0;
+
+#if defined(CONVERT_SSE2)
+	// Eight pixels at a time, widened to 32 bits, four pixels per half
+
+	if (format != kPixelFormatDepth16) {
+		const __m128i zero = _mm_setzero_si128();
+
+		for (; (i + 8) <= count; i += 8, src += 16, dest += 32) {
+			const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+
+			const __m128i low  = convert16<redPos, bluePos>(_mm_unpacklo_epi16(pixels, zero), format);
+			const __m128i high = convert16<redPos, bluePos>(_mm_unpackhi_epi16(pixels, zero), format);
+
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dest     ), low);
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dest + 16), high);
+		}
+	}
+#endif
+
+	for (; i < count; i++, src += 2, dest += 4) {
+		const uint16 color = READ_LE_UINT16(src);
+
+		if        (format == kPixelFormatR5G6B5) {
+			writePixel<redPos, bluePos>(dest, (color & 0xF800) >> 11, (color & 0x07E0) >> 5, color & 0x001F, 0xFF);
+		} else if (format == kPixelFormatA1R5G5B5) {
+			writePixel<redPos, bluePos>(dest, (color & 0x7C00) >> 10, (color & 0x03E0) >> 5, color & 0x001F,
+			                            (color & 0x8000) ? 0xFF : 0x00);
+		} else {
+			const byte gray = color / 128;
+
+			writePixel<redPos, bluePos>(dest, gray, gray, gray, (color >= 0x7FFF) ? 0x00 : 0xFF);
+		}
+	}
+}
+
+template<int redPos, int bluePos>
+static void convertPixels(byte *dest, const byte *src, size_t count, PixelFormat format) {
+	switch (format) {
+		case kPixelFormatR8G8B8:
+		case kPixelFormatB8G8R8:
+			convert24<redPos, bluePos>(dest, src, count, format == kPixelFormatR8G8B8);
+			break;
+
+		case kPixelFormatR8G8B8A8:
+		case kPixelFormatB8G8R8A8:
+			convert32<redPos, bluePos>(dest, src, count, format == kPixelFormatR8G8B8A8);
+			break;
+
+		case kPixelFormatR5G6B5:
+		case kPixelFormatA1R5G5B5:
+		case kPixelFormatDepth16:
+			convert16<redPos, bluePos>(dest, src, count, format);
+			break;
+
+		default:
+			throw Common::Exception("Unsupported pixel format: %d", (int) format);
+	}
+}
+
+void convertToR8G8B8A8(byte *dest, const byte *src, size_t count, PixelFormat format) {
+	convertPixels<0, 2>(dest, src, count, format);
+}
+
+void convertToB8G8R8A8(byte *dest, const byte *src, size_t count, PixelFormat format) {
+	convertPixels<2, 0>(dest, src, count, format);
+}
+
+} // End of namespace Images
@@ -0,0 +1,52 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Converting rows of pixels between formats.
+ */
+
+#ifndef IMAGES_CONVERT_H
+#define IMAGES_CONVERT_H
+
+#include <cstddef>
+
+#include "src/common/types.h"
+
+#include "src/images/types.h"
+
+namespace Images {
+
+/** Convert count pixels of an uncompressed format into R8G8B8A8.
+ *
+ *  If available, SSE2 or SSSE3 instructions are used to convert several
+ *  pixels at once. Compressed formats throw an exception.
+ */
+void convertToR8G8B8A8(byte *dest, const byte *src, size_t count, PixelFormat format);
+
+/** Convert count pixels of an uncompressed format into B8G8R8A8.
+ *
+ *  If available, SSE2 or SSSE3 instructions are used to convert several
+ *  pixels at once. Compressed formats throw an exception.
+ */
+void convertToB8G8R8A8(byte *dest, const byte *src, size_t count, PixelFormat format);
+
+} // End of namespace Images
+
+#endif // IMAGES_CONVERT_H
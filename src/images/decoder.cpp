@@ -24,10 +24,12 @@
 
 #include <cassert>
 
+#include <vector>
+
 #include "src/common/scopedptr.h"
 #include "src/common/util.h"
 #include "src/common/error.h"
-#include "src/common/memreadstream.h"
+#include "src/common/thread.h"
 
 #include "src/images/decoder.h"
 #include "src/images/util.h"
@@ -136,7 +138,8 @@ const Decoder::MipMap &Decoder::getMipMap(size_t mipMap, size_t layer) const {
 	return *_mipMaps[index];
 }
 
-void Decoder::decompress(MipMap &out, const MipMap &in, PixelFormat format) {
+/** Check a compressed mip map and allocate its decompressed counterpart. */
+static void allocateDecompressed(Decoder::MipMap &out, const Decoder::MipMap &in, PixelFormat format) {
 	if ((format != kPixelFormatDXT1) &&
 	    (format != kPixelFormatDXT3) &&
 	    (format != kPixelFormatDXT5))
@@ -147,34 +150,112 @@ void Decoder::decompress(MipMap &out, const MipMap &in, PixelFormat format) {
 	if (!hasValidDimensions(format, in.width, in.height))
 		throw Common::Exception("Invalid dimensions (%dx%d) for format %d", in.width, in.height, format);
 
+	const uint32 dataSize = getDataSize(format, in.width, in.height);
+	if (in.size < dataSize)
+		throw Common::Exception("Compressed mip map too small (%u < %u)", in.size, dataSize);
+
 	out.width  = in.width;
 	out.height = in.height;
 	out.size   = MAX(out.width * out.height * 4, 64);
 
 	out.data.reset(new byte[out.size]);
+}
+
+/** Decompress the pixel rows [y, y + height) of a compressed mip map.
+ *
+ *  y needs to be a multiple of 4, and unless the rows reach to the
+ *  bottom of the mip map, height needs to be as well.
+ */
+static void decompressRows(Decoder::MipMap &out, const Decoder::MipMap &in, PixelFormat format,
+                           int y, int height) {
+
+	const uint32 blockSize = (format == kPixelFormatDXT1) ? 8 : 16;
+	const uint32 pitch     = out.width * 4;
 
-	Common::ScopedPtr<Common::MemoryReadStream> stream(new Common::MemoryReadStream(in.data.get(), in.size));
+	const byte *src  = in.data.get()  + (y / 4) * ((in.width + 3) / 4) * blockSize;
+	      byte *dest = out.data.get() + y * pitch;
 
 	if      (format == kPixelFormatDXT1)
-		decompressDXT1(out.data.get(), *stream, out.width, out.height, out.width * 4);
+		decompressDXT1(dest, src, out.width, height, pitch);
 	else if (format == kPixelFormatDXT3)
-		decompressDXT3(out.data.get(), *stream, out.width, out.height, out.width * 4);
+		decompressDXT3(dest, src, out.width, height, pitch);
 	else if (format == kPixelFormatDXT5)
-		decompressDXT5(out.data.get(), *stream, out.width, out.height, out.width * 4);
+		decompressDXT5(dest, src, out.width, height, pitch);
+}
+
+/** A band of pixel rows of a mip map to decompress. */
+struct DecompressTask {
+	const Decoder::MipMap *in;
+	Decoder::MipMap *out;
+
+	int y;
+	int height;
+
+	DecompressTask(const Decoder::MipMap &i, Decoder::MipMap &o, int t, int h) :
+		in(&i), out(&o), y(t), height(h) {
+	}
+};
+
+/** Number of pixel rows in one task. Needs to be a multiple of 4. */
+static const int kDecompressTaskRows = 64;
+/** Below this number of pixels, decompress on the calling thread alone. */
+static const uint32 kDecompressParallelPixels = 256 * 256;
+
+/** Split a mip map into bands of rows that can be decompressed independently. */
+static void addDecompressTasks(std::vector<DecompressTask> &tasks, const Decoder::MipMap &in, Decoder::MipMap &out) {
+	int y = 0;
+
+	// Images smaller than a block are decoded specially, and can't be split
+	if ((out.width >= 4) && (out.height >= 4)) {
+		// Keep at least 4 rows for the last band
+		while ((out.height - y) >= (kDecompressTaskRows + 4)) {
+			tasks.push_back(DecompressTask(in, out, y, kDecompressTaskRows));
+
+			y += kDecompressTaskRows;
+		}
+	}
+
+	tasks.push_back(DecompressTask(in, out, y, out.height - y));
+}
+
+void Decoder::decompress(MipMap &out, const MipMap &in, PixelFormat format) {
+	allocateDecompressed(out, in, format);
+
+	decompressRows(out, in, format, 0, out.height);
 }
 
 void Decoder::decompress() {
 	if (!isCompressed())
 		return;
 
+	/* Check and allocate everything up-front, then decompress all mip maps
+	 * of all layers, split into bands of rows, on a pool of threads. */
+
+	MipMaps decompressed;
+	decompressed.reserve(_mipMaps.size());
+
+	std::vector<DecompressTask> tasks;
+
+	uint32 pixelCount = 0;
 	for (MipMaps::iterator m = _mipMaps.begin(); m != _mipMaps.end(); ++m) {
-		MipMap decompressed;
+		decompressed.push_back(new MipMap);
 
-		decompress(decompressed, **m, _format);
+		allocateDecompressed(*decompressed.back(), **m, _format);
+		addDecompressTasks(tasks, **m, *decompressed.back());
 
-		decompressed.swap(**m);
+		pixelCount += (*m)->width * (*m)->height;
 	}
 
+	const size_t threadCount = (pixelCount >= kDecompressParallelPixels) ? 0 : 1;
+
+	const PixelFormat format = _format;
+	Common::parallelFor(tasks.size(), [&tasks, format](size_t i) {
+		decompressRows(*tasks[i].out, *tasks[i].in, format, tasks[i].y, tasks[i].height);
+	}, threadCount);
+
+	for (size_t i = 0; i < _mipMaps.size(); i++)
+		decompressed[i]->swap(*_mipMaps[i]);
+
 	_format = kPixelFormatR8G8B8A8;
 }
 
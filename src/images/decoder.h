@@ -108,7 +108,11 @@ protected:
 	/** Is the image data compressed? */
 	bool isCompressed() const;
 
-	/** Manually decompress the texture image data. */
+	/** Manually decompress the texture image data.
+	 *
+	 *  Large images are decompressed on several threads, unless this is
+	 *  already called from within a Common::parallelFor().
+	 */
 	void decompress();
 
 	static void decompress(MipMap &out, const MipMap &in, PixelFormat format);
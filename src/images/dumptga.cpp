@@ -30,61 +30,10 @@
 #include "src/common/writefile.h"
 
 #include "src/images/decoder.h"
+#include "src/images/convert.h"
 
 namespace Images {
 
-static void writePixel(Common::WriteStream &file, const byte *&data, PixelFormat format) {
-	if (format == kPixelFormatR8G8B8) {
-		file.writeByte(data[2]);
-		file.writeByte(data[1]);
-		file.writeByte(data[0]);
-		file.writeByte(0xFF);
-		data += 3;
-	} else if (format == kPixelFormatB8G8R8) {
-		file.writeByte(data[0]);
-		file.writeByte(data[1]);
-		file.writeByte(data[2]);
-		file.writeByte(0xFF);
-		data += 3;
-	} else if (format == kPixelFormatR8G8B8A8) {
-		file.writeByte(data[2]);
-		file.writeByte(data[1]);
-		file.writeByte(data[0]);
-		file.writeByte(data[3]);
-		data += 4;
-	} else if (format == kPixelFormatB8G8R8A8) {
-		file.writeByte(data[0]);
-		file.writeByte(data[1]);
-		file.writeByte(data[2]);
-		file.writeByte(data[3]);
-		data += 4;
-	} else if (format == kPixelFormatR5G6B5) {
-		uint16 color = READ_LE_UINT16(data);
-		file.writeByte( color & 0x001F);
-		file.writeByte((color & 0x07E0) >>  5);
-		file.writeByte((color & 0xF800) >> 11);
-		file.writeByte(0xFF);
-		data += 2;
-	} else if (format == kPixelFormatA1R5G5B5) {
-		uint16 color = READ_LE_UINT16(data);
-		file.writeByte( color & 0x001F);
-		file.writeByte((color & 0x03E0) >>  5);
-		file.writeByte((color & 0x7C00) >> 10);
-		file.writeByte((color & 0x8000) ? 0xFF : 0x00);
-		data += 2;
-	} else if (format == kPixelFormatDepth16) {
-		uint16 color = READ_LE_UINT16(data);
-		file.writeByte(color / 128);
-		file.writeByte(color / 128);
-		file.writeByte(color / 128);
-		file.writeByte((color >= 0x7FFF) ? 0x00 : 0xFF);
-
-		data += 2;
-	} else
-		throw Common::Exception("Unsupported pixel format: %d", (int) format);
-
-}
-
 static Common::WriteStream *openTGA(const Common::UString &fileName, int width, int height) {
 	Common::WriteFile *file = new Common::WriteFile(fileName);
 
@@ -107,11 +56,12 @@ static Common::WriteStream *openTGA(const Common::UString &fileName, int width,
 }
 
 static void writeMipMap(Common::WriteStream &stream, const Decoder::MipMap &mipMap, PixelFormat format) {
-	const byte *data = mipMap.data.get();
+	const size_t count = mipMap.width * mipMap.height;
+
+	Common::ScopedArray<byte> data(new byte[count * 4]);
+	convertToB8G8R8A8(data.get(), mipMap.data.get(), count, format);
 
-	uint32 count = mipMap.width * mipMap.height;
-	while (count-- > 0)
-		writePixel(stream, data, format);
+	stream.write(data.get(), count * 4);
 }
 
 void dumpTGA(const Common::UString &fileName, const Decoder &image) {
@@ -0,0 +1,88 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Loading images by their file type.
+ */
+
+#include "src/common/error.h"
+#include "src/common/readstream.h"
+
+#include "src/images/loader.h"
+#include "src/images/dds.h"
+#include "src/images/sbm.h"
+#include "src/images/tga.h"
+#include "src/images/tpc.h"
+#include "src/images/txb.h"
+#include "src/images/winiconimage.h"
+
+namespace Images {
+
+Decoder *loadImage(Common::SeekableReadStream &stream, Aurora::FileType type) {
+	Decoder *img = 0;
+	switch (type) {
+		case Aurora::kFileTypeDDS:
+			img = new DDS(stream);
+			break;
+
+		case Aurora::kFileTypeTPC:
+			img = new TPC(stream);
+			break;
+
+		// TXB may be actually TPC
+		case Aurora::kFileTypeTXB:
+		case Aurora::kFileTypeTXB2:
+			try {
+				img = new TXB(stream);
+			} catch (Common::Exception &e1) {
+
+				try {
+					stream.seek(0);
+					img = new TPC(stream);
+
+				} catch (Common::Exception &e2) {
+					e1.add(e2);
+
+					throw e1;
+				}
+			}
+			break;
+
+		case Aurora::kFileTypeTGA:
+			img = new TGA(stream);
+			break;
+
+		case Aurora::kFileTypeSBM:
+			img = new SBM(stream);
+			break;
+
+		case Aurora::kFileTypeCUR:
+		case Aurora::kFileTypeCURS:
+			img = new WinIconImage(stream);
+			break;
+
+		default:
+			throw Common::Exception("Unsupported image type %d", type);
+	}
+
+	return img;
+}
+
+} // End of namespace Images
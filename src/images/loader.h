@@ -0,0 +1,48 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Loading images by their file type.
+ */
+
+#ifndef IMAGES_LOADER_H
+#define IMAGES_LOADER_H
+
+#include "src/aurora/types.h"
+
+namespace Common {
+	class SeekableReadStream;
+}
+
+namespace Images {
+
+class Decoder;
+
+/** Load an image of this file type from a stream.
+ *
+ *  TXB files that fail to load are retried as TPC, since some of them
+ *  actually are. If the file type is not an image type we can load,
+ *  an exception is thrown.
+ */
+Decoder *loadImage(Common::SeekableReadStream &stream, Aurora::FileType type);
+
+} // End of namespace Images
+
+#endif // IMAGES_LOADER_H
@@ -26,8 +26,10 @@ src_images_libimages_la_SOURCES += \
     src/images/types.h \
     src/images/util.h \
     src/images/s3tc.h \
+    src/images/convert.h \
     src/images/decoder.h \
     src/images/dumptga.h \
+    src/images/loader.h \
     src/images/winiconimage.h \
     src/images/tga.h \
     src/images/dds.h \
@@ -38,8 +40,10 @@ src_images_libimages_la_SOURCES += \
 
 src_images_libimages_la_SOURCES += \
     src/images/s3tc.cpp \
+    src/images/convert.cpp \
     src/images/decoder.cpp \
     src/images/dumptga.cpp \
+    src/images/loader.cpp \
     src/images/winiconimage.cpp \
     src/images/tga.cpp \
     src/images/dds.cpp \
@@ -22,198 +22,263 @@
  *  Manual S3TC DXTn decompression methods.
  */
 
+#include <cstring>
+
 #include "src/common/util.h"
-#include "src/common/readstream.h"
 
 #include "src/images/s3tc.h"
 
+#if defined(__AVX2__)
+	#include <immintrin.h>
+
+	#define S3TC_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+	#include <emmintrin.h>
+
+	#define S3TC_SSE2 1
+#endif
+
 namespace Images {
 
-static uint32 convert565To8888(uint16 color) {
-	return ((color & 0x1F) << 11) | ((color & 0x7E0) << 13) | ((color & 0xF800) << 16) | 0xFF;
+enum DXTFormat {
+	kDXT1,
+	kDXT3,
+	kDXT5
+};
+
+/** Expand a R5G6B5 colour into a R8G8B8A8 colour. */
+static inline void convert565To8888(byte *color, uint16 c, byte alpha) {
+	color[0] = (c & 0xF800) >> 8;
+	color[1] = (c & 0x07E0) >> 3;
+	color[2] = (c & 0x001F) << 3;
+	color[3] = alpha;
 }
 
-static uint32 interpolate32(double weight, uint32 color_0, uint32 color_1) {
-	byte r[3], g[3], b[3], a[3];
-	r[0] = color_0 >> 24;
-	r[1] = color_1 >> 24;
-	r[2] = (byte)((1.0f - weight) * (double)r[0] + weight * (double)r[1]);
-	g[0] = (color_0 >> 16) & 0xFF;
-	g[1] = (color_1 >> 16) & 0xFF;
-	g[2] = (byte)((1.0f - weight) * (double)g[0] + weight * (double)g[1]);
-	b[0] = (color_0 >> 8) & 0xFF;
-	b[1] = (color_1 >> 8) & 0xFF;
-	b[2] = (byte)((1.0f - weight) * (double)b[0] + weight * (double)b[1]);
-	a[0] = color_0 & 0xFF;
-	a[1] = color_1 & 0xFF;
-	a[2] = (byte)((1.0f - weight) * (double)a[0] + weight * (double)a[1]);
-	return r[2] << 24 | g[2] << 16 | b[2] << 8 | a[2];
+/** Interpolate 1/3 of the way from a to b. An exact third is rounded towards a. */
+static inline byte interpolateThird(uint32 a, uint32 b) {
+	return (2 * a + b - ((b > a) ? 1 : 0)) / 3;
 }
 
-struct DXT1Texel {
-	uint16 color_0;
-	uint16 color_1;
-	uint32 pixels;
-};
+/** Interpolate 2/3 of the way from a to b. An exact third is rounded towards a. */
+static inline byte interpolateTwoThirds(uint32 a, uint32 b) {
+	return (a + 2 * b - ((b > a) ? 1 : 0)) / 3;
+}
 
-#define READ_DXT1_TEXEL(x) \
-	x.color_0 = src.readUint16LE(); \
-	x.color_1 = src.readUint16LE(); \
-	x.pixels = src.readUint32BE()
-
-void decompressDXT1(byte *dest, Common::SeekableReadStream &src, uint32 width, uint32 height, uint32 pitch) {
-	for (int32 ty = height; ty > 0; ty -= 4) {
-		for (uint32 tx = 0; tx < width; tx += 4) {
-			DXT1Texel tex;
-			READ_DXT1_TEXEL(tex);
-			uint32 blended[4];
-
-			blended[0] = convert565To8888(tex.color_0);
-			blended[1] = convert565To8888(tex.color_1);
-
-			if (tex.color_0 > tex.color_1) {
-				blended[2] = interpolate32(0.333333f, blended[0], blended[1]);
-				blended[3] = interpolate32(0.666666f, blended[0], blended[1]);
-			} else {
-				blended[2] = interpolate32(0.5f, blended[0], blended[1]);
-				blended[3] = 0;
-			}
+/** Read the colour palette of a DXT block: four R8G8B8A8 colours. */
+static inline void readColors(byte (&colors)[16], const byte *src, DXTFormat format) {
+	const uint16 color0 = READ_LE_UINT16(src + 0);
+	const uint16 color1 = READ_LE_UINT16(src + 2);
 
-			uint32 cpx = tex.pixels;
-			uint32 blockWidth = MIN<uint32>(width, 4);
-			uint32 blockHeight = MIN<uint32>(height, 4);
+	// DXT3 and DXT5 store their alpha separately
+	const byte alpha = (format == kDXT1) ? 0xFF : 0x00;
 
-			for (byte y = 0; y < blockHeight; ++y) {
-				for (byte x = 0; x < blockWidth; ++x) {
-					const uint32 destX = tx + x;
-					const uint32 destY = height - 1 - (ty - blockHeight + y);
+	convert565To8888(colors + 0, color0, alpha);
+	convert565To8888(colors + 4, color1, alpha);
 
-					const uint32 pixel =  blended[cpx & 3];
+	if ((format != kDXT1) || (color0 > color1)) {
+		for (size_t i = 0; i < 4; i++) {
+			colors[ 8 + i] = interpolateThird    (colors[i], colors[4 + i]);
+			colors[12 + i] = interpolateTwoThirds(colors[i], colors[4 + i]);
+		}
+	} else {
+		// DXT1 with only three colours, plus transparent black
+		for (size_t i = 0; i < 4; i++) {
+			colors[ 8 + i] = (colors[i] + colors[4 + i]) / 2;
+			colors[12 + i] = 0;
+		}
+	}
+}
 
-					cpx >>= 2;
+/** Read the alpha palette of a DXT5 block: eight alpha values. */
+static inline void readAlphas(byte (&alphas)[8], const byte *src) {
+	const uint32 alpha0 = src[0];
+	const uint32 alpha1 = src[1];
 
-					if ((destX < width) && (destY < height))
-						WRITE_BE_UINT32(dest + destY * pitch + destX * 4, pixel);
-				}
-			}
-		}
+	alphas[0] = alpha0;
+	alphas[1] = alpha1;
+
+	if (alpha0 > alpha1) {
+		for (uint32 i = 1; i < 7; i++)
+			alphas[i + 1] = ((7 - i) * alpha0 + i * alpha1 + 3) / 7;
+	} else {
+		for (uint32 i = 1; i < 5; i++)
+			alphas[i + 1] = ((5 - i) * alpha0 + i * alpha1 + 2) / 5;
+
+		alphas[6] = 0;
+		alphas[7] = 255;
 	}
 }
 
-struct DXT23Texel : public DXT1Texel {
-	uint16 alpha[4];
-};
+/** Look up the colours of all 16 pixels of a block, from the 2-bit indices of each row. */
+static inline void decodeColors(uint32 (&pixels)[16], const byte (&colors)[16], const byte *indices) {
+#if defined(S3TC_AVX2)
 
-#define READ_DXT3_TEXEL(x) \
-	x.alpha[0] = src.readUint16LE(); \
-	x.alpha[1] = src.readUint16LE(); \
-	x.alpha[2] = src.readUint16LE(); \
-	x.alpha[3] = src.readUint16LE(); \
-	READ_DXT1_TEXEL(x)
-
-void decompressDXT3(byte *dest, Common::SeekableReadStream &src, uint32 width, uint32 height, uint32 pitch) {
-	for (int32 ty = height; ty > 0; ty -= 4) {
-		for (uint32 tx = 0; tx < width; tx += 4) {
-			DXT23Texel tex;
-			uint32 blended[4];
-			READ_DXT3_TEXEL(tex);
-
-			blended[0] = convert565To8888(tex.color_0) & 0xFFFFFF00;
-			blended[1] = convert565To8888(tex.color_1) & 0xFFFFFF00;
-			blended[2] = interpolate32(0.333333f, blended[0], blended[1]);
-			blended[3] = interpolate32(0.666666f, blended[0], blended[1]);
-
-			uint32 cpx = tex.pixels;
-			uint32 blockWidth = MIN<uint32>(width, 4);
-			uint32 blockHeight = MIN<uint32>(height, 4);
-
-			for (byte y = 0; y < blockHeight; ++y) {
-				for (byte x = 0; x < blockWidth; ++x) {
-					const uint32 destX = tx + x;
-					const uint32 destY = height - 1 - (ty - blockHeight + y);
-
-					const uint32 alpha = (tex.alpha[y] >> (x * 4)) & 0xF;
-					const uint32 pixel = blended[cpx & 3] | alpha << 4;
-
-					cpx >>= 2;
-
-					if ((destX < width) && (destY < height))
-						WRITE_BE_UINT32(dest + destY * pitch + destX * 4, pixel);
-				}
-			}
+	// Two rows at a time: shift each pixel's index into place and permute the palette with them
+	const __m256i palette = _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(colors)));
+	const __m256i shifts  = _mm256_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14);
+	const __m256i mask    = _mm256_set1_epi32(3);
+
+	for (size_t y = 0; y < 4; y += 2) {
+		const __m256i rows = _mm256_set1_epi32(indices[y] | (indices[y + 1] << 8));
+		const __m256i index = _mm256_and_si256(_mm256_srlv_epi32(rows, shifts), mask);
+
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(pixels + y * 4), _mm256_permutevar8x32_epi32(palette, index));
+	}
+
+#elif defined(S3TC_SSE2)
+
+	// One row at a time: compare each pixel's index against all four values, and mask the palette with them
+	const __m128i palette = _mm_loadu_si128(reinterpret_cast<const __m128i *>(colors));
+
+	const __m128i color0 = _mm_shuffle_epi32(palette, 0x00);
+	const __m128i color1 = _mm_shuffle_epi32(palette, 0x55);
+	const __m128i color2 = _mm_shuffle_epi32(palette, 0xAA);
+	const __m128i color3 = _mm_shuffle_epi32(palette, 0xFF);
+
+	const __m128i mask   = _mm_setr_epi32(0x03, 0x0C, 0x30, 0xC0);
+	const __m128i index1 = _mm_setr_epi32(0x01, 0x04, 0x10, 0x40);
+	const __m128i index2 = _mm_setr_epi32(0x02, 0x08, 0x20, 0x80);
+
+	for (size_t y = 0; y < 4; y++) {
+		const __m128i index = _mm_and_si128(_mm_set1_epi32(indices[y]), mask);
+
+		const __m128i select0 = _mm_cmpeq_epi32(index, _mm_setzero_si128());
+		const __m128i select1 = _mm_cmpeq_epi32(index, index1);
+		const __m128i select2 = _mm_cmpeq_epi32(index, index2);
+		const __m128i select3 = _mm_cmpeq_epi32(index, mask);
+
+		const __m128i row = _mm_or_si128(_mm_or_si128(_mm_and_si128(select0, color0), _mm_and_si128(select1, color1)),
+		                                 _mm_or_si128(_mm_and_si128(select2, color2), _mm_and_si128(select3, color3)));
+
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(pixels + y * 4), row);
+	}
+
+#else
+
+	uint32 palette[4];
+	std::memcpy(palette, colors, sizeof(palette));
+
+	for (size_t y = 0; y < 4; y++)
+		for (size_t x = 0; x < 4; x++)
+			pixels[y * 4 + x] = palette[(indices[y] >> (x * 2)) & 3];
+
+#endif
+}
+
+/** Decode a DXT block into 4x4 R8G8B8A8 pixels. */
+static inline void decodeBlock(uint32 (&pixels)[16], const byte *src, DXTFormat format) {
+	byte colors[16];
+	readColors(colors, src + ((format == kDXT1) ? 0 : 8), format);
+
+	decodeColors(pixels, colors, src + ((format == kDXT1) ? 4 : 12));
+
+	byte *alpha = reinterpret_cast<byte *>(pixels) + 3;
+
+	if (format == kDXT3) {
+		/* 4-bit alpha values, stored in the upper nibble. Note that the
+		 * alpha rows are applied in reverse order, bottom to top. */
+
+		for (size_t y = 0; y < 4; y++) {
+			const uint16 rowAlpha = READ_LE_UINT16(src + 2 * (3 - y));
+
+			for (size_t x = 0; x < 4; x++, alpha += 4)
+				*alpha = ((rowAlpha >> (x * 4)) & 0xF) << 4;
 		}
+
+	} else if (format == kDXT5) {
+		byte alphas[8];
+		readAlphas(alphas, src);
+
+		uint64 indices = READ_LE_UINT32(src + 2) | (((uint64) READ_LE_UINT16(src + 6)) << 32);
+
+		for (size_t i = 0; i < 16; i++, alpha += 4, indices >>= 3)
+			*alpha = alphas[indices & 7];
 	}
 }
 
-struct DXT45Texel : public DXT1Texel {
-	byte alpha_0;
-	byte alpha_1;
-	uint64 alphabl;
-};
+/** Decompress an image of at least 4x4 pixels, block by block. */
+static void decompressBlocks(byte *dest, const byte *src, uint32 width, uint32 height, uint32 pitch,
+                             DXTFormat format) {
+
+	const size_t blockSize = (format == kDXT1) ? 8 : 16;
+
+	for (uint32 by = 0; by < height; by += 4) {
+		const uint32 blockHeight = MIN<uint32>(height - by, 4);
+
+		for (uint32 bx = 0; bx < width; bx += 4, src += blockSize) {
+			const uint32 blockWidth = MIN<uint32>(width - bx, 4);
+
+			uint32 pixels[16];
+			decodeBlock(pixels, src, format);
 
-static uint64 readUint48LE(Common::SeekableReadStream &src) {
-	uint64 output = src.readUint32LE();
-	return output | ((uint64)src.readUint16LE() << 32);
+			for (uint32 y = 0; y < blockHeight; y++)
+				std::memcpy(dest + (by + y) * pitch + bx * 4, pixels + y * 4, blockWidth * 4);
+		}
+	}
 }
 
-#define READ_DXT5_TEXEL(x) \
-	x.alpha_0 = src.readByte(); \
-	x.alpha_1 = src.readByte(); \
-	x.alphabl = readUint48LE(src); \
-	READ_DXT1_TEXEL(x)
-
-void decompressDXT5(byte *dest, Common::SeekableReadStream &src, uint32 width, uint32 height, uint32 pitch) {
-	for (int32 ty = height; ty > 0; ty -= 4) {
-		for (uint32 tx = 0; tx < width; tx += 4) {
-			uint32 blended[4];
-			byte alphab[8];
-			DXT45Texel tex;
-			READ_DXT5_TEXEL(tex);
-
-			alphab[0] = tex.alpha_0;
-			alphab[1] = tex.alpha_1;
-
-			if (tex.alpha_0 > tex.alpha_1) {
-				alphab[2] = (byte)((6.0f * (double)alphab[0] + 1.0f * (double)alphab[1] + 3.0f) / 7.0f);
-				alphab[3] = (byte)((5.0f * (double)alphab[0] + 2.0f * (double)alphab[1] + 3.0f) / 7.0f);
-				alphab[4] = (byte)((4.0f * (double)alphab[0] + 3.0f * (double)alphab[1] + 3.0f) / 7.0f);
-				alphab[5] = (byte)((3.0f * (double)alphab[0] + 4.0f * (double)alphab[1] + 3.0f) / 7.0f);
-				alphab[6] = (byte)((2.0f * (double)alphab[0] + 5.0f * (double)alphab[1] + 3.0f) / 7.0f);
-				alphab[7] = (byte)((1.0f * (double)alphab[0] + 6.0f * (double)alphab[1] + 3.0f) / 7.0f);
-			} else {
-				alphab[2] = (byte)((4.0f * (double)alphab[0] + 1.0f * (double)alphab[1] + 2.0f) / 5.0f);
-				alphab[3] = (byte)((3.0f * (double)alphab[0] + 2.0f * (double)alphab[1] + 2.0f) / 5.0f);
-				alphab[4] = (byte)((2.0f * (double)alphab[0] + 3.0f * (double)alphab[1] + 2.0f) / 5.0f);
-				alphab[5] = (byte)((1.0f * (double)alphab[0] + 4.0f * (double)alphab[1] + 2.0f) / 5.0f);
-				alphab[6] = 0;
-				alphab[7] = 255;
-			}
+/** Decompress an image smaller than 4 pixels in either direction.
+ *
+ *  Such images are made of partial blocks. To stay compatible, their pixels
+ *  are picked out of the decoded blocks in the same order we always did.
+ */
+static void decompressSmall(byte *dest, const byte *src, uint32 width, uint32 height, uint32 pitch,
+                            DXTFormat format) {
 
-			blended[0] = convert565To8888(tex.color_0) & 0xFFFFFF00;
-			blended[1] = convert565To8888(tex.color_1) & 0xFFFFFF00;
-			blended[2] = interpolate32(0.333333f, blended[0], blended[1]);
-			blended[3] = interpolate32(0.666666f, blended[0], blended[1]);
+	const size_t blockSize = (format == kDXT1) ? 8 : 16;
 
-			uint32 cpx = tex.pixels;
-			uint32 blockWidth = MIN<uint32>(width, 4);
-			uint32 blockHeight = MIN<uint32>(height, 4);
+	const uint32 blockWidth  = MIN<uint32>(width , 4);
+	const uint32 blockHeight = MIN<uint32>(height, 4);
 
-			for (byte y = 0; y < blockHeight; ++y) {
-				for (byte x = 0; x < blockWidth; ++x) {
-					const uint32 destX = tx + x;
-					const uint32 destY = height - 1 - (ty - blockHeight + y);
+	for (uint32 by = 0; by < height; by += 4) {
+		for (uint32 bx = 0; bx < width; bx += 4, src += blockSize) {
+			uint32 pixels[16];
+			decodeBlock(pixels, src, format);
 
-					const uint32 alpha = alphab[(tex.alphabl >> (3 * (4 * (3 - y) + x))) & 7];
-					const uint32 pixel = blended[cpx & 3] | alpha;
+			const byte *block = reinterpret_cast<const byte *>(pixels);
 
-					cpx >>= 2;
+			for (uint32 y = 0, i = 0; y < blockHeight; y++) {
+				for (uint32 x = 0; x < blockWidth; x++, i++) {
+					const uint32 destX = bx + x;
+					const uint32 destY = by + blockHeight - 1 - y;
 
-					if ((destX < width) && (destY < height))
-						WRITE_BE_UINT32(dest + destY * pitch + destX * 4, pixel);
+					if ((destX >= width) || (destY >= height))
+						continue;
+
+					const byte *color = block + ((3 - i / 4) * 4 + (i % 4)) * 4;
+					const byte *alpha = (format == kDXT1) ? color : (block + ((3 - y) * 4 + x) * 4);
+
+					byte *pixel = dest + destY * pitch + destX * 4;
+
+					pixel[0] = color[0];
+					pixel[1] = color[1];
+					pixel[2] = color[2];
+					pixel[3] = alpha[3];
 				}
 			}
 		}
 	}
 }
 
+static void decompressDXT(byte *dest, const byte *src, uint32 width, uint32 height, uint32 pitch,
+                          DXTFormat format) {
+
+	if ((width < 4) || (height < 4))
+		decompressSmall(dest, src, width, height, pitch, format);
+	else
+		decompressBlocks(dest, src, width, height, pitch, format);
+}
+
+void decompressDXT1(byte *dest, const byte *src, uint32 width, uint32 height, uint32 pitch) {
+	decompressDXT(dest, src, width, height, pitch, kDXT1);
+}
+
+void decompressDXT3(byte *dest, const byte *src, uint32 width, uint32 height, uint32 pitch) {
+	decompressDXT(dest, src, width, height, pitch, kDXT3);
+}
+
+void decompressDXT5(byte *dest, const byte *src, uint32 width, uint32 height, uint32 pitch) {
+	decompressDXT(dest, src, width, height, pitch, kDXT5);
+}
+
 } // End of namespace Images
@@ -27,15 +27,18 @@
 
 #include "src/common/types.h"
 
-namespace Common {
-	class SeekableReadStream;
-}
-
 namespace Images {
 
-void decompressDXT1(byte *dest, Common::SeekableReadStream &src, uint32 width, uint32 height, uint32 pitch);
-void decompressDXT3(byte *dest, Common::SeekableReadStream &src, uint32 width, uint32 height, uint32 pitch);
-void decompressDXT5(byte *dest, Common::SeekableReadStream &src, uint32 width, uint32 height, uint32 pitch);
+/** Decompress DXT1/3/5 data into R8G8B8A8 pixels.
+ *
+ *  The source data needs to hold all blocks of the image, i.e. as many
+ *  bytes as getDataSize() returns for the format and dimensions.
+ *
+ *  If available, SSE2 or AVX2 instructions are used to decode the blocks.
+ */
+void decompressDXT1(byte *dest, const byte *src, uint32 width, uint32 height, uint32 pitch);
+void decompressDXT3(byte *dest, const byte *src, uint32 width, uint32 height, uint32 pitch);
+void decompressDXT5(byte *dest, const byte *src, uint32 width, uint32 height, uint32 pitch);
 
 } // End of namespace Images
 
@@ -40,10 +40,12 @@
 
 #include "src/gui/icons.h"
 #include "src/gui/mainwindow.h"
+#include "src/gui/resourcecache.h"
 
 #include "src/sound/sound.h"
 
 #include "src/cline.h"
+#include "src/extract.h"
 
 void initPlatform();
 
@@ -73,6 +75,10 @@ int main(int argc, char **argv) {
 				openGamePath(job.path);
 				break;
 
+			case kOperationExtract:
+				extractResources(job);
+				break;
+
 			case kOperationInvalid:
 			default:
 				std::printf("%s\n", createHelpText(args[0]).c_str());
@@ -152,6 +158,8 @@ void Phaethon::deinitSubsystems() {
 		SoundMan.deinit();
 
 		Sound::SoundManager::destroy();
+
+		GUI::ResourceCache::destroy();
 	} catch (Common::Exception &e) {
 		e.add("Failed to deinitialize subsystems");
 
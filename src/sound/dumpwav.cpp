@@ -0,0 +1,100 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A simple PCM WAV dumper.
+ */
+
+#include "src/common/util.h"
+#include "src/common/error.h"
+#include "src/common/writestream.h"
+
+#include "src/sound/dumpwav.h"
+#include "src/sound/audiostream.h"
+
+namespace Sound {
+
+/** Number of samples to decode and write in one go. */
+static const size_t kBufferSize = 4096;
+
+static void writeHeader(Common::WriteStream &wav, uint16 channels, uint32 rate, uint32 dataSize) {
+	const uint32 byteRate   = rate * channels * 2;
+	const uint16 blockAlign = channels * 2;
+
+	wav.writeUint32BE(MKTAG('R', 'I', 'F', 'F'));
+	wav.writeUint32LE(36 + dataSize);
+	wav.writeUint32BE(MKTAG('W', 'A', 'V', 'E'));
+
+	wav.writeUint32BE(MKTAG('f', 'm', 't', ' '));
+	wav.writeUint32LE(16);
+	wav.writeUint16LE(1);
+	wav.writeUint16LE(channels);
+	wav.writeUint32LE(rate);
+	wav.writeUint32LE(byteRate);
+	wav.writeUint16LE(blockAlign);
+	wav.writeUint16LE(16);
+
+	wav.writeUint32BE(MKTAG('d', 'a', 't', 'a'));
+	wav.writeUint32LE(dataSize);
+}
+
+void dumpWAV(Common::SeekableWriteStream &wav, AudioStream &sound) {
+	const uint16 channels = sound.getChannels();
+	const uint32 rate     = sound.getRate();
+
+	if (channels == 0)
+		throw Common::Exception("dumpWAV(): Sound has no channels");
+
+	// Write a header with a placeholder size, to be filled in at the end
+
+	const size_t headerPos = wav.pos();
+	writeHeader(wav, channels, rate, 0);
+
+	int16 buffer[kBufferSize];
+
+	uint64 samples = 0;
+	while (!sound.endOfStream()) {
+		const int count = sound.readBuffer(buffer, kBufferSize);
+		if (count <= 0)
+			continue;
+
+		for (int i = 0; i < count; i++)
+			buffer[i] = TO_LE_16(buffer[i]);
+
+		if (wav.write(buffer, count * 2) != (size_t) (count * 2))
+			throw Common::Exception(Common::kWriteError);
+
+		samples += count;
+	}
+
+	const uint64 dataSize = (samples / channels) * channels * 2;
+	if (dataSize > (0xFFFFFFFFULL - 36))
+		throw Common::Exception("dumpWAV(): Sound too long for a WAV file");
+
+	// Go back and fill in the size
+
+	const size_t endPos = wav.pos();
+
+	wav.seek(headerPos);
+	writeHeader(wav, channels, rate, dataSize);
+	wav.seek(endPos);
+}
+
+} // End of namespace Sound
@@ -26,11 +26,13 @@ src_sound_libsound_la_SOURCES += \
     src/sound/types.h \
     src/sound/audiostream.h \
     src/sound/sound.h \
+    src/sound/dumpwav.h \
     $(EMPTY)
 
 src_sound_libsound_la_SOURCES += \
     src/sound/audiostream.cpp \
     src/sound/sound.cpp \
+    src/sound/dumpwav.cpp \
     $(EMPTY)
 
 src_sound_libsound_la_LIBADD = \
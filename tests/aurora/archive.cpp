@@ -0,0 +1,94 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for the generic archive interface.
+ */
+
+#include "gtest/gtest.h"
+
+#include "src/common/system.h"
+#include "src/common/hash.h"
+
+#include "src/aurora/archive.h"
+
+#include "tests/aurora/testarchive.h"
+
+GTEST_TEST(Archive, findResourceName) {
+	TestArchive archive(Common::kHashNone);
+
+	archive.addResource("ozymandias", Aurora::kFileTypeTXT);
+	archive.addResource("Ozymandias", Aurora::kFileTypeBMP);
+	archive.addResource("nope"      , Aurora::kFileTypeTXT);
+
+	EXPECT_EQ(archive.findResource("ozymandias", Aurora::kFileTypeTXT), 0);
+	EXPECT_EQ(archive.findResource("Ozymandias", Aurora::kFileTypeBMP), 1);
+	EXPECT_EQ(archive.findResource("nope"      , Aurora::kFileTypeTXT), 2);
+
+	EXPECT_EQ(archive.findResource("nope"      , Aurora::kFileTypeBMP), 0xFFFFFFFF);
+	EXPECT_EQ(archive.findResource("ozymandia" , Aurora::kFileTypeTXT), 0xFFFFFFFF);
+	EXPECT_EQ(archive.findResource(""          , Aurora::kFileTypeTXT), 0xFFFFFFFF);
+}
+
+GTEST_TEST(Archive, findResourceNameCase) {
+	TestArchive archive(Common::kHashNone);
+
+	archive.addResource("ozymandias", Aurora::kFileTypeTXT);
+	archive.addResource("Ozymandias", Aurora::kFileTypeBMP);
+
+	// Names are compared exactly, like the linear search did
+	EXPECT_EQ(archive.findResource("ozymandias", Aurora::kFileTypeTXT), 0);
+	EXPECT_EQ(archive.findResource("Ozymandias", Aurora::kFileTypeBMP), 1);
+
+	EXPECT_EQ(archive.findResource("OZYMANDIAS", Aurora::kFileTypeTXT), 0xFFFFFFFF);
+	EXPECT_EQ(archive.findResource("Ozymandias", Aurora::kFileTypeTXT), 0xFFFFFFFF);
+	EXPECT_EQ(archive.findResource("ozymandias", Aurora::kFileTypeBMP), 0xFFFFFFFF);
+}
+
+GTEST_TEST(Archive, findResourceDuplicate) {
+	TestArchive archive(Common::kHashFNV64);
+
+	archive.addResource("ozymandias", Aurora::kFileTypeTXT);
+	archive.addResource("OZYMANDIAS", Aurora::kFileTypeTXT);
+	archive.addResource("ozymandias", Aurora::kFileTypeTXT);
+
+	EXPECT_EQ(archive.findResource("ozymandias", Aurora::kFileTypeTXT), 0);
+	EXPECT_EQ(archive.findResource("OZYMANDIAS", Aurora::kFileTypeTXT), 1);
+	EXPECT_EQ(archive.findResource(Common::hashString("ozymandias", Common::kHashFNV64)), 0);
+}
+
+GTEST_TEST(Archive, findResourceHash) {
+	TestArchive archive(Common::kHashFNV64);
+
+	archive.addResource("ozymandias", Aurora::kFileTypeTXT);
+	archive.addResource("nope"      , Aurora::kFileTypeTXT);
+
+	EXPECT_EQ(archive.findResource(Common::hashString("ozymandias", Common::kHashFNV64)), 0);
+	EXPECT_EQ(archive.findResource(Common::hashString("nope"      , Common::kHashFNV64)), 1);
+	EXPECT_EQ(archive.findResource(Common::hashString("foobar"    , Common::kHashFNV64)), 0xFFFFFFFF);
+}
+
+GTEST_TEST(Archive, findResourceHashNone) {
+	TestArchive archive(Common::kHashNone);
+
+	archive.addResource("ozymandias", Aurora::kFileTypeTXT);
+
+	EXPECT_EQ(archive.findResource(archive.getResources().front().hash), 0xFFFFFFFF);
+}
@@ -0,0 +1,157 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Benchmark for looking up resources in archives.
+ *
+ *  Looks up resources by name and type, and by name hash, in an archive
+ *  of 100000 resources, similar to the KEY files of the later games. The
+ *  lookups are done both by Archive::findResource() and by a linear search
+ *  through the resource list, and the number of lookups per second printed.
+ *  Since the linear search is so slow, it only does the first few lookups.
+ */
+
+#include <cstdio>
+
+#include <vector>
+
+#include <boost/chrono.hpp>
+
+#include "gtest/gtest.h"
+
+#include "src/common/system.h"
+#include "src/common/util.h"
+#include "src/common/hash.h"
+#include "src/common/strutil.h"
+
+#include "src/aurora/archive.h"
+
+#include "tests/aurora/testarchive.h"
+
+static const size_t kResourceCount = 100000;
+static const size_t kLookupCount   = 100000;
+static const size_t kLinearCount   =    100; ///< The linear search only does the first lookups.
+
+static const Aurora::FileType kTypes[] = {
+	Aurora::kFileTypeTXT, Aurora::kFileTypeTGA, Aurora::kFileTypeWAV, Aurora::kFileTypeMDL
+};
+
+/** Fill an archive with resources. */
+static void fillArchive(TestArchive &archive) {
+	for (size_t i = 0; i < kResourceCount; i++)
+		archive.addResource(Common::UString::format("resource%06u", (uint)i), kTypes[i % ARRAYSIZE(kTypes)]);
+}
+
+/** Find a resource by name and type, by walking through the whole list. */
+static uint32 findLinear(const Aurora::Archive &archive, const Common::UString &name, Aurora::FileType type) {
+	const Aurora::Archive::ResourceList &resources = archive.getResources();
+
+	for (Aurora::Archive::ResourceList::const_iterator r = resources.begin(); r != resources.end(); ++r)
+		if ((r->type == type) && r->name.equalsIgnoreCase(name))
+			return r->index;
+
+	return 0xFFFFFFFF;
+}
+
+/** Find a resource by hash, by walking through the whole list. */
+static uint32 findLinear(const Aurora::Archive &archive, uint64 hash) {
+	const Aurora::Archive::ResourceList &resources = archive.getResources();
+
+	for (Aurora::Archive::ResourceList::const_iterator r = resources.begin(); r != resources.end(); ++r)
+		if (r->hash == hash)
+			return r->index;
+
+	return 0xFFFFFFFF;
+}
+
+struct Lookup {
+	Common::UString name;
+	Aurora::FileType type;
+	uint64 hash;
+};
+
+/** Create lookups for random resources, about a tenth of which don't exist. */
+static void createLookups(std::vector<Lookup> &lookups) {
+	lookups.resize(kLookupCount);
+
+	uint32 seed = 0xC0FFEE;
+	for (size_t i = 0; i < kLookupCount; i++) {
+		seed = seed * 1103515245 + 12345;
+
+		const size_t n = (seed >> 8) % (kResourceCount + kResourceCount / 10);
+
+		lookups[i].name = Common::UString::format("RESOURCE%06u", (uint)n);
+		lookups[i].type = kTypes[n % ARRAYSIZE(kTypes)];
+		lookups[i].hash = Common::hashString(lookups[i].name.toLower(), Common::kHashFNV64);
+	}
+}
+
+static double getElapsed(const boost::chrono::steady_clock::time_point &start) {
+	const boost::chrono::duration<double> elapsed = boost::chrono::steady_clock::now() - start;
+
+	return MAX(elapsed.count(), 1e-9);
+}
+
+GTEST_TEST(ArchiveBenchmark, findResource) {
+	TestArchive archive(Common::kHashFNV64);
+	fillArchive(archive);
+
+	std::vector<Lookup> lookups;
+	createLookups(lookups);
+
+	std::vector<uint32> linearNames(kLinearCount), linearHashes(kLinearCount);
+	std::vector<uint32> indexNames (kLookupCount), indexHashes (kLookupCount);
+
+	boost::chrono::steady_clock::time_point start = boost::chrono::steady_clock::now();
+	for (size_t i = 0; i < kLinearCount; i++)
+		linearNames[i] = findLinear(archive, lookups[i].name, lookups[i].type);
+	const double linearNameTime = getElapsed(start);
+
+	start = boost::chrono::steady_clock::now();
+	for (size_t i = 0; i < kLinearCount; i++)
+		linearHashes[i] = findLinear(archive, lookups[i].hash);
+	const double linearHashTime = getElapsed(start);
+
+	// The first lookup builds the index
+	start = boost::chrono::steady_clock::now();
+	archive.findResource(0);
+	const double buildTime = getElapsed(start);
+
+	start = boost::chrono::steady_clock::now();
+	for (size_t i = 0; i < kLookupCount; i++)
+		indexNames[i] = archive.findResource(lookups[i].name, lookups[i].type);
+	const double indexNameTime = getElapsed(start);
+
+	start = boost::chrono::steady_clock::now();
+	for (size_t i = 0; i < kLookupCount; i++)
+		indexHashes[i] = archive.findResource(lookups[i].hash);
+	const double indexHashTime = getElapsed(start);
+
+	for (size_t i = 0; i < kLinearCount; i++) {
+		ASSERT_EQ(indexNames[i] , linearNames[i] ) << "At index " << i;
+		ASSERT_EQ(indexHashes[i], linearHashes[i]) << "At index " << i;
+	}
+
+	std::printf("Building the index:    %10.3f ms\n", buildTime * 1000.0);
+	std::printf("Linear name lookups:   %10.0f lookups/s\n", kLinearCount / linearNameTime);
+	std::printf("Indexed name lookups:  %10.0f lookups/s\n", kLookupCount / indexNameTime);
+	std::printf("Linear hash lookups:   %10.0f lookups/s\n", kLinearCount / linearHashTime);
+	std::printf("Indexed hash lookups:  %10.0f lookups/s\n", kLookupCount / indexHashTime);
+}
@@ -29,6 +29,7 @@
 
 #include "src/aurora/biffile.h"
 #include "src/aurora/keyfile.h"
+#include "src/aurora/keydatafilecache.h"
 
 // Percy Bysshe Shelley's "Ozymandias"
 static const char *kFileData =
@@ -158,6 +159,39 @@ GTEST_TEST(BIFFile10, mergeKEY) {
 	delete bif;
 }
 
+GTEST_TEST(BIFFile10, mergeKEYCache) {
+	Aurora::KEYFile key(new Common::MemoryReadStream(kKEYFile));
+
+	size_t opened = 0;
+	Aurora::KEYDataFileCache cache([&opened](const Common::UString &name) -> Aurora::KEYDataFile * {
+		if (name != "xoreos.bif")
+			return 0;
+
+		opened++;
+		return new Aurora::BIFFile(new Common::MemoryReadStream(kBIF10File));
+	});
+
+	key.setDataFileCache(&cache);
+
+	// The data file is only opened once a resource within is accessed
+	EXPECT_TRUE(key.haveDataFile(0));
+	EXPECT_EQ(opened, 0);
+
+	EXPECT_EQ(key.getResourceSize(0), strlen(kFileData));
+
+	Common::SeekableReadStream *file = key.getResource(0);
+	ASSERT_NE(file, static_cast<Common::SeekableReadStream *>(0));
+
+	ASSERT_EQ(file->size(), strlen(kFileData));
+
+	for (size_t i = 0; i < strlen(kFileData); i++)
+		EXPECT_EQ(file->readByte(), kFileData[i]) << "At index " << i;
+
+	delete file;
+
+	EXPECT_EQ(opened, 1);
+}
+
 // --- BIF V1.1 ---
 
 // Percy Bysshe Shelley's "Ozymandias", within a BIF V1.1 file
@@ -22,13 +22,19 @@
  *  Unit tests for our BZF file archive class.
  */
 
+#include <vector>
+#include <algorithm>
+
 #include "gtest/gtest.h"
 
+#include "src/common/system.h"
 #include "src/common/error.h"
+#include "src/common/scopedptr.h"
 #include "src/common/memreadstream.h"
 
 #include "src/aurora/bzffile.h"
 #include "src/aurora/keyfile.h"
+#include "src/aurora/keydatafilecache.h"
 
 // Percy Bysshe Shelley's "Ozymandias"
 static const char *kFileData =
@@ -130,6 +136,22 @@ GTEST_TEST(BZFFile, getResource) {
 	delete file;
 }
 
+GTEST_TEST(BZFFile, getResourceOutlivesBZF) {
+	std::vector<byte> data(kBZFFile, kBZFFile + sizeof(kBZFFile));
+
+	Common::ScopedPtr<Aurora::BZFFile> bzf(new Aurora::BZFFile(new Common::MemoryReadStream(&data[0], data.size())));
+	Common::ScopedPtr<Common::SeekableReadStream> file(bzf->getResource(0));
+
+	// Without tryNoCopy, the resource must not depend on the BZF anymore
+	bzf.reset();
+	std::fill(data.begin(), data.end(), 0);
+
+	ASSERT_EQ(file->size(), strlen(kFileData));
+
+	for (size_t i = 0; i < strlen(kFileData); i++)
+		EXPECT_EQ(file->readByte(), kFileData[i]) << "At index " << i;
+}
+
 GTEST_TEST(BZFFile, mergeKEY) {
 	Aurora::KEYFile key(new Common::MemoryReadStream(kKEYFile));
 
@@ -143,3 +165,45 @@ GTEST_TEST(BZFFile, mergeKEY) {
 
 	delete bzf;
 }
+
+/** A BZF file counting how many of them exist. */
+class CountedBZFFile : public Aurora::BZFFile {
+public:
+	CountedBZFFile(Common::SeekableReadStream *bzf, size_t &count) : Aurora::BZFFile(bzf), _count(&count) {
+		(*_count)++;
+	}
+
+	~CountedBZFFile() {
+		(*_count)--;
+	}
+
+private:
+	size_t *_count;
+};
+
+GTEST_TEST(BZFFile, getResourceFromEvictedKEYDataFile) {
+	std::vector<byte> data(kBZFFile, kBZFFile + sizeof(kBZFFile));
+	size_t aliveCount = 0;
+
+	Aurora::KEYDataFileCache cache([&](const Common::UString &UNUSED(name)) {
+		return new CountedBZFFile(new Common::MemoryReadStream(&data[0], data.size()), aliveCount);
+	}, 1);
+
+	Aurora::KEYFile key(new Common::MemoryReadStream(kKEYFile));
+	key.setDataFileCache(&cache);
+
+	Common::ScopedPtr<Common::SeekableReadStream> file(key.getResource(0));
+	ASSERT_EQ(file->size(), strlen(kFileData));
+
+	// Read a bit, then make the cache close the BZF, while we're still reading
+	for (size_t i = 0; i < 10; i++)
+		EXPECT_EQ(file->readByte(), kFileData[i]) << "At index " << i;
+
+	cache.getDataFile("other.bzf");
+	EXPECT_EQ(aliveCount, 1);
+
+	std::fill(data.begin(), data.end(), 0);
+
+	for (size_t i = 10; i < strlen(kFileData); i++)
+		EXPECT_EQ(file->readByte(), kFileData[i]) << "At index " << i;
+}
@@ -22,10 +22,14 @@
  *  Unit tests for our ERF file archive class.
  */
 
+#include <vector>
+#include <algorithm>
+
 #include "gtest/gtest.h"
 
 #include "src/common/error.h"
 #include "src/common/hash.h"
+#include "src/common/scopedptr.h"
 #include "src/common/memreadstream.h"
 
 #include "src/aurora/locstring.h"
@@ -1209,6 +1213,22 @@ GTEST_TEST(ERFFile22DeflateHeader, getResource) {
 	delete file;
 }
 
+GTEST_TEST(ERFFile22DeflateHeader, getResourceOutlivesERF) {
+	std::vector<byte> data(kERFFile22DH, kERFFile22DH + sizeof(kERFFile22DH));
+
+	Common::ScopedPtr<Aurora::ERFFile> erf(new Aurora::ERFFile(new Common::MemoryReadStream(&data[0], data.size())));
+	Common::ScopedPtr<Common::SeekableReadStream> file(erf->getResource(0));
+
+	// Without tryNoCopy, the resource must not depend on the ERF anymore
+	erf.reset();
+	std::fill(data.begin(), data.end(), 0);
+
+	ASSERT_EQ(file->size(), strlen(kFileData));
+
+	for (size_t i = 0; i < strlen(kFileData); i++)
+		EXPECT_EQ(file->readByte(), kFileData[i]) << "At index " << i;
+}
+
 // --- ERF V2.2 (DEFLATE, raw) ---
 
 // Percy Bysshe Shelley's "Ozymandias", within an ERF V2.2 (DEFLATE, raw) file
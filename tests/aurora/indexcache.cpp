@@ -0,0 +1,391 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for our persistent index cache.
+ */
+
+#include <cstring>
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include "gtest/gtest.h"
+
+#include "src/common/util.h"
+#include "src/common/scopedptr.h"
+#include "src/common/platform.h"
+#include "src/common/filetree.h"
+#include "src/common/memreadstream.h"
+
+#include "src/aurora/rimfile.h"
+#include "src/aurora/indexcache.h"
+#include "src/aurora/cachedarchive.h"
+
+// Percy Bysshe Shelley's "Ozymandias", within a RIM file
+static const byte kRIMFile[] = {
+	0x52,0x49,0x4D,0x20,0x56,0x31,0x2E,0x30,0x00,0x00,0x00,0x00,0x01,0x00,0x00,0x00,
+	0x14,0x00,0x00,0x00,0x6F,0x7A,0x79,0x6D,0x61,0x6E,0x64,0x69,0x61,0x73,0x00,0x00,
+	0x00,0x00,0x00,0x00,0x0A,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x34,0x00,0x00,0x00,
+	0x6F,0x02,0x00,0x00,0x49,0x20,0x6D,0x65,0x74,0x20,0x61,0x20,0x74,0x72,0x61,0x76,
+	0x65,0x6C,0x6C,0x65,0x72,0x20,0x66,0x72,0x6F,0x6D,0x20,0x61,0x6E,0x20,0x61,0x6E,
+	0x74,0x69,0x71,0x75,0x65,0x20,0x6C,0x61,0x6E,0x64,0x0A,0x57,0x68,0x6F,0x20,0x73,
+	0x61,0x69,0x64,0x3A,0x20,0x54,0x77,0x6F,0x20,0x76,0x61,0x73,0x74,0x20,0x61,0x6E,
+	0x64,0x20,0x74,0x72,0x75,0x6E,0x6B,0x6C,0x65,0x73,0x73,0x20,0x6C,0x65,0x67,0x73,
+	0x20,0x6F,0x66,0x20,0x73,0x74,0x6F,0x6E,0x65,0x0A,0x53,0x74,0x61,0x6E,0x64,0x20,
+	0x69,0x6E,0x20,0x74,0x68,0x65,0x20,0x64,0x65,0x73,0x65,0x72,0x74,0x2E,0x20,0x4E,
+	0x65,0x61,0x72,0x20,0x74,0x68,0x65,0x6D,0x2C,0x20,0x6F,0x6E,0x20,0x74,0x68,0x65,
+	0x20,0x73,0x61,0x6E,0x64,0x2C,0x0A,0x48,0x61,0x6C,0x66,0x20,0x73,0x75,0x6E,0x6B,
+	0x2C,0x20,0x61,0x20,0x73,0x68,0x61,0x74,0x74,0x65,0x72,0x65,0x64,0x20,0x76,0x69,
+	0x73,0x61,0x67,0x65,0x20,0x6C,0x69,0x65,0x73,0x2C,0x20,0x77,0x68,0x6F,0x73,0x65,
+	0x20,0x66,0x72,0x6F,0x77,0x6E,0x2C,0x0A,0x41,0x6E,0x64,0x20,0x77,0x72,0x69,0x6E,
+	0x6B,0x6C,0x65,0x64,0x20,0x6C,0x69,0x70,0x2C,0x20,0x61,0x6E,0x64,0x20,0x73,0x6E,
+	0x65,0x65,0x72,0x20,0x6F,0x66,0x20,0x63,0x6F,0x6C,0x64,0x20,0x63,0x6F,0x6D,0x6D,
+	0x61,0x6E,0x64,0x2C,0x0A,0x54,0x65,0x6C,0x6C,0x20,0x74,0x68,0x61,0x74,0x20,0x69,
+	0x74,0x73,0x20,0x73,0x63,0x75,0x6C,0x70,0x74,0x6F,0x72,0x20,0x77,0x65,0x6C,0x6C,
+	0x20,0x74,0x68,0x6F,0x73,0x65,0x20,0x70,0x61,0x73,0x73,0x69,0x6F,0x6E,0x73,0x20,
+	0x72,0x65,0x61,0x64,0x0A,0x57,0x68,0x69,0x63,0x68,0x20,0x79,0x65,0x74,0x20,0x73,
+	0x75,0x72,0x76,0x69,0x76,0x65,0x2C,0x20,0x73,0x74,0x61,0x6D,0x70,0x65,0x64,0x20,
+	0x6F,0x6E,0x20,0x74,0x68,0x65,0x73,0x65,0x20,0x6C,0x69,0x66,0x65,0x6C,0x65,0x73,
+	0x73,0x20,0x74,0x68,0x69,0x6E,0x67,0x73,0x2C,0x0A,0x54,0x68,0x65,0x20,0x68,0x61,
+	0x6E,0x64,0x20,0x74,0x68,0x61,0x74,0x20,0x6D,0x6F,0x63,0x6B,0x65,0x64,0x20,0x74,
+	0x68,0x65,0x6D,0x20,0x61,0x6E,0x64,0x20,0x74,0x68,0x65,0x20,0x68,0x65,0x61,0x72,
+	0x74,0x20,0x74,0x68,0x61,0x74,0x20,0x66,0x65,0x64,0x3A,0x0A,0x41,0x6E,0x64,0x20,
+	0x6F,0x6E,0x20,0x74,0x68,0x65,0x20,0x70,0x65,0x64,0x65,0x73,0x74,0x61,0x6C,0x20,
+	0x74,0x68,0x65,0x73,0x65,0x20,0x77,0x6F,0x72,0x64,0x73,0x20,0x61,0x70,0x70,0x65,
+	0x61,0x72,0x3A,0x0A,0x27,0x4D,0x79,0x20,0x6E,0x61,0x6D,0x65,0x20,0x69,0x73,0x20,
+	0x4F,0x7A,0x79,0x6D,0x61,0x6E,0x64,0x69,0x61,0x73,0x2C,0x20,0x6B,0x69,0x6E,0x67,
+	0x20,0x6F,0x66,0x20,0x6B,0x69,0x6E,0x67,0x73,0x3A,0x0A,0x4C,0x6F,0x6F,0x6B,0x20,
+	0x6F,0x6E,0x20,0x6D,0x79,0x20,0x77,0x6F,0x72,0x6B,0x73,0x2C,0x20,0x79,0x65,0x20,
+	0x4D,0x69,0x67,0x68,0x74,0x79,0x2C,0x20,0x61,0x6E,0x64,0x20,0x64,0x65,0x73,0x70,
+	0x61,0x69,0x72,0x21,0x27,0x0A,0x4E,0x6F,0x74,0x68,0x69,0x6E,0x67,0x20,0x62,0x65,
+	0x73,0x69,0x64,0x65,0x20,0x72,0x65,0x6D,0x61,0x69,0x6E,0x73,0x2E,0x20,0x52,0x6F,
+	0x75,0x6E,0x64,0x20,0x74,0x68,0x65,0x20,0x64,0x65,0x63,0x61,0x79,0x0A,0x4F,0x66,
+	0x20,0x74,0x68,0x61,0x74,0x20,0x63,0x6F,0x6C,0x6F,0x73,0x73,0x61,0x6C,0x20,0x77,
+	0x72,0x65,0x63,0x6B,0x2C,0x20,0x62,0x6F,0x75,0x6E,0x64,0x6C,0x65,0x73,0x73,0x20,
+	0x61,0x6E,0x64,0x20,0x62,0x61,0x72,0x65,0x0A,0x54,0x68,0x65,0x20,0x6C,0x6F,0x6E,
+	0x65,0x20,0x61,0x6E,0x64,0x20,0x6C,0x65,0x76,0x65,0x6C,0x20,0x73,0x61,0x6E,0x64,
+	0x73,0x20,0x73,0x74,0x72,0x65,0x74,0x63,0x68,0x20,0x66,0x61,0x72,0x20,0x61,0x77,
+	0x61,0x79,0x2E
+};
+
+static boost::filesystem::path kDirectoryPath;
+static boost::filesystem::path kRIMPath;
+static boost::filesystem::path kCachePath;
+
+class IndexCache : public ::testing::Test {
+protected:
+	static void SetUpTestCase() {
+		Common::Platform::init();
+
+		boost::filesystem::path tmpPath    = boost::filesystem::temp_directory_path();
+		boost::filesystem::path uniquePath = boost::filesystem::unique_path("%%%%_%%%%_%%%%_%%%%.xoreos");
+
+		kDirectoryPath = tmpPath / uniquePath;
+		kRIMPath       = kDirectoryPath / "data" / "ozymandias.rim";
+		kCachePath     = tmpPath / (uniquePath.generic_string() + ".idx");
+
+		boost::filesystem::create_directories(kRIMPath.parent_path());
+	}
+
+	static void TearDownTestCase() {
+		boost::filesystem::remove_all(kDirectoryPath);
+		boost::filesystem::remove(kCachePath);
+	}
+
+	void SetUp() {
+		writeRIM(sizeof(kRIMFile));
+	}
+
+	static void writeRIM(size_t size) {
+		boost::filesystem::ofstream file(kRIMPath, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char *>(kRIMFile), size);
+	}
+};
+
+GTEST_TEST_F(IndexCache, getCacheFile) {
+	const Common::UString cacheFile1 = Aurora::IndexCache::getCacheFile(kDirectoryPath.generic_string());
+	const Common::UString cacheFile2 = Aurora::IndexCache::getCacheFile(kRIMPath.generic_string());
+
+	EXPECT_FALSE(cacheFile1.empty());
+	EXPECT_FALSE(cacheFile2.empty());
+	EXPECT_NE(cacheFile1, cacheFile2);
+}
+
+GTEST_TEST_F(IndexCache, tree) {
+	boost::filesystem::remove(kCachePath);
+
+	Common::FileTree files;
+	files.readPath(kDirectoryPath, -1);
+
+	{
+		Aurora::IndexCache cache(kDirectoryPath.generic_string(), kCachePath.generic_string());
+
+		Common::FileTree cachedFiles;
+		EXPECT_FALSE(cache.getTree(cachedFiles));
+
+		cache.setTree(files);
+		cache.save();
+	}
+
+	Aurora::IndexCache cache(kDirectoryPath.generic_string(), kCachePath.generic_string());
+
+	Common::FileTree cachedFiles;
+	ASSERT_TRUE(cache.getTree(cachedFiles));
+
+	const Common::FileTree::Entry &root = cachedFiles.getRoot();
+	EXPECT_STREQ(root.path.generic_string().c_str(), files.getRoot().path.generic_string().c_str());
+	EXPECT_TRUE(root.isDirectory());
+	ASSERT_EQ(root.children.size(), 1);
+
+	const Common::FileTree::Entry &data = root.children.front();
+	EXPECT_STREQ(data.name.c_str(), "data");
+	EXPECT_TRUE(data.isDirectory());
+	ASSERT_EQ(data.children.size(), 1);
+
+	const Common::FileTree::Entry &rim = data.children.front();
+	EXPECT_STREQ(rim.name.c_str(), "ozymandias.rim");
+	EXPECT_STREQ(rim.path.generic_string().c_str(), (files.getRoot().path / "data" / "ozymandias.rim").generic_string().c_str());
+	EXPECT_FALSE(rim.isDirectory());
+	EXPECT_EQ(rim.size, sizeof(kRIMFile));
+}
+
+GTEST_TEST_F(IndexCache, treeOutdated) {
+	boost::filesystem::remove(kCachePath);
+
+	Common::FileTree files;
+	files.readPath(kDirectoryPath, -1);
+
+	{
+		Aurora::IndexCache cache(kDirectoryPath.generic_string(), kCachePath.generic_string());
+
+		cache.setTree(files);
+		cache.save();
+	}
+
+	// Adding a file changes the directory's modification time
+	const boost::filesystem::path newFile = kRIMPath.parent_path() / "new.txt";
+	boost::filesystem::ofstream(newFile).close();
+	boost::filesystem::last_write_time(kRIMPath.parent_path(),
+		boost::filesystem::last_write_time(kRIMPath.parent_path()) + 10);
+
+	Aurora::IndexCache cache(kDirectoryPath.generic_string(), kCachePath.generic_string());
+
+	Common::FileTree cachedFiles;
+	EXPECT_FALSE(cache.getTree(cachedFiles));
+
+	boost::filesystem::remove(newFile);
+}
+
+GTEST_TEST_F(IndexCache, treeFileChanged) {
+	boost::filesystem::remove(kCachePath);
+
+	const Common::UString rimPath = kRIMPath.generic_string();
+
+	Common::FileTree files;
+	files.readPath(kDirectoryPath, -1);
+
+	{
+		Aurora::IndexCache cache(kDirectoryPath.generic_string(), kCachePath.generic_string());
+
+		const Aurora::RIMFile rim(new Common::MemoryReadStream(kRIMFile));
+		cache.addArchive(rimPath, rim);
+
+		cache.setTree(files);
+		cache.save();
+	}
+
+	// Rewriting a file in place doesn't change the directory's modification time
+	const std::time_t directoryTime = boost::filesystem::last_write_time(kRIMPath.parent_path());
+
+	writeRIM(sizeof(kRIMFile) - 1);
+	boost::filesystem::last_write_time(kRIMPath.parent_path(), directoryTime);
+
+	Aurora::IndexCache cache(kDirectoryPath.generic_string(), kCachePath.generic_string());
+
+	// The tree is still used, files aren't checked individually...
+	Common::FileTree cachedFiles;
+	EXPECT_TRUE(cache.getTree(cachedFiles));
+
+	// ...but the archive is, once it's opened
+	EXPECT_EQ(cache.getArchiveTable(rimPath), static_cast<const Aurora::IndexCache::ArchiveTable *>(0));
+}
+
+GTEST_TEST_F(IndexCache, treeSavedAfterRestore) {
+	boost::filesystem::remove(kCachePath);
+
+	Common::FileTree files;
+	files.readPath(kDirectoryPath, -1);
+
+	{
+		Aurora::IndexCache cache(kDirectoryPath.generic_string(), kCachePath.generic_string());
+
+		cache.setTree(files);
+		cache.save();
+	}
+
+	// Restore the tree, then change something else, so that the cache is written again
+	{
+		Aurora::IndexCache cache(kDirectoryPath.generic_string(), kCachePath.generic_string());
+
+		Common::FileTree cachedFiles;
+		ASSERT_TRUE(cache.getTree(cachedFiles));
+
+		const Aurora::RIMFile rim(new Common::MemoryReadStream(kRIMFile));
+		cache.addArchive(kRIMPath.generic_string(), rim);
+
+		cache.save();
+	}
+
+	Aurora::IndexCache cache(kDirectoryPath.generic_string(), kCachePath.generic_string());
+
+	Common::FileTree cachedFiles;
+	ASSERT_TRUE(cache.getTree(cachedFiles));
+
+	const Common::FileTree::Entry &root = cachedFiles.getRoot();
+	ASSERT_EQ(root.children.size(), 1);
+	EXPECT_EQ(root.children.front().children.size(), 1);
+
+	// The tree was handed out, so it can't be restored a second time
+	Common::FileTree cachedFiles2;
+	EXPECT_FALSE(cache.getTree(cachedFiles2));
+}
+
+GTEST_TEST_F(IndexCache, saveReplaces) {
+	boost::filesystem::remove(kCachePath);
+
+	Common::FileTree files;
+	files.readPath(kDirectoryPath, -1);
+
+	{
+		Aurora::IndexCache cache(kDirectoryPath.generic_string(), kCachePath.generic_string());
+
+		cache.setTree(files);
+		cache.save();
+	}
+
+	ASSERT_TRUE(boost::filesystem::exists(kCachePath));
+
+	// An already existing cache file is replaced
+	{
+		Aurora::IndexCache cache(kDirectoryPath.generic_string(), kCachePath.generic_string());
+
+		cache.setTree(files);
+		cache.save();
+	}
+
+	Aurora::IndexCache cache(kDirectoryPath.generic_string(), kCachePath.generic_string());
+
+	Common::FileTree cachedFiles;
+	EXPECT_TRUE(cache.getTree(cachedFiles));
+}
+
+GTEST_TEST_F(IndexCache, archive) {
+	boost::filesystem::remove(kCachePath);
+
+	const Common::UString rimPath = kRIMPath.generic_string();
+
+	{
+		Aurora::IndexCache cache(kDirectoryPath.generic_string(), kCachePath.generic_string());
+		EXPECT_EQ(cache.getArchiveTable(rimPath), static_cast<const Aurora::IndexCache::ArchiveTable *>(0));
+
+		const Aurora::RIMFile rim(new Common::MemoryReadStream(kRIMFile));
+		ASSERT_NE(cache.addArchive(rimPath, rim), static_cast<const Aurora::IndexCache::ArchiveTable *>(0));
+
+		cache.save();
+	}
+
+	Aurora::IndexCache cache(kDirectoryPath.generic_string(), kCachePath.generic_string());
+
+	const Aurora::IndexCache::ArchiveTable *table = cache.getArchiveTable(rimPath);
+	ASSERT_NE(table, static_cast<const Aurora::IndexCache::ArchiveTable *>(0));
+
+	EXPECT_EQ(table->nameHashAlgo, Common::kHashNone);
+	ASSERT_EQ(table->resources.size(), 1);
+
+	const Aurora::Archive::Resource &resource = table->resources.front();
+	EXPECT_STREQ(resource.name.c_str(), "ozymandias");
+	EXPECT_EQ(resource.type, Aurora::kFileTypeTXT);
+	EXPECT_EQ(resource.index, 0);
+
+	ASSERT_EQ(table->resourceSizes.size(), 1);
+	EXPECT_EQ(table->resourceSizes[0], 623);
+}
+
+GTEST_TEST_F(IndexCache, archiveOutdated) {
+	boost::filesystem::remove(kCachePath);
+
+	const Common::UString rimPath = kRIMPath.generic_string();
+
+	{
+		Aurora::IndexCache cache(kDirectoryPath.generic_string(), kCachePath.generic_string());
+
+		const Aurora::RIMFile rim(new Common::MemoryReadStream(kRIMFile));
+		cache.addArchive(rimPath, rim);
+
+		cache.save();
+	}
+
+	writeRIM(sizeof(kRIMFile) - 1);
+
+	Aurora::IndexCache cache(kDirectoryPath.generic_string(), kCachePath.generic_string());
+	EXPECT_EQ(cache.getArchiveTable(rimPath), static_cast<const Aurora::IndexCache::ArchiveTable *>(0));
+}
+
+GTEST_TEST_F(IndexCache, broken) {
+	{
+		boost::filesystem::ofstream file(kCachePath, std::ios::binary | std::ios::trunc);
+		file.write("PIDX\x01\x00\x00\x00\xFF\xFF", 10);
+	}
+
+	Aurora::IndexCache cache(kDirectoryPath.generic_string(), kCachePath.generic_string());
+
+	Common::FileTree cachedFiles;
+	EXPECT_FALSE(cache.getTree(cachedFiles));
+	EXPECT_EQ(cache.getArchiveTable(kRIMPath.generic_string()), static_cast<const Aurora::IndexCache::ArchiveTable *>(0));
+}
+
+GTEST_TEST_F(IndexCache, cachedArchive) {
+	const Aurora::RIMFile rim(new Common::MemoryReadStream(kRIMFile));
+
+	Aurora::IndexCache cache(kDirectoryPath.generic_string(), kCachePath.generic_string());
+	const Aurora::IndexCache::ArchiveTable *table = cache.addArchive(kRIMPath.generic_string(), rim);
+	ASSERT_NE(table, static_cast<const Aurora::IndexCache::ArchiveTable *>(0));
+
+	size_t openCount = 0;
+	const Aurora::CachedArchive cached(*table, [&]() -> Aurora::Archive * {
+		openCount++;
+		return const_cast<Aurora::RIMFile *>(&rim);
+	});
+
+	ASSERT_EQ(cached.getResources().size(), 1);
+	EXPECT_EQ(cached.getResourceSize(0), 623);
+	EXPECT_THROW(cached.getResourceSize(1), Common::Exception);
+	EXPECT_EQ(cached.findResource("ozymandias", Aurora::kFileTypeTXT), 0);
+
+	EXPECT_EQ(openCount, 0);
+
+	Common::ScopedPtr<Common::SeekableReadStream> file1(cached.getResource(0));
+	Common::ScopedPtr<Common::SeekableReadStream> file2(cached.getResource(0));
+	EXPECT_EQ(file1->size(), 623);
+	EXPECT_EQ(file2->size(), 623);
+
+	EXPECT_EQ(openCount, 1);
+}
@@ -0,0 +1,220 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for the cache of opened KEY data files.
+ */
+
+#include "src/common/atomic.h"
+
+#include <vector>
+
+#include <boost/thread.hpp>
+
+#include "gtest/gtest.h"
+
+#include "src/common/system.h"
+#include "src/common/error.h"
+
+#include "src/aurora/keydatafile.h"
+#include "src/aurora/keydatafilecache.h"
+
+/** A data file without resources, counting how many of them exist. */
+class TestDataFile : public Aurora::KEYDataFile {
+public:
+	TestDataFile(size_t &count) : _count(&count) {
+		(*_count)++;
+	}
+
+	~TestDataFile() {
+		(*_count)--;
+	}
+
+	Common::SeekableReadStream *getResource(uint32 UNUSED(index), bool UNUSED(tryNoCopy)) const {
+		return 0;
+	}
+
+private:
+	size_t *_count;
+};
+
+/** Opens TestDataFiles, remembering which ones it opened. */
+class TestOpener {
+public:
+	size_t aliveCount;
+	std::vector<Common::UString> opened;
+
+	TestOpener() : aliveCount(0) {
+	}
+
+	Aurora::KEYDataFile *open(const Common::UString &name) {
+		if (name == "missing.bif")
+			throw Common::Exception("No such file");
+
+		opened.push_back(name);
+		return new TestDataFile(aliveCount);
+	}
+
+	Aurora::KEYDataFileCache::Opener getOpener() {
+		return [this](const Common::UString &name) { return open(name); };
+	}
+};
+
+/** Opens TestDataFiles, blocking on "slow.bif" until released. */
+class BlockingOpener {
+public:
+	size_t aliveCount;
+
+	boost::atomic<int> slowOpenCount;
+	boost::atomic<bool> slowStarted;
+	boost::atomic<bool> slowReleased;
+
+	BlockingOpener() : aliveCount(0), slowOpenCount(0), slowStarted(false), slowReleased(false) {
+	}
+
+	Aurora::KEYDataFile *open(const Common::UString &name) {
+		if (name == "slow.bif") {
+			slowOpenCount++;
+			slowStarted = true;
+
+			while (!slowReleased)
+				boost::this_thread::sleep_for(boost::chrono::milliseconds(1));
+		}
+
+		boost::lock_guard<boost::mutex> lock(_mutex);
+		return new TestDataFile(aliveCount);
+	}
+
+	Aurora::KEYDataFileCache::Opener getOpener() {
+		return [this](const Common::UString &name) { return open(name); };
+	}
+
+private:
+	boost::mutex _mutex;
+};
+
+GTEST_TEST(KEYDataFileCache, getDataFile) {
+	TestOpener opener;
+	Aurora::KEYDataFileCache cache(opener.getOpener(), 4);
+
+	EXPECT_EQ(cache.getCapacity(), 4);
+	EXPECT_EQ(cache.getOpenCount(), 0);
+
+	Aurora::KEYDataFileCache::DataFilePtr file1 = cache.getDataFile("data/1.bif");
+	Aurora::KEYDataFileCache::DataFilePtr file2 = cache.getDataFile("data/2.bif");
+
+	ASSERT_TRUE(file1);
+	ASSERT_TRUE(file2);
+	EXPECT_NE(file1, file2);
+
+	// Already open, so we should get the same data file again
+	EXPECT_EQ(cache.getDataFile("data/1.bif"), file1);
+
+	ASSERT_EQ(opener.opened.size(), 2);
+	EXPECT_EQ(cache.getOpenCount(), 2);
+	EXPECT_EQ(opener.aliveCount, 2);
+}
+
+GTEST_TEST(KEYDataFileCache, evict) {
+	TestOpener opener;
+	Aurora::KEYDataFileCache cache(opener.getOpener(), 2);
+
+	cache.getDataFile("data/1.bif");
+	cache.getDataFile("data/2.bif");
+
+	// Mark 1 as recently used, so that 2 is evicted when 3 is opened
+	cache.getDataFile("data/1.bif");
+	cache.getDataFile("data/3.bif");
+
+	EXPECT_EQ(cache.getOpenCount(), 2);
+	EXPECT_EQ(opener.aliveCount, 2);
+
+	cache.getDataFile("data/1.bif");
+	EXPECT_EQ(opener.opened.size(), 3);
+
+	// 2 has to be opened again
+	cache.getDataFile("data/2.bif");
+	ASSERT_EQ(opener.opened.size(), 4);
+	EXPECT_EQ(opener.opened[3], "data/2.bif");
+
+	EXPECT_EQ(cache.getOpenCount(), 2);
+	EXPECT_EQ(opener.aliveCount, 2);
+
+	cache.clear();
+
+	EXPECT_EQ(cache.getOpenCount(), 0);
+	EXPECT_EQ(opener.aliveCount, 0);
+}
+
+GTEST_TEST(KEYDataFileCache, evictInUse) {
+	TestOpener opener;
+	Aurora::KEYDataFileCache cache(opener.getOpener(), 1);
+
+	Aurora::KEYDataFileCache::DataFilePtr file1 = cache.getDataFile("data/1.bif");
+	cache.getDataFile("data/2.bif");
+
+	// 1 was evicted from the cache, but it's still alive while we hold on to it
+	EXPECT_EQ(cache.getOpenCount(), 1);
+	EXPECT_EQ(opener.aliveCount, 2);
+
+	file1.reset();
+	EXPECT_EQ(opener.aliveCount, 1);
+}
+
+GTEST_TEST(KEYDataFileCache, failure) {
+	TestOpener opener;
+	Aurora::KEYDataFileCache cache(opener.getOpener(), 2);
+
+	EXPECT_THROW(cache.getDataFile("missing.bif"), Common::Exception);
+	EXPECT_THROW(cache.getDataFile("missing.bif"), Common::Exception);
+
+	EXPECT_EQ(cache.getOpenCount(), 0);
+	EXPECT_TRUE(opener.opened.empty());
+}
+
+GTEST_TEST(KEYDataFileCache, openConcurrently) {
+	BlockingOpener opener;
+	Aurora::KEYDataFileCache cache(opener.getOpener(), 4);
+
+	Aurora::KEYDataFileCache::DataFilePtr slow1, slow2;
+
+	boost::thread thread1([&]() { slow1 = cache.getDataFile("slow.bif"); });
+	while (!opener.slowStarted)
+		boost::this_thread::sleep_for(boost::chrono::milliseconds(1));
+
+	// Opening slow.bif must not block access to other data files
+	EXPECT_TRUE(cache.getDataFile("fast.bif"));
+
+	// A second request for slow.bif waits for the first open instead of opening it again
+	boost::thread thread2([&]() { slow2 = cache.getDataFile("slow.bif"); });
+	boost::this_thread::sleep_for(boost::chrono::milliseconds(10));
+
+	opener.slowReleased = true;
+
+	thread1.join();
+	thread2.join();
+
+	ASSERT_TRUE(slow1);
+	EXPECT_EQ(slow1, slow2);
+	EXPECT_EQ(opener.slowOpenCount, 1);
+
+	EXPECT_EQ(cache.getOpenCount(), 2);
+	EXPECT_EQ(opener.aliveCount, 2);
+}
@@ -110,6 +110,23 @@ GTEST_TEST(KEYFile10, findResourceName) {
 	EXPECT_EQ(key.findResource("nope"      , Aurora::kFileTypeBMP), 0xFFFFFFFF);
 }
 
+GTEST_TEST(KEYFile10, getResourceListForDataFile) {
+	const Aurora::KEYFile key(new Common::MemoryReadStream(kKEY10File));
+
+	const std::vector<const Aurora::Archive::Resource *> &byIndex = key.getResourceListForDataFile(0);
+	ASSERT_EQ(byIndex.size(), 1);
+	EXPECT_STREQ(byIndex[0]->name.c_str(), "ozymandias");
+	EXPECT_EQ(byIndex[0]->index, 0);
+
+	EXPECT_THROW(key.getResourceListForDataFile(1), Common::Exception);
+
+	const std::vector<const Aurora::Archive::Resource *> byName = key.getResourceListForDataFile("data/xoreos.bif");
+	ASSERT_EQ(byName.size(), 1);
+	EXPECT_EQ(byName[0], byIndex[0]);
+
+	EXPECT_TRUE(key.getResourceListForDataFile("data/nope.bif").empty());
+}
+
 // --- KEY V1.1 ---
 
 static const byte kKEY11File[] = {
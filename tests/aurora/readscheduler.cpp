@@ -0,0 +1,142 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for the batched, offset-sorted reading of archive resources.
+ */
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "src/common/system.h"
+#include "src/common/error.h"
+#include "src/common/scopedptr.h"
+#include "src/common/memreadstream.h"
+
+#include "src/aurora/archive.h"
+#include "src/aurora/readscheduler.h"
+
+#include "tests/aurora/testarchive.h"
+
+static const size_t kDataSize = 2 * 1024 * 1024;
+
+static void createData(std::vector<byte> &data) {
+	data.resize(kDataSize);
+
+	for (size_t i = 0; i < kDataSize; i++)
+		data[i] = (byte) ((i * 7) ^ (i >> 8));
+}
+
+GTEST_TEST(ReadScheduler, run) {
+	std::vector<byte> data;
+	createData(data);
+
+	TestArchive archive(&data[0], data.size());
+
+	archive.addResource(  1000,  50);        // 0: Merged with 2 and 3, despite the small gap
+	archive.addResource(1048576,  10);       // 1: Too far away from all others
+	archive.addResource(     0, 100);        // 2
+	archive.addResource(   100, 100);        // 3
+	archive.addResource(  2000, 200, false); // 4: Packed, so read by the archive, but still merged
+	archive.addResource(     0,   0);        // 5: No location, and failing
+
+	Aurora::ReadScheduler scheduler;
+	for (uint32 i = 0; i < archive.getResources().size(); i++)
+		EXPECT_EQ(scheduler.add(archive, i), i);
+
+	EXPECT_EQ(scheduler.getRequestCount(), 6);
+	EXPECT_EQ(scheduler.getReadCount(), 3);
+
+	std::vector<std::vector<byte> > results(scheduler.getRequestCount());
+	std::vector<int> handled(scheduler.getRequestCount(), 0), failed(scheduler.getRequestCount(), 0);
+
+	scheduler.run([&](size_t request, Common::SeekableReadStream *stream) {
+		Common::ScopedPtr<Common::SeekableReadStream> res(stream);
+
+		results[request].resize(res->size());
+		if (res->size() > 0)
+			res->read(&results[request][0], res->size());
+
+		handled[request]++;
+
+	}, [&](size_t request, Common::Exception &UNUSED(e)) {
+		failed[request]++;
+
+	}, 4);
+
+	static const size_t kOffsets[] = { 1000, 1048576, 0, 100, 2000 };
+	static const size_t kSizes  [] = {   50,      10, 100, 100, 200 };
+
+	for (size_t i = 0; i < ARRAYSIZE(kOffsets); i++) {
+		EXPECT_EQ(handled[i], 1) << "At request " << i;
+		EXPECT_EQ(failed [i], 0) << "At request " << i;
+
+		ASSERT_EQ(results[i].size(), kSizes[i]) << "At request " << i;
+		for (size_t j = 0; j < kSizes[i]; j++)
+			ASSERT_EQ(results[i][j], data[kOffsets[i] + j]) << "At request " << i << ", index " << j;
+	}
+
+	EXPECT_EQ(handled[5], 0);
+	EXPECT_EQ(failed [5], 1);
+}
+
+GTEST_TEST(ReadScheduler, maxReadSize) {
+	std::vector<byte> data;
+	createData(data);
+
+	TestArchive archive(&data[0], data.size());
+
+	// Back-to-back resources, spanning more than the maximum size of a read
+	const size_t size = 256 * 1024;
+	for (size_t offset = 0; (offset + size) <= kDataSize; offset += size)
+		archive.addResource(offset, size);
+
+	Aurora::ReadScheduler scheduler;
+	for (uint32 i = 0; i < archive.getResources().size(); i++)
+		scheduler.add(archive, i);
+
+	const size_t perRead = Aurora::ReadScheduler::kMaxReadSize / size;
+	EXPECT_EQ(scheduler.getReadCount(), (archive.getResources().size() + perRead - 1) / perRead);
+}
+
+GTEST_TEST(ReadScheduler, handlerThrows) {
+	std::vector<byte> data;
+	createData(data);
+
+	TestArchive archive(&data[0], data.size());
+	archive.addResource(0, 100);
+
+	Aurora::ReadScheduler scheduler;
+	scheduler.add(archive, 0);
+
+	size_t failed = 0;
+	scheduler.run([](size_t UNUSED(request), Common::SeekableReadStream *stream) {
+		delete stream;
+
+		throw Common::Exception("Nope");
+
+	}, [&failed](size_t UNUSED(request), Common::Exception &e) {
+		EXPECT_STREQ(e.what(), "Nope");
+		failed++;
+	});
+
+	EXPECT_EQ(failed, 1);
+}
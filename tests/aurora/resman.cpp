@@ -0,0 +1,196 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for the prioritized resource manager.
+ */
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "src/common/system.h"
+#include "src/common/strutil.h"
+
+#include "src/aurora/archive.h"
+#include "src/aurora/resman.h"
+
+#include "tests/aurora/testarchive.h"
+
+GTEST_TEST(ResourceManager, findResource) {
+	TestArchive key, module;
+
+	key.addResource("ozymandias", Aurora::kFileTypeTXT);
+	key.addResource("nope"      , Aurora::kFileTypeTXT);
+	module.addResource("Ozymandias", Aurora::kFileTypeTXT);
+
+	Aurora::ResourceManager resMan;
+
+	const uint32 moduleSource = resMan.addArchive(module, Aurora::kPriorityERF);
+	const uint32 keySource    = resMan.addArchive(key   , Aurora::kPriorityKEY);
+
+	EXPECT_EQ(resMan.getSourceCount(), 2);
+
+	Aurora::ResourceManager::Resource resource;
+
+	ASSERT_TRUE(resMan.findResource("OZYMANDIAS", Aurora::kFileTypeTXT, resource));
+	EXPECT_EQ(resource.source  , moduleSource);
+	EXPECT_EQ(resource.priority, (uint32) Aurora::kPriorityERF);
+	EXPECT_EQ(resource.archive , &module);
+	EXPECT_EQ(resource.index   , 0);
+
+	ASSERT_TRUE(resMan.findResource("nope", Aurora::kFileTypeTXT, resource));
+	EXPECT_EQ(resource.source , keySource);
+	EXPECT_EQ(resource.archive, &key);
+	EXPECT_EQ(resource.index  , 1);
+
+	EXPECT_FALSE(resMan.findResource("nope", Aurora::kFileTypeBMP, resource));
+	EXPECT_FALSE(resMan.hasResource("foobar", Aurora::kFileTypeTXT));
+	EXPECT_TRUE (resMan.hasResource("Nope"  , Aurora::kFileTypeTXT));
+}
+
+GTEST_TEST(ResourceManager, findAllResources) {
+	TestArchive key, rim, module, hak;
+
+	key.addResource("ozymandias", Aurora::kFileTypeTXT);
+	rim.addResource("ozymandias", Aurora::kFileTypeTXT);
+	module.addResource("ozymandias", Aurora::kFileTypeTXT);
+	hak.addResource("ozymandias", Aurora::kFileTypeTXT);
+
+	Aurora::ResourceManager resMan;
+
+	resMan.addArchive(rim   , Aurora::kPriorityRIM);
+	resMan.addArchive(hak   , Aurora::kPriorityHAK);
+	resMan.addArchive(key   , Aurora::kPriorityKEY);
+	resMan.addArchive(module, Aurora::kPriorityERF);
+
+	const Aurora::ResourceManager::ResourceList resources =
+		resMan.findAllResources("ozymandias", Aurora::kFileTypeTXT);
+
+	ASSERT_EQ(resources.size(), 4);
+	EXPECT_EQ(resources[0].archive, &hak);
+	EXPECT_EQ(resources[1].archive, &module);
+	EXPECT_EQ(resources[2].archive, &rim);
+	EXPECT_EQ(resources[3].archive, &key);
+
+	EXPECT_EQ(resMan.getShadowedCount("ozymandias", Aurora::kFileTypeTXT), 3);
+	EXPECT_EQ(resMan.getShadowedCount("foobar"    , Aurora::kFileTypeTXT), 0);
+
+	EXPECT_TRUE(resMan.findAllResources("foobar", Aurora::kFileTypeTXT).empty());
+}
+
+GTEST_TEST(ResourceManager, samePriority) {
+	TestArchive first, second;
+
+	first.addResource("ozymandias", Aurora::kFileTypeTXT);
+	second.addResource("ozymandias", Aurora::kFileTypeTXT);
+
+	Aurora::ResourceManager resMan;
+
+	resMan.addArchive(first , Aurora::kPriorityERF);
+	resMan.addArchive(second, Aurora::kPriorityERF);
+
+	Aurora::ResourceManager::Resource resource;
+
+	ASSERT_TRUE(resMan.findResource("ozymandias", Aurora::kFileTypeTXT, resource));
+	EXPECT_EQ(resource.archive, &second);
+}
+
+GTEST_TEST(ResourceManager, removeSource) {
+	TestArchive key, module;
+
+	key.addResource("ozymandias", Aurora::kFileTypeTXT);
+	key.addResource("nope"      , Aurora::kFileTypeTXT);
+	module.addResource("ozymandias", Aurora::kFileTypeTXT);
+
+	Aurora::ResourceManager resMan;
+
+	const uint32 keySource    = resMan.addArchive(key   , Aurora::kPriorityKEY);
+	const uint32 moduleSource = resMan.addArchive(module, Aurora::kPriorityERF);
+
+	Aurora::ResourceManager::Resource resource;
+
+	resMan.removeSource(moduleSource);
+	EXPECT_EQ(resMan.getSourceCount(), 1);
+
+	ASSERT_TRUE(resMan.findResource("ozymandias", Aurora::kFileTypeTXT, resource));
+	EXPECT_EQ(resource.archive, &key);
+	EXPECT_EQ(resMan.getShadowedCount("ozymandias", Aurora::kFileTypeTXT), 0);
+
+	resMan.removeSource(keySource);
+	EXPECT_EQ(resMan.getSourceCount(), 0);
+
+	EXPECT_FALSE(resMan.hasResource("ozymandias", Aurora::kFileTypeTXT));
+	EXPECT_FALSE(resMan.hasResource("nope"      , Aurora::kFileTypeTXT));
+
+	// Removing a source that doesn't exist is fine
+	resMan.removeSource(keySource);
+}
+
+GTEST_TEST(ResourceManager, addFiles) {
+	TestArchive module;
+
+	module.addResource("ozymandias", Aurora::kFileTypeTXT);
+
+	Aurora::ResourceManager resMan;
+
+	resMan.addArchive(module, Aurora::kPriorityERF);
+
+	std::vector<Common::UString> files;
+	files.push_back("/game/override/ozymandias.txt");
+	files.push_back("/game/override/texture.tga");
+
+	const uint32 overrideSource = resMan.addFiles(files, Aurora::kPriorityOverride);
+
+	Aurora::ResourceManager::Resource resource;
+
+	ASSERT_TRUE(resMan.findResource("ozymandias", Aurora::kFileTypeTXT, resource));
+	EXPECT_EQ(resource.source , overrideSource);
+	EXPECT_EQ(resource.archive, (const Aurora::Archive *) 0);
+	EXPECT_EQ(resource.path   , "/game/override/ozymandias.txt");
+
+	ASSERT_TRUE(resMan.findResource("texture", Aurora::kFileTypeTGA, resource));
+	EXPECT_EQ(resource.path, "/game/override/texture.tga");
+
+	resMan.removeSource(overrideSource);
+
+	ASSERT_TRUE(resMan.findResource("ozymandias", Aurora::kFileTypeTXT, resource));
+	EXPECT_EQ(resource.archive, &module);
+	EXPECT_FALSE(resMan.hasResource("texture", Aurora::kFileTypeTGA));
+}
+
+GTEST_TEST(ResourceManager, hashedNames) {
+	TestArchive archive;
+
+	archive.addResource("", Aurora::kFileTypeTXT, 0x1234);
+
+	Aurora::ResourceManager resMan;
+
+	resMan.addArchive(archive, Aurora::kPriorityERF);
+
+	EXPECT_TRUE(resMan.hasResource(Common::composeString<uint64>(0x1234), Aurora::kFileTypeTXT));
+}
+
+GTEST_TEST(ResourceManager, getArchivePriority) {
+	EXPECT_EQ(Aurora::ResourceManager::getArchivePriority(Aurora::kFileTypeKEY), (uint32) Aurora::kPriorityKEY);
+	EXPECT_EQ(Aurora::ResourceManager::getArchivePriority(Aurora::kFileTypeRIM), (uint32) Aurora::kPriorityRIM);
+	EXPECT_EQ(Aurora::ResourceManager::getArchivePriority(Aurora::kFileTypeMOD), (uint32) Aurora::kPriorityERF);
+	EXPECT_EQ(Aurora::ResourceManager::getArchivePriority(Aurora::kFileTypeHAK), (uint32) Aurora::kPriorityHAK);
+}
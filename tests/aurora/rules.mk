@@ -26,11 +26,33 @@ aurora_LIBS = \
     tests/version/libversion.la \
     $(LDADD)
 
+noinst_HEADERS += tests/aurora/testarchive.h
+
 check_PROGRAMS                 += tests/aurora/test_util
 tests_aurora_test_util_SOURCES  = tests/aurora/util.cpp
 tests_aurora_test_util_LDADD    = $(aurora_LIBS)
 tests_aurora_test_util_CXXFLAGS = $(test_CXXFLAGS)
 
+check_PROGRAMS                    += tests/aurora/test_archive
+tests_aurora_test_archive_SOURCES  = tests/aurora/archive.cpp
+tests_aurora_test_archive_LDADD    = $(aurora_LIBS)
+tests_aurora_test_archive_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                   += tests/aurora/test_resman
+tests_aurora_test_resman_SOURCES  = tests/aurora/resman.cpp
+tests_aurora_test_resman_LDADD    = $(aurora_LIBS)
+tests_aurora_test_resman_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                          += tests/aurora/test_readscheduler
+tests_aurora_test_readscheduler_SOURCES  = tests/aurora/readscheduler.cpp
+tests_aurora_test_readscheduler_LDADD    = $(aurora_LIBS)
+tests_aurora_test_readscheduler_CXXFLAGS = $(test_CXXFLAGS)
+
+BENCHMARKS                         += tests/aurora/bench_archive
+tests_aurora_bench_archive_SOURCES  = tests/aurora/bench_archive.cpp
+tests_aurora_bench_archive_LDADD    = $(aurora_LIBS)
+tests_aurora_bench_archive_CXXFLAGS = $(test_CXXFLAGS)
+
 check_PROGRAMS                     += tests/aurora/test_language
 tests_aurora_test_language_SOURCES  = tests/aurora/language.cpp
 tests_aurora_test_language_LDADD    = $(aurora_LIBS)
@@ -70,3 +92,13 @@ check_PROGRAMS                    += tests/aurora/test_erffile
 tests_aurora_test_erffile_SOURCES  = tests/aurora/erffile.cpp
 tests_aurora_test_erffile_LDADD    = $(aurora_LIBS)
 tests_aurora_test_erffile_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                       += tests/aurora/test_indexcache
+tests_aurora_test_indexcache_SOURCES  = tests/aurora/indexcache.cpp
+tests_aurora_test_indexcache_LDADD    = $(aurora_LIBS)
+tests_aurora_test_indexcache_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                              += tests/aurora/test_keydatafilecache
+tests_aurora_test_keydatafilecache_SOURCES  = tests/aurora/keydatafilecache.cpp
+tests_aurora_test_keydatafilecache_LDADD    = $(aurora_LIBS)
+tests_aurora_test_keydatafilecache_CXXFLAGS = $(test_CXXFLAGS)
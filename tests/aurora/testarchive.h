@@ -0,0 +1,115 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+/** @file
+ *  An archive for unit tests, included by the various Aurora archive tests.
+ */
+
+#ifndef TESTS_AURORA_TESTARCHIVE_H
+#define TESTS_AURORA_TESTARCHIVE_H
+
+#include <vector>
+
+#include "src/common/types.h"
+#include "src/common/system.h"
+#include "src/common/error.h"
+#include "src/common/ustring.h"
+#include "src/common/hash.h"
+#include "src/common/memreadstream.h"
+
+#include "src/aurora/types.h"
+#include "src/aurora/archive.h"
+
+/** An archive with a fixed list of resources.
+ *
+ *  Resources are either added by name, in which case they don't have any
+ *  data, or by their location within the data given to the constructor.
+ */
+class TestArchive : public Aurora::Archive {
+public:
+	TestArchive(Common::HashAlgo hashAlgo = Common::kHashNone) : _hashAlgo(hashAlgo), _data(static_cast<const byte *>(0), 0) {
+	}
+
+	TestArchive(const byte *data, size_t size) : _hashAlgo(Common::kHashNone), _data(data, size) {
+	}
+
+	/** Add a resource without data, hashing its name with the archive's hash algorithm. */
+	void addResource(const Common::UString &name, Aurora::FileType type) {
+		addResource(name, type, Common::hashString(name, _hashAlgo));
+	}
+
+	/** Add a resource without data, with an explicit name hash. */
+	void addResource(const Common::UString &name, Aurora::FileType type, uint64 hash) {
+		_resources.push_back(Resource());
+
+		_resources.back().name  = name;
+		_resources.back().type  = type;
+		_resources.back().hash  = hash;
+		_resources.back().index = _resources.size() - 1;
+
+		_locations.push_back(Location());
+	}
+
+	/** Add a resource within the data. Resources with a size of 0 don't have a location, and can't be read. */
+	void addResource(size_t offset, size_t size, bool raw = true) {
+		_resources.push_back(Resource());
+		_resources.back().index = _resources.size() - 1;
+
+		Location location;
+
+		location.stream = &_data;
+		location.offset = offset;
+		location.size   = size;
+		location.raw    = raw;
+
+		_locations.push_back(location);
+	}
+
+	const ResourceList &getResources() const {
+		return _resources;
+	}
+
+	Common::SeekableReadStream *getResource(uint32 index, bool UNUSED(tryNoCopy)) const {
+		const Location &location = _locations.at(index);
+		if (location.size == 0)
+			throw Common::Exception("No data for resource %u", index);
+
+		return _data.readStreamAt(location.offset, location.size);
+	}
+
+	bool getResourceLocation(uint32 index, Location &location) const {
+		location = _locations.at(index);
+
+		return location.size != 0;
+	}
+
+	Common::HashAlgo getNameHashAlgo() const {
+		return _hashAlgo;
+	}
+
+private:
+	Common::HashAlgo _hashAlgo;
+
+	mutable Common::MemoryReadStream _data;
+
+	ResourceList _resources;
+	std::vector<Location> _locations;
+};
+
+#endif // TESTS_AURORA_TESTARCHIVE_H
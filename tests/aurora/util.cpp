@@ -39,3 +39,17 @@ GTEST_TEST(AuroraUtil, getFileType) {
 
 	destroyTypeMan();
 }
+
+GTEST_TEST(AuroraUtil, ResourceKey) {
+	const Aurora::ResourceKey key("Ozymandias", Aurora::kFileTypeTXT);
+
+	EXPECT_TRUE (key == Aurora::ResourceKey("ozymandias", Aurora::kFileTypeTXT));
+	EXPECT_TRUE (key == Aurora::ResourceKey("OZYMANDIAS", Aurora::kFileTypeTXT));
+	EXPECT_FALSE(key == Aurora::ResourceKey("ozymandias", Aurora::kFileTypeBMP));
+	EXPECT_FALSE(key == Aurora::ResourceKey("ozymandia" , Aurora::kFileTypeTXT));
+
+	const Aurora::hashResourceKey hash;
+
+	EXPECT_EQ(hash(key), hash(Aurora::ResourceKey("OZYMANDIAS", Aurora::kFileTypeTXT)));
+	EXPECT_NE(hash(key), hash(Aurora::ResourceKey("Ozymandias", Aurora::kFileTypeBMP)));
+}
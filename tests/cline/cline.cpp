@@ -0,0 +1,107 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+/** @file
+ *  Unit tests for the command line handling.
+ */
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "src/common/ustring.h"
+
+#include "src/cline.h"
+
+static Job parse(const std::vector<Common::UString> &args) {
+	std::vector<Common::UString> argv;
+
+	argv.push_back("phaethon");
+	argv.insert(argv.end(), args.begin(), args.end());
+
+	return parseCommandLine(argv);
+}
+
+GTEST_TEST(CommandLine, path) {
+	const Job job = parse({ "/path/to/game" });
+
+	EXPECT_EQ(job.operation, kOperationPath);
+	EXPECT_STREQ(job.path.c_str(), "/path/to/game");
+
+	EXPECT_EQ(parse({ }).operation, kOperationPath);
+	EXPECT_EQ(parse({ "a", "b" }).operation, kOperationInvalid);
+}
+
+GTEST_TEST(CommandLine, helpVersion) {
+	EXPECT_EQ(parse({ "-h" }).operation, kOperationHelp);
+	EXPECT_EQ(parse({ "--help" }).operation, kOperationHelp);
+	EXPECT_EQ(parse({ "-v" }).operation, kOperationVersion);
+	EXPECT_EQ(parse({ "--version" }).operation, kOperationVersion);
+}
+
+GTEST_TEST(CommandLine, extractDefaults) {
+	const Job job = parse({ "extract", "/path/to/game" });
+
+	EXPECT_EQ(job.operation, kOperationExtract);
+	EXPECT_STREQ(job.path.c_str(), "/path/to/game");
+	EXPECT_STREQ(job.outPath.c_str(), ".");
+	EXPECT_EQ(job.extractMode, kExtractModeRaw);
+	EXPECT_EQ(job.threadCount, 0U);
+	EXPECT_TRUE(job.filters.empty());
+}
+
+GTEST_TEST(CommandLine, extractOptions) {
+	const Job job = parse({ "extract", "-o", "out", "--filter", "*.tga", "-f", "*.dds",
+	                        "--mode", "tga", "-j", "4", "/path/to/game" });
+
+	EXPECT_EQ(job.operation, kOperationExtract);
+	EXPECT_STREQ(job.path.c_str(), "/path/to/game");
+	EXPECT_STREQ(job.outPath.c_str(), "out");
+	EXPECT_EQ(job.extractMode, kExtractModeTGA);
+	EXPECT_EQ(job.threadCount, 4U);
+
+	ASSERT_EQ(job.filters.size(), 2U);
+	EXPECT_STREQ(job.filters[0].c_str(), "*.tga");
+	EXPECT_STREQ(job.filters[1].c_str(), "*.dds");
+
+	EXPECT_EQ(parse({ "extract", "-m", "raw", "x" }).extractMode, kExtractModeRaw);
+	EXPECT_EQ(parse({ "extract", "-m", "wav", "x" }).extractMode, kExtractModeWAV);
+}
+
+GTEST_TEST(CommandLine, extractHelp) {
+	EXPECT_EQ(parse({ "extract", "-h" }).operation, kOperationHelp);
+	EXPECT_EQ(parse({ "extract", "x", "--help" }).operation, kOperationHelp);
+}
+
+GTEST_TEST(CommandLine, extractInvalid) {
+	// Nothing to extract
+	EXPECT_EQ(parse({ "extract" }).operation, kOperationInvalid);
+	EXPECT_EQ(parse({ "extract", "-o", "out" }).operation, kOperationInvalid);
+
+	// Two paths
+	EXPECT_EQ(parse({ "extract", "a", "b" }).operation, kOperationInvalid);
+
+	// Unknown options and values
+	EXPECT_EQ(parse({ "extract", "--foo", "x" }).operation, kOperationInvalid);
+	EXPECT_EQ(parse({ "extract", "-m", "mp3", "x" }).operation, kOperationInvalid);
+	EXPECT_EQ(parse({ "extract", "-j", "many", "x" }).operation, kOperationInvalid);
+
+	// An option missing its value
+	EXPECT_EQ(parse({ "extract", "x", "-o" }).operation, kOperationInvalid);
+}
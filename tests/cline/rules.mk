@@ -0,0 +1,31 @@
+# Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+#
+# Phaethon is the legal property of its developers, whose names
+# can be found in the AUTHORS file distributed with this source
+# distribution.
+#
+# Phaethon is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License
+# as published by the Free Software Foundation; either version 3
+# of the License, or (at your option) any later version.
+#
+# Phaethon is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+
+# Unit tests for the command line handling.
+
+cline_LIBS = \
+    $(test_LIBS) \
+    src/common/libcommon.la \
+    tests/version/libversion.la \
+    $(LDADD)
+
+check_PROGRAMS                 += tests/cline/test_cline
+tests_cline_test_cline_SOURCES  = tests/cline/cline.cpp src/cline.cpp
+tests_cline_test_cline_LDADD    = $(cline_LIBS)
+tests_cline_test_cline_CXXFLAGS = $(test_CXXFLAGS)
@@ -0,0 +1,146 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Benchmark for our Blowfish implementation.
+ *
+ *  Encrypts and decrypts a few MB of data, and prints the throughput in
+ *  MB/s. As a baseline, the same data is also processed one block at a
+ *  time. Then, many small pieces are decrypted with the same key, which
+ *  only expands the key once, and with changing keys.
+ */
+
+#include <cstdio>
+
+#include <vector>
+
+#include <boost/chrono.hpp>
+
+#include "gtest/gtest.h"
+
+#include "src/common/util.h"
+#include "src/common/scopedptr.h"
+#include "src/common/memreadstream.h"
+#include "src/common/blowfish.h"
+
+static const size_t kDataSize   = 16 * 1024 * 1024;
+static const size_t kPieceSize  = 512;
+static const size_t kPieceCount = 4096;
+
+static void createData(std::vector<byte> &data, size_t size) {
+	data.resize(size);
+
+	uint32 seed = 0xB10F15;
+	for (size_t i = 0; i < size; i++) {
+		seed = seed * 1103515245 + 12345;
+		data[i] = seed >> 24;
+	}
+}
+
+static void createKey(std::vector<byte> &key, uint32 n) {
+	key.resize(16);
+
+	for (size_t i = 0; i < key.size(); i++)
+		key[i] = (byte) (n + i * 7);
+}
+
+static double getSeconds(const boost::chrono::steady_clock::time_point &start) {
+	const boost::chrono::duration<double> elapsed = boost::chrono::steady_clock::now() - start;
+
+	return MAX(elapsed.count(), 1e-9);
+}
+
+/** Decrypt one block at a time, as a reference. */
+static double decryptBlocks(std::vector<byte> &data, const std::vector<byte> &key) {
+	const boost::chrono::steady_clock::time_point start = boost::chrono::steady_clock::now();
+
+	for (size_t i = 0; i < data.size(); i += 8)
+		Common::decryptBlowfishEBC(&data[i], 8, key);
+
+	return getSeconds(start);
+}
+
+static double decryptBuffer(std::vector<byte> &data, const std::vector<byte> &key) {
+	const boost::chrono::steady_clock::time_point start = boost::chrono::steady_clock::now();
+
+	Common::decryptBlowfishEBC(&data[0], data.size(), key);
+
+	return getSeconds(start);
+}
+
+GTEST_TEST(BlowfishBenchmark, buffer) {
+	std::vector<byte> clearText;
+	createData(clearText, kDataSize);
+
+	std::vector<byte> key;
+	createKey(key, 0);
+
+	std::vector<byte> cipherText = clearText;
+	Common::encryptBlowfishEBC(&cipherText[0], cipherText.size(), key);
+
+	std::vector<byte> referenceData = cipherText, data = cipherText;
+
+	const double referenceTime = decryptBlocks(referenceData, key);
+	const double time          = decryptBuffer(data         , key);
+
+	ASSERT_EQ(referenceData, clearText);
+	ASSERT_EQ(data         , clearText);
+
+	const double megaBytes = kDataSize / (1024.0 * 1024.0);
+
+	std::printf("Single blocks: %8.2f MB/s\n", megaBytes / referenceTime);
+	std::printf("Buffer:        %8.2f MB/s\n", megaBytes / time);
+}
+
+GTEST_TEST(BlowfishBenchmark, keySchedule) {
+	std::vector<byte> clearText;
+	createData(clearText, kPieceSize);
+
+	std::vector<std::vector<byte> > keys(kPieceCount);
+	for (size_t i = 0; i < kPieceCount; i++)
+		createKey(keys[i], i);
+
+	std::vector<byte> data;
+
+	boost::chrono::steady_clock::time_point start = boost::chrono::steady_clock::now();
+
+	for (size_t i = 0; i < kPieceCount; i++) {
+		data = clearText;
+		Common::decryptBlowfishEBC(&data[0], data.size(), keys[0]);
+	}
+
+	const double sameKeyTime = getSeconds(start);
+
+	start = boost::chrono::steady_clock::now();
+
+	for (size_t i = 0; i < kPieceCount; i++) {
+		data = clearText;
+		Common::decryptBlowfishEBC(&data[0], data.size(), keys[i]);
+	}
+
+	const double changingKeyTime = getSeconds(start);
+
+	// Make sure the cached key schedule is the right one
+	Common::encryptBlowfishEBC(&data[0], data.size(), keys[kPieceCount - 1]);
+	ASSERT_EQ(data, clearText);
+
+	std::printf("Same key:      %8.0f pieces/s\n", kPieceCount / sameKeyTime);
+	std::printf("Changing keys: %8.0f pieces/s\n", kPieceCount / changingKeyTime);
+}
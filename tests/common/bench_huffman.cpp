@@ -0,0 +1,145 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Benchmark for our Huffman decoder.
+ *
+ *  Decodes a few MB of Huffman'd data with codes of between 5 and 20
+ *  bits, similar to the WMA coefficient tables, and prints the number
+ *  of decoded symbols per second. As a baseline, the same data is also
+ *  decoded by a straight-forward reference decoder, reading one bit at
+ *  a time and searching through all codes of the current length.
+ */
+
+#include <cstdio>
+
+#include <vector>
+#include <list>
+
+#include <boost/chrono.hpp>
+
+#include "gtest/gtest.h"
+
+#include "src/common/huffman.h"
+#include "src/common/util.h"
+#include "src/common/memreadstream.h"
+#include "src/common/bitstream.h"
+
+static const size_t kDataSize = 2 * 1024 * 1024;
+
+/** A complete canonical Huffman code: 16 codes of each length from 5 to 19, and 32 codes of length 20. */
+static void createCodes(std::vector<uint32> &codes, std::vector<uint8> &lengths) {
+	uint32 code = 0;
+	for (uint8 length = 5; length <= 20; length++) {
+		const size_t count = (length == 20) ? 32 : 16;
+
+		for (size_t i = 0; i < count; i++) {
+			codes.push_back(code++);
+			lengths.push_back(length);
+		}
+
+		code <<= 1;
+	}
+}
+
+/** Random data. Since the code is complete, any data is a valid stream of codes. */
+static void createData(std::vector<byte> &data) {
+	data.resize(kDataSize);
+
+	uint32 seed = 0xC0FFEE;
+	for (size_t i = 0; i < kDataSize; i++) {
+		seed = seed * 1103515245 + 12345;
+		data[i] = seed >> 16;
+	}
+}
+
+/** A reference decoder, reading bit by bit, with a linear search through the codes of each length. */
+class ReferenceHuffman {
+public:
+	ReferenceHuffman(const std::vector<uint32> &codes, const std::vector<uint8> &lengths) {
+		for (size_t i = 0; i < codes.size(); i++) {
+			if (_codes.size() < lengths[i])
+				_codes.resize(lengths[i]);
+
+			_codes[lengths[i] - 1].push_back(std::make_pair(codes[i], (uint32) i));
+		}
+	}
+
+	uint32 getSymbol(Common::BitStream &bits) const {
+		uint32 code = 0;
+
+		for (size_t i = 0; i < _codes.size(); i++) {
+			bits.addBit(code, i);
+
+			for (CodeList::const_iterator c = _codes[i].begin(); c != _codes[i].end(); ++c)
+				if (code == c->first)
+					return c->second;
+		}
+
+		throw Common::Exception("Unknown Huffman code");
+	}
+
+private:
+	typedef std::list<std::pair<uint32, uint32> > CodeList;
+
+	std::vector<CodeList> _codes;
+};
+
+template<class Decoder>
+static double decode(const Decoder &huffman, const std::vector<byte> &data, std::vector<uint32> &symbols) {
+	Common::MemoryReadStream byteStream(&data[0], data.size());
+	Common::BitStream8MSB    bitStream (byteStream);
+
+	symbols.clear();
+
+	const boost::chrono::steady_clock::time_point start = boost::chrono::steady_clock::now();
+
+	// Stop before the end, since the last code might be cut off
+	while ((bitStream.size() - bitStream.pos()) >= 20)
+		symbols.push_back(huffman.getSymbol(bitStream));
+
+	const boost::chrono::duration<double> elapsed = boost::chrono::steady_clock::now() - start;
+
+	return elapsed.count();
+}
+
+GTEST_TEST(HuffmanBenchmark, getSymbol) {
+	std::vector<uint32> codes;
+	std::vector<uint8>  lengths;
+	createCodes(codes, lengths);
+
+	std::vector<byte> data;
+	createData(data);
+
+	const ReferenceHuffman reference(codes, lengths);
+	const Common::Huffman  huffman(0, codes.size(), &codes[0], &lengths[0]);
+
+	std::vector<uint32> referenceSymbols, symbols;
+
+	const double referenceTime = decode(reference, data, referenceSymbols);
+	const double time          = decode(huffman  , data, symbols);
+
+	ASSERT_EQ(symbols.size(), referenceSymbols.size());
+	for (size_t i = 0; i < symbols.size(); i++)
+		ASSERT_EQ(symbols[i], referenceSymbols[i]) << "At index " << i;
+
+	std::printf("Reference decoder: %10.0f symbols/s\n", referenceSymbols.size() / MAX(referenceTime, 1e-9));
+	std::printf("Huffman decoder:   %10.0f symbols/s\n", symbols.size() / MAX(time, 1e-9));
+}
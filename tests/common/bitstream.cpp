@@ -192,3 +192,133 @@ GTEST_TEST(BitStream, BitStream64BELSB) {
 
 	testBitStream(bitStream, compValues);
 }
+
+/** Read bit n of this data, as a bit stream with this layout, one bit at a time. */
+static uint32 getReferenceBit(const byte *data, size_t n, int valueBits, bool isLE, bool isMSB2LSB) {
+	const size_t valueBytes = valueBits / 8;
+	const byte  *valueData  = data + (n / valueBits) * valueBytes;
+
+	uint64 value = 0;
+	for (size_t i = 0; i < valueBytes; i++)
+		value |= ((uint64) valueData[isLE ? i : (valueBytes - 1 - i)]) << (i * 8);
+
+	const size_t bit = n % valueBits;
+
+	return (value >> (isMSB2LSB ? (valueBits - 1 - bit) : bit)) & 1;
+}
+
+/** Read n bits of this data, starting at bit pos, one bit at a time. */
+static uint32 getReferenceBits(const byte *data, size_t pos, size_t n, int valueBits, bool isLE, bool isMSB2LSB) {
+	uint32 v = 0;
+
+	for (size_t i = 0; i < n; i++) {
+		const uint32 b = getReferenceBit(data, pos + i, valueBits, isLE, isMSB2LSB);
+
+		if (isMSB2LSB)
+			v = (v << 1) | b;
+		else
+			v |= b << i;
+	}
+
+	return v;
+}
+
+/** Compare reading, peeking and skipping mixed bit counts against the bit-by-bit reference. */
+template<int valueBits, bool isLE, bool isMSB2LSB>
+static void testBulkBits(bool inMemory) {
+	static const size_t kDataSize = 10000;
+
+	byte data[kDataSize];
+
+	uint32 seed = 0x1234;
+	for (size_t i = 0; i < kDataSize; i++) {
+		seed = seed * 1103515245 + 12345;
+		data[i] = seed >> 16;
+	}
+
+	Common::MemoryReadStream memStream(data);
+	Common::SeekableSubReadStream subStream(&memStream, 0, kDataSize);
+
+	Common::BitStreamImpl<valueBits, isLE, isMSB2LSB> bitStream(inMemory ?
+			static_cast<Common::SeekableReadStream &>(memStream) : static_cast<Common::SeekableReadStream &>(subStream));
+
+	ASSERT_EQ(bitStream.size(), kDataSize * 8);
+
+	size_t pos = 0, step = 0;
+	while ((bitStream.size() - pos) > 4096) {
+		const size_t n = (step++ * 7) % 33;
+
+		ASSERT_EQ(bitStream.pos(), pos);
+
+		const uint32 v = getReferenceBits(data, pos, n, valueBits, isLE, isMSB2LSB);
+
+		ASSERT_EQ(bitStream.peekBits(n), v) << "At " << pos << ", " << n;
+
+		if ((step % 5) == 0) {
+			bitStream.skip(n);
+		} else {
+			ASSERT_EQ(bitStream.getBits(n), v) << "At " << pos << ", " << n;
+		}
+
+		pos += n;
+
+		if ((step % 97) == 0) {
+			bitStream.skip(1000 + step);
+			pos += 1000 + step;
+		}
+	}
+
+	const size_t rest = bitStream.size() - bitStream.pos();
+	bitStream.skip(rest - 3);
+
+	// Reading past the end fails, peeking past the end pads with 0
+	const uint32 last = getReferenceBits(data, bitStream.size() - 3, 3, valueBits, isLE, isMSB2LSB);
+	if (isMSB2LSB)
+		EXPECT_EQ(bitStream.peekBits(8), last << 5);
+	else
+		EXPECT_EQ(bitStream.peekBits(8), last);
+
+	EXPECT_THROW(bitStream.getBits(4), Common::Exception);
+	EXPECT_EQ(bitStream.getBits(3), last);
+	EXPECT_TRUE(bitStream.eos());
+
+	EXPECT_THROW(bitStream.skip(1), Common::Exception);
+
+	bitStream.rewind();
+	EXPECT_EQ(bitStream.pos(), 0);
+	EXPECT_EQ(bitStream.getBits(32), getReferenceBits(data, 0, 32, valueBits, isLE, isMSB2LSB));
+}
+
+GTEST_TEST(BitStream, bulkBitsMemory) {
+	testBulkBits< 8, false, true >(true);
+	testBulkBits< 8, false, false>(true);
+	testBulkBits<16, true , true >(true);
+	testBulkBits<16, true , false>(true);
+	testBulkBits<16, false, true >(true);
+	testBulkBits<16, false, false>(true);
+	testBulkBits<32, true , true >(true);
+	testBulkBits<32, true , false>(true);
+	testBulkBits<32, false, true >(true);
+	testBulkBits<32, false, false>(true);
+	testBulkBits<64, true , true >(true);
+	testBulkBits<64, true , false>(true);
+	testBulkBits<64, false, true >(true);
+	testBulkBits<64, false, false>(true);
+}
+
+GTEST_TEST(BitStream, bulkBitsStream) {
+	testBulkBits< 8, false, true >(false);
+	testBulkBits< 8, false, false>(false);
+	testBulkBits<16, true , true >(false);
+	testBulkBits<16, true , false>(false);
+	testBulkBits<16, false, true >(false);
+	testBulkBits<16, false, false>(false);
+	testBulkBits<32, true , true >(false);
+	testBulkBits<32, true , false>(false);
+	testBulkBits<32, false, true >(false);
+	testBulkBits<32, false, false>(false);
+	testBulkBits<64, true , true >(false);
+	testBulkBits<64, true , false>(false);
+	testBulkBits<64, false, true >(false);
+	testBulkBits<64, false, false>(false);
+}
@@ -22,12 +22,15 @@
  *  Unit tests for our Blowfish implementation.
  */
 
+#include <cstring>
+
 #include <vector>
 
 #include "gtest/gtest.h"
 
 #include "src/common/util.h"
 #include "src/common/error.h"
+#include "src/common/scopedptr.h"
 #include "src/common/memreadstream.h"
 #include "src/common/blowfish.h"
 
@@ -81,3 +84,173 @@ GTEST_TEST(Blowfish, misalign) {
 
 	EXPECT_THROW(Common::decryptBlowfishEBC(cipherText, key), Common::Exception);
 }
+
+GTEST_TEST(Blowfish, encryptBuffer) {
+	byte data[ARRAYSIZE(kCypherText)] = { 0 };
+	std::memcpy(data, kClearText, ARRAYSIZE(kClearText));
+
+	std::vector<byte> key;
+	createKey(key);
+
+	Common::encryptBlowfishEBC(data, sizeof(data), key);
+
+	for (size_t i = 0; i < ARRAYSIZE(kCypherText); i++)
+		EXPECT_EQ(data[i], kCypherText[i]) << "At index " << i;
+}
+
+GTEST_TEST(Blowfish, decryptBuffer) {
+	byte data[ARRAYSIZE(kCypherText)];
+	std::memcpy(data, kCypherText, ARRAYSIZE(kCypherText));
+
+	std::vector<byte> key;
+	createKey(key);
+
+	Common::decryptBlowfishEBC(data, sizeof(data), key);
+
+	for (size_t i = 0; i < ARRAYSIZE(kClearText); i++)
+		EXPECT_EQ(data[i], kClearText[i]) << "At index " << i;
+}
+
+GTEST_TEST(Blowfish, misalignBuffer) {
+	byte data[ARRAYSIZE(kCypherText)];
+	std::memcpy(data, kCypherText, ARRAYSIZE(kCypherText));
+
+	std::vector<byte> key;
+	createKey(key);
+
+	EXPECT_THROW(Common::decryptBlowfishEBC(data, 7, key), Common::Exception);
+}
+
+GTEST_TEST(Blowfish, largeBuffer) {
+	// Large enough to be split across threads, with a few blocks that don't fill all lanes
+	std::vector<byte> clearText(3 * 1024 * 1024 + 3 * 8);
+
+	uint32 seed = 0xB10F15;
+	for (size_t i = 0; i < clearText.size(); i++) {
+		seed = seed * 1103515245 + 12345;
+		clearText[i] = seed >> 24;
+	}
+
+	std::vector<byte> key;
+	createKey(key);
+
+	std::vector<byte> data = clearText;
+	Common::encryptBlowfishEBC(&data[0], data.size(), key);
+
+	// Compare a sample of blocks against the single block encryption
+	for (size_t i = 0; i < data.size(); i += 4099 * 8) {
+		Common::MemoryReadStream clearBlock(&clearText[i], 8);
+		Common::ScopedPtr<Common::MemoryReadStream> cipherBlock(Common::encryptBlowfishEBC(clearBlock, key));
+
+		for (size_t j = 0; j < 8; j++)
+			ASSERT_EQ(data[i + j], cipherBlock->readByte()) << "At index " << (i + j);
+	}
+
+	Common::decryptBlowfishEBC(&data[0], data.size(), key);
+
+	for (size_t i = 0; i < data.size(); i++)
+		ASSERT_EQ(data[i], clearText[i]) << "At index " << i;
+}
+
+/** Create clear text spanning several chunks of a BlowfishReadStream, and encrypt it. */
+static void createLargeText(std::vector<byte> &clearText, Common::ScopedPtr<Common::MemoryReadStream> &cipherText) {
+	clearText.resize(5 * 4096 + 7 * 8);
+
+	uint32 seed = 0xB10F15;
+	for (size_t i = 0; i < clearText.size(); i++) {
+		seed = seed * 1103515245 + 12345;
+		clearText[i] = seed >> 24;
+	}
+
+	std::vector<byte> key;
+	createKey(key);
+
+	Common::MemoryReadStream clearStream(&clearText[0], clearText.size());
+	cipherText.reset(Common::encryptBlowfishEBC(clearStream, key));
+}
+
+GTEST_TEST(BlowfishReadStream, read) {
+	Common::MemoryReadStream cipherText(kCypherText);
+
+	std::vector<byte> key;
+	createKey(key);
+
+	Common::BlowfishReadStream clearText(&cipherText, key, false);
+	ASSERT_EQ(clearText.size(), ARRAYSIZE(kCypherText));
+
+	for (size_t i = 0; i < ARRAYSIZE(kClearText); i++)
+		EXPECT_EQ(clearText.readByte(), kClearText[i]) << "At index " << i;
+
+	EXPECT_EQ(clearText.pos(), ARRAYSIZE(kClearText));
+	EXPECT_FALSE(clearText.eos());
+
+	byte buffer[16];
+	EXPECT_EQ(clearText.read(buffer, sizeof(buffer)), ARRAYSIZE(kCypherText) - ARRAYSIZE(kClearText));
+	EXPECT_TRUE(clearText.eos());
+}
+
+GTEST_TEST(BlowfishReadStream, misalign) {
+	Common::MemoryReadStream cipherText(kCypherText, 7);
+
+	std::vector<byte> key;
+	createKey(key);
+
+	EXPECT_THROW(Common::BlowfishReadStream(&cipherText, key, false), Common::Exception);
+}
+
+GTEST_TEST(BlowfishReadStream, readAt) {
+	std::vector<byte> clearText;
+	Common::ScopedPtr<Common::MemoryReadStream> cipherText;
+	createLargeText(clearText, cipherText);
+
+	std::vector<byte> key;
+	createKey(key);
+
+	Common::BlowfishReadStream stream(cipherText.get(), key, false);
+	ASSERT_EQ(stream.size(), clearText.size());
+
+	// Unaligned reads within chunks, across chunk boundaries and across several whole chunks
+	static const size_t kReads[][2] = {
+		{    0,     1 }, {    3,    17 }, { 4090,    12 }, { 8191,     1 },
+		{ 4096,  4096 }, {  100, 12000 }, {    0, 20536 }, { 20530,   50 },
+		{ 5000,     3 }, { 4097,  8191 }
+	};
+
+	std::vector<byte> buffer;
+	for (size_t i = 0; i < ARRAYSIZE(kReads); i++) {
+		const size_t offset = kReads[i][0];
+		const size_t size   = MIN<size_t>(kReads[i][1], clearText.size() - offset);
+
+		buffer.resize(kReads[i][1]);
+		ASSERT_EQ(stream.readAt(offset, &buffer[0], kReads[i][1]), size) << "At read " << i;
+
+		for (size_t j = 0; j < size; j++)
+			ASSERT_EQ(buffer[j], clearText[offset + j]) << "At read " << i << ", index " << j;
+	}
+
+	EXPECT_EQ(stream.readAt(clearText.size(), &buffer[0], 1), 0);
+}
+
+GTEST_TEST(BlowfishReadStream, seek) {
+	std::vector<byte> clearText;
+	Common::ScopedPtr<Common::MemoryReadStream> cipherText;
+	createLargeText(clearText, cipherText);
+
+	std::vector<byte> key;
+	createKey(key);
+
+	Common::BlowfishReadStream stream(cipherText.get(), key, false);
+
+	// Jump back and forth through more chunks than are cached
+	for (size_t i = 0; i < 64; i++) {
+		const size_t offset = (i * 7919) % clearText.size();
+
+		stream.seek(offset);
+		EXPECT_EQ(stream.readByte(), clearText[offset]) << "At offset " << offset;
+	}
+
+	stream.seek(-8, Common::SeekableReadStream::kOriginEnd);
+	EXPECT_EQ(stream.readUint64BE(), READ_BE_UINT64(&clearText[clearText.size() - 8]));
+
+	EXPECT_THROW(stream.seek(1, Common::SeekableReadStream::kOriginCurrent), Common::Exception);
+}
@@ -22,11 +22,17 @@
  *  Unit tests for our DEFLATE decompressor (which uses zlib).
  */
 
+#include <vector>
+
+#include <zlib.h>
+
 #include "gtest/gtest.h"
 
 #include "src/common/deflate.h"
+#include "src/common/readstream.h"
 #include "src/common/memreadstream.h"
 #include "src/common/error.h"
+#include "src/common/util.h"
 
 // Percy Bysshe Shelley's "Ozymandias"
 static const char *kDataUncompressed =
@@ -131,3 +137,167 @@ GTEST_TEST(DEFLATE, decompressFailInputCut) {
 	                                       kSizeDecompressed, Common::kWindowBitsMaxRaw),
 	             Common::Exception);
 }
+
+GTEST_TEST(DeflateReadStream, read) {
+	static const size_t kSizeDecompressed = strlen(kDataUncompressed);
+
+	Common::DeflateReadStream decompressed(new Common::MemoryReadStream(kDataCompressed),
+	                                       kSizeDecompressed, Common::kWindowBitsMaxRaw);
+	ASSERT_EQ(decompressed.size(), kSizeDecompressed);
+
+	for (size_t i = 0; i < kSizeDecompressed; i++)
+		EXPECT_EQ(decompressed.readByte(), kDataUncompressed[i]) << "At index " << i;
+
+	byte b;
+	EXPECT_EQ(decompressed.read(&b, 1), 0);
+	EXPECT_TRUE(decompressed.eos());
+}
+
+GTEST_TEST(DeflateReadStream, seek) {
+	static const size_t kSizeDecompressed = strlen(kDataUncompressed);
+
+	Common::DeflateReadStream decompressed(new Common::MemoryReadStream(kDataCompressed),
+	                                       kSizeDecompressed, Common::kWindowBitsMaxRaw);
+
+	decompressed.seek(100);
+	EXPECT_EQ(decompressed.pos(), 100);
+	EXPECT_EQ(decompressed.readByte(), kDataUncompressed[100]);
+
+	decompressed.seek(10);
+	EXPECT_EQ(decompressed.pos(), 10);
+	EXPECT_EQ(decompressed.readByte(), kDataUncompressed[10]);
+
+	decompressed.seek(-1, Common::SeekableReadStream::kOriginEnd);
+	EXPECT_EQ(decompressed.readByte(), kDataUncompressed[kSizeDecompressed - 1]);
+
+	EXPECT_THROW(decompressed.seek(kSizeDecompressed + 1), Common::Exception);
+}
+
+/** A memory stream that counts how much data was read from it with readAt(). */
+class CountingReadStream : public Common::MemoryReadStream {
+public:
+	CountingReadStream(const byte *data, size_t size) : Common::MemoryReadStream(data, size), _count(0) {
+	}
+
+	size_t readAt(size_t offset, void *dataPtr, size_t dataSize) {
+		const size_t readSize = Common::MemoryReadStream::readAt(offset, dataPtr, dataSize);
+
+		_count += readSize;
+		return readSize;
+	}
+
+	size_t getCount() const {
+		return _count;
+	}
+
+private:
+	size_t _count;
+};
+
+GTEST_TEST(DeflateReadStream, readAt) {
+	static const size_t kSizeDecompressed = strlen(kDataUncompressed);
+
+	Common::DeflateReadStream decompressed(new Common::MemoryReadStream(kDataCompressed),
+	                                       kSizeDecompressed, Common::kWindowBitsMaxRaw);
+
+	decompressed.seek(10);
+
+	byte buffer[20];
+	ASSERT_EQ(decompressed.readAt(100, buffer, sizeof(buffer)), sizeof(buffer));
+	for (size_t i = 0; i < sizeof(buffer); i++)
+		EXPECT_EQ(buffer[i], kDataUncompressed[100 + i]) << "At index " << (100 + i);
+
+	// readAt() doesn't touch the position
+	EXPECT_EQ(decompressed.pos(), 10);
+	EXPECT_EQ(decompressed.readByte(), kDataUncompressed[10]);
+
+	EXPECT_EQ(decompressed.readAt(kSizeDecompressed - 5, buffer, sizeof(buffer)), 5);
+	EXPECT_EQ(decompressed.readAt(kSizeDecompressed, buffer, sizeof(buffer)), 0);
+}
+
+GTEST_TEST(DeflateReadStream, readSubStream) {
+	// Several MB of somewhat compressible data, spanning many DEFLATE blocks
+	static const size_t kSizeDecompressed = 4 * 1024 * 1024;
+
+	std::vector<byte> data(kSizeDecompressed);
+
+	uint32 seed = 0x87654321;
+	for (size_t i = 0; i < kSizeDecompressed; i++) {
+		seed = seed * 1103515245 + 12345;
+		data[i] = (seed >> 16) & 0x1F;
+	}
+
+	uLongf sizeCompressed = compressBound(kSizeDecompressed);
+	std::vector<byte> compressed(sizeCompressed);
+	ASSERT_EQ(compress(&compressed[0], &sizeCompressed, &data[0], kSizeDecompressed), Z_OK);
+
+	CountingReadStream input(&compressed[0], sizeCompressed);
+
+	Common::DeflateReadStream decompressed(&input, kSizeDecompressed, Common::kWindowBitsMax, false);
+
+	// A member within the deflated data, read in small pieces like a parser would
+	static const size_t kMemberStart = 1000;
+	static const size_t kMemberEnd   = kSizeDecompressed - 1000;
+
+	Common::SeekableSubReadStream member(&decompressed, kMemberStart, kMemberEnd);
+	ASSERT_EQ(member.size(), kMemberEnd - kMemberStart);
+
+	byte buffer[4096];
+	for (size_t pos = 0; pos < member.size(); ) {
+		const size_t readSize = member.read(buffer, sizeof(buffer));
+		ASSERT_GT(readSize, 0);
+
+		for (size_t i = 0; i < readSize; i++)
+			ASSERT_EQ(buffer[i], data[kMemberStart + pos + i]) << "At index " << (kMemberStart + pos + i);
+
+		pos += readSize;
+	}
+
+	// Everything was inflated only once
+	EXPECT_LE(input.getCount(), sizeCompressed);
+}
+
+GTEST_TEST(DeflateReadStream, readFailInputCut) {
+	static const size_t kSizeCompressed   = sizeof(kDataCompressed) / 2;
+	static const size_t kSizeDecompressed = strlen(kDataUncompressed);
+
+	Common::DeflateReadStream decompressed(new Common::MemoryReadStream(kDataCompressed, kSizeCompressed),
+	                                       kSizeDecompressed, Common::kWindowBitsMaxRaw);
+
+	byte data[1024];
+	EXPECT_THROW(decompressed.read(data, kSizeDecompressed), Common::Exception);
+}
+
+GTEST_TEST(DeflateReadStream, seekCheckpoints) {
+	// Several MB of somewhat compressible data, spanning many DEFLATE blocks
+	static const size_t kSizeDecompressed = 4 * 1024 * 1024;
+
+	std::vector<byte> data(kSizeDecompressed);
+
+	uint32 seed = 0x12345678;
+	for (size_t i = 0; i < kSizeDecompressed; i++) {
+		seed = seed * 1103515245 + 12345;
+		data[i] = (seed >> 16) & 0x1F;
+	}
+
+	uLongf sizeCompressed = compressBound(kSizeDecompressed);
+	std::vector<byte> compressed(sizeCompressed);
+	ASSERT_EQ(compress(&compressed[0], &sizeCompressed, &data[0], kSizeDecompressed), Z_OK);
+
+	Common::DeflateReadStream decompressed(new Common::MemoryReadStream(&compressed[0], sizeCompressed),
+	                                       kSizeDecompressed, Common::kWindowBitsMax, true, 256 * 1024);
+
+	static const size_t kPositions[] = {
+		3 * 1024 * 1024 + 17, 12, 2 * 1024 * 1024, 1024 * 1024 + 12345, kSizeDecompressed - 100, 0, 700000
+	};
+
+	for (size_t i = 0; i < ARRAYSIZE(kPositions); i++) {
+		decompressed.seek(kPositions[i]);
+
+		byte buffer[100];
+		ASSERT_EQ(decompressed.read(buffer, sizeof(buffer)), sizeof(buffer));
+
+		for (size_t j = 0; j < sizeof(buffer); j++)
+			ASSERT_EQ(buffer[j], data[kPositions[i] + j]) << "At index " << (kPositions[i] + j);
+	}
+}
@@ -0,0 +1,196 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for the FileTreeScanner class.
+ */
+
+#include <cstdlib>
+#include <set>
+#include <map>
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include "gtest/gtest.h"
+
+#include "src/common/util.h"
+#include "src/common/strutil.h"
+#include "src/common/platform.h"
+#include "src/common/filetreescanner.h"
+
+static boost::filesystem::path kDirectoryPath;
+
+static const size_t kManyFileCount = 10;
+static const size_t kEntryCount    = 6 + kManyFileCount;
+
+static void createFile(const boost::filesystem::path &path, size_t size) {
+	boost::filesystem::ofstream file(path, std::ofstream::binary);
+	ASSERT_FALSE(file.fail());
+
+	file << std::string(size, 'x');
+}
+
+class FileTreeScanner: public ::testing::Test {
+protected:
+	static void SetUpTestCase() {
+		Common::Platform::init();
+
+		boost::filesystem::path tmpPath    = boost::filesystem::temp_directory_path();
+		boost::filesystem::path uniquePath = boost::filesystem::unique_path("%%%%_%%%%_%%%%_%%%%.xoreos");
+
+		kDirectoryPath = tmpPath / uniquePath;
+
+		/* root/file1
+		 * root/a/file2
+		 * root/a/b/file3
+		 * root/many/0 ... root/many/9
+		 */
+
+		boost::filesystem::create_directories(kDirectoryPath / "a" / "b");
+		boost::filesystem::create_directories(kDirectoryPath / "many");
+
+		createFile(kDirectoryPath / "file1", 1);
+		createFile(kDirectoryPath / "a" / "file2", 2);
+		createFile(kDirectoryPath / "a" / "b" / "file3", 3);
+
+		for (size_t i = 0; i < kManyFileCount; i++)
+			createFile(kDirectoryPath / "many" / Common::composeString(i).c_str(), i);
+	}
+
+	static void TearDownTestCase() {
+		if (!kDirectoryPath.empty())
+			boost::filesystem::remove_all(kDirectoryPath);
+	}
+};
+
+/** Take all batches of a finished scan and check that every directory came before its batches. */
+static size_t checkBatches(Common::FileTreeScanner &scanner, std::map<std::string, size_t> &batchCounts) {
+	std::list<Common::FileTreeScanner::Batch> batches;
+	std::list<Common::Exception> errors;
+
+	scanner.wait();
+	EXPECT_FALSE(scanner.takeBatches(batches, errors));
+	EXPECT_TRUE(errors.empty());
+
+	std::set<std::string> directories;
+	directories.insert(scanner.getRoot().path.generic_string());
+
+	size_t count = 0;
+	for (std::list<Common::FileTreeScanner::Batch>::const_iterator b = batches.begin(); b != batches.end(); ++b) {
+		EXPECT_EQ(directories.count(b->directory.generic_string()), 1) << b->directory.generic_string();
+
+		batchCounts[b->directory.filename().generic_string()]++;
+
+		for (std::vector<Common::FileTree::Entry>::const_iterator e = b->entries.begin(); e != b->entries.end(); ++e) {
+			EXPECT_EQ(e->path.parent_path(), b->directory);
+			EXPECT_TRUE(e->children.empty());
+
+			if (e->isDirectory())
+				directories.insert(e->path.generic_string());
+			else
+				EXPECT_EQ(e->size, e->name.equals("file1") ? 1 : e->name.equals("file2") ? 2 :
+				                   e->name.equals("file3") ? 3 : atoi(e->name.c_str()));
+
+			count++;
+		}
+	}
+
+	return count;
+}
+
+static size_t countEntries(const Common::FileTree::Entry &entry) {
+	size_t count = entry.children.size();
+	for (std::list<Common::FileTree::Entry>::const_iterator c = entry.children.begin(); c != entry.children.end(); ++c)
+		count += countEntries(*c);
+
+	return count;
+}
+
+GTEST_TEST_F(FileTreeScanner, readPath) {
+	Common::FileTreeScanner scanner;
+	scanner.scan(kDirectoryPath.generic_string());
+
+	EXPECT_TRUE(scanner.getRoot().isDirectory());
+	EXPECT_TRUE(scanner.getRoot().children.empty());
+
+	std::map<std::string, size_t> batchCounts;
+	EXPECT_EQ(checkBatches(scanner, batchCounts), kEntryCount);
+	EXPECT_TRUE(scanner.isFinished());
+
+	EXPECT_EQ(batchCounts.size(), 4);
+	EXPECT_EQ(batchCounts["many"], 1);
+
+	Common::FileTree tree;
+	scanner.getTree(tree);
+
+	EXPECT_EQ(countEntries(tree.getRoot()), kEntryCount);
+}
+
+GTEST_TEST_F(FileTreeScanner, splitBatches) {
+	Common::FileTreeScanner scanner(4);
+	scanner.scan(kDirectoryPath.generic_string());
+
+	std::map<std::string, size_t> batchCounts;
+	EXPECT_EQ(checkBatches(scanner, batchCounts), kEntryCount);
+
+	EXPECT_EQ(batchCounts["many"], 3);
+}
+
+GTEST_TEST_F(FileTreeScanner, streamTree) {
+	Common::FileTree tree;
+	tree.readPath(kDirectoryPath, -1);
+
+	Common::FileTreeScanner scanner;
+	scanner.scan(tree.getRoot());
+
+	EXPECT_EQ(scanner.getRoot().path, tree.getRoot().path);
+
+	std::map<std::string, size_t> batchCounts;
+	EXPECT_EQ(checkBatches(scanner, batchCounts), kEntryCount);
+
+	EXPECT_EQ(batchCounts.size(), 4);
+}
+
+GTEST_TEST_F(FileTreeScanner, cancel) {
+	Common::FileTreeScanner scanner(1);
+	scanner.scan(kDirectoryPath.generic_string());
+	scanner.cancel();
+
+	EXPECT_TRUE(scanner.isFinished());
+
+	std::list<Common::FileTreeScanner::Batch> batches;
+	std::list<Common::Exception> errors;
+	EXPECT_FALSE(scanner.takeBatches(batches, errors));
+
+	const size_t count = batches.size();
+
+	batches.clear();
+	scanner.takeBatches(batches, errors);
+	EXPECT_TRUE(batches.empty());
+
+	EXPECT_LE(count, kEntryCount);
+}
+
+GTEST_TEST_F(FileTreeScanner, nonExisting) {
+	Common::FileTreeScanner scanner;
+
+	EXPECT_THROW(scanner.scan((kDirectoryPath / "nope").generic_string()), Common::Exception);
+}
@@ -50,6 +50,22 @@ GTEST_TEST(Huffman, getSymbolSymbols) {
 		EXPECT_EQ(huffman.getSymbol(bitStream), kDeHuffmanDataSymbols[i]) << "At index " << i;
 }
 
+GTEST_TEST(Huffman, getSymbolLSB) {
+	// The same codes, but read LSB first
+	static const uint32 kCodesLSB[] = { 0, 1, 5, 3, 7 };
+
+	// The same data, but with the bits in each byte reversed
+	static const byte kHuffmanDataLSB[] = { 0xA2, 0xE6 };
+
+	Common::MemoryReadStream byteStream(kHuffmanDataLSB);
+	Common::BitStream8LSB    bitStream (byteStream);
+
+	Common::Huffman huffman(kMaxLength, ARRAYSIZE(kCodesLSB), kCodesLSB, kLengths, kSymbols);
+
+	for (size_t i = 0; i < ARRAYSIZE(kDeHuffmanDataSymbols); i++)
+		EXPECT_EQ(huffman.getSymbol(bitStream), kDeHuffmanDataSymbols[i]) << "At index " << i;
+}
+
 GTEST_TEST(Huffman, getSymbolCodes) {
 	Common::MemoryReadStream byteStream(kHuffmanData);
 	Common::BitStream8MSB    bitStream (byteStream);
@@ -0,0 +1,110 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for our byte-budgeted LRU cache.
+ */
+
+#include <memory>
+
+#include "gtest/gtest.h"
+
+#include "src/common/lrucache.h"
+
+typedef Common::LRUCache<int, int> TestCache;
+
+static TestCache::ValuePtr makeValue(int value) {
+	return std::make_shared<const int>(value);
+}
+
+GTEST_TEST(LRUCache, get) {
+	TestCache cache(100);
+
+	EXPECT_FALSE(cache.get(1));
+
+	EXPECT_TRUE(cache.insert(1, makeValue(10), 20));
+	EXPECT_TRUE(cache.insert(2, makeValue(20), 30));
+
+	ASSERT_TRUE(cache.get(1));
+	EXPECT_EQ(*cache.get(1), 10);
+	ASSERT_TRUE(cache.get(2));
+	EXPECT_EQ(*cache.get(2), 20);
+
+	EXPECT_FALSE(cache.get(3));
+
+	EXPECT_EQ(cache.getCount(), 2);
+	EXPECT_EQ(cache.getSize(), 50);
+
+	EXPECT_EQ(cache.getHits(), 4);
+	EXPECT_EQ(cache.getMisses(), 2);
+}
+
+GTEST_TEST(LRUCache, evict) {
+	TestCache cache(100);
+
+	cache.insert(1, makeValue(10), 40);
+	cache.insert(2, makeValue(20), 40);
+
+	// Use 1, so that 2 is the least recently used value
+	EXPECT_TRUE(cache.get(1));
+
+	cache.insert(3, makeValue(30), 40);
+
+	EXPECT_TRUE (cache.get(1));
+	EXPECT_FALSE(cache.get(2));
+	EXPECT_TRUE (cache.get(3));
+
+	EXPECT_EQ(cache.getSize(), 80);
+	EXPECT_EQ(cache.getEvictions(), 1);
+
+	// Too big to be cached at all, and nothing is evicted for it
+	EXPECT_FALSE(cache.insert(4, makeValue(40), 101));
+	EXPECT_FALSE(cache.get(4));
+	EXPECT_EQ(cache.getCount(), 2);
+}
+
+GTEST_TEST(LRUCache, replace) {
+	TestCache cache(100);
+
+	cache.insert(1, makeValue(10), 40);
+	cache.insert(1, makeValue(11), 60);
+
+	ASSERT_TRUE(cache.get(1));
+	EXPECT_EQ(*cache.get(1), 11);
+
+	EXPECT_EQ(cache.getCount(), 1);
+	EXPECT_EQ(cache.getSize(), 60);
+}
+
+GTEST_TEST(LRUCache, keepAlive) {
+	TestCache cache(100);
+
+	cache.insert(1, makeValue(10), 100);
+
+	const TestCache::ValuePtr value = cache.get(1);
+	cache.clear();
+
+	EXPECT_FALSE(cache.get(1));
+	EXPECT_EQ(cache.getSize(), 0);
+
+	// Still usable after it was removed from the cache
+	ASSERT_TRUE(value);
+	EXPECT_EQ(*value, 10);
+}
@@ -25,6 +25,7 @@
 #include "gtest/gtest.h"
 
 #include "src/common/lzma.h"
+#include "src/common/readstream.h"
 #include "src/common/memreadstream.h"
 #include "src/common/error.h"
 
@@ -132,3 +133,77 @@ GTEST_TEST(LZMA1, decompressFailInputCut) {
 	EXPECT_THROW(Common::decompressLZMA1(kDataCompressed, kSizeCompressed, kSizeDecompressed),
 	             Common::Exception);
 }
+
+GTEST_TEST(LZMAReadStream, read) {
+	static const size_t kSizeDecompressed = strlen(kDataUncompressed);
+
+	Common::LZMAReadStream decompressed(new Common::MemoryReadStream(kDataCompressed), kSizeDecompressed);
+	ASSERT_EQ(decompressed.size(), kSizeDecompressed);
+
+	for (size_t i = 0; i < kSizeDecompressed; i++)
+		EXPECT_EQ(decompressed.readByte(), kDataUncompressed[i]) << "At index " << i;
+
+	byte b;
+	EXPECT_EQ(decompressed.read(&b, 1), 0);
+	EXPECT_TRUE(decompressed.eos());
+}
+
+GTEST_TEST(LZMAReadStream, seek) {
+	static const size_t kSizeDecompressed = strlen(kDataUncompressed);
+
+	Common::LZMAReadStream decompressed(new Common::MemoryReadStream(kDataCompressed), kSizeDecompressed);
+
+	decompressed.seek(100);
+	EXPECT_EQ(decompressed.pos(), 100);
+	EXPECT_EQ(decompressed.readByte(), kDataUncompressed[100]);
+
+	decompressed.seek(10);
+	EXPECT_EQ(decompressed.pos(), 10);
+	EXPECT_EQ(decompressed.readByte(), kDataUncompressed[10]);
+
+	decompressed.seek(-1, Common::SeekableReadStream::kOriginEnd);
+	EXPECT_EQ(decompressed.readByte(), kDataUncompressed[kSizeDecompressed - 1]);
+
+	EXPECT_THROW(decompressed.seek(kSizeDecompressed + 1), Common::Exception);
+}
+
+GTEST_TEST(LZMAReadStream, readAt) {
+	static const size_t kSizeDecompressed = strlen(kDataUncompressed);
+
+	Common::LZMAReadStream decompressed(new Common::MemoryReadStream(kDataCompressed), kSizeDecompressed);
+
+	decompressed.seek(10);
+
+	byte buffer[20];
+	ASSERT_EQ(decompressed.readAt(100, buffer, sizeof(buffer)), sizeof(buffer));
+	for (size_t i = 0; i < sizeof(buffer); i++)
+		EXPECT_EQ(buffer[i], kDataUncompressed[100 + i]) << "At index " << (100 + i);
+
+	// readAt() doesn't touch the position
+	EXPECT_EQ(decompressed.pos(), 10);
+	EXPECT_EQ(decompressed.readByte(), kDataUncompressed[10]);
+
+	EXPECT_EQ(decompressed.readAt(kSizeDecompressed - 5, buffer, sizeof(buffer)), 5);
+	EXPECT_EQ(decompressed.readAt(kSizeDecompressed, buffer, sizeof(buffer)), 0);
+}
+
+GTEST_TEST(LZMAReadStream, readSubStream) {
+	static const size_t kSizeDecompressed = strlen(kDataUncompressed);
+
+	Common::LZMAReadStream decompressed(new Common::MemoryReadStream(kDataCompressed), kSizeDecompressed);
+
+	Common::SeekableSubReadStream member(&decompressed, 50, kSizeDecompressed - 50);
+	for (size_t i = 50; i < (kSizeDecompressed - 50); i++)
+		EXPECT_EQ(member.readByte(), kDataUncompressed[i]) << "At index " << i;
+}
+
+GTEST_TEST(LZMAReadStream, readFailInputCut) {
+	static const size_t kSizeCompressed   = sizeof(kDataCompressed) / 2;
+	static const size_t kSizeDecompressed = strlen(kDataUncompressed);
+
+	Common::LZMAReadStream decompressed(new Common::MemoryReadStream(kDataCompressed, kSizeCompressed),
+	                                    kSizeDecompressed);
+
+	byte data[1024];
+	EXPECT_THROW(decompressed.read(data, kSizeDecompressed), Common::Exception);
+}
@@ -0,0 +1,149 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for our memory-mapped file read stream.
+ */
+
+#include <string>
+#include <iostream>
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include "gtest/gtest.h"
+
+#include "src/common/util.h"
+#include "src/common/scopedptr.h"
+#include "src/common/platform.h"
+#include "src/common/memreadstream.h"
+#include "src/common/mappedfile.h"
+
+static const byte kData[5] = { 0x12, 0x34, 0x56, 0x78, 0x90 };
+
+boost::filesystem::path kFilePath;
+
+class MappedFile : public ::testing::Test {
+protected:
+	static void SetUpTestCase() {
+		Common::Platform::init();
+
+		boost::filesystem::path tmpPath    = boost::filesystem::temp_directory_path();
+		boost::filesystem::path uniquePath = boost::filesystem::unique_path("%%%%_%%%%_%%%%_%%%%.xoreos");
+
+		kFilePath = tmpPath / uniquePath;
+
+		boost::filesystem::ofstream testFile(kFilePath, std::ofstream::binary);
+
+		testFile.write(reinterpret_cast<const char *>(kData), ARRAYSIZE(kData));
+		testFile.flush();
+		testFile.close();
+	}
+
+	static void TearDownTestCase() {
+		if (!kFilePath.empty())
+			boost::filesystem::remove(kFilePath);
+	}
+};
+
+GTEST_TEST_F(MappedFile, read) {
+	ASSERT_FALSE(kFilePath.empty());
+
+	Common::MappedFile file(kFilePath.generic_string());
+	ASSERT_TRUE(file.isOpen());
+
+	EXPECT_EQ(file.size(), ARRAYSIZE(kData));
+
+	byte readData[ARRAYSIZE(kData)];
+	const size_t readCount = file.read(readData, sizeof(readData));
+	EXPECT_EQ(readCount, ARRAYSIZE(readData));
+
+	for (size_t i = 0; i < ARRAYSIZE(kData); i++)
+		EXPECT_EQ(readData[i], kData[i]) << "At index " << i;
+
+	EXPECT_FALSE(file.eos());
+	EXPECT_EQ(file.read(readData, 1), 0);
+	EXPECT_TRUE(file.eos());
+
+	file.close();
+	ASSERT_FALSE(file.isOpen());
+}
+
+GTEST_TEST_F(MappedFile, seek) {
+	ASSERT_FALSE(kFilePath.empty());
+
+	Common::MappedFile file(kFilePath.generic_string());
+	ASSERT_TRUE(file.isOpen());
+
+	EXPECT_EQ(file.seek(3), 0);
+	EXPECT_EQ(file.pos(), 3);
+	EXPECT_EQ(file.readByte(), kData[3]);
+
+	EXPECT_EQ(file.seek(-2, Common::SeekableReadStream::kOriginEnd), 4);
+	EXPECT_EQ(file.readByte(), kData[3]);
+
+	EXPECT_THROW(file.seek(6), Common::Exception);
+}
+
+GTEST_TEST_F(MappedFile, getData) {
+	ASSERT_FALSE(kFilePath.empty());
+
+	Common::MappedFile file(kFilePath.generic_string());
+	ASSERT_TRUE(file.isOpen());
+
+	const byte *data = file.getData();
+	ASSERT_NE(data, static_cast<const byte *>(0));
+
+	for (size_t i = 0; i < ARRAYSIZE(kData); i++)
+		EXPECT_EQ(data[i], kData[i]) << "At index " << i;
+
+	EXPECT_EQ(Common::getStreamMemory(file), data);
+}
+
+GTEST_TEST_F(MappedFile, createMemoryView) {
+	ASSERT_FALSE(kFilePath.empty());
+
+	Common::MappedFile file(kFilePath.generic_string());
+	ASSERT_TRUE(file.isOpen());
+
+	Common::ScopedPtr<Common::MemoryReadStream> view(Common::createMemoryView(file, 1, 4));
+	ASSERT_TRUE(view);
+
+	EXPECT_EQ(view->size(), 3);
+	EXPECT_EQ(view->getData(), file.getData() + 1);
+
+	EXPECT_EQ(view->readByte(), kData[1]);
+	EXPECT_EQ(view->readByte(), kData[2]);
+	EXPECT_EQ(view->readByte(), kData[3]);
+
+	EXPECT_THROW(view->readByte(), Common::Exception);
+
+	EXPECT_THROW(Common::createMemoryView(file, 4, 6), Common::Exception);
+}
+
+GTEST_TEST(MemoryView, memoryReadStream) {
+	Common::MemoryReadStream stream(kData);
+
+	Common::ScopedPtr<Common::MemoryReadStream> view(Common::createMemoryView(stream, 2, 5));
+	ASSERT_TRUE(view);
+
+	EXPECT_EQ(view->size(), 3);
+	EXPECT_EQ(view->getData(), kData + 2);
+}
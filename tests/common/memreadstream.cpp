@@ -259,6 +259,22 @@ GTEST_TEST(MemoryReadStream, readIEEEDoubleBE) {
 	EXPECT_THROW(stream.readIEEEDoubleBE(), Common::Exception);
 }
 
+GTEST_TEST(MemoryReadStream, readAt) {
+	static const byte data[5] = { 0x12, 0x34, 0x56, 0x78, 0x90 };
+	Common::MemoryReadStream stream(data);
+
+	byte readData[4] = { 0 };
+	EXPECT_EQ(stream.readAt(3, readData, 4), 2);
+
+	EXPECT_EQ(readData[0], data[3]);
+	EXPECT_EQ(readData[1], data[4]);
+
+	EXPECT_EQ(stream.readAt(5, readData, 1), 0);
+
+	EXPECT_EQ(stream.pos(), 0);
+	EXPECT_FALSE(stream.eos());
+}
+
 GTEST_TEST(MemoryReadStreamEndian, streamEndianLE) {
 	static const byte data[4] = { 0x78, 0x56, 0x34, 0x12 };
 	Common::MemoryReadStreamEndian stream(data, sizeof(data), false);
@@ -315,6 +331,37 @@ GTEST_TEST(SeekableSubReadStream, fromMem) {
 	EXPECT_FALSE(subStream.eos());
 }
 
+GTEST_TEST(SeekableSubReadStream, independentOfParent) {
+	static const byte data[5] = { 0x12, 0x34, 0x56, 0x78, 0x90 };
+	Common::MemoryReadStream stream(data);
+
+	Common::SeekableSubReadStream subStream1(&stream, 1, 5);
+	Common::SeekableSubReadStream subStream2(&stream, 3, 5);
+
+	EXPECT_EQ(subStream1.readByte(), data[1]);
+	EXPECT_EQ(subStream2.readByte(), data[3]);
+	EXPECT_EQ(subStream1.readByte(), data[2]);
+	EXPECT_EQ(subStream2.readByte(), data[4]);
+
+	EXPECT_EQ(stream.pos(), 0);
+}
+
+GTEST_TEST(SeekableSubReadStream, readAt) {
+	static const byte data[5] = { 0x12, 0x34, 0x56, 0x78, 0x90 };
+	Common::MemoryReadStream stream(data);
+
+	Common::SeekableSubReadStream subStream(&stream, 1, 4);
+
+	byte readData[4] = { 0 };
+	EXPECT_EQ(subStream.readAt(1, readData, 4), 2);
+
+	EXPECT_EQ(readData[0], data[2]);
+	EXPECT_EQ(readData[1], data[3]);
+
+	EXPECT_EQ(subStream.readAt(3, readData, 1), 0);
+	EXPECT_EQ(subStream.pos(), 0);
+}
+
 GTEST_TEST(SeekableSubReadStreamEndian, streamEndianLE) {
 	static const byte data[4] = { 0x78, 0x56, 0x34, 0x12 };
 	Common::MemoryReadStream stream(data);
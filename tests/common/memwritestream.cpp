@@ -324,3 +324,32 @@ GTEST_TEST(MemoryWriteStreamDynamic, write) {
 	for (size_t i = 0; i < ARRAYSIZE(data); i++)
 		EXPECT_EQ(stream.getData()[i], data[i]) << "At index " << i;
 }
+
+GTEST_TEST(MemoryWriteStreamDynamic, seek) {
+	static const byte data[8] = { 0x12, 0x34, 0x56, 0x78, 0x90, 0xAB, 0xCD, 0xEF };
+
+	Common::MemoryWriteStreamDynamic stream(true);
+
+	stream.writeUint32BE(0);
+	stream.write(data + 4, 4);
+
+	EXPECT_EQ(stream.pos(), 8);
+
+	EXPECT_EQ(stream.seek(0), 8);
+	stream.write(data, 4);
+
+	EXPECT_EQ(stream.pos(), 4);
+	ASSERT_EQ(stream.size(), ARRAYSIZE(data));
+
+	for (size_t i = 0; i < ARRAYSIZE(data); i++)
+		EXPECT_EQ(stream.getData()[i], data[i]) << "At index " << i;
+
+	stream.seek(0, Common::SeekableReadStream::kOriginEnd);
+	stream.writeByte(0xFF);
+
+	EXPECT_EQ(stream.pos(), 9);
+	EXPECT_EQ(stream.size(), 9);
+
+	EXPECT_THROW(stream.seek(10), Common::Exception);
+	EXPECT_THROW(stream.seek(1, Common::SeekableReadStream::kOriginCurrent), Common::Exception);
+}
@@ -32,6 +32,7 @@
 
 #include "src/common/util.h"
 #include "src/common/platform.h"
+#include "src/common/memreadstream.h"
 #include "src/common/readfile.h"
 
 boost::filesystem::path kFilePath;
@@ -87,3 +88,58 @@ GTEST_TEST_F(ReadFile, write) {
 	for (size_t i = 0; i < ARRAYSIZE(data); i++)
 		EXPECT_EQ(readData[i], data[i]) << "At index " << i;
 }
+
+GTEST_TEST_F(ReadFile, readAt) {
+	ASSERT_FALSE(kFilePath.empty());
+
+	static const byte data[5] = { 0x12, 0x34, 0x56, 0x78, 0x90 };
+
+	boost::filesystem::ofstream testFile(kFilePath, std::ofstream::binary);
+
+	testFile.write(reinterpret_cast<const char *>(data), ARRAYSIZE(data));
+	testFile.flush();
+	ASSERT_FALSE(testFile.fail());
+
+	testFile.close();
+
+	Common::ReadFile file(kFilePath.generic_string());
+	ASSERT_TRUE(file.isOpen());
+
+	file.seek(1);
+
+	byte readData[4] = { 0 };
+	EXPECT_EQ(file.readAt(2, readData, 4), 3);
+
+	EXPECT_EQ(readData[0], data[2]);
+	EXPECT_EQ(readData[1], data[3]);
+	EXPECT_EQ(readData[2], data[4]);
+
+	EXPECT_EQ(file.readAt(5, readData, 1), 0);
+
+	// The stream position is not affected
+	EXPECT_EQ(file.pos(), 1);
+	EXPECT_EQ(file.readByte(), data[1]);
+}
+
+GTEST_TEST_F(ReadFile, openTemporary) {
+	static const byte data[5] = { 0x12, 0x34, 0x56, 0x78, 0x90 };
+
+	Common::MemoryReadStream stream(data);
+	stream.skip(1);
+
+	Common::ReadFile file;
+	file.openTemporary(stream);
+	ASSERT_TRUE(file.isOpen());
+
+	EXPECT_EQ(file.size(), ARRAYSIZE(data) - 1);
+	EXPECT_EQ(file.pos(), 0);
+
+	byte readData[4] = { 0 };
+	EXPECT_EQ(file.read(readData, sizeof(readData)), 4);
+
+	for (size_t i = 0; i < ARRAYSIZE(readData); i++)
+		EXPECT_EQ(readData[i], data[i + 1]) << "At index " << i;
+
+	EXPECT_EQ(file.readAt(3, readData, 4), 1);
+	EXPECT_EQ(readData[0], data[4]);
+}
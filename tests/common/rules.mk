@@ -30,6 +30,11 @@ tests_common_test_util_SOURCES  = tests/common/util.cpp
 tests_common_test_util_LDADD    = $(common_LIBS)
 tests_common_test_util_CXXFLAGS = $(test_CXXFLAGS)
 
+check_PROGRAMS                   += tests/common/test_thread
+tests_common_test_thread_SOURCES  = tests/common/thread.cpp
+tests_common_test_thread_LDADD    = $(common_LIBS)
+tests_common_test_thread_CXXFLAGS = $(test_CXXFLAGS)
+
 check_PROGRAMS                      += tests/common/test_scopedptr
 tests_common_test_scopedptr_SOURCES  = tests/common/scopedptr.cpp
 tests_common_test_scopedptr_LDADD    = $(common_LIBS)
@@ -55,6 +60,11 @@ tests_common_test_ptrmap_SOURCES  = tests/common/ptrmap.cpp
 tests_common_test_ptrmap_LDADD    = $(common_LIBS)
 tests_common_test_ptrmap_CXXFLAGS = $(test_CXXFLAGS)
 
+check_PROGRAMS                     += tests/common/test_lrucache
+tests_common_test_lrucache_SOURCES  = tests/common/lrucache.cpp
+tests_common_test_lrucache_LDADD    = $(common_LIBS)
+tests_common_test_lrucache_CXXFLAGS = $(test_CXXFLAGS)
+
 check_PROGRAMS                    += tests/common/test_ustring
 tests_common_test_ustring_SOURCES  = tests/common/ustring.cpp
 tests_common_test_ustring_LDADD    = $(common_LIBS)
@@ -80,6 +90,11 @@ tests_common_test_readfile_SOURCES  = tests/common/readfile.cpp
 tests_common_test_readfile_LDADD    = $(common_LIBS)
 tests_common_test_readfile_CXXFLAGS = $(test_CXXFLAGS)
 
+check_PROGRAMS                       += tests/common/test_mappedfile
+tests_common_test_mappedfile_SOURCES  = tests/common/mappedfile.cpp
+tests_common_test_mappedfile_LDADD    = $(common_LIBS)
+tests_common_test_mappedfile_CXXFLAGS = $(test_CXXFLAGS)
+
 check_PROGRAMS                      += tests/common/test_writefile
 tests_common_test_writefile_SOURCES  = tests/common/writefile.cpp
 tests_common_test_writefile_LDADD    = $(common_LIBS)
@@ -95,11 +110,21 @@ tests_common_test_huffman_SOURCES  = tests/common/huffman.cpp
 tests_common_test_huffman_LDADD    = $(common_LIBS)
 tests_common_test_huffman_CXXFLAGS = $(test_CXXFLAGS)
 
+BENCHMARKS                         += tests/common/bench_huffman
+tests_common_bench_huffman_SOURCES  = tests/common/bench_huffman.cpp
+tests_common_bench_huffman_LDADD    = $(common_LIBS)
+tests_common_bench_huffman_CXXFLAGS = $(test_CXXFLAGS)
+
 check_PROGRAMS                     += tests/common/test_blowfish
 tests_common_test_blowfish_SOURCES  = tests/common/blowfish.cpp
 tests_common_test_blowfish_LDADD    = $(common_LIBS)
 tests_common_test_blowfish_CXXFLAGS = $(test_CXXFLAGS)
 
+BENCHMARKS                          += tests/common/bench_blowfish
+tests_common_bench_blowfish_SOURCES  = tests/common/bench_blowfish.cpp
+tests_common_bench_blowfish_LDADD    = $(common_LIBS)
+tests_common_bench_blowfish_CXXFLAGS = $(test_CXXFLAGS)
+
 noinst_HEADERS += tests/common/encoding.h tests/common/encoding_tests.h
 
 check_PROGRAMS                           += tests/common/test_encoding_ascii
@@ -172,6 +197,11 @@ tests_common_test_filelist_SOURCES  = tests/common/filelist.cpp
 tests_common_test_filelist_LDADD    = $(common_LIBS)
 tests_common_test_filelist_CXXFLAGS = $(test_CXXFLAGS)
 
+check_PROGRAMS                            += tests/common/test_filetreescanner
+tests_common_test_filetreescanner_SOURCES  = tests/common/filetreescanner.cpp
+tests_common_test_filetreescanner_LDADD    = $(common_LIBS)
+tests_common_test_filetreescanner_CXXFLAGS = $(test_CXXFLAGS)
+
 check_PROGRAMS                 += tests/common/test_hash
 tests_common_test_hash_SOURCES  = tests/common/hash.cpp
 tests_common_test_hash_LDADD    = $(common_LIBS)
@@ -347,3 +347,47 @@ GTEST_TEST(StrUtil, parseDouble) {
 	Common::parseString( "0.0", x);
 	EXPECT_DOUBLE_EQ(x, 0.0);
 }
+
+GTEST_TEST(StrUtil, matchGlobLiteral) {
+	EXPECT_TRUE(Common::matchGlob("foo.tga", "foo.tga"));
+	EXPECT_TRUE(Common::matchGlob("FOO.tga", "foo.TGA"));
+
+	EXPECT_FALSE(Common::matchGlob("foo.tga", "foo.tg"));
+	EXPECT_FALSE(Common::matchGlob("foo.tg", "foo.tga"));
+	EXPECT_FALSE(Common::matchGlob("foo.tga", "bar.tga"));
+
+	EXPECT_TRUE(Common::matchGlob("", ""));
+	EXPECT_FALSE(Common::matchGlob("", "foo"));
+}
+
+GTEST_TEST(StrUtil, matchGlobQuestionMark) {
+	EXPECT_TRUE(Common::matchGlob("fo?.tga", "foo.tga"));
+	EXPECT_TRUE(Common::matchGlob("???", "abc"));
+
+	EXPECT_FALSE(Common::matchGlob("???", "ab"));
+	EXPECT_FALSE(Common::matchGlob("???", "abcd"));
+	EXPECT_FALSE(Common::matchGlob("?", ""));
+}
+
+GTEST_TEST(StrUtil, matchGlobStar) {
+	EXPECT_TRUE(Common::matchGlob("*", ""));
+	EXPECT_TRUE(Common::matchGlob("*", "foo.tga"));
+	EXPECT_TRUE(Common::matchGlob("*.tga", "foo.tga"));
+	EXPECT_TRUE(Common::matchGlob("*.TGA", "foo.tga"));
+	EXPECT_TRUE(Common::matchGlob("foo*", "foo"));
+	EXPECT_TRUE(Common::matchGlob("f*o*a", "foo.tga"));
+	EXPECT_TRUE(Common::matchGlob("**.tga", "foo.tga"));
+
+	EXPECT_FALSE(Common::matchGlob("*.tga", "foo.dds"));
+	EXPECT_FALSE(Common::matchGlob("*.tga", "foo.tga.dds"));
+	EXPECT_FALSE(Common::matchGlob("foo*", "bar"));
+}
+
+GTEST_TEST(StrUtil, matchGlobBacktrack) {
+	// The first ".t" after the '*' is a false start
+	EXPECT_TRUE(Common::matchGlob("*.tga", "foo.txt.tga"));
+	EXPECT_TRUE(Common::matchGlob("*a?c", "abaxc"));
+	EXPECT_TRUE(Common::matchGlob("a*b*c", "aXbYbZc"));
+
+	EXPECT_FALSE(Common::matchGlob("a*b*c", "aXbYbZ"));
+}
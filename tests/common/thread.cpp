@@ -0,0 +1,137 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+/** @file
+ *  Unit tests for our threading helpers.
+ */
+
+#include "src/common/atomic.h"
+
+#include <vector>
+#include <set>
+
+#include "gtest/gtest.h"
+
+#include "src/common/error.h"
+#include "src/common/mutex.h"
+#include "src/common/thread.h"
+
+GTEST_TEST(ParallelFor, allIndices) {
+	static const size_t kCount = 1000;
+
+	std::vector<boost::atomic<int> > calls(kCount);
+	for (size_t i = 0; i < kCount; i++)
+		calls[i] = 0;
+
+	Common::parallelFor(kCount, [&calls](size_t i) {
+		calls[i]++;
+	}, 4);
+
+	for (size_t i = 0; i < kCount; i++)
+		EXPECT_EQ(calls[i], 1) << "At index " << i;
+}
+
+GTEST_TEST(ParallelFor, empty) {
+	bool called = false;
+
+	Common::parallelFor(0, [&called](size_t) {
+		called = true;
+	});
+
+	EXPECT_FALSE(called);
+}
+
+GTEST_TEST(ParallelFor, singleThread) {
+	const boost::thread::id caller = boost::this_thread::get_id();
+
+	Common::parallelFor(100, [caller](size_t) {
+		EXPECT_EQ(boost::this_thread::get_id(), caller);
+	}, 1);
+}
+
+GTEST_TEST(ParallelFor, nested) {
+	Common::Mutex mutex;
+	size_t inner = 0;
+
+	Common::parallelFor(8, [&mutex, &inner](size_t) {
+		const boost::thread::id outer = boost::this_thread::get_id();
+
+		// A nested parallelFor() stays on the thread that calls it
+		Common::parallelFor(16, [&mutex, &inner, outer](size_t) {
+			EXPECT_EQ(boost::this_thread::get_id(), outer);
+
+			Common::StackLock lock(mutex);
+			inner++;
+		}, 4);
+	}, 4);
+
+	EXPECT_EQ(inner, 8 * 16);
+}
+
+GTEST_TEST(ParallelFor, exception) {
+	boost::atomic<size_t> calls(0);
+
+	EXPECT_THROW(Common::parallelFor(1000, [&calls](size_t i) {
+		calls++;
+
+		if (i == 10)
+			throw Common::Exception("Failed at %u", (uint) i);
+	}, 4), Common::Exception);
+
+	EXPECT_LT(calls, 1000);
+
+	// The calling thread isn't left marked as working for a parallelFor()
+	std::set<boost::thread::id> threads;
+	Common::Mutex mutex;
+
+	Common::parallelFor(64, [&threads, &mutex](size_t) {
+		boost::this_thread::sleep_for(boost::chrono::milliseconds(1));
+
+		Common::StackLock lock(mutex);
+		threads.insert(boost::this_thread::get_id());
+	}, 4);
+
+	EXPECT_GT(threads.size(), 1);
+}
+
+GTEST_TEST(ParallelFor, reuseThreads) {
+	static thread_local bool tSeen = false;
+
+	const boost::thread::id caller = boost::this_thread::get_id();
+
+	Common::Mutex mutex;
+	size_t newThreads = 0;
+
+	for (size_t n = 0; n < 10; n++) {
+		Common::parallelFor(64, [&mutex, &newThreads, caller](size_t) {
+			boost::this_thread::sleep_for(boost::chrono::microseconds(100));
+
+			if (tSeen || (boost::this_thread::get_id() == caller))
+				return;
+
+			tSeen = true;
+
+			Common::StackLock lock(mutex);
+			newThreads++;
+		}, 4);
+	}
+
+	// The helpers are kept around between calls, instead of new threads every time
+	EXPECT_LE(newThreads, 3);
+}
@@ -94,3 +94,47 @@ GTEST_TEST_F(WriteFile, write) {
 	for (size_t i = 0; i < ARRAYSIZE(data); i++)
 		EXPECT_EQ(readData[i], data[i]) << "At index " << i;
 }
+
+GTEST_TEST_F(WriteFile, seek) {
+	ASSERT_FALSE(kFilePath.empty());
+
+	static const byte data[8] = { 0x12, 0x34, 0x56, 0x78, 0x90, 0xAB, 0xCD, 0xEF };
+
+	// Write a placeholder, then go back and fill it in
+
+	Common::WriteFile file(kFilePath.generic_string());
+	ASSERT_TRUE(file.isOpen());
+
+	file.writeUint32BE(0);
+	file.write(data + 4, 4);
+
+	EXPECT_EQ(file.pos(), 8);
+
+	EXPECT_EQ(file.seek(0), 8);
+	file.write(data, 4);
+
+	EXPECT_EQ(file.pos() , 4);
+	EXPECT_EQ(file.size(), ARRAYSIZE(data));
+
+	EXPECT_THROW(file.seek(9), Common::Exception);
+
+	file.seek(0, Common::SeekableReadStream::kOriginEnd);
+	EXPECT_EQ(file.pos(), 8);
+
+	file.flush();
+	file.close();
+
+	// Read back in the file and compare
+
+	boost::filesystem::ifstream testFile(kFilePath, std::ofstream::binary);
+
+	byte readData[ARRAYSIZE(data)] = { 0 };
+
+	testFile.read(reinterpret_cast<char *>(readData), ARRAYSIZE(readData));
+	ASSERT_FALSE(testFile.fail());
+
+	testFile.close();
+
+	for (size_t i = 0; i < ARRAYSIZE(data); i++)
+		EXPECT_EQ(readData[i], data[i]) << "At index " << i;
+}
@@ -22,8 +22,14 @@
  *  Unit tests for our ZIP file reader.
  */
 
+#include <cstring>
+
+#include <vector>
+#include <algorithm>
+
 #include "gtest/gtest.h"
 
+#include "src/common/scopedptr.h"
 #include "src/common/zipfile.h"
 #include "src/common/memreadstream.h"
 #include "src/common/error.h"
@@ -119,8 +125,173 @@ GTEST_TEST(ZIPFile, getFile) {
 	delete file;
 }
 
+GTEST_TEST(ZIPFile, getFileOutlivesZIP) {
+	std::vector<byte> data(kDataCompressed, kDataCompressed + sizeof(kDataCompressed));
+
+	Common::ScopedPtr<Common::ZipFile> zip(new Common::ZipFile(new Common::MemoryReadStream(&data[0], data.size())));
+	Common::ScopedPtr<Common::SeekableReadStream> file(zip->getFile(0));
+
+	// Without tryNoCopy, the file must not depend on the ZIP anymore
+	zip.reset();
+	std::fill(data.begin(), data.end(), 0);
+
+	ASSERT_EQ(file->size(), strlen(kDataUncompressed));
+
+	for (size_t i = 0; i < strlen(kDataUncompressed); i++)
+		EXPECT_EQ(file->readByte(), kDataUncompressed[i]) << "At index " << i;
+}
+
 GTEST_TEST(ZIPFile, brokenZIP) {
 	Common::MemoryReadStream *stream = new Common::MemoryReadStream(kDataCompressed, sizeof(kDataCompressed) / 2);
 
 	EXPECT_THROW(Common::ZipFile zip(stream), Common::Exception);
 }
+
+static void writeUint16(std::vector<byte> &data, uint16 value) {
+	for (size_t i = 0; i < 2; i++)
+		data.push_back((byte) (value >> (i * 8)));
+}
+
+static void writeUint32(std::vector<byte> &data, uint32 value) {
+	for (size_t i = 0; i < 4; i++)
+		data.push_back((byte) (value >> (i * 8)));
+}
+
+static void writeUint64(std::vector<byte> &data, uint64 value) {
+	for (size_t i = 0; i < 8; i++)
+		data.push_back((byte) (value >> (i * 8)));
+}
+
+static void writeString(std::vector<byte> &data, const char *str) {
+	data.insert(data.end(), str, str + strlen(str));
+}
+
+/** Create a ZIP64 file with a single line of text stored uncompressed.
+ *
+ *  All sizes, offsets and counts that can be are moved into the ZIP64 fields.
+ */
+static void createZIP64(std::vector<byte> &zip, const char *line) {
+	const char *name = "Line.txt";
+
+	const uint32 size = strlen(line);
+
+	// Local file header
+	writeUint32(zip, 0x04034B50);
+	writeUint16(zip, 45);         // Version needed
+	writeUint16(zip, 0);          // Flags
+	writeUint16(zip, 0);          // Stored
+	writeUint32(zip, 0);          // Time, date
+	writeUint32(zip, 0);          // CRC, not checked
+	writeUint32(zip, 0xFFFFFFFF); // Compressed size, in the extra field
+	writeUint32(zip, 0xFFFFFFFF); // Size, in the extra field
+	writeUint16(zip, strlen(name));
+	writeUint16(zip, 20);
+	writeString(zip, name);
+	writeUint16(zip, 0x0001);
+	writeUint16(zip, 16);
+	writeUint64(zip, size);
+	writeUint64(zip, size);
+
+	writeString(zip, line);
+
+	// Central directory
+	const size_t centralDirPos = zip.size();
+
+	writeUint32(zip, 0x02014B50);
+	writeUint16(zip, 45);         // Version made by
+	writeUint16(zip, 45);         // Version needed
+	writeUint16(zip, 0);          // Flags
+	writeUint16(zip, 0);          // Stored
+	writeUint32(zip, 0);          // Time, date
+	writeUint32(zip, 0);          // CRC
+	writeUint32(zip, 0xFFFFFFFF); // Compressed size, in the extra field
+	writeUint32(zip, 0xFFFFFFFF); // Size, in the extra field
+	writeUint16(zip, strlen(name));
+	writeUint16(zip, 4 + 24 + 8); // Extra field, with an unknown block in front
+	writeUint16(zip, 0);          // Comment
+	writeUint16(zip, 0xFFFF);     // Disk number, in the extra field
+	writeUint16(zip, 0);          // Internal attributes
+	writeUint32(zip, 0);          // External attributes
+	writeUint32(zip, 0xFFFFFFFF); // Local header offset, in the extra field
+	writeString(zip, name);
+	writeUint16(zip, 0x5455);     // Extended timestamp, to be skipped
+	writeUint16(zip, 0);
+	writeUint16(zip, 0x0001);
+	writeUint16(zip, 32);
+	writeUint64(zip, size);
+	writeUint64(zip, size);
+	writeUint64(zip, 0);
+	writeUint32(zip, 0);          // Disk number
+
+	const size_t centralDirSize = zip.size() - centralDirPos;
+
+	// ZIP64 end of central directory record
+	const size_t zip64EndPos = zip.size();
+
+	writeUint32(zip, 0x06064B50);
+	writeUint64(zip, 44);         // Size of the rest of the record
+	writeUint16(zip, 45);         // Version made by
+	writeUint16(zip, 45);         // Version needed
+	writeUint32(zip, 0);          // Disk
+	writeUint32(zip, 0);          // Central directory disk
+	writeUint64(zip, 1);          // Entries on this disk
+	writeUint64(zip, 1);          // Entries
+	writeUint64(zip, centralDirSize);
+	writeUint64(zip, centralDirPos);
+
+	// ZIP64 end of central directory locator
+	writeUint32(zip, 0x07064B50);
+	writeUint32(zip, 0);          // Disk
+	writeUint64(zip, zip64EndPos);
+	writeUint32(zip, 1);          // Number of disks
+
+	// End of central directory record
+	writeUint32(zip, 0x06054B50);
+	writeUint16(zip, 0xFFFF);
+	writeUint16(zip, 0xFFFF);
+	writeUint16(zip, 0xFFFF);
+	writeUint16(zip, 0xFFFF);
+	writeUint32(zip, 0xFFFFFFFF);
+	writeUint32(zip, 0xFFFFFFFF);
+	writeUint16(zip, 0);          // Comment
+}
+
+static const char *kLine = "I met a traveller from an antique land\n";
+
+GTEST_TEST(ZIPFile, ZIP64) {
+	std::vector<byte> data;
+	createZIP64(data, kLine);
+
+	const Common::ZipFile zip(new Common::MemoryReadStream(&data[0], data.size()));
+
+	const Common::ZipFile::FileList &files = zip.getFiles();
+	ASSERT_EQ(files.size(), 1);
+
+	EXPECT_EQ(files.begin()->index, 0);
+	EXPECT_STREQ(files.begin()->name.c_str(), "line.txt");
+
+	EXPECT_EQ(zip.getFileSize(0), strlen(kLine));
+
+	Common::ScopedPtr<Common::SeekableReadStream> file(zip.getFile(0));
+	ASSERT_EQ(file->size(), strlen(kLine));
+
+	for (size_t i = 0; i < strlen(kLine); i++)
+		EXPECT_EQ(file->readByte(), kLine[i]) << "At index " << i;
+}
+
+GTEST_TEST(ZIPFile, getFileNoCopy) {
+	std::vector<byte> data;
+	createZIP64(data, kLine);
+
+	const Common::ZipFile zip(new Common::MemoryReadStream(&data[0], data.size()));
+
+	Common::ScopedPtr<Common::SeekableReadStream> file(zip.getFile(0, true));
+	ASSERT_EQ(file->size(), strlen(kLine));
+
+	// A stored file is served straight out of the ZIP
+	EXPECT_NE(dynamic_cast<Common::SeekableSubReadStream *>(file.get()),
+	          static_cast<Common::SeekableSubReadStream *>(0));
+
+	for (size_t i = 0; i < strlen(kLine); i++)
+		EXPECT_EQ(file->readByte(), kLine[i]) << "At index " << i;
+}
@@ -0,0 +1,138 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for our pixel format conversion.
+ */
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "src/common/util.h"
+#include "src/common/error.h"
+
+#include "src/images/convert.h"
+
+/** Convert one pixel into B8G8R8A8, byte by byte. */
+static void convertReference(byte *dest, const byte *&src, Images::PixelFormat format) {
+	if        (format == Images::kPixelFormatR8G8B8) {
+		dest[0] = src[2]; dest[1] = src[1]; dest[2] = src[0]; dest[3] = 0xFF;
+		src += 3;
+	} else if (format == Images::kPixelFormatB8G8R8) {
+		dest[0] = src[0]; dest[1] = src[1]; dest[2] = src[2]; dest[3] = 0xFF;
+		src += 3;
+	} else if (format == Images::kPixelFormatR8G8B8A8) {
+		dest[0] = src[2]; dest[1] = src[1]; dest[2] = src[0]; dest[3] = src[3];
+		src += 4;
+	} else if (format == Images::kPixelFormatB8G8R8A8) {
+		dest[0] = src[0]; dest[1] = src[1]; dest[2] = src[2]; dest[3] = src[3];
+		src += 4;
+	} else if (format == Images::kPixelFormatR5G6B5) {
+		const uint16 color = READ_LE_UINT16(src);
+		dest[0] =  color & 0x001F;
+		dest[1] = (color & 0x07E0) >>  5;
+		dest[2] = (color & 0xF800) >> 11;
+		dest[3] = 0xFF;
+		src += 2;
+	} else if (format == Images::kPixelFormatA1R5G5B5) {
+		const uint16 color = READ_LE_UINT16(src);
+		dest[0] =  color & 0x001F;
+		dest[1] = (color & 0x03E0) >>  5;
+		dest[2] = (color & 0x7C00) >> 10;
+		dest[3] = (color & 0x8000) ? 0xFF : 0x00;
+		src += 2;
+	} else if (format == Images::kPixelFormatDepth16) {
+		const uint16 color = READ_LE_UINT16(src);
+		dest[0] = dest[1] = dest[2] = color / 128;
+		dest[3] = (color >= 0x7FFF) ? 0x00 : 0xFF;
+		src += 2;
+	}
+}
+
+static void testConvert(Images::PixelFormat format, int bpp) {
+	for (size_t count = 0; count < 40; count++) {
+		std::vector<byte> data(count * bpp + 1);
+
+		uint32 seed = count;
+		for (size_t i = 0; i < data.size(); i++) {
+			seed = seed * 1103515245 + 12345;
+			data[i] = seed >> 16;
+		}
+
+		std::vector<byte> reference(count * 4 + 1, 0), bgra(count * 4 + 1, 0), rgba(count * 4 + 1, 0);
+
+		const byte *src = &data[0];
+		for (size_t i = 0; i < count; i++)
+			convertReference(&reference[i * 4], src, format);
+
+		Images::convertToB8G8R8A8(&bgra[0], &data[0], count, format);
+		Images::convertToR8G8B8A8(&rgba[0], &data[0], count, format);
+
+		for (size_t i = 0; i < count; i++) {
+			for (size_t j = 0; j < 4; j++)
+				EXPECT_EQ(bgra[i * 4 + j], reference[i * 4 + j]) << "At " << count << ", " << i << ", " << j;
+
+			EXPECT_EQ(rgba[i * 4 + 0], reference[i * 4 + 2]) << "At " << count << ", " << i;
+			EXPECT_EQ(rgba[i * 4 + 1], reference[i * 4 + 1]) << "At " << count << ", " << i;
+			EXPECT_EQ(rgba[i * 4 + 2], reference[i * 4 + 0]) << "At " << count << ", " << i;
+			EXPECT_EQ(rgba[i * 4 + 3], reference[i * 4 + 3]) << "At " << count << ", " << i;
+		}
+
+		// Nothing written past the end
+		EXPECT_EQ(bgra[count * 4], 0);
+		EXPECT_EQ(rgba[count * 4], 0);
+	}
+}
+
+GTEST_TEST(ImagesConvert, R8G8B8) {
+	testConvert(Images::kPixelFormatR8G8B8, 3);
+}
+
+GTEST_TEST(ImagesConvert, B8G8R8) {
+	testConvert(Images::kPixelFormatB8G8R8, 3);
+}
+
+GTEST_TEST(ImagesConvert, R8G8B8A8) {
+	testConvert(Images::kPixelFormatR8G8B8A8, 4);
+}
+
+GTEST_TEST(ImagesConvert, B8G8R8A8) {
+	testConvert(Images::kPixelFormatB8G8R8A8, 4);
+}
+
+GTEST_TEST(ImagesConvert, R5G6B5) {
+	testConvert(Images::kPixelFormatR5G6B5, 2);
+}
+
+GTEST_TEST(ImagesConvert, A1R5G5B5) {
+	testConvert(Images::kPixelFormatA1R5G5B5, 2);
+}
+
+GTEST_TEST(ImagesConvert, Depth16) {
+	testConvert(Images::kPixelFormatDepth16, 2);
+}
+
+GTEST_TEST(ImagesConvert, compressed) {
+	byte data[64];
+
+	EXPECT_THROW(Images::convertToB8G8R8A8(data, data, 1, Images::kPixelFormatDXT1), Common::Exception);
+	EXPECT_THROW(Images::convertToR8G8B8A8(data, data, 1, Images::kPixelFormatDXT5), Common::Exception);
+}
@@ -31,3 +31,13 @@ check_PROGRAMS                 += tests/images/test_util
 tests_images_test_util_SOURCES  = tests/images/util.cpp
 tests_images_test_util_LDADD    = $(images_LIBS)
 tests_images_test_util_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                  += tests/images/test_s3tc
+tests_images_test_s3tc_SOURCES  = tests/images/s3tc.cpp
+tests_images_test_s3tc_LDADD    = $(images_LIBS)
+tests_images_test_s3tc_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                     += tests/images/test_convert
+tests_images_test_convert_SOURCES  = tests/images/convert.cpp
+tests_images_test_convert_LDADD    = $(images_LIBS)
+tests_images_test_convert_CXXFLAGS = $(test_CXXFLAGS)
@@ -35,9 +35,23 @@ noinst_HEADERS += \
     tests/skip.h \
     $(EMPTY)
 
+# Benchmarks. They are neither built by "make" nor run by "make check",
+# only by "make bench".
+
+BENCHMARKS =
+
 include tests/version/rules.mk
 include tests/common/rules.mk
 include tests/aurora/rules.mk
 include tests/images/rules.mk
+include tests/cline/rules.mk
 
 TESTS += $(check_PROGRAMS)
+
+EXTRA_PROGRAMS += $(BENCHMARKS)
+CLEANFILES     += $(BENCHMARKS)
+
+bench: $(BENCHMARKS)
+	@for bench in $(BENCHMARKS); do ./$$bench || exit 1; done
+
+.PHONY: bench